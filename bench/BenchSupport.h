@@ -0,0 +1,59 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#ifndef BENCHSUPPORT_H
+#define BENCHSUPPORT_H
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+/**
+ * 基准测试程序共用的计时和统计
+ * 每个基准测试是一个独立的程序,直接把结果打印到标准输出,不作为ctest的一部分运行
+ * (结果依赖机器负载,只用于对比,不做通过/失败判断).
+ */
+class BenchSupport {
+public:
+    static uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * 取分位数(会对samples排序)
+     * @param samples - 样本
+     * @param fraction - 0~1
+     */
+    static uint64_t percentile(std::vector<uint64_t> &samples, const double fraction) {
+        if (samples.empty()) {
+            return 0;
+        }
+        std::sort(samples.begin(), samples.end());
+        const size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * (samples.size() - 1) + 0.5));
+        return samples[index];
+    }
+
+    /**
+     * 打印一组延迟样本的p50/p90/p99/最大值(微秒)
+     */
+    static void printLatency(const char *name, std::vector<uint64_t> &samplesNs) {
+        std::printf("%-28s n=%-7zu p50=%8.1fus p90=%8.1fus p99=%8.1fus max=%8.1fus\n", name, samplesNs.size(),
+                    percentile(samplesNs, 0.50) / 1000.0, percentile(samplesNs, 0.90) / 1000.0,
+                    percentile(samplesNs, 0.99) / 1000.0, percentile(samplesNs, 1.0) / 1000.0);
+    }
+
+    /**
+     * 打印每次操作的平均耗时
+     */
+    static void printPerOperation(const char *name, const uint64_t elapsedNs, const uint64_t operations) {
+        std::printf("%-28s %10.1f ns/次 (%llu次)\n", name, operations ? static_cast<double>(elapsedNs) / operations : 0.0,
+                    static_cast<unsigned long long>(operations));
+    }
+};
+
+
+#endif //BENCHSUPPORT_H
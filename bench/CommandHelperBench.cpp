@@ -0,0 +1,69 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "CommandHelper.h"
+#include "McuDecoder.h"
+
+// 统计堆分配次数
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(const size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+static constexpr uint64_t ROUNDS = 5000000;
+
+template<typename Function>
+static void measure(const char *name, Function function) {
+    const uint64_t allocationsBefore = allocations.load();
+    const uint64_t startNs = BenchSupport::nowNs();
+    for (uint64_t i = 0; i < ROUNDS; i++) {
+        function(static_cast<uint32_t>(i));
+    }
+    BenchSupport::printPerOperation(name, BenchSupport::nowNs() - startNs, ROUNDS);
+    std::printf("%-28s %10.2f 次/条\n", "  堆分配", static_cast<double>(allocations.load() - allocationsBefore) / ROUNDS);
+}
+
+int main() {
+    volatile uint32_t sink = 0;
+    CommandHelper::McuReport report;
+    measure("encodeCommand(设置显示模式)", [&](const uint32_t sequence) {
+        CommandHelper::encodeCommand<McuMsgId::SET_DISPLAY_MODE>(report, sequence, 3, 1, 3, 0xB4, 0);
+        sink += report[1];
+    });
+    measure("buildCustomDisplayCommand(vector)", [&](uint32_t) {
+        const std::vector<uint8_t> command = CommandHelper::buildCustomDisplayCommand();
+        sink += command[1];
+    });
+    measure("encodeText(\"v\")", [&](uint32_t) {
+        CommandHelper::encodeText(report, "v");
+        sink += report[1];
+    });
+
+    CommandHelper::encodeCommand<McuMsgId::GET_FIRMWARE_VERSION>(report, 1);
+    MCU_MESSAGE_VIEW message;
+    measure("McuDecoder::decode", [&](uint32_t) {
+        McuDecoder::decode(report.data(), report.size(), message);
+        sink += message.sequence;
+    });
+    return 0;
+}
@@ -0,0 +1,129 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "CommandWriter.h"
+#include "Logger.h"
+
+/**
+ * 每次写入耗时固定的设备,和真实的中断端点一样同一时间只能完成一次写入,
+ * 记录同时在等待/进行写入的调用数
+ */
+class CountingDeviceHandle : public HidDeviceHandle {
+public:
+    int write(const uint8_t *, const size_t length) override {
+        const int concurrent = ++inFlight;
+        int previous = maxInFlight.load();
+        while (concurrent > previous && !maxInFlight.compare_exchange_weak(previous, concurrent)) {
+        }
+        {
+            std::lock_guard<std::mutex> lock(endpointMutex);
+            // USB中断传输的典型耗时
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+        --inFlight;
+        writes++;
+        return static_cast<int>(length);
+    }
+
+    int sendFeatureReport(const uint8_t *data, const size_t length) override {
+        return write(data, length);
+    }
+
+    int read(uint8_t *, size_t, int) override {
+        return 0;
+    }
+
+    std::string lastError() override {
+        return "";
+    }
+
+    std::mutex endpointMutex;
+    std::atomic<int> inFlight{0};
+    std::atomic<int> maxInFlight{0};
+    std::atomic<uint64_t> writes{0};
+};
+
+static constexpr int PRODUCERS = 4;
+static constexpr int COMMANDS = 20000;
+
+/**
+ * 改造前sendCommandAsync的写法: 每条命令一个线程
+ */
+static void threadPerCommand() {
+    auto device = std::make_shared<CountingDeviceHandle>();
+    uint8_t report[64] = {0xFD};
+    const uint64_t startNs = BenchSupport::nowNs();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&] {
+            std::vector<std::thread> commands;
+            commands.reserve(COMMANDS / PRODUCERS);
+            for (int i = 0; i < COMMANDS / PRODUCERS; i++) {
+                commands.emplace_back([&] {
+                    device->write(report, sizeof(report));
+                });
+            }
+            for (auto &command: commands) {
+                command.join();
+            }
+        });
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    const uint64_t elapsedNs = BenchSupport::nowNs() - startNs;
+    BenchSupport::printPerOperation("每条命令一个线程", elapsedNs, COMMANDS);
+    std::printf("%-28s 同时等待写入最多 %d 个\n", "", device->maxInFlight.load());
+}
+
+static void commandWriter() {
+    auto device = std::make_shared<CountingDeviceHandle>();
+    auto writer = std::make_shared<CommandWriter>(device);
+    writer->start();
+    uint8_t report[64] = {0xFD};
+    std::atomic<int> completed{0};
+    const uint64_t startNs = BenchSupport::nowNs();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&] {
+            for (int i = 0; i < COMMANDS / PRODUCERS; i++) {
+                writer->submit(report, sizeof(report), [&](bool) {
+                    completed++;
+                });
+            }
+        });
+    }
+    for (auto &producer: producers) {
+        producer.join();
+    }
+    while (completed < COMMANDS - static_cast<int>(writer->stats().rejected)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const uint64_t elapsedNs = BenchSupport::nowNs() - startNs;
+    const CommandWriter::Stats stats = writer->stats();
+    writer->stop();
+
+    BenchSupport::printPerOperation("CommandWriter队列", elapsedNs, COMMANDS);
+    std::printf("%-28s 同时等待写入最多 %d 个, 拒绝 %llu, 队列最高 %zu, 提交->写完 平均 %.1fus 最大 %.1fus\n", "",
+                device->maxInFlight.load(), static_cast<unsigned long long>(stats.rejected), stats.high_water,
+                stats.sent ? stats.total_latency_ns / 1e3 / stats.sent : 0.0, stats.max_latency_ns / 1e3);
+}
+
+int main() {
+    // 写入成功的日志每条命令两行,关闭控制台输出,只测写入本身
+    Logger::setConsole(false);
+    std::printf("%d个线程共提交%d条命令, 设备每次写入20us\n", PRODUCERS, COMMANDS);
+    threadPerCommand();
+    commandWriter();
+    return 0;
+}
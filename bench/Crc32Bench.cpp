@@ -0,0 +1,44 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "Crc32.h"
+
+int main() {
+    std::mt19937 random(1);
+    std::vector<uint8_t> buffer(8 << 20);
+    for (uint8_t &byte: buffer) {
+        byte = static_cast<uint8_t>(random());
+    }
+    const Crc32::Implementation implementations[] = {
+        Crc32::Implementation::TABLE, Crc32::Implementation::SLICE8, Crc32::Implementation::PCLMUL,
+        Crc32::Implementation::ARMV8
+    };
+    std::printf("当前选中: %s\n", Crc32::name(Crc32::selected()));
+
+    // 24字节为0xFD报文的典型CRC范围,64字节为一条完整上报,其余为录制文件的块
+    for (const size_t size: {size_t(24), size_t(64), size_t(256), size_t(4096), size_t(65536), size_t(1 << 20),
+                             size_t(8 << 20)}) {
+        std::printf("%8zu B:", size);
+        for (const Crc32::Implementation implementation: implementations) {
+            if (!Crc32::supported(implementation)) {
+                continue;
+            }
+            const size_t rounds = std::max<size_t>(1, (size_t(64) << 20) / size);
+            volatile uint32_t sink = 0;
+            const uint64_t startNs = BenchSupport::nowNs();
+            for (size_t i = 0; i < rounds; i++) {
+                sink += Crc32::compute(implementation, buffer.data(), size);
+            }
+            const double ns = static_cast<double>(BenchSupport::nowNs() - startNs) / rounds;
+            std::printf("  %s %.1fns (%.2f GB/s)", Crc32::name(implementation), ns, size / ns);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "DevicesHelper.h"
+#include "INTERFACE_INFO.h"
+#include "Logger.h"
+#include "SimulatedTransport.h"
+
+/**
+ * 把模拟眼镜的接口包装成没有可等待句柄的接口(pollFd()返回-1),
+ * 与macOS(IOHIDManager)和libusb后端的hidapi一样,只能靠hid_read_timeout或轮询读取
+ */
+class NoFdDeviceHandle : public HidDeviceHandle {
+public:
+    explicit NoFdDeviceHandle(std::shared_ptr<HidDeviceHandle> device) : device(std::move(device)) {
+    }
+
+    int write(const uint8_t *data, const size_t length) override {
+        return device->write(data, length);
+    }
+
+    int sendFeatureReport(const uint8_t *data, const size_t length) override {
+        return device->sendFeatureReport(data, length);
+    }
+
+    int read(uint8_t *buffer, const size_t length, const int timeoutMs) override {
+        return device->read(buffer, length, timeoutMs);
+    }
+
+    std::string lastError() override {
+        return device->lastError();
+    }
+
+private:
+    std::shared_ptr<HidDeviceHandle> device;
+};
+
+class NoFdTransport : public HidTransport {
+public:
+    explicit NoFdTransport(std::shared_ptr<HidTransport> transport) : transport(std::move(transport)) {
+    }
+
+    std::vector<HID_DEVICE_ENTRY> enumerate(const uint16_t vendorId) override {
+        return transport->enumerate(vendorId);
+    }
+
+    std::shared_ptr<HidDeviceHandle> open(const std::string &path) override {
+        std::shared_ptr<HidDeviceHandle> device = transport->open(path);
+        return device ? std::make_shared<NoFdDeviceHandle>(device) : nullptr;
+    }
+
+private:
+    std::shared_ptr<HidTransport> transport;
+};
+
+static const char *modeName(const ReaderMode mode) {
+    switch (mode) {
+        case ReaderMode::POLLING:
+            return "POLLING";
+        case ReaderMode::BLOCKING:
+            return "BLOCKING";
+        default:
+            return "REACTOR";
+    }
+}
+
+static double cpuSeconds(rusage &usage) {
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * 打开模拟眼镜的IMU接口,按指定方式读取一段时间
+ * 模拟设备的IMU时间戳就是上报产生(到达)时的steady_clock,与接收时间之差即为到达->交给消费者的延迟
+ */
+static void measure(const ReaderMode mode, const bool withFd, const double imuRateHz, const int seconds) {
+    SimulatedTransport::Config config;
+    config.imu_rate_hz = imuRateHz;
+    std::shared_ptr<HidTransport> transport = std::make_shared<SimulatedTransport>(config);
+    if (!withFd) {
+        transport = std::make_shared<NoFdTransport>(transport);
+    }
+    HidTransport::use(transport);
+
+    INTERFACE_INFO info;
+    for (const HID_DEVICE_ENTRY &entry: transport->enumerate(DevicesHelper::XREAL_VID)) {
+        if (entry.interface_number == SimulatedTransport::IMU_INTERFACE) {
+            info.hid_path = entry.path;
+            info.interface_number = entry.interface_number;
+            break;
+        }
+    }
+    info.reader_mode = mode;
+    info.imu_samples = std::make_shared<ImuSampleBuffer>(16384);
+
+    rusage before{};
+    rusage after{};
+    const double cpuBefore = cpuSeconds(before);
+    info.open();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    info.close();
+    const double cpuUsed = cpuSeconds(after) - cpuBefore;
+    const long switches = (after.ru_nvcsw + after.ru_nivcsw) - (before.ru_nvcsw + before.ru_nivcsw);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%s", modeName(mode), withFd ? "" : " (无fd)");
+    if (imuRateHz > 0) {
+        // 跳过开头的样本,等读取线程和定时器稳定下来
+        std::vector<uint64_t> latencies;
+        const ImuSampleBuffer &samples = *info.imu_samples;
+        const uint64_t last = samples.lastSequence();
+        IMU_SAMPLE sample;
+        for (uint64_t sequence = 200; sequence <= last; sequence++) {
+            if (samples.read(sequence, sample) && sample.received_at_ns >= sample.device_timestamp_ns) {
+                latencies.push_back(sample.received_at_ns - sample.device_timestamp_ns);
+            }
+        }
+        BenchSupport::printLatency(name, latencies);
+    }
+    std::printf("%-28s CPU %5.1f%%  上下文切换 %.0f 次/秒\n", imuRateHz > 0 ? "" : name, cpuUsed * 100.0 / seconds,
+                static_cast<double>(switches) / seconds);
+}
+
+int main() {
+    Logger::setConsole(false);
+    constexpr int SECONDS = 3;
+    const ReaderMode modes[] = {ReaderMode::POLLING, ReaderMode::BLOCKING, ReaderMode::REACTOR};
+    // 模拟设备的上报由HidReactor的毫秒级定时器产生,所有方式的延迟中都包含同样的定时器误差(约0.5ms)
+    for (const double rateHz: {1000.0, 125.0}) {
+        std::printf("模拟眼镜IMU接口 %.0fHz, 每种方式%d秒, 上报到达->交给消费者的延迟\n", rateHz, SECONDS);
+        for (const bool withFd: {true, false}) {
+            for (const ReaderMode mode: modes) {
+                measure(mode, withFd, rateHz, SECONDS);
+            }
+        }
+        std::printf("\n");
+    }
+    std::printf("空闲(不上报)时的开销\n");
+    for (const bool withFd: {true, false}) {
+        for (const ReaderMode mode: modes) {
+            measure(mode, withFd, 0.0, SECONDS);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "ReportRingBuffer.h"
+
+// 统计堆分配次数,验证写入路径上没有分配
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(const size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+static constexpr uint64_t REPORTS = 2000000;
+
+/**
+ * 改造前 INTERFACE_INFO::received_messages 的写法: 每条上报一个vector,超过100条后erase(begin())
+ */
+static void legacyIngest() {
+    std::vector<std::vector<uint8_t>> receivedMessages;
+    uint8_t data[HID_REPORT::MAX_SIZE] = {0};
+    const uint64_t allocationsBefore = allocations.load();
+    const uint64_t startNs = BenchSupport::nowNs();
+    for (uint64_t i = 0; i < REPORTS; i++) {
+        data[0] = static_cast<uint8_t>(i);
+        receivedMessages.emplace_back(data, data + sizeof(data));
+        if (receivedMessages.size() > 100) {
+            receivedMessages.erase(receivedMessages.begin());
+        }
+    }
+    BenchSupport::printPerOperation("vector<vector>写入", BenchSupport::nowNs() - startNs, REPORTS);
+    std::printf("%-28s %10.2f 次/条\n", "  堆分配", static_cast<double>(allocations.load() - allocationsBefore) / REPORTS);
+}
+
+static void ringIngest(const int readers) {
+    ReportRingBuffer buffer(128);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> readCounts(readers, 0);
+    for (int i = 0; i < readers; i++) {
+        threads.emplace_back([&, i] {
+            ReportRingBuffer::Cursor cursor;
+            HID_REPORT out;
+            while (!done.load(std::memory_order_acquire)) {
+                while (buffer.next(cursor, out)) {
+                    readCounts[i]++;
+                }
+            }
+        });
+    }
+
+    uint8_t data[HID_REPORT::MAX_SIZE] = {0};
+    const uint64_t allocationsBefore = allocations.load();
+    const uint64_t startNs = BenchSupport::nowNs();
+    for (uint64_t i = 0; i < REPORTS; i++) {
+        data[0] = static_cast<uint8_t>(i);
+        buffer.push(data, sizeof(data), startNs);
+    }
+    const uint64_t elapsedNs = BenchSupport::nowNs() - startNs;
+    const uint64_t ingestAllocations = allocations.load() - allocationsBefore;
+    done.store(true, std::memory_order_release);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "环形缓冲区写入(%d个读者)", readers);
+    BenchSupport::printPerOperation(name, elapsedNs, REPORTS);
+    std::printf("%-28s %10.2f 次/条\n", "  堆分配", static_cast<double>(ingestAllocations) / REPORTS);
+    for (int i = 0; i < readers; i++) {
+        std::printf("  读者%d读到 %llu 条\n", i, static_cast<unsigned long long>(readCounts[i]));
+    }
+}
+
+static void snapshotCost() {
+    ReportRingBuffer buffer(128);
+    uint8_t data[HID_REPORT::MAX_SIZE] = {0};
+    for (int i = 0; i < 128; i++) {
+        buffer.push(data, sizeof(data), 0);
+    }
+    std::vector<HID_REPORT> out;
+    constexpr uint64_t ROUNDS = 100000;
+    const uint64_t startNs = BenchSupport::nowNs();
+    for (uint64_t i = 0; i < ROUNDS; i++) {
+        buffer.snapshot(out, 100);
+    }
+    BenchSupport::printPerOperation("快照100条", BenchSupport::nowNs() - startNs, ROUNDS);
+}
+
+int main() {
+    legacyIngest();
+    ringIngest(0);
+    ringIngest(2);
+    snapshotCost();
+    return 0;
+}
@@ -0,0 +1,67 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "SensorFusion.h"
+
+/**
+ * 1kHz的合成数据: 绕z轴(与重力同轴)匀速转动0.5弧度/秒,x轴叠加小幅摆动
+ */
+static std::vector<IMU_SAMPLE> generate(const size_t count) {
+    std::vector<IMU_SAMPLE> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        IMU_SAMPLE &sample = samples[i];
+        const double t = static_cast<double>(i) * 1e-3;
+        sample.device_timestamp_ns = 1000000 * (i + 1);
+        sample.gyro[0] = 0.2f * static_cast<float>(std::sin(3 * t));
+        sample.gyro[2] = 0.5f;
+        sample.accel[0] = 0.01f * static_cast<float>(std::sin(t));
+        sample.accel[2] = 1;
+    }
+    return samples;
+}
+
+static double yawOf(const float *q) {
+    return std::atan2(2 * (q[0] * q[3] + q[1] * q[2]), 1 - 2 * (q[2] * q[2] + q[3] * q[3]));
+}
+
+int main() {
+    // HeadTracker每次最多取64条,这里按16条一批模拟1kHz下的典型批量
+    constexpr size_t BATCH = 16;
+    const std::vector<IMU_SAMPLE> samples = generate(1 << 16);
+    for (const SensorFusion::Algorithm algorithm: {SensorFusion::Algorithm::MADGWICK, SensorFusion::Algorithm::MAHONY}) {
+        float quaternions[2][4] = {};
+        for (const SensorFusion::Path path: {SensorFusion::Path::SCALAR, SensorFusion::Path::SIMD}) {
+            SensorFusion::Config config;
+            config.algorithm = algorithm;
+            config.path = path;
+            double bestNs = 1e18;
+            for (int round = 0; round < 5; round++) {
+                SensorFusion fusion(config);
+                const uint64_t startNs = BenchSupport::nowNs();
+                for (size_t i = 0; i < samples.size(); i += BATCH) {
+                    fusion.update(&samples[i], BATCH);
+                }
+                bestNs = std::min(bestNs, static_cast<double>(BenchSupport::nowNs() - startNs) / samples.size());
+                if (round == 0) {
+                    std::copy(fusion.orientation().quaternion, fusion.orientation().quaternion + 4,
+                              quaternions[path == SensorFusion::Path::SIMD]);
+                }
+            }
+            std::printf("%-8s %-6s %6.1f ns/样本\n", SensorFusion::name(algorithm), SensorFusion::name(path), bestNs);
+        }
+        double difference = 0;
+        for (int k = 0; k < 4; k++) {
+            difference = std::max(difference, static_cast<double>(std::fabs(quaternions[0][k] - quaternions[1][k])));
+        }
+        const double seconds = static_cast<double>(samples.size() - 1) * 1e-3;
+        std::printf("  标量/SIMD最大差 %.2e, %.1f秒后偏航 %.3f 弧度(陀螺仪积分 %.3f)\n", difference, seconds,
+                    yawOf(quaternions[1]), std::remainder(0.5 * seconds, 2 * M_PI));
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "PosePredictor.h"
+#include "SeqLock.h"
+
+/**
+ * 改造前的写法: 用互斥锁保护最新姿态
+ */
+class MutexSlot {
+public:
+    void store(const PosePredictor::State &value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = value;
+    }
+
+    void load(PosePredictor::State &out) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        out = state;
+    }
+
+private:
+    mutable std::mutex mutex;
+    PosePredictor::State state;
+};
+
+/**
+ * 一个写入线程(融合线程)和若干读取线程(渲染/网页桥接)
+ * @param steady - true为按1kHz写入(实际负载),false为不间断写入(最坏情况)
+ */
+template<typename Slot>
+static void run(const char *name, const int readers, const bool steady) {
+    Slot slot;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> readNs{0};
+    std::atomic<uint64_t> torn{0};
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; r++) {
+        threads.emplace_back([&] {
+            PosePredictor::State state;
+            uint64_t count = 0;
+            const uint64_t startNs = BenchSupport::nowNs();
+            while (!done.load(std::memory_order_relaxed)) {
+                slot.load(state);
+                // 写入方在两个字段中写入同一个值,不一致即为读到一半被覆盖
+                if (state.orientation.device_timestamp_ns != state.orientation.sample_sequence) {
+                    torn++;
+                }
+                count++;
+            }
+            readNs += BenchSupport::nowNs() - startNs;
+            reads += count;
+        });
+    }
+
+    const int writes = steady ? 3000 : 2000000;
+    std::vector<uint64_t> writeNs;
+    writeNs.reserve(writes);
+    PosePredictor::State state;
+    for (int i = 1; i <= writes; i++) {
+        state.orientation.device_timestamp_ns = i;
+        state.orientation.sample_sequence = i;
+        state.orientation.quaternion[0] = static_cast<float>(i);
+        const uint64_t startNs = BenchSupport::nowNs();
+        slot.store(state);
+        writeNs.push_back(BenchSupport::nowNs() - startNs);
+        if (steady) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    done = true;
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    uint64_t totalWriteNs = 0;
+    for (const uint64_t ns: writeNs) {
+        totalWriteNs += ns;
+    }
+    std::printf("%-8s %d个读者 %-6s 写入 平均%9.1fns p99 %9.1fns 最大%9.1fus | 读取 %6.1fns/次 | 撕裂 %llu\n", name,
+                readers, steady ? "1kHz" : "不间断", static_cast<double>(totalWriteNs) / writes,
+                static_cast<double>(BenchSupport::percentile(writeNs, 0.99)),
+                BenchSupport::percentile(writeNs, 1.0) / 1e3,
+                reads ? static_cast<double>(readNs) / reads : 0.0, static_cast<unsigned long long>(torn.load()));
+}
+
+int main() {
+    std::printf("sizeof(PosePredictor::State)=%zu, %u个核\n", sizeof(PosePredictor::State),
+                std::thread::hardware_concurrency());
+    for (const int readers: {1, 4}) {
+        run<SeqLock<PosePredictor::State>>("seqlock", readers, true);
+        run<MutexSlot>("mutex", readers, true);
+        run<SeqLock<PosePredictor::State>>("seqlock", readers, false);
+        run<MutexSlot>("mutex", readers, false);
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "StreamHealth.h"
+#include "Utils.h"
+
+int main() {
+    // 直方图的分位数与精确值的对比(对数正态分布,中位数1ms)
+    std::mt19937_64 random(3);
+    std::lognormal_distribution<double> distribution(std::log(1e6), 0.5);
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    for (int i = 0; i < 200000; i++) {
+        const auto value = static_cast<uint64_t>(distribution(random));
+        values.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(values.begin(), values.end());
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    for (const double quantile: {0.5, 0.9, 0.99, 0.999}) {
+        const uint64_t exact = values[static_cast<size_t>(std::ceil(quantile * values.size())) - 1];
+        const uint64_t estimate = snapshot.percentile(quantile);
+        std::printf("p%-5g 精确 %8.1fus 直方图 %8.1fus (%+.1f%%)\n", quantile * 100, exact / 1e3, estimate / 1e3,
+                    100.0 * (static_cast<double>(estimate) - exact) / exact);
+    }
+    std::printf("%zu个桶, %zu字节\n\n", LatencyHistogram::BUCKETS, sizeof(LatencyHistogram));
+
+    // 读取线程每条上报的统计开销
+    constexpr int REPORTS = 2000000;
+    StreamHealth health;
+    uint64_t nowNs = BenchSupport::nowNs();
+    uint64_t startNs = BenchSupport::nowNs();
+    for (int i = 0; i < REPORTS; i++) {
+        nowNs += 1000000;
+        health.onReport(nowNs);
+        health.onImu(nowNs + 5);
+        health.onHandled(2000 + (i & 1023));
+    }
+    BenchSupport::printPerOperation("onReport+onImu+onHandled", BenchSupport::nowNs() - startNs, REPORTS);
+
+    volatile uint64_t sink = 0;
+    startNs = BenchSupport::nowNs();
+    for (int i = 0; i < REPORTS; i++) {
+        sink += Utils::steadyNowNs();
+    }
+    BenchSupport::printPerOperation("Utils::steadyNowNs", BenchSupport::nowNs() - startNs, REPORTS);
+
+    constexpr int SNAPSHOTS = 1000;
+    startNs = BenchSupport::nowNs();
+    for (int i = 0; i < SNAPSHOTS; i++) {
+        sink += health.snapshot().reports;
+    }
+    BenchSupport::printPerOperation("snapshot", BenchSupport::nowNs() - startNs, SNAPSHOTS);
+    return 0;
+}
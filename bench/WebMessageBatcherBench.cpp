@@ -0,0 +1,61 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchSupport.h"
+#include "WebMessageBatcher.h"
+
+int main() {
+    // 突发: 4个线程各投递5000条日志,界面线程每帧取一批
+    WebMessageBatcher flood;
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 5000;
+    std::vector<std::thread> threads;
+    const uint64_t startNs = BenchSupport::nowNs();
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&flood, t] {
+            for (int i = 0; i < PER_THREAD; i++) {
+                flood.postText("log", "[INFO] 命令应答 msgId=" + std::to_string(i) + " 往返耗时: 123us thread " +
+                                      std::to_string(t));
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    BenchSupport::printPerOperation("postText(4个线程)", BenchSupport::nowNs() - startNs, THREADS * PER_THREAD);
+
+    std::string out;
+    std::vector<uint64_t> takeNs;
+    size_t maxBytes = 0;
+    while (!flood.empty()) {
+        const uint64_t takeStartNs = BenchSupport::nowNs();
+        flood.takeBatch(out);
+        takeNs.push_back(BenchSupport::nowNs() - takeStartNs);
+        maxBytes = std::max(maxBytes, out.size());
+    }
+    const WebMessageBatcher::Stats stats = flood.stats();
+    std::printf("突发%d条: %zu帧发完, 丢弃 %llu, 发出 %llu, 单批最大 %zu 字节, 队列最高 %zu\n", THREADS * PER_THREAD,
+                takeNs.size(), static_cast<unsigned long long>(stats.dropped),
+                static_cast<unsigned long long>(stats.delivered), maxBytes, stats.high_water);
+    BenchSupport::printLatency("takeBatch", takeNs);
+
+    // 平稳: 每帧3条按键/日志,持续60帧
+    WebMessageBatcher steady;
+    int scripts = 0;
+    for (int frame = 0; frame < 60; frame++) {
+        for (int k = 0; k < 3; k++) {
+            steady.postText("log", "[C++ KEY] KeyDown: Code=65, Timestamp=1");
+        }
+        if (steady.takeBatch(out)) {
+            scripts++;
+        }
+    }
+    std::printf("平稳: 60帧共180条消息, 执行脚本 %d 次(逐条发送为180次)\n", scripts);
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <unistd.h> // 添加这个头文件用于getpid
 
 #include "XRealGlassesController/Index.h"
+#include "XRealGlassesController/InputDecoder.h"
 
 // macOS特定头文件
 #ifdef __WXOSX__
@@ -22,6 +23,10 @@ END_EVENT_TABLE()
 bool App::OnInit() {
     if (!wxApp::OnInit())
         return false;
+
+    // 先于连接眼镜启动,连接/探测的耗时也能导出
+    m_metricsExporter = std::make_unique<MetricsExporter>(MetricsExporter::configFromEnvironment());
+    m_metricsExporter->start();
         
     // 尝试连接到眼镜
     auto xrealGlassesController = new Index();
@@ -36,6 +41,11 @@ bool App::OnInit() {
         return false;
     }
     
+    // 眼镜上的按键在读取线程中收到,转到主线程处理
+    m_inputSubscription = Index::inputEvents().subscribe([this](const INPUT_EVENT& event) {
+        CallAfter([this, event]() { OnGlassesInput(event); });
+    });
+
     // 启动定时器，延迟检查分辨率是否正确
     fprintf(stderr, "将在5秒后检查分辨率...\n");
     m_resolutionCheckTimer.SetOwner(this);
@@ -54,12 +64,26 @@ void App::OnResolutionCheckTimer(wxTimerEvent& event) {
     
     // 如果达到预期分辨率（宽度等于或接近3840），创建主窗口
     if (screenSize.GetWidth() >= 3800) {
-        fprintf(stderr, "检测到预期分辨率，创建主窗口...\n");
         m_resolutionCheckTimer.Stop();
+        if (m_mainFrame) {
+            // 用户在眼镜上切回了3D,按新的分辨率重新铺满左右两半
+            fprintf(stderr, "检测到预期分辨率，重新布局主窗口...\n");
+            m_mainFrame->SetSize(wxRect(wxPoint(0, 0), screenSize));
+            m_mainFrame->ShowFullScreen(true, wxFULLSCREEN_ALL);
+            m_mainFrame->Raise();
+            return;
+        }
+        fprintf(stderr, "检测到预期分辨率，创建主窗口...\n");
         CreateMainWindow();
         return;
     }
     
+    // 主窗口已经存在时是用户自己切到了2D,保持运行,等待切回3D
+    if (m_mainFrame && m_resolutionCheckCount >= 5) {
+        m_resolutionCheckTimer.Stop();
+        return;
+    }
+
     // 达到最大检查次数（5次），仍然没有正确的分辨率，恢复并退出
     if (m_resolutionCheckCount >= 5) {
         fprintf(stderr, "分辨率检查超时，恢复2D模式并退出...\n");
@@ -68,6 +92,21 @@ void App::OnResolutionCheckTimer(wxTimerEvent& event) {
     }
 }
 
+void App::OnGlassesInput(const INPUT_EVENT& event) {
+    if (InputDecoder::changesDisplayMode(event)) {
+        // 不必等到下一次每秒一次的检查
+        fprintf(stderr, "眼镜上切换了显示模式，立即检查分辨率...\n");
+        RestartResolutionCheck();
+    }
+}
+
+void App::RestartResolutionCheck() {
+    m_resolutionCheckCount = 0;
+    m_resolutionCheckTimer.Start(1000);
+    wxTimerEvent event(m_resolutionCheckTimer);
+    OnResolutionCheckTimer(event);
+}
+
 bool App::CreateMainWindow() {
     // 获取当前屏幕分辨率
     wxSize screenSize = wxGetDisplaySize();
@@ -79,6 +118,9 @@ bool App::CreateMainWindow() {
     
     // 创建主窗口
     MainFrame *frame = new MainFrame("Xreal Vision Stereo Viewer", formPos, formSize);
+    m_mainFrame = frame;
+    // 页面通过RPC切换显示模式后与眼镜上切换一样,立即检查分辨率
+    frame->SetDisplayModeChangedHandler([this]() { RestartResolutionCheck(); });
     SetTopWindow(frame);
     
     // 显示窗口
@@ -126,8 +168,11 @@ bool App::CreateMainWindow() {
 }
 
 void App::RestoreAndExit() {
-    // 恢复2D模式
+    // 恢复2D模式(先停止页面RPC,它的处理函数会访问眼镜)
     fprintf(stderr, "恢复2D模式...\n");
+    if (m_mainFrame) {
+        m_mainFrame->StopRpc();
+    }
     Index::restoreTo2DMode();
 
     
@@ -137,6 +182,16 @@ void App::RestoreAndExit() {
 }
 
 int App::OnExit() {
+    if (m_inputSubscription) {
+        Index::inputEvents().unsubscribe(m_inputSubscription);
+        m_inputSubscription = 0;
+    }
+    // 主窗口在OnExit之后才销毁,先停止页面RPC,它的处理函数会访问眼镜
+    if (m_mainFrame) {
+        m_mainFrame->StopRpc();
+    }
+    m_mainFrame = nullptr;
+
     // 首先将眼镜切换回2D模式
     try {
         fprintf(stderr, "正在尝试将眼镜切换回2D模式...\n");
@@ -145,6 +200,12 @@ int App::OnExit() {
         fwprintf(stderr, L"切换眼镜模式时发生错误: %s\n", e.what());
     }
     
+    // 最后写一次指标文件,包含切回2D的结果
+    if (m_metricsExporter) {
+        m_metricsExporter->stop();
+        m_metricsExporter.reset();
+    }
+    
     // 恢复原始显示模式
     if (originalDisplayMode) {
         fprintf(stderr, "正在尝试恢复原始显示模式...\n");
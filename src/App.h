@@ -2,6 +2,13 @@
 
 #include <wx/wx.h>
 #include <wx/timer.h>
+#include <wx/weakref.h>
+
+#include <memory>
+
+#include "MainFrame.h"
+#include "XRealGlassesController/INPUT_EVENT.h"
+#include "XRealGlassesController/MetricsExporter.h"
 
 class App : public wxApp {
 public:
@@ -15,8 +22,23 @@ private:
     wxTimer m_resolutionCheckTimer;
     int m_resolutionCheckCount = 0;
     
+    // 主窗口(分辨率检查通过后创建,窗口销毁后自动变为空)
+    wxWeakRef<MainFrame> m_mainFrame;
+
+    // 眼镜输入事件的订阅ID
+    uint64_t m_inputSubscription = 0;
+
+    // 把运行指标导出到文件/本地端口(由环境变量配置,没有配置时不启动)
+    std::unique_ptr<MetricsExporter> m_metricsExporter;
+
     // 处理分辨率检查定时器事件
     void OnResolutionCheckTimer(wxTimerEvent& event);
+
+    // 在主线程中处理眼镜上的按键/显示切换
+    void OnGlassesInput(const INPUT_EVENT& event);
+
+    // 立即检查一次分辨率,并在之后几秒内继续每秒检查
+    void RestartResolutionCheck();
     
     // 创建主窗口
     bool CreateMainWindow();
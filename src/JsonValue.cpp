@@ -0,0 +1,484 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#include "JsonValue.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+//嵌套层数上限,避免恶意或损坏的输入耗尽栈
+static constexpr int MAX_DEPTH = 64;
+
+/**
+ * 递归下降解析器
+ */
+class JsonParser {
+public:
+    explicit JsonParser(const std::string &text) : text(text) {
+    }
+
+    bool parseDocument(JsonValue &out) {
+        skipSpace();
+        if (!parseValue(out, 0)) {
+            return false;
+        }
+        skipSpace();
+        if (position != text.size()) {
+            return fail("多余的内容");
+        }
+        return true;
+    }
+
+    std::string error;
+
+private:
+    const std::string &text;
+    size_t position = 0;
+
+    bool fail(const char *reason) {
+        error = std::string(reason) + " (位置 " + std::to_string(position) + ")";
+        return false;
+    }
+
+    void skipSpace() {
+        while (position < text.size() &&
+               (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+            position++;
+        }
+    }
+
+    bool consume(const char *literal) {
+        size_t length = 0;
+        while (literal[length]) {
+            length++;
+        }
+        if (text.compare(position, length, literal) != 0) {
+            return false;
+        }
+        position += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue &out, const int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("嵌套太深");
+        }
+        if (position >= text.size()) {
+            return fail("意外的结尾");
+        }
+        const char c = text[position];
+        if (c == '{') {
+            return parseObject(out, depth);
+        }
+        if (c == '[') {
+            return parseArray(out, depth);
+        }
+        if (c == '"') {
+            std::string value;
+            if (!parseString(value)) {
+                return false;
+            }
+            out = JsonValue(std::move(value));
+            return true;
+        }
+        if (consume("true")) {
+            out = JsonValue(true);
+            return true;
+        }
+        if (consume("false")) {
+            out = JsonValue(false);
+            return true;
+        }
+        if (consume("null")) {
+            out = JsonValue();
+            return true;
+        }
+        return parseNumber(out);
+    }
+
+    bool parseNumber(JsonValue &out) {
+        const char *start = text.c_str() + position;
+        char *end = nullptr;
+        const double value = std::strtod(start, &end);
+        if (end == start || !std::isfinite(value)) {
+            return fail("无效的值");
+        }
+        position += static_cast<size_t>(end - start);
+        out = JsonValue(value);
+        return true;
+    }
+
+    static void appendUtf8(std::string &out, const uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(uint32_t &out) {
+        if (position + 4 > text.size()) {
+            return fail("无效的\\u转义");
+        }
+        out = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = text[position++];
+            out <<= 4;
+            if (c >= '0' && c <= '9') {
+                out |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                out |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                out |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return fail("无效的\\u转义");
+            }
+        }
+        return true;
+    }
+
+    bool parseString(std::string &out) {
+        position++; // 开头的引号
+        while (position < text.size()) {
+            const char c = text[position++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (position >= text.size()) {
+                break;
+            }
+            const char escaped = text[position++];
+            switch (escaped) {
+                case '"':
+                case '\\':
+                case '/':
+                    out += escaped;
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u': {
+                    uint32_t codePoint = 0;
+                    if (!parseHex4(codePoint)) {
+                        return false;
+                    }
+                    // 代理对
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF && consume("\\u")) {
+                        uint32_t low = 0;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        if (low >= 0xDC00 && low <= 0xDFFF) {
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            appendUtf8(out, 0xFFFD);
+                            codePoint = low;
+                        }
+                    } else if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                        codePoint = 0xFFFD;
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return fail("无效的转义");
+            }
+        }
+        return fail("字符串没有结束");
+    }
+
+    bool parseArray(JsonValue &out, const int depth) {
+        position++;
+        out = JsonValue::array();
+        skipSpace();
+        if (position < text.size() && text[position] == ']') {
+            position++;
+            return true;
+        }
+        while (true) {
+            JsonValue item;
+            skipSpace();
+            if (!parseValue(item, depth + 1)) {
+                return false;
+            }
+            out.push(std::move(item));
+            skipSpace();
+            if (position < text.size() && text[position] == ',') {
+                position++;
+                continue;
+            }
+            if (position < text.size() && text[position] == ']') {
+                position++;
+                return true;
+            }
+            return fail("数组中缺少,或]");
+        }
+    }
+
+    bool parseObject(JsonValue &out, const int depth) {
+        position++;
+        out = JsonValue::object();
+        skipSpace();
+        if (position < text.size() && text[position] == '}') {
+            position++;
+            return true;
+        }
+        while (true) {
+            skipSpace();
+            if (position >= text.size() || text[position] != '"') {
+                return fail("对象的键必须是字符串");
+            }
+            std::string key;
+            if (!parseString(key)) {
+                return false;
+            }
+            skipSpace();
+            if (position >= text.size() || text[position] != ':') {
+                return fail("对象中缺少:");
+            }
+            position++;
+            skipSpace();
+            JsonValue value;
+            if (!parseValue(value, depth + 1)) {
+                return false;
+            }
+            out.set(key, std::move(value));
+            skipSpace();
+            if (position < text.size() && text[position] == ',') {
+                position++;
+                continue;
+            }
+            if (position < text.size() && text[position] == '}') {
+                position++;
+                return true;
+            }
+            return fail("对象中缺少,或}");
+        }
+    }
+};
+
+JsonValue JsonValue::array() {
+    JsonValue value;
+    value.valueType = Type::ARRAY;
+    return value;
+}
+
+JsonValue JsonValue::object() {
+    JsonValue value;
+    value.valueType = Type::OBJECT;
+    return value;
+}
+
+const JsonValue &JsonValue::operator[](const std::string &key) const {
+    static const JsonValue null;
+    for (const auto &member: objectMembers) {
+        if (member.first == key) {
+            return member.second;
+        }
+    }
+    return null;
+}
+
+bool JsonValue::has(const std::string &key) const {
+    for (const auto &member: objectMembers) {
+        if (member.first == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+JsonValue &JsonValue::set(const std::string &key, JsonValue value) {
+    valueType = Type::OBJECT;
+    for (auto &member: objectMembers) {
+        if (member.first == key) {
+            member.second = std::move(value);
+            return *this;
+        }
+    }
+    objectMembers.emplace_back(key, std::move(value));
+    return *this;
+}
+
+JsonValue &JsonValue::push(JsonValue value) {
+    valueType = Type::ARRAY;
+    arrayItems.push_back(std::move(value));
+    return *this;
+}
+
+std::string JsonValue::dump() const {
+    std::string out;
+    dumpTo(out);
+    return out;
+}
+
+void JsonValue::dumpTo(std::string &out) const {
+    switch (valueType) {
+        case Type::NUL:
+            out += "null";
+            break;
+        case Type::BOOL:
+            out += boolValue ? "true" : "false";
+            break;
+        case Type::NUMBER: {
+            if (!std::isfinite(numberValue)) {
+                out += "null";
+                break;
+            }
+            char text[32];
+            // 整数不带小数点,其余保留足够的有效数字
+            if (numberValue == std::floor(numberValue) && std::fabs(numberValue) < 1e15) {
+                snprintf(text, sizeof(text), "%.0f", numberValue);
+            } else {
+                snprintf(text, sizeof(text), "%.9g", numberValue);
+            }
+            out += text;
+            break;
+        }
+        case Type::STRING:
+            appendString(out, stringValue);
+            break;
+        case Type::ARRAY:
+            out += '[';
+            for (size_t i = 0; i < arrayItems.size(); i++) {
+                if (i > 0) {
+                    out += ',';
+                }
+                arrayItems[i].dumpTo(out);
+            }
+            out += ']';
+            break;
+        case Type::OBJECT:
+            out += '{';
+            for (size_t i = 0; i < objectMembers.size(); i++) {
+                if (i > 0) {
+                    out += ',';
+                }
+                appendString(out, objectMembers[i].first);
+                out += ':';
+                objectMembers[i].second.dumpTo(out);
+            }
+            out += '}';
+            break;
+    }
+}
+
+bool JsonValue::parse(const std::string &text, JsonValue &out, std::string &error) {
+    JsonParser parser(text);
+    if (!parser.parseDocument(out)) {
+        error = parser.error;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * text[i]开始的UTF-8字符的字节数(RFC 3629: 不接受过长编码、代理区和超过U+10FFFF的码点)
+ * @return - 不是有效的字符时为0
+ */
+static size_t utf8SequenceLength(const std::string &text, const size_t i) {
+    const auto byte = [&text](const size_t index) {
+        return static_cast<unsigned char>(text[index]);
+    };
+    const unsigned char c = byte(i);
+    size_t length;
+    unsigned char low = 0x80, high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        low = c == 0xE0 ? 0xA0 : 0x80;
+        high = c == 0xED ? 0x9F : 0xBF;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        low = c == 0xF0 ? 0x90 : 0x80;
+        high = c == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+    if (i + length > text.size() || byte(i + 1) < low || byte(i + 1) > high) {
+        return 0;
+    }
+    for (size_t k = 2; k < length; k++) {
+        if ((byte(i + k) & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+void JsonValue::appendString(std::string &out, const std::string &text) {
+    static const char *digits = "0123456789abcdef";
+    out += '"';
+    for (size_t i = 0; i < text.size(); i++) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += digits[c >> 4];
+                    out += digits[c & 0xF];
+                } else if (c < 0x80) {
+                    out += static_cast<char>(c);
+                } else if (const size_t length = utf8SequenceLength(text, i)) {
+                    if (length == 3 && c == 0xE2 && static_cast<unsigned char>(text[i + 1]) == 0x80 &&
+                        (static_cast<unsigned char>(text[i + 2]) == 0xA8 ||
+                         static_cast<unsigned char>(text[i + 2]) == 0xA9)) {
+                        // U+2028/U+2029在JSON中合法,但在较旧的JavaScript引擎中会结束脚本中的字符串
+                        out += static_cast<unsigned char>(text[i + 2]) == 0xA8 ? "\\u2028" : "\\u2029";
+                    } else {
+                        out.append(text, i, length);
+                    }
+                    i += length - 1;
+                } else {
+                    // 无效的字节(例如截断的多字节字符)换成U+FFFD,否则整段脚本无法按UTF-8解码
+                    out += "\xEF\xBF\xBD";
+                }
+                break;
+        }
+    }
+    out += '"';
+}
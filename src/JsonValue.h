@@ -0,0 +1,146 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#ifndef JSONVALUE_H
+#define JSONVALUE_H
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * 简单的JSON值,用于与页面之间的RPC
+ * 只支持RPC需要的部分: 数字统一为double,对象按插入顺序保存成员(成员很少,线性查找).
+ */
+class JsonValue {
+public:
+    enum class Type {
+        NUL,
+        BOOL,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    JsonValue() = default;
+
+    JsonValue(bool value) : valueType(Type::BOOL), boolValue(value) {
+    }
+
+    template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+    JsonValue(T value) : valueType(Type::NUMBER), numberValue(static_cast<double>(value)) {
+    }
+
+    JsonValue(const char *value) : valueType(Type::STRING), stringValue(value ? value : "") {
+    }
+
+    JsonValue(std::string value) : valueType(Type::STRING), stringValue(std::move(value)) {
+    }
+
+    static JsonValue array();
+
+    static JsonValue object();
+
+    Type type() const {
+        return valueType;
+    }
+
+    bool isNull() const {
+        return valueType == Type::NUL;
+    }
+
+    bool isBool() const {
+        return valueType == Type::BOOL;
+    }
+
+    bool isNumber() const {
+        return valueType == Type::NUMBER;
+    }
+
+    bool isString() const {
+        return valueType == Type::STRING;
+    }
+
+    bool isArray() const {
+        return valueType == Type::ARRAY;
+    }
+
+    bool isObject() const {
+        return valueType == Type::OBJECT;
+    }
+
+    bool asBool(const bool fallback = false) const {
+        return valueType == Type::BOOL ? boolValue : fallback;
+    }
+
+    double asNumber(const double fallback = 0) const {
+        return valueType == Type::NUMBER ? numberValue : fallback;
+    }
+
+    const std::string &asString() const {
+        return stringValue;
+    }
+
+    const std::vector<JsonValue> &items() const {
+        return arrayItems;
+    }
+
+    const std::vector<std::pair<std::string, JsonValue>> &members() const {
+        return objectMembers;
+    }
+
+    /**
+     * 对象的成员
+     * @return - 不是对象或没有这个成员时为null
+     */
+    const JsonValue &operator[](const std::string &key) const;
+
+    bool has(const std::string &key) const;
+
+    /**
+     * 设置对象的成员(已有时替换)
+     * @return - 自身,便于连续设置
+     */
+    JsonValue &set(const std::string &key, JsonValue value);
+
+    /**
+     * 追加数组元素
+     */
+    JsonValue &push(JsonValue value);
+
+    /**
+     * 编码为JSON文本
+     */
+    std::string dump() const;
+
+    void dumpTo(std::string &out) const;
+
+    /**
+     * 解析JSON文本
+     * @param text - UTF-8文本
+     * @param out - 解析结果
+     * @param error - 失败时的原因
+     * @return - 是否成功
+     */
+    static bool parse(const std::string &text, JsonValue &out, std::string &error);
+
+    /**
+     * 把文本编码为JSON字符串追加到out(包括引号),输入为UTF-8
+     * U+2028/U+2029也被转义,无效的UTF-8字节换成U+FFFD,编码结果总是有效的UTF-8,可以直接嵌入脚本
+     */
+    static void appendString(std::string &out, const std::string &text);
+
+private:
+    Type valueType = Type::NUL;
+    bool boolValue = false;
+    double numberValue = 0;
+    std::string stringValue;
+    std::vector<JsonValue> arrayItems;
+    std::vector<std::pair<std::string, JsonValue>> objectMembers;
+};
+
+
+#endif //JSONVALUE_H
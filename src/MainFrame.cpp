@@ -19,6 +19,11 @@
 #include <wx/sharedptr.h> // Add for wxSharedPtr
 // --- End Add Headers ---
 
+#include "RpcSchema.h"
+#include "XRealGlassesController/Index.h"
+#include "XRealGlassesController/Logger.h"
+#include "XRealGlassesController/Utils.h"
+
 enum {
     ID_LoadTimer = wxID_HIGHEST + 1,
     ID_ReloadDevServerTimer // Add new timer ID
@@ -40,6 +45,13 @@ public:
     // This method is called by wxWebView when it encounters our scheme
     virtual wxFSFile* GetFile(const wxString& uri) override
     {
+        static MetricCounter &served = Metrics::counter("xreal_assets_total", "页面从应用包中读取的资源",
+                                                        {{"result", "served"}});
+        static MetricCounter &missing = Metrics::counter("xreal_assets_total", "页面从应用包中读取的资源",
+                                                         {{"result", "not_found"}});
+        static MetricCounter &servedBytes = Metrics::counter("xreal_asset_bytes_total", "页面从应用包中读取的字节数");
+        static MetricHistogram &openTime = Metrics::histogram("xreal_asset_open_seconds", "查找并打开资源文件的耗时");
+        const uint64_t startNs = Utils::steadyNowNs();
         fprintf(stderr, "[HANDLER DEBUG] AppBundleFSHandler::GetFile called for URI: %s\n", (const char*)uri.ToUTF8());
 
         // 1. Extract the relative path from the URI using the stored scheme
@@ -79,6 +91,7 @@ public:
         // 4. Check if the file exists
         if (!filePath.FileExists()) { 
             fprintf(stderr, "[HANDLER WARNING]   File NOT found: %s\n", (const char*)fullPath.ToUTF8());
+            missing.add();
             return nullptr;
         }
         fprintf(stderr, "[HANDLER DEBUG]   File exists: %s\n", (const char*)fullPath.ToUTF8());
@@ -111,6 +124,10 @@ public:
 
         fprintf(stderr, "[HANDLER INFO] Serving file: %s (MIME: %s) for URI: %s\n", (const char*)fullPath.ToUTF8(), (const char*)mimeType.ToUTF8(), (const char*)uri.ToUTF8());
 
+        served.add();
+        servedBytes.add(static_cast<uint64_t>(stream->GetLength()));
+        openTime.record(Utils::steadyNowNs() - startNs);
+
         // Correct the wxFSFile constructor call arguments (again)
         return new wxFSFile(stream,                    // 1. Stream
                             uri,                       // 2. Location (URI)
@@ -124,9 +141,11 @@ public:
 wxBEGIN_EVENT_TABLE(MainFrame, wxFrame)
     EVT_CLOSE(MainFrame::OnClose)
     EVT_TIMER(ID_LoadTimer, MainFrame::OnTimerLoad)
+    EVT_WEBVIEW_NAVIGATING(wxID_ANY, MainFrame::OnWebViewNavigating)
     EVT_WEBVIEW_NAVIGATED(wxID_ANY, MainFrame::OnWebViewNavigated)
     EVT_WEBVIEW_LOADED(wxID_ANY, MainFrame::OnWebViewLoaded)
     EVT_WEBVIEW_ERROR(wxID_ANY, MainFrame::OnWebViewError)
+    EVT_WEBVIEW_SCRIPT_MESSAGE_RECEIVED(wxID_ANY, MainFrame::OnScriptMessage)
     EVT_MENU(wxID_EXIT, MainFrame::OnQuit)
     EVT_CHAR_HOOK(MainFrame::OnCharHook)
     EVT_KEY_DOWN(MainFrame::OnKeyDown)
@@ -186,6 +205,29 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
 
         // 注册自定义文件系统处理器
         webView->RegisterHandler(wxSharedPtr<wxWebViewHandler>(new AppBundleFSHandler("wxfs")));
+
+        m_bridge = std::make_unique<WebViewBridge>(webView);
+
+        // 页面调用C++的RPC: 请求经由脚本消息处理器xrealRpc发来,在RPC的工作线程中处理,
+        // 响应经由消息通道的rpc通道按帧发回(不可丢弃,否则页面的调用永远等不到结果)
+        m_rpc = std::make_unique<RpcServer>([this](const std::string& response) {
+            m_bridge->post("rpc", response, false);
+        });
+        // 头部姿态在每帧发出前一刻预测到出光时间,经由pose通道(只保留最新值)发给页面
+        m_poseStreamer = std::make_unique<PoseStreamer>(&Index::predictOrientation);
+        m_poseProducer = m_bridge->addFrameProducer([this](WebViewBridge& bridge, uint64_t frameNs) {
+            std::string packet;
+            if (m_poseStreamer->makePacket(frameNs, packet)) {
+                bridge.postLatest("pose", packet);
+            }
+        });
+
+        RegisterRpcMethods();
+        m_rpc->start();
+        m_metricsCollector = Metrics::addCollector([this](Metrics::Writer& writer) { CollectMetrics(writer); });
+        if (!webView->AddScriptMessageHandler("xrealRpc")) {
+            fprintf(stderr, "[警告] 无法注册脚本消息处理器xrealRpc，页面将无法调用C++\n");
+        }
         
         // 使用伸展性sizer确保WebView填满整个窗口
         wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
@@ -199,6 +241,11 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
         // 记录WebView初始尺寸
         fprintf(stderr, "WebView初始尺寸: %dx%d\n", 
                 webView->GetSize().GetWidth(), webView->GetSize().GetHeight());
+
+        // 警告和错误同时显示在页面的日志中;回调在日志线程中执行,消息通道负责转到界面线程
+        m_logSink = Logger::addSink(LogLevel::WARNING, [this](LogLevel level, uint64_t, const std::string& message) {
+            m_bridge->postText("log", (level == LogLevel::ERROR ? "[ERROR] " : "[WARNING] ") + message);
+        });
     } else {
         fprintf(stderr, "[错误] 无法创建wxWebView后端\n");
     }
@@ -234,11 +281,42 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
 }
 
 MainFrame::~MainFrame() {
+    if (m_metricsCollector) {
+        // 收集函数读取下面要停止/销毁的对象,最先删除
+        Metrics::removeCollector(m_metricsCollector);
+        m_metricsCollector = 0;
+    }
+    // 先停止RPC的工作线程,它会向m_bridge投递响应(断开眼镜时可能已经停止过)
+    StopRpc();
+    if (m_poseProducer) {
+        m_bridge->removeFrameProducer(m_poseProducer);
+        m_poseProducer = 0;
+        const PoseStreamer::Stats stats = m_poseStreamer->stats();
+        Logger::info("头部姿态: 发出 %llu, 没有新样本 %llu, 没有数据 %llu, 样本时长 p50 %.1fms p99 %.1fms, 生成耗时 p99 %.1fus",
+                     stats.packets, stats.repeated, stats.unavailable,
+                     stats.sample_age.percentile(0.5) / 1e6, stats.sample_age.percentile(0.99) / 1e6,
+                     stats.encode.percentile(0.99) / 1e3);
+    }
+    if (m_logSink) {
+        Logger::removeSink(m_logSink);
+        m_logSink = 0;
+    }
+    if (m_bridge) {
+        const WebViewBridge::Stats stats = m_bridge->stats();
+        Logger::info("页面消息: 投递 %llu, 发出 %llu (%llu批, %lluKB), 合并 %llu, 丢弃 %llu, 每批耗时 p50 %.1fus p99 %.1fus",
+                     stats.messages.posted, stats.messages.delivered, stats.messages.batches,
+                     stats.messages.bytes / 1024, stats.messages.coalesced, stats.messages.dropped,
+                     stats.script_cost.percentile(0.5) / 1e3, stats.script_cost.percentile(0.99) / 1e3);
+    }
     if (m_loadTimer.IsRunning()) {
         m_loadTimer.Stop();
     }
 }
 
+void MainFrame::SetDisplayModeChangedHandler(std::function<void()> handler) {
+    m_displayModeChangedHandler = std::move(handler);
+}
+
 void MainFrame::PrepareLoadUrl(const wxString& url) {
     m_urlToLoad = url;
     if (m_urlToLoad == "http://localhost:5173") {
@@ -277,6 +355,15 @@ void MainFrame::OnTimerLoad(wxTimerEvent& event) {
     #endif
 }
 
+void MainFrame::OnWebViewNavigating(wxWebViewEvent& event) {
+    m_navigatingNs = Utils::steadyNowNs();
+    // 新页面加载完成之前不执行脚本,消息先留在队列中
+    if (m_bridge) {
+        m_bridge->setReady(false);
+    }
+    event.Skip();
+}
+
 void MainFrame::OnWebViewNavigated(wxWebViewEvent& event) {
     // Corrected fprintf (newline inside quotes)
     fprintf(stderr, "[信息] WebView 导航: URL='%s', Target='%s'\n",
@@ -288,7 +375,17 @@ void MainFrame::OnWebViewLoaded(wxWebViewEvent& event) {
     fprintf(stderr, "[信息] WebView 加载完成: URL='%s', Target='%s'\n",
             (const char*)event.GetURL().ToUTF8(),
             (const char*)event.GetTarget().ToUTF8());
+
+    static MetricHistogram &loadTime = Metrics::histogram("xreal_page_load_seconds", "页面从开始导航到加载完成的耗时");
+    if (m_navigatingNs) {
+        loadTime.record(Utils::steadyNowNs() - m_navigatingNs);
+        m_navigatingNs = 0;
+    }
     
+    if (m_bridge) {
+        m_bridge->setReady(true);
+    }
+
     // 设置控件位置（填充整个窗口）
     if (webView) {
         wxSize clientSize = GetClientSize();
@@ -348,6 +445,112 @@ void MainFrame::OnWebViewError(wxWebViewEvent& event) {
     }
 }
 
+void MainFrame::OnScriptMessage(wxWebViewEvent& event) {
+    // 只解析和入队,处理函数在RPC的工作线程中执行
+    if (m_rpc && event.GetMessageHandler() == "xrealRpc") {
+        const wxScopedCharBuffer utf8 = event.GetString().ToUTF8();
+        m_rpc->receive(std::string(utf8.data(), utf8.length()));
+    }
+}
+
+void MainFrame::StopRpc() {
+    if (!m_rpc || m_rpcStopped) {
+        return;
+    }
+    m_rpcStopped = true;
+    m_rpc->stop();
+    const RpcServer::Stats stats = m_rpc->stats();
+    Logger::info("页面RPC: 请求 %llu, 成功 %llu, 失败 %llu, 拒绝 %llu, 超时 %llu, 处理耗时 p50 %.1fus p99 %.1fus",
+                 stats.requests, stats.completed, stats.failed, stats.rejected, stats.expired,
+                 stats.handler_time.percentile(0.5) / 1e3, stats.handler_time.percentile(0.99) / 1e3);
+}
+
+void MainFrame::RegisterRpcMethods() {
+    // 以下处理函数都在RPC的工作线程中按顺序执行;Index的访问函数在使用期间持有对象的引用,
+    // 断开眼镜之前先调用StopRpc,处理函数不会与断开同时进行
+    m_rpc->registerMethod<RpcSchema::NoParams, RpcSchema::DeviceInfo>("device.info",
+        [](const RpcSchema::NoParams&, RpcSchema::DeviceInfo& result, std::string&) {
+            ORIENTATION orientation;
+            result.connected = Index::isConnected();
+            result.serial_number = Index::serialNumber();
+            result.imu = Index::imuSamples() != nullptr;
+            result.orientation = Index::latestOrientation(orientation);
+            return true;
+        });
+
+    // 等待眼镜应答期间(最多1秒)不占用工作线程,应答在反应器线程中回复
+    using SwitchModeReply = std::function<void(bool, const RpcSchema::SwitchModeResult&, const std::string&)>;
+    m_rpc->registerAsyncMethod<RpcSchema::SwitchModeParams, RpcSchema::SwitchModeResult>("device.switchMode",
+        [this](const RpcSchema::SwitchModeParams& params, SwitchModeReply reply) {
+            if (!Index::isConnected()) {
+                reply(false, RpcSchema::SwitchModeResult(), "眼镜未连接");
+                return;
+            }
+            Index::switchModeAsync(params.mode3D, [this, reply](Index::SwitchResult switched) {
+                RpcSchema::SwitchModeResult result;
+                result.switched = switched != Index::SwitchResult::FAILED;
+                result.confirmed = switched == Index::SwitchResult::CONFIRMED;
+                if (result.switched) {
+                    // 分辨率随之变化,转到主线程重新检查(StopRpc等到回复之后才返回,窗口此时仍然存在)
+                    CallAfter([this]() {
+                        if (m_displayModeChangedHandler) {
+                            m_displayModeChangedHandler();
+                        }
+                    });
+                }
+                reply(true, result, std::string());
+            });
+        });
+
+    m_rpc->registerMethod<RpcSchema::NoParams, RpcSchema::DeviceStats>("device.stats",
+        [this](const RpcSchema::NoParams&, RpcSchema::DeviceStats& result, std::string&) {
+            result.streams = Index::streamHealth();
+            result.has_imu_latency = Index::imuLatency(result.imu_latency);
+            const WebViewBridge::Stats bridgeStats = m_bridge->stats();
+            result.bridge = bridgeStats.messages;
+            result.bridge_script_cost = bridgeStats.script_cost;
+            result.log = Logger::stats();
+            result.rpc = m_rpc->stats();
+            result.pose = m_poseStreamer->stats();
+            return true;
+        });
+}
+
+void MainFrame::CollectMetrics(Metrics::Writer& writer) {
+    const WebViewBridge::Stats bridge = m_bridge->stats();
+    writer.counter("xreal_bridge_messages_total", "发往页面的消息", {{"state", "posted"}}, bridge.messages.posted);
+    writer.counter("xreal_bridge_messages_total", "发往页面的消息", {{"state", "delivered"}},
+                   bridge.messages.delivered);
+    writer.counter("xreal_bridge_messages_total", "发往页面的消息", {{"state", "coalesced"}},
+                   bridge.messages.coalesced);
+    writer.counter("xreal_bridge_messages_total", "发往页面的消息", {{"state", "dropped"}}, bridge.messages.dropped);
+    writer.counter("xreal_bridge_batches_total", "发往页面的批数", {}, bridge.messages.batches);
+    writer.counter("xreal_bridge_bytes_total", "发往页面的JSON字节数", {}, bridge.messages.bytes);
+    writer.gauge("xreal_bridge_queued", "等待发往页面的消息", {}, static_cast<double>(bridge.messages.queued));
+    writer.histogram("xreal_bridge_flush_seconds", "每批在界面线程中的耗时", {}, bridge.script_cost);
+
+    const RpcServer::Stats rpc = m_rpc->stats();
+    writer.counter("xreal_rpc_requests_total", "页面发来的RPC请求", {{"result", "completed"}}, rpc.completed);
+    writer.counter("xreal_rpc_requests_total", "页面发来的RPC请求", {{"result", "failed"}}, rpc.failed);
+    writer.counter("xreal_rpc_requests_total", "页面发来的RPC请求", {{"result", "rejected"}}, rpc.rejected);
+    writer.counter("xreal_rpc_requests_total", "页面发来的RPC请求", {{"result", "expired"}}, rpc.expired);
+    writer.counter("xreal_rpc_malformed_total", "无法解析的RPC消息", {}, rpc.malformed);
+    writer.gauge("xreal_rpc_pending", "排队中的RPC请求", {}, static_cast<double>(rpc.pending));
+    writer.histogram("xreal_rpc_queue_seconds", "RPC请求排队的时间", {}, rpc.queue_time);
+    writer.histogram("xreal_rpc_handler_seconds", "RPC方法的执行时间", {}, rpc.handler_time);
+
+    const PoseStreamer::Stats pose = m_poseStreamer->stats();
+    writer.counter("xreal_pose_frames_total", "生成头部姿态包的帧", {{"result", "fresh"}}, pose.packets - pose.repeated);
+    writer.counter("xreal_pose_frames_total", "生成头部姿态包的帧", {{"result", "repeated"}}, pose.repeated);
+    writer.counter("xreal_pose_frames_total", "生成头部姿态包的帧", {{"result", "unavailable"}}, pose.unavailable);
+    writer.histogram("xreal_pose_sample_age_seconds", "最后一条参与融合的样本到发出的时间", {}, pose.sample_age);
+    writer.histogram("xreal_pose_encode_seconds", "头部姿态预测+编码的耗时", {}, pose.encode);
+
+    const Logger::Stats log = Logger::stats();
+    writer.counter("xreal_log_lines_total", "日志条数", {{"result", "written"}}, log.written);
+    writer.counter("xreal_log_lines_total", "日志条数", {{"result", "dropped"}}, log.dropped);
+}
+
 // --- Add Implementations for Missing Key Handlers ---
 void MainFrame::OnCharHook(wxKeyEvent& event) {
     int keyCode = event.GetKeyCode();
@@ -400,23 +603,11 @@ void MainFrame::OnReloadDevServerTimer(wxTimerEvent& event) {
 }
 
 // --- Add LogToWebView Method --- 
+// 可以在任意线程调用;消息按帧合批发给页面(xrealBridge的log通道),不再每条消息执行一次脚本
 void MainFrame::LogToWebView(const wxString& message) {
-    if (!webView) return; // Don't try if webView isn't created
-
-    // Basic JavaScript escaping: replace backslash, single quote, and newline
-    wxString escapedMessage = message;
-    escapedMessage.Replace("\\", "\\\\"); // Escape backslashes FIRST
-    escapedMessage.Replace("'", "\\'"); // Escape single quotes
-    escapedMessage.Replace("\n", "\\n"); // Escape newlines
-    // Add more escapes if needed (e.g., double quotes)
-
-    wxString script = wxString::Format("if (typeof appendLog === 'function') { appendLog('%s'); } else { console.error('appendLog function not found'); }", escapedMessage);
-
-    // RunScript might need to be called on the main UI thread if logging from other threads
-    // For now, assuming calls are from the main thread
-    webView->RunScriptAsync(script);
-    // Use RunScriptAsync if available and appropriate to avoid blocking
-    // webView->RunScript(script); // Or synchronous version
+    if (!m_bridge) return; // Don't try if webView isn't created
+    const wxScopedCharBuffer utf8 = message.ToUTF8();
+    m_bridge->postText("log", std::string(utf8.data(), utf8.length()));
 }
 // --- End LogToWebView Method ---
 
@@ -441,6 +632,10 @@ void MainFrame::OnSize(wxSizeEvent& event) {
     if (webView) {
         webView->SetSize(0, 0, size.GetWidth(), size.GetHeight());
     }
+    // 全屏窗口的大小变化通常是显示模式切换(2D/3D的刷新率不同),消息按新的帧间隔发送
+    if (m_bridge) {
+        m_bridge->updateFrameInterval();
+    }
     
     // 调用默认处理
     event.Skip();
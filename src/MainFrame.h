@@ -4,6 +4,14 @@
 #include <wx/webview.h>
 #include <wx/timer.h>
 
+#include <functional>
+#include <memory>
+
+#include "PoseStreamer.h"
+#include "RpcServer.h"
+#include "WebViewBridge.h"
+#include "XRealGlassesController/Metrics.h"
+
 class MainFrame : public wxFrame {
 public:
     MainFrame(const wxString& title, const wxPoint& pos, const wxSize& size);
@@ -11,18 +19,42 @@ public:
 
     void PrepareLoadUrl(const wxString& url);
 
+    // 页面通过RPC切换了眼镜的显示模式之后(主线程中)调用,用于重新检查分辨率
+    void SetDisplayModeChangedHandler(std::function<void()> handler);
+
+    // 停止页面RPC的工作线程,返回时不再有处理函数在访问眼镜;断开眼镜之前调用,之后的调用以busy拒绝
+    void StopRpc();
+
 private:
     wxWebView* webView = nullptr;
+    // 发往页面的消息(日志等)经由它按帧合批发送
+    std::unique_ptr<WebViewBridge> m_bridge;
+    // 页面调用C++的RPC,响应经由m_bridge的rpc通道发回(在m_bridge之后声明,先于它销毁)
+    std::unique_ptr<RpcServer> m_rpc;
+    // StopRpc已经执行过(断开眼镜前或析构时)
+    bool m_rpcStopped = false;
+    std::function<void()> m_displayModeChangedHandler;
+    // 每帧生成头部姿态包,由m_bridge的帧生产者发出
+    std::unique_ptr<PoseStreamer> m_poseStreamer;
+    uint64_t m_poseProducer = 0;
     wxTimer m_loadTimer;
     wxTimer m_reloadDevServerTimer;
     wxString m_urlToLoad;
     bool m_devServerAttempted = false;
+    // 把警告/错误日志显示到页面的日志输出ID
+    uint64_t m_logSink = 0;
+    // 消息通道/RPC/头部姿态指标的收集函数ID(见Metrics)
+    uint64_t m_metricsCollector = 0;
+    // 页面开始加载的时间(steady_clock纳秒),用于统计加载耗时
+    uint64_t m_navigatingNs = 0;
 
     void OnClose(wxCloseEvent& event);
     void OnTimerLoad(wxTimerEvent& event);
+    void OnWebViewNavigating(wxWebViewEvent& event);
     void OnWebViewNavigated(wxWebViewEvent& event);
     void OnWebViewLoaded(wxWebViewEvent& event);
     void OnWebViewError(wxWebViewEvent& event);
+    void OnScriptMessage(wxWebViewEvent& event);
     void OnQuit(wxCommandEvent& event);
     void OnReloadDevServerTimer(wxTimerEvent& event);
 
@@ -33,5 +65,11 @@ private:
 
     void LogToWebView(const wxString& message);
 
+    // 注册页面可以调用的RPC方法
+    void RegisterRpcMethods();
+
+    // 在取指标快照的线程中读出消息通道/RPC/头部姿态/日志的统计
+    void CollectMetrics(Metrics::Writer& writer);
+
     wxDECLARE_EVENT_TABLE();
 }; 
\ No newline at end of file
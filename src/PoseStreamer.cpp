@@ -0,0 +1,66 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#include "PoseStreamer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "XRealGlassesController/Utils.h"
+
+PoseStreamer::PoseStreamer(Source source) : PoseStreamer(std::move(source), Config()) {
+}
+
+PoseStreamer::PoseStreamer(Source source, const Config &config) : source(std::move(source)), config(config) {
+    if (const char *configured = std::getenv("XREAL_POSE_PREDICTION_MS")) {
+        const double ms = std::atof(configured);
+        if (ms >= 0 && ms <= 200) {
+            this->config.prediction_ns = static_cast<uint64_t>(ms * 1e6);
+        }
+    }
+}
+
+bool PoseStreamer::makePacket(const uint64_t frameNs, std::string &out) {
+    const uint64_t photonNs = frameNs + config.prediction_ns;
+    ORIENTATION pose;
+    if (!source(photonNs, pose) || pose.sample_sequence == 0) {
+        unavailable.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (pose.sample_sequence == lastSampleSequence) {
+        repeated.fetch_add(1, std::memory_order_relaxed);
+    }
+    lastSampleSequence = pose.sample_sequence;
+    const uint64_t ageNs = frameNs > pose.host_timestamp_ns ? frameNs - pose.host_timestamp_ns : 0;
+    sampleAge.record(ageNs);
+
+    // steady_clock换算到系统时钟,页面用同一个时钟计算延迟
+    const double wallNowMs = std::chrono::duration<double, std::milli>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const double publishMs = wallNowMs - static_cast<double>(Utils::steadyNowNs() - frameNs) / 1e6;
+
+    char packet[320];
+    const int length = snprintf(packet, sizeof(packet),
+                                "[%d,%llu,%.3f,%.3f,%.7f,%.7f,%.7f,%.7f,%.6f,%.6f,%.6f,%.3f]",
+                                PACKET_VERSION, static_cast<unsigned long long>(++sequence),
+                                publishMs, publishMs + static_cast<double>(config.prediction_ns) / 1e6,
+                                pose.quaternion[0], pose.quaternion[1], pose.quaternion[2], pose.quaternion[3],
+                                pose.angular_velocity[0], pose.angular_velocity[1], pose.angular_velocity[2],
+                                static_cast<double>(ageNs) / 1e6);
+    out.assign(packet, length > 0 ? static_cast<size_t>(length) : 0);
+    packets.fetch_add(1, std::memory_order_relaxed);
+    encodeCost.record(Utils::steadyNowNs() - frameNs);
+    return true;
+}
+
+PoseStreamer::Stats PoseStreamer::stats() const {
+    Stats result;
+    result.packets = packets.load(std::memory_order_relaxed);
+    result.repeated = repeated.load(std::memory_order_relaxed);
+    result.unavailable = unavailable.load(std::memory_order_relaxed);
+    result.sample_age = sampleAge.snapshot();
+    result.encode = encodeCost.snapshot();
+    return result;
+}
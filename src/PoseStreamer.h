@@ -0,0 +1,90 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#ifndef POSESTREAMER_H
+#define POSESTREAMER_H
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "XRealGlassesController/LatencyHistogram.h"
+#include "XRealGlassesController/ORIENTATION.h"
+
+
+/**
+ * 每个显示帧生成一个头部姿态包,经由WebViewBridge的pose通道(只保留最新值)发给页面
+ * 包在这一帧发出前一刻生成,朝向预测到预计的出光时间.包是定长的数字数组,页面按下标读取:
+ *   [0] 版本(1)
+ *   [1] 序号
+ *   [2] 发出时间(系统时钟,毫秒,含小数),与页面的 performance.timeOrigin + performance.now() 同一个时钟
+ *   [3] 朝向预测到的时间(系统时钟,毫秒)
+ *   [4..7] 预测的朝向四元数 w, x, y, z(IMU坐标系到世界坐标系,见ORIENTATION.h)
+ *   [8..10] 角速度 x, y, z(弧度/秒,IMU坐标系),页面可以据此再外推到实际渲染的时间
+ *   [11] 最后一条参与融合的样本到发出时的时间(毫秒)
+ * 页面的解析见 web/src/bridge/pose.ts,修改时两边一起改.
+ * 不依赖wxWidgets.
+ */
+class PoseStreamer {
+public:
+    static constexpr int PACKET_VERSION = 1;
+
+    struct Config {
+        //从发出到出光的预计时间(脚本执行+等待下一次requestAnimationFrame+渲染+扫描输出),
+        //可以用环境变量XREAL_POSE_PREDICTION_MS覆盖
+        uint64_t prediction_ns = 25000000;
+    };
+
+    struct Stats {
+        //生成的包数
+        uint64_t packets = 0;
+        //与上一个包相比没有新样本的包数(只是预测得更远)
+        uint64_t repeated = 0;
+        //没有朝向数据、没有生成包的帧数
+        uint64_t unavailable = 0;
+        //最后一条参与融合的样本到发出的时间
+        LatencyHistogram::Snapshot sample_age;
+        //预测+编码的耗时
+        LatencyHistogram::Snapshot encode;
+    };
+
+    /**
+     * 朝向来源,通常为Index::predictOrientation
+     * @param photonTimeNs - 预测到的时间(steady_clock纳秒)
+     * @return - 是否有朝向数据
+     */
+    using Source = std::function<bool(uint64_t photonTimeNs, ORIENTATION &out)>;
+
+    explicit PoseStreamer(Source source);
+
+    PoseStreamer(Source source, const Config &config);
+
+    PoseStreamer(const PoseStreamer&) = delete;
+    PoseStreamer& operator=(const PoseStreamer&) = delete;
+
+    /**
+     * 生成这一帧的姿态包(只在一个线程中调用,通常是界面线程)
+     * @param frameNs - 这一帧的发出时间(steady_clock纳秒)
+     * @param out - 编码后的JSON数组
+     * @return - 是否有朝向数据
+     */
+    bool makePacket(uint64_t frameNs, std::string &out);
+
+    Stats stats() const;
+
+private:
+    const Source source;
+    Config config;
+    uint64_t sequence = 0;
+    uint64_t lastSampleSequence = 0;
+    //以下计数只在调用makePacket的线程中写入
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> repeated{0};
+    std::atomic<uint64_t> unavailable{0};
+    LatencyHistogram sampleAge;
+    LatencyHistogram encodeCost;
+};
+
+
+#endif //POSESTREAMER_H
@@ -0,0 +1,122 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#include "RpcSchema.h"
+
+bool RpcSchema::NoParams::fromJson(const JsonValue &json, NoParams &, std::string &error) {
+    if (!json.isNull() && !json.isObject()) {
+        error = "参数必须是对象";
+        return false;
+    }
+    return true;
+}
+
+JsonValue RpcSchema::DeviceInfo::toJson() const {
+    JsonValue json = JsonValue::object();
+    json.set("connected", connected)
+        .set("serialNumber", serial_number)
+        .set("imu", imu)
+        .set("orientation", orientation);
+    return json;
+}
+
+bool RpcSchema::SwitchModeParams::fromJson(const JsonValue &json, SwitchModeParams &out, std::string &error) {
+    if (!json["mode3D"].isBool()) {
+        error = "缺少mode3D(布尔值)";
+        return false;
+    }
+    out.mode3D = json["mode3D"].asBool();
+    return true;
+}
+
+JsonValue RpcSchema::SwitchModeResult::toJson() const {
+    JsonValue json = JsonValue::object();
+    json.set("switched", switched).set("confirmed", confirmed);
+    return json;
+}
+
+JsonValue RpcSchema::histogramToJson(const LatencyHistogram::Snapshot &snapshot) {
+    JsonValue json = JsonValue::object();
+    json.set("count", snapshot.count)
+        .set("meanUs", snapshot.mean() / 1e3)
+        .set("p50Us", static_cast<double>(snapshot.percentile(0.5)) / 1e3)
+        .set("p99Us", static_cast<double>(snapshot.percentile(0.99)) / 1e3)
+        .set("maxUs", static_cast<double>(snapshot.max_ns) / 1e3);
+    return json;
+}
+
+JsonValue RpcSchema::DeviceStats::toJson() const {
+    JsonValue streamList = JsonValue::array();
+    for (const StreamHealth::Snapshot &stream: streams) {
+        JsonValue item = JsonValue::object();
+        item.set("interface", stream.interface_number)
+            .set("reports", stream.reports)
+            .set("imuReports", stream.imu_reports)
+            .set("mcuReports", stream.mcu_reports)
+            .set("crcFailures", stream.crc_failures)
+            .set("malformed", stream.malformed)
+            .set("readErrors", stream.read_errors)
+            .set("imuMissing", stream.imu_missing)
+            .set("imuGaps", stream.imu_gaps)
+            .set("timestampRegressions", stream.timestamp_regressions)
+            .set("sequenceMissing", stream.sequence_missing)
+            .set("rate1sHz", stream.rate_1s_hz)
+            .set("rateWindowHz", stream.rate_window_hz)
+            .set("idleMs", static_cast<double>(stream.idle_ns) / 1e6)
+            .set("arrival", histogramToJson(stream.arrival))
+            .set("handling", histogramToJson(stream.handling));
+        streamList.push(std::move(item));
+    }
+
+    JsonValue imuLatency;
+    if (has_imu_latency) {
+        imuLatency = JsonValue::object();
+        imuLatency.set("transit", histogramToJson(imu_latency.transit))
+            .set("consume", histogramToJson(imu_latency.consume));
+    }
+
+    JsonValue bridgeJson = JsonValue::object();
+    bridgeJson.set("posted", bridge.posted)
+        .set("delivered", bridge.delivered)
+        .set("coalesced", bridge.coalesced)
+        .set("dropped", bridge.dropped)
+        .set("batches", bridge.batches)
+        .set("bytes", bridge.bytes)
+        .set("queued", bridge.queued)
+        .set("highWater", bridge.high_water)
+        .set("scriptCost", histogramToJson(bridge_script_cost));
+
+    JsonValue logJson = JsonValue::object();
+    logJson.set("written", log.written)
+        .set("dropped", log.dropped)
+        .set("threads", log.threads);
+
+    JsonValue rpcJson = JsonValue::object();
+    rpcJson.set("requests", rpc.requests)
+        .set("completed", rpc.completed)
+        .set("failed", rpc.failed)
+        .set("rejected", rpc.rejected)
+        .set("expired", rpc.expired)
+        .set("malformed", rpc.malformed)
+        .set("pending", rpc.pending)
+        .set("highWater", rpc.high_water)
+        .set("queueTime", histogramToJson(rpc.queue_time))
+        .set("handlerTime", histogramToJson(rpc.handler_time));
+
+    JsonValue poseJson = JsonValue::object();
+    poseJson.set("packets", pose.packets)
+        .set("repeated", pose.repeated)
+        .set("unavailable", pose.unavailable)
+        .set("sampleAge", histogramToJson(pose.sample_age))
+        .set("encode", histogramToJson(pose.encode));
+
+    JsonValue json = JsonValue::object();
+    json.set("streams", std::move(streamList))
+        .set("imuLatency", std::move(imuLatency))
+        .set("bridge", std::move(bridgeJson))
+        .set("log", std::move(logJson))
+        .set("rpc", std::move(rpcJson))
+        .set("pose", std::move(poseJson));
+    return json;
+}
@@ -0,0 +1,92 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#ifndef RPCSCHEMA_H
+#define RPCSCHEMA_H
+#include <string>
+#include <vector>
+
+#include "JsonValue.h"
+#include "PoseStreamer.h"
+#include "RpcServer.h"
+#include "WebMessageBatcher.h"
+#include "XRealGlassesController/HeadTracker.h"
+#include "XRealGlassesController/Logger.h"
+#include "XRealGlassesController/StreamHealth.h"
+
+
+/**
+ * 页面可以调用的RPC方法的参数和返回值
+ * 与 web/src/bridge/rpc.ts 中的 RpcSchema 一一对应,修改时两边一起改.
+ * JSON中的字段名用页面的命名习惯(驼峰).
+ */
+class RpcSchema {
+public:
+    /**
+     * 没有参数的方法
+     */
+    struct NoParams {
+        static bool fromJson(const JsonValue &json, NoParams &out, std::string &error);
+    };
+
+    /**
+     * device.info
+     */
+    struct DeviceInfo {
+        bool connected = false;
+        std::string serial_number;
+        //是否有IMU数据流
+        bool imu = false;
+        //是否已经有头部朝向
+        bool orientation = false;
+
+        JsonValue toJson() const;
+    };
+
+    /**
+     * device.switchMode 的参数
+     */
+    struct SwitchModeParams {
+        bool mode3D = true;
+
+        static bool fromJson(const JsonValue &json, SwitchModeParams &out, std::string &error);
+    };
+
+    /**
+     * device.switchMode 的返回值
+     */
+    struct SwitchModeResult {
+        //命令是否已发出(设备确认或等待应答超时)
+        bool switched = false;
+        //设备是否确认了命令(为false而switched为true时,是否生效由分辨率检查来确认)
+        bool confirmed = false;
+
+        JsonValue toJson() const;
+    };
+
+    /**
+     * device.stats
+     */
+    struct DeviceStats {
+        std::vector<StreamHealth::Snapshot> streams;
+        //没有IMU数据时为false
+        bool has_imu_latency = false;
+        HeadTracker::Latency imu_latency;
+        WebMessageBatcher::Stats bridge;
+        LatencyHistogram::Snapshot bridge_script_cost;
+        Logger::Stats log;
+        RpcServer::Stats rpc;
+        PoseStreamer::Stats pose;
+
+        JsonValue toJson() const;
+    };
+
+    /**
+     * 直方图的摘要: {count, meanUs, p50Us, p99Us, maxUs}
+     */
+    static JsonValue histogramToJson(const LatencyHistogram::Snapshot &snapshot);
+};
+
+
+#endif //RPCSCHEMA_H
@@ -0,0 +1,236 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#include "RpcServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <vector>
+
+#include "XRealGlassesController/Logger.h"
+#include "XRealGlassesController/Utils.h"
+
+RpcServer::RpcServer(Responder responder) : RpcServer(std::move(responder), Config()) {
+}
+
+RpcServer::RpcServer(Responder responder, const Config &config)
+    : config(config), responder(std::move(responder)) {
+}
+
+RpcServer::~RpcServer() {
+    stop();
+}
+
+void RpcServer::registerMethod(const std::string &name, Handler handler) {
+    methods[name] = Method{std::move(handler), nullptr};
+}
+
+void RpcServer::registerAsyncMethod(const std::string &name, AsyncHandler handler) {
+    methods[name] = Method{nullptr, std::move(handler)};
+}
+
+void RpcServer::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    worker = std::thread(&RpcServer::run, this);
+}
+
+void RpcServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    wakeup.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    // 异步方法的回复会用到responder,它的所有者在stop返回后就可能销毁
+    std::unique_lock<std::mutex> lock(mutex);
+    allReplied.wait(lock, [this] { return inFlight == 0; });
+    pending.clear();
+}
+
+void RpcServer::receive(const std::string &message) {
+    const uint64_t nowNs = Utils::steadyNowNs();
+    JsonValue root;
+    std::string error;
+    if (!JsonValue::parse(message, root, error) || !root["r"].isArray()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.malformed++;
+        }
+        Logger::warning("RPC: 无法解析的消息: %s", error.empty() ? "缺少请求列表" : error.c_str());
+        return;
+    }
+
+    // 队列满时在锁外回复busy,回复可能要进入页面消息队列的锁
+    std::vector<std::pair<double, bool>> refused; // 请求ID, 是否因队列满而拒绝
+    bool added = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t accepted = 0;
+        for (const JsonValue &item: root["r"].items()) {
+            const double id = item["i"].asNumber(-1);
+            counters.requests++;
+            if (!item["i"].isNumber() || !item["m"].isString()) {
+                counters.malformed++;
+                refused.emplace_back(id, false);
+                continue;
+            }
+            if (!running || pending.size() >= config.max_pending || accepted >= config.max_requests_per_message) {
+                counters.rejected++;
+                refused.emplace_back(id, true);
+                continue;
+            }
+            Request request;
+            request.id = id;
+            request.method = item["m"].asString();
+            request.params = item["p"];
+            request.received_ns = nowNs;
+            request.timeout_ns = static_cast<uint64_t>(std::max(0.0, item["t"].asNumber(0)) * 1e6);
+            pending.push_back(std::move(request));
+            accepted++;
+            added = true;
+        }
+        counters.high_water = std::max(counters.high_water, pending.size());
+    }
+    if (added) {
+        wakeup.notify_one();
+    }
+    for (const auto &entry: refused) {
+        if (entry.second) {
+            respondError(entry.first, "busy", "请求太多,请稍后重试");
+        } else {
+            respondError(entry.first, "malformed", "请求缺少i或m");
+        }
+    }
+}
+
+RpcServer::Stats RpcServer::stats() const {
+    Stats result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result = counters;
+        result.pending = pending.size();
+    }
+    result.queue_time = queueTime.snapshot();
+    result.handler_time = handlerTime.snapshot();
+    return result;
+}
+
+void RpcServer::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this] {
+            return !running || !pending.empty();
+        });
+        if (!running) {
+            return;
+        }
+        Request request = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        execute(request);
+        lock.lock();
+    }
+}
+
+void RpcServer::execute(const Request &request) {
+    const uint64_t startNs = Utils::steadyNowNs();
+    queueTime.record(startNs - request.received_ns);
+    if (request.timeout_ns > 0 && startNs - request.received_ns > request.timeout_ns) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.expired++;
+        }
+        respondError(request.id, "timeout", "排队超时");
+        return;
+    }
+
+    const auto found = methods.find(request.method);
+    if (found == methods.end()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.failed++;
+        }
+        respondError(request.id, "unknown_method", "未知的方法: " + request.method);
+        return;
+    }
+
+    if (found->second.asyncHandler) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight++;
+        }
+        const auto replied = std::make_shared<std::atomic<bool>>(false);
+        const double id = request.id;
+        Reply reply = [this, id, replied](const bool ok, const JsonValue &result, const Error &error) {
+            if (replied->exchange(true)) {
+                return;
+            }
+            complete(id, ok, result, error);
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight--;
+            allReplied.notify_all();
+        };
+        try {
+            found->second.asyncHandler(request.params, reply);
+        } catch (const std::exception &e) {
+            Error error;
+            error.message = e.what();
+            reply(false, JsonValue(), error);
+        }
+        // 只统计在工作线程中的耗时,等待应答的时间不算
+        handlerTime.record(Utils::steadyNowNs() - startNs);
+        return;
+    }
+
+    JsonValue result;
+    Error error;
+    bool ok;
+    try {
+        ok = found->second.handler(request.params, result, error);
+    } catch (const std::exception &e) {
+        ok = false;
+        error.code = "failed";
+        error.message = e.what();
+    }
+    handlerTime.record(Utils::steadyNowNs() - startNs);
+    complete(request.id, ok, result, error);
+}
+
+void RpcServer::complete(const double id, const bool ok, const JsonValue &result, const Error &error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ok) {
+            counters.completed++;
+        } else {
+            counters.failed++;
+        }
+    }
+    if (!ok) {
+        respondError(id, error.code.c_str(), error.message);
+        return;
+    }
+
+    std::string response = "{\"i\":";
+    JsonValue(id).dumpTo(response);
+    response += ",\"ok\":true,\"v\":";
+    result.dumpTo(response);
+    response += '}';
+    responder(response);
+}
+
+void RpcServer::respondError(const double id, const char *code, const std::string &error) {
+    JsonValue response = JsonValue::object();
+    response.set("i", id).set("ok", false).set("c", code).set("e", error);
+    responder(response.dump());
+}
@@ -0,0 +1,225 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#ifndef RPCSERVER_H
+#define RPCSERVER_H
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "JsonValue.h"
+#include "XRealGlassesController/LatencyHistogram.h"
+
+
+/**
+ * 页面调用C++的RPC
+ * 页面把一个微任务内的所有调用合成一条消息(经由脚本消息处理器)发来:
+ *   {"r":[{"i":1,"m":"device.info","p":{},"t":2000}, ...]}
+ * i: 请求ID; m: 方法名; p: 参数; t: 可选,排队超过这么多毫秒时不再执行.
+ * 每个请求对应一条响应,经由WebViewBridge的"rpc"通道按帧合批发回:
+ *   {"i":1,"ok":true,"v":{...}}  或  {"i":1,"ok":false,"c":"busy","e":"..."}
+ * c: 错误类型 busy(队列满,可以稍后重试)/timeout/unknown_method/bad_params/failed/malformed.
+ *
+ * receive()只解析和入队(界面线程中约几微秒),处理函数在唯一的工作线程中按顺序执行,
+ * 既不阻塞界面线程,也不会有两个处理函数同时访问眼镜.等待中的请求有上限,超出时立即以busy拒绝.
+ * 需要等待设备应答的方法注册为异步方法: 处理函数发出命令后立即返回,应答到达时(任意线程)再回复,
+ * 等待期间工作线程继续处理后面的请求;stop()等到所有异步方法都已回复才返回.
+ * 不依赖wxWidgets.
+ */
+class RpcServer {
+public:
+    struct Config {
+        //等待执行的请求上限
+        size_t max_pending = 256;
+        //一条消息中最多的请求数,超出的以busy拒绝
+        size_t max_requests_per_message = 64;
+    };
+
+    struct Stats {
+        //收到的请求数
+        uint64_t requests = 0;
+        //成功返回的请求数
+        uint64_t completed = 0;
+        //处理失败的请求数(参数错误/处理函数返回失败/未知方法)
+        uint64_t failed = 0;
+        //队列满时拒绝的请求数
+        uint64_t rejected = 0;
+        //排队超时没有执行的请求数
+        uint64_t expired = 0;
+        //无法解析的消息数
+        uint64_t malformed = 0;
+        size_t pending = 0;
+        size_t high_water = 0;
+        //从收到到开始执行的时间
+        LatencyHistogram::Snapshot queue_time;
+        //处理函数的执行时间
+        LatencyHistogram::Snapshot handler_time;
+    };
+
+    struct Error {
+        //错误类型,见类的说明
+        std::string code = "failed";
+        std::string message;
+    };
+
+    /**
+     * 处理函数
+     * @param params - 请求参数
+     * @param result - 返回值
+     * @param error - 失败时的原因
+     * @return - 是否成功
+     */
+    using Handler = std::function<bool(const JsonValue &params, JsonValue &result, Error &error)>;
+
+    /**
+     * 异步方法的回复,可以在任意线程中调用,必须调用且只有第一次有效
+     * @param ok - 是否成功
+     * @param result - 成功时的返回值
+     * @param error - 失败时的原因
+     */
+    using Reply = std::function<void(bool ok, const JsonValue &result, const Error &error)>;
+
+    /**
+     * 异步处理函数: 在工作线程中发起操作后立即返回,操作完成时调用reply
+     */
+    using AsyncHandler = std::function<void(const JsonValue &params, Reply reply)>;
+
+    /**
+     * 发送一条响应(在工作线程、调用receive的线程或异步方法回复的线程中执行)
+     */
+    using Responder = std::function<void(const std::string &json)>;
+
+    explicit RpcServer(Responder responder);
+
+    RpcServer(Responder responder, const Config &config);
+
+    ~RpcServer();
+
+    RpcServer(const RpcServer&) = delete;
+    RpcServer& operator=(const RpcServer&) = delete;
+
+    /**
+     * 注册方法,必须在start()之前调用
+     */
+    void registerMethod(const std::string &name, Handler handler);
+
+    /**
+     * 注册有类型的方法
+     * Params需要 static bool fromJson(const JsonValue &, Params &, std::string &error);
+     * Result需要 JsonValue toJson() const.
+     */
+    template<typename Params, typename Result>
+    void registerMethod(const std::string &name,
+                        std::function<bool(const Params &params, Result &result, std::string &error)> handler) {
+        registerMethod(name, [handler](const JsonValue &json, JsonValue &out, Error &error) {
+            Params params;
+            if (!Params::fromJson(json, params, error.message)) {
+                error.code = "bad_params";
+                return false;
+            }
+            Result result;
+            if (!handler(params, result, error.message)) {
+                return false;
+            }
+            out = result.toJson();
+            return true;
+        });
+    }
+
+    /**
+     * 注册异步方法,必须在start()之前调用
+     */
+    void registerAsyncMethod(const std::string &name, AsyncHandler handler);
+
+    /**
+     * 注册有类型的异步方法,Params/Result的要求与registerMethod相同
+     */
+    template<typename Params, typename Result>
+    void registerAsyncMethod(
+        const std::string &name,
+        std::function<void(const Params &params,
+                           std::function<void(bool ok, const Result &result, const std::string &error)> reply)>
+        handler) {
+        registerAsyncMethod(name, [handler](const JsonValue &json, Reply reply) {
+            Params params;
+            Error error;
+            if (!Params::fromJson(json, params, error.message)) {
+                error.code = "bad_params";
+                reply(false, JsonValue(), error);
+                return;
+            }
+            handler(params, [reply](const bool ok, const Result &result, const std::string &message) {
+                Error failure;
+                failure.message = message;
+                reply(ok, ok ? result.toJson() : JsonValue(), failure);
+            });
+        });
+    }
+
+    /**
+     * 启动工作线程
+     */
+    void start();
+
+    /**
+     * 停止工作线程,还在等待的请求不再执行;已经发起的异步方法回复之后才返回
+     */
+    void stop();
+
+    /**
+     * 收到页面发来的一条消息(任意线程)
+     */
+    void receive(const std::string &message);
+
+    Stats stats() const;
+
+private:
+    struct Request {
+        double id = 0;
+        std::string method;
+        JsonValue params;
+        uint64_t received_ns = 0;
+        //排队超过这个时间时不再执行(0为不限)
+        uint64_t timeout_ns = 0;
+    };
+
+    struct Method {
+        //二者之一不为空
+        Handler handler;
+        AsyncHandler asyncHandler;
+    };
+
+    const Config config;
+    const Responder responder;
+    std::map<std::string, Method> methods;
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    //已经发起、还没有回复的异步方法数
+    size_t inFlight = 0;
+    std::condition_variable allReplied;
+    std::deque<Request> pending;
+    std::thread worker;
+    bool running = false;
+    Stats counters;
+    //只在工作线程中记录
+    LatencyHistogram queueTime;
+    LatencyHistogram handlerTime;
+
+    void run();
+
+    void execute(const Request &request);
+
+    // 统计并发出一个请求的结果(任意线程)
+    void complete(double id, bool ok, const JsonValue &result, const Error &error);
+
+    void respondError(double id, const char *code, const std::string &error);
+};
+
+
+#endif //RPCSERVER_H
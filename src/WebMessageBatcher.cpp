@@ -0,0 +1,132 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#include "WebMessageBatcher.h"
+
+#include <algorithm>
+
+#include "JsonValue.h"
+
+WebMessageBatcher::WebMessageBatcher() : WebMessageBatcher(Config()) {
+}
+
+WebMessageBatcher::WebMessageBatcher(const Config &config) : config(config) {
+}
+
+bool WebMessageBatcher::post(const std::string &channel, const std::string &json, const bool droppable) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool wasIdle = idleLocked();
+    counters.posted++;
+    if (droppable && droppableQueued >= config.max_queued) {
+        // 页面跟不上时丢弃最旧的可丢弃消息,按通道计数,下一批告诉页面丢了多少
+        const auto oldest = std::find_if(queue.begin(), queue.end(), [](const Message &message) {
+            return message.droppable;
+        });
+        droppedByChannel[oldest->channel]++;
+        counters.dropped++;
+        queue.erase(oldest);
+        droppableQueued--;
+    }
+    queue.push_back({channel, json, droppable});
+    if (droppable) {
+        droppableQueued++;
+    }
+    counters.high_water = std::max(counters.high_water, queue.size());
+    return wasIdle;
+}
+
+bool WebMessageBatcher::postText(const std::string &channel, const std::string &text) {
+    std::string json;
+    json.reserve(text.size() + 2);
+    JsonValue::appendString(json, text);
+    return post(channel, json);
+}
+
+bool WebMessageBatcher::postLatest(const std::string &channel, const std::string &json) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool wasIdle = idleLocked();
+    counters.posted++;
+    auto found = latest.find(channel);
+    if (found != latest.end()) {
+        found->second = json;
+        counters.coalesced++;
+    } else {
+        latest.emplace(channel, json);
+    }
+    return wasIdle;
+}
+
+bool WebMessageBatcher::takeBatch(std::string &out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idleLocked()) {
+        return false;
+    }
+    out.clear();
+    out += "{\"m\":[";
+    size_t taken = 0;
+    while (!queue.empty() && taken < config.max_messages_per_batch) {
+        const Message &message = queue.front();
+        const size_t size = message.channel.size() + message.json.size() + 6;
+        if (taken > 0 && out.size() + size > config.max_bytes_per_batch) {
+            break;
+        }
+        if (taken > 0) {
+            out += ',';
+        }
+        out += '[';
+        JsonValue::appendString(out, message.channel);
+        out += ',';
+        out += message.json;
+        out += ']';
+        if (message.droppable) {
+            droppableQueued--;
+        }
+        queue.pop_front();
+        taken++;
+    }
+    out += "],\"l\":{";
+    bool first = true;
+    for (const auto &entry: latest) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        JsonValue::appendString(out, entry.first);
+        out += ':';
+        out += entry.second;
+    }
+    out += "},\"d\":{";
+    first = true;
+    for (const auto &entry: droppedByChannel) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        JsonValue::appendString(out, entry.first);
+        out += ':';
+        out += std::to_string(entry.second);
+    }
+    out += "},\"q\":";
+    out += std::to_string(queue.size());
+    out += '}';
+
+    counters.delivered += taken + latest.size();
+    counters.batches++;
+    counters.bytes += out.size();
+    latest.clear();
+    droppedByChannel.clear();
+    return true;
+}
+
+bool WebMessageBatcher::empty() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idleLocked();
+}
+
+WebMessageBatcher::Stats WebMessageBatcher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats result = counters;
+    result.queued = queue.size();
+    return result;
+}
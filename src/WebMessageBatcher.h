@@ -0,0 +1,105 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#ifndef WEBMESSAGEBATCHER_H
+#define WEBMESSAGEBATCHER_H
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+/**
+ * 发往页面的消息队列
+ * 任意线程都可以投递消息,界面线程每帧取出一批,编码为一条JSON交给页面的xrealBridge.receive():
+ *   {"m":[["log","..."],["key",{...}]], "l":{"pose":{...}}, "d":{"log":12}, "q":0}
+ * m: 按投递顺序的消息([通道, 数据]); l: 只保留最新值的通道; d: 自上一批以来因队列满而丢弃的条数; q: 留到下一批的条数.
+ * 每批的条数和字节数有上限,超出的留到下一帧;队列满时丢弃最旧的消息.
+ * 不依赖wxWidgets,只负责排队和编码.
+ */
+class WebMessageBatcher {
+public:
+    struct Config {
+        //每批最多的消息条数
+        size_t max_messages_per_batch = 64;
+        //每批最多的字节数(至少会包含一条消息)
+        size_t max_bytes_per_batch = 32 * 1024;
+        //队列中最多的消息条数,超出时丢弃最旧的
+        size_t max_queued = 1024;
+    };
+
+    struct Stats {
+        //投递的消息条数(含只保留最新值的通道)
+        uint64_t posted = 0;
+        //只保留最新值的通道中被新值覆盖、没有发出的条数
+        uint64_t coalesced = 0;
+        //队列满时丢弃的条数
+        uint64_t dropped = 0;
+        //发给页面的消息条数
+        uint64_t delivered = 0;
+        uint64_t batches = 0;
+        //发给页面的JSON总字节数
+        uint64_t bytes = 0;
+        size_t queued = 0;
+        size_t high_water = 0;
+    };
+
+    WebMessageBatcher();
+
+    explicit WebMessageBatcher(const Config &config);
+
+    /**
+     * 投递一条消息
+     * @param channel - 通道名
+     * @param json - 已编码的JSON值
+     * @param droppable - 队列满时是否可以丢弃(RPC的响应等不能丢的消息为false,不计入上限)
+     * @return - 投递前是否没有待发送的内容(调用方据此安排一次发送)
+     */
+    bool post(const std::string &channel, const std::string &json, bool droppable = true);
+
+    /**
+     * 投递一条文本消息(编码为JSON字符串)
+     */
+    bool postText(const std::string &channel, const std::string &text);
+
+    /**
+     * 投递只保留最新值的消息,同一通道还没发出的旧值被覆盖
+     */
+    bool postLatest(const std::string &channel, const std::string &json);
+
+    /**
+     * 取出一批消息
+     * @param out - 编码后的JSON
+     * @return - 是否有内容
+     */
+    bool takeBatch(std::string &out);
+
+    bool empty() const;
+
+    Stats stats() const;
+
+private:
+    struct Message {
+        std::string channel;
+        std::string json;
+        bool droppable;
+    };
+
+    const Config config;
+    mutable std::mutex mutex;
+    std::deque<Message> queue;
+    std::map<std::string, std::string> latest;
+    std::map<std::string, uint64_t> droppedByChannel;
+    //队列中可以丢弃的条数
+    size_t droppableQueued = 0;
+    Stats counters;
+
+    bool idleLocked() const {
+        return queue.empty() && latest.empty() && droppedByChannel.empty();
+    }
+};
+
+
+#endif //WEBMESSAGEBATCHER_H
@@ -0,0 +1,144 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#include "WebViewBridge.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <wx/display.h>
+
+#include "XRealGlassesController/Logger.h"
+#include "XRealGlassesController/Utils.h"
+
+WebViewBridge::WebViewBridge(wxWebView *webView) : WebViewBridge(webView, Config()) {
+}
+
+WebViewBridge::WebViewBridge(wxWebView *webView, const Config &config)
+    : webView(webView), config(config), batcher(config.batcher), frameTimer(this) {
+    Bind(wxEVT_TIMER, &WebViewBridge::OnFrameTimer, this, frameTimer.GetId());
+    updateFrameInterval();
+}
+
+WebViewBridge::~WebViewBridge() {
+    frameTimer.Stop();
+}
+
+void WebViewBridge::post(const std::string &channel, const std::string &json, const bool droppable) {
+    requestFlush(batcher.post(channel, json, droppable));
+}
+
+void WebViewBridge::postText(const std::string &channel, const std::string &text) {
+    requestFlush(batcher.postText(channel, text));
+}
+
+void WebViewBridge::postLatest(const std::string &channel, const std::string &json) {
+    requestFlush(batcher.postLatest(channel, json));
+}
+
+void WebViewBridge::setReady(const bool ready) {
+    this->ready = ready;
+    if (ready && (!batcher.empty() || !frameProducers.empty())) {
+        scheduleFlush();
+    }
+}
+
+uint64_t WebViewBridge::addFrameProducer(FrameProducer producer) {
+    const uint64_t id = nextProducerId++;
+    frameProducers.emplace(id, std::move(producer));
+    if (ready) {
+        scheduleFlush();
+    }
+    return id;
+}
+
+void WebViewBridge::removeFrameProducer(const uint64_t id) {
+    frameProducers.erase(id);
+}
+
+void WebViewBridge::updateFrameInterval() {
+    double hz = config.display_hz;
+    if (const char *value = std::getenv("XREAL_DISPLAY_HZ")) {
+        hz = std::atof(value);
+    }
+    if (hz <= 0 && webView) {
+        // 显示器报告不出刷新率时(部分外接显示器为0)使用眼镜的刷新率
+        const int index = wxDisplay::GetFromWindow(webView);
+        const wxDisplay display(index == wxNOT_FOUND ? 0u : static_cast<unsigned>(index));
+        hz = display.GetCurrentMode().refresh;
+    }
+    if (hz <= 0 || hz > 1000) {
+        hz = DEFAULT_DISPLAY_HZ;
+    }
+    const uint64_t interval = static_cast<uint64_t>(1e9 / hz);
+    if (interval != frameInterval) {
+        frameInterval = interval;
+        Logger::info("网页消息按 %.1fHz 的显示刷新率发送", hz);
+    }
+}
+
+WebViewBridge::Stats WebViewBridge::stats() const {
+    Stats result;
+    result.messages = batcher.stats();
+    result.script_cost = scriptCost.snapshot();
+    return result;
+}
+
+void WebViewBridge::requestFlush(const bool becameBusy) {
+    // 只有队列从空变为非空的那一次投递需要转到界面线程,同一帧内的其余投递只是入队
+    if (becameBusy && !flushScheduled.exchange(true)) {
+        CallAfter(&WebViewBridge::scheduleFlush);
+    }
+}
+
+void WebViewBridge::scheduleFlush() {
+    flushScheduled.store(true);
+    if (frameTimer.IsRunning()) {
+        return;
+    }
+    // 距离上一批不足一帧时等到下一帧,否则尽快发出;定时器以毫秒为单位,取最接近的值(72Hz约14ms)
+    const uint64_t sinceLastNs = Utils::steadyNowNs() - lastFlushNs;
+    const int delayMs = sinceLastNs >= frameInterval
+                            ? 1
+                            : std::max(1, static_cast<int>((frameInterval - sinceLastNs + 500000) / 1000000));
+    frameTimer.StartOnce(delayMs);
+}
+
+void WebViewBridge::OnFrameTimer(wxTimerEvent &event) {
+    flush();
+}
+
+void WebViewBridge::flush() {
+    if (!webView || !ready) {
+        // 页面加载完成后由setReady发出
+        flushScheduled.store(false);
+        return;
+    }
+    const uint64_t startNs = Utils::steadyNowNs();
+    // 每帧的内容在发出前一刻生成,尽量新(此时标记还在,生产者投递时不必再转到界面线程)
+    for (auto &entry: frameProducers) {
+        entry.second(*this, startNs);
+    }
+    // 先清除标记再取消息,取出之后投递的消息会重新安排发送
+    flushScheduled.store(false);
+    std::string batch;
+    if (batcher.takeBatch(batch)) {
+        const std::string script = "if (window.xrealBridge) { window.xrealBridge.receive(" + batch + "); }";
+        const wxString text = wxString::FromUTF8(script.data(), script.size());
+        if (text.empty()) {
+            // 无效的UTF-8时FromUTF8返回空串;JsonValue编码的内容不会这样,出现时是未经编码直接投递的JSON
+            Logger::error("网页消息不是有效的UTF-8,丢弃这一批(%u字节)", batch.size());
+        } else {
+            webView->RunScriptAsync(text);
+        }
+        scriptCost.record(Utils::steadyNowNs() - startNs);
+    }
+    // 没有内容的帧也算一帧,帧生产者暂时没有数据时不会空转
+    lastFlushNs = startNs;
+
+    // 超出每批上限的消息留到下一帧;有帧生产者时按帧持续发送
+    if (!batcher.empty() || !frameProducers.empty()) {
+        scheduleFlush();
+    }
+}
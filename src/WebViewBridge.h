@@ -0,0 +1,138 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#ifndef WEBVIEWBRIDGE_H
+#define WEBVIEWBRIDGE_H
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+#include <wx/wx.h>
+#include <wx/timer.h>
+#include <wx/webview.h>
+
+#include "WebMessageBatcher.h"
+#include "XRealGlassesController/LatencyHistogram.h"
+
+
+/**
+ * C++到页面的消息通道
+ * 任意线程调用post/postText/postLatest,消息先进入WebMessageBatcher;
+ * 有消息时转到界面线程,按显示帧的间隔每帧最多调用一次RunScriptAsync,把这一帧的所有消息作为一批交给页面.
+ * 页面没有加载完成时消息留在队列中(队列满时丢弃最旧的),加载完成后一起发出.
+ * 需要每帧刷新的内容(头部姿态等)通过帧生产者在发出前一刻生成,有生产者时按帧持续发送.
+ */
+class WebViewBridge : public wxEvtHandler {
+public:
+    //取不到显示器刷新率时使用的值(眼镜3D模式的刷新率)
+    static constexpr double DEFAULT_DISPLAY_HZ = 72.0;
+
+    struct Config {
+        //显示刷新率,两批之间的最小间隔为一帧;<=0时取WebView所在显示器的当前模式,
+        //可以用环境变量XREAL_DISPLAY_HZ覆盖
+        double display_hz = 0;
+        WebMessageBatcher::Config batcher;
+    };
+
+    struct Stats {
+        WebMessageBatcher::Stats messages;
+        //每批在界面线程中的耗时(编码+RunScriptAsync)
+        LatencyHistogram::Snapshot script_cost;
+    };
+
+    explicit WebViewBridge(wxWebView *webView);
+
+    WebViewBridge(wxWebView *webView, const Config &config);
+
+    ~WebViewBridge() override;
+
+    WebViewBridge(const WebViewBridge&) = delete;
+    WebViewBridge& operator=(const WebViewBridge&) = delete;
+
+    /**
+     * 帧生产者,每批发出之前在界面线程中调用,通常用postLatest投递这一帧的内容
+     * @param frameNs - 这一批的发出时间(steady_clock纳秒)
+     */
+    using FrameProducer = std::function<void(WebViewBridge &bridge, uint64_t frameNs)>;
+
+    /**
+     * 投递一条消息(任意线程)
+     * @param channel - 通道名
+     * @param json - 已编码的JSON值
+     * @param droppable - 页面跟不上时是否可以丢弃
+     */
+    void post(const std::string &channel, const std::string &json, bool droppable = true);
+
+    /**
+     * 投递一条文本消息(任意线程)
+     */
+    void postText(const std::string &channel, const std::string &text);
+
+    /**
+     * 投递只保留最新值的消息(任意线程),一帧内多次投递只发最后一次
+     */
+    void postLatest(const std::string &channel, const std::string &json);
+
+    /**
+     * 页面是否已经加载完成,可以执行脚本(界面线程)
+     */
+    void setReady(bool ready);
+
+    /**
+     * 添加帧生产者(界面线程)
+     * @return - ID,用于removeFrameProducer
+     */
+    uint64_t addFrameProducer(FrameProducer producer);
+
+    void removeFrameProducer(uint64_t id);
+
+    /**
+     * 重新读取显示器的刷新率(显示模式切换后调用,界面线程)
+     */
+    void updateFrameInterval();
+
+    /**
+     * 当前两批之间的最小间隔
+     */
+    uint64_t frameIntervalNs() const {
+        return frameInterval;
+    }
+
+    Stats stats() const;
+
+private:
+    wxWebView *webView;
+    const Config config;
+    WebMessageBatcher batcher;
+    wxTimer frameTimer;
+    bool ready = false;
+    //两批之间的最小间隔(纳秒),由刷新率得出
+    uint64_t frameInterval = 0;
+    //已经安排了发送(其他线程投递时据此决定是否需要转到界面线程)
+    std::atomic<bool> flushScheduled{false};
+    uint64_t lastFlushNs = 0;
+    LatencyHistogram scriptCost;
+    //只在界面线程中访问
+    std::map<uint64_t, FrameProducer> frameProducers;
+    uint64_t nextProducerId = 1;
+
+    /**
+     * 队列从空变为非空时调用,安排一次发送
+     */
+    void requestFlush(bool becameBusy);
+
+    /**
+     * 在界面线程中启动帧定时器
+     */
+    void scheduleFlush();
+
+    void OnFrameTimer(wxTimerEvent &event);
+
+    void flush();
+};
+
+
+#endif //WEBVIEWBRIDGE_H
@@ -0,0 +1,57 @@
+//
+// Created by Norman Wang on 2025/5/6.
+//
+
+#ifndef ATOMICWORDS_H
+#define ATOMICWORDS_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+/**
+ * 按8字节分段存放在原子变量中的定长数据(relaxed读写)
+ * 顺序锁(SeqLock/ReportRingBuffer的槽位)的数据部分: 写入方和读取方可能同时拷贝,
+ * 普通内存的并发读写在C++内存模型下是数据竞争,分段的原子读写不是;读到的是否一致仍由序号判断.
+ * 顺序由调用方的栅栏保证,这里只负责拷贝.T必须可以按字节拷贝.
+ */
+template<typename T>
+class AtomicWords {
+    static_assert(std::is_trivially_copyable<T>::value, "AtomicWords只能存放可以按字节拷贝的类型");
+
+public:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    AtomicWords() {
+        for (auto &word: words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    AtomicWords(const AtomicWords&) = delete;
+    AtomicWords& operator=(const AtomicWords&) = delete;
+
+    void store(const T &value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+    }
+
+    void load(T &out) const {
+        uint64_t buffer[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(&out, buffer, sizeof(T));
+    }
+
+private:
+    std::atomic<uint64_t> words[WORDS];
+};
+
+
+#endif //ATOMICWORDS_H
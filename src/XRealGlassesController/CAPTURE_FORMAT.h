@@ -0,0 +1,67 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+#include <cstddef>
+#include <cstdint>
+
+#include "MCU_MESSAGE.h"
+
+
+/**
+ * 录制文件中一条记录的类型
+ */
+enum class CaptureRecordKind : uint8_t {
+    // 枚举到的接口(HID_DEVICE_ENTRY),回放时据此枚举
+    DEVICE = 1,
+    // 从接口读到的上报
+    INPUT = 2,
+    // 写入接口的输出报告
+    OUTPUT = 3,
+    // 发送的特征报告
+    FEATURE = 4
+};
+
+/**
+ * 录制文件(.xrcap)的布局,所有多字节字段均为小端
+ *
+ * 文件头(16字节): [0..7] "XRCAPTUR" | [8..11] 版本 | [12..15] 保留
+ * 之后是若干个块,只追加不修改:
+ *   块头(32字节): [0..3] "CHNK" | [4..7] 负载字节数 | [8..11] 记录数 | [12..15] 负载的CRC32
+ *                 [16..23] 第一条记录的主机时间 | [24..31] 最后一条记录的主机时间
+ *   负载: 若干条记录,每条为 记录头(12字节) + 数据
+ *   记录头: [0..7] 主机时间(steady_clock纳秒) | [8..9] 数据字节数 | [10] 接口编号 | [11] 类型
+ * DEVICE记录的数据: [0..1] VID | [2..3] PID | 之后依次是路径、序列号、厂商、产品名(各以\0结尾)
+ *
+ * 块头记录了时间范围,回放时只需读块头就能建立时间索引;最后一个块不完整或CRC不对(录制时崩溃)时丢弃.
+ */
+struct CAPTURE_FORMAT {
+    static constexpr char MAGIC[8] = {'X', 'R', 'C', 'A', 'P', 'T', 'U', 'R'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t FILE_HEADER_SIZE = 16;
+    static constexpr REPORT_FIELD FILE_VERSION{8, 4};
+
+    static constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+    static constexpr size_t CHUNK_HEADER_SIZE = 32;
+    static constexpr REPORT_FIELD CHUNK_TAG{0, 4};
+    static constexpr REPORT_FIELD CHUNK_PAYLOAD_SIZE{4, 4};
+    static constexpr REPORT_FIELD CHUNK_RECORD_COUNT{8, 4};
+    static constexpr REPORT_FIELD CHUNK_CRC{12, 4};
+    static constexpr REPORT_FIELD CHUNK_FIRST_NS{16, 8};
+    static constexpr REPORT_FIELD CHUNK_LAST_NS{24, 8};
+
+    static constexpr size_t RECORD_HEADER_SIZE = 12;
+    static constexpr REPORT_FIELD RECORD_HOST_NS{0, 8};
+    static constexpr REPORT_FIELD RECORD_LENGTH{8, 2};
+    static constexpr REPORT_FIELD RECORD_INTERFACE{10, 1};
+    static constexpr REPORT_FIELD RECORD_KIND{11, 1};
+
+    // 负载超过这个大小,或者块内时间跨度超过MAX_CHUNK_SPAN_NS时写出当前块
+    static constexpr size_t MAX_CHUNK_PAYLOAD = 64 * 1024;
+    static constexpr uint64_t MAX_CHUNK_SPAN_NS = 1000000000ULL;
+};
+
+
+#endif //CAPTURE_FORMAT_H
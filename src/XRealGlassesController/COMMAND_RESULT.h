@@ -0,0 +1,30 @@
+//
+// Created by Norman Wang on 2025/5/8.
+//
+
+#ifndef COMMAND_RESULT_H
+#define COMMAND_RESULT_H
+#include <cstdint>
+#include <string>
+
+#include "HID_REPORT.h"
+
+
+/**
+ * 一次命令请求的结果(发送 + 等待设备应答)
+ */
+struct COMMAND_RESULT {
+    //是否收到了匹配的应答
+    bool success = false;
+    //是否因为等待应答超时而失败
+    bool timed_out = false;
+    //失败原因(发送失败/超时/已取消)
+    std::string error;
+    //设备的应答原文
+    HID_REPORT reply;
+    //从发出到收到应答的往返时间(纳秒)
+    uint64_t round_trip_ns = 0;
+};
+
+
+#endif //COMMAND_RESULT_H
@@ -0,0 +1,158 @@
+//
+// Created by Norman Wang on 2025/5/13.
+//
+
+#include "CalibrationCache.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "Logger.h"
+
+// 文件第一行,格式变化时递增版本号,旧版本的文件会被忽略
+static constexpr const char *FILE_HEADER = "xreal-imu-calibration 1";
+
+/**
+ * 逐级创建目录(相当于mkdir -p)
+ */
+static bool makeDirectories(const std::string &path) {
+    for (size_t position = 1; position <= path.size(); position++) {
+        if (position != path.size() && path[position] != '/') {
+            continue;
+        }
+        const std::string part = path.substr(0, position);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void writeAxes(std::ostream &out, const char *name, const float (&values)[3]) {
+    out << name << ' ' << values[0] << ' ' << values[1] << ' ' << values[2] << '\n';
+}
+
+std::string CalibrationCache::directory() {
+    if (const char *configured = std::getenv("XREAL_CALIBRATION_DIR")) {
+        return configured;
+    }
+    const char *home = std::getenv("HOME");
+#ifdef __APPLE__
+    if (!home) {
+        return "";
+    }
+    return std::string(home) + "/Library/Application Support/XrealVisionStereo/calibration";
+#else
+    if (const char *configHome = std::getenv("XDG_CONFIG_HOME")) {
+        return std::string(configHome) + "/XrealVisionStereo/calibration";
+    }
+    if (!home) {
+        return "";
+    }
+    return std::string(home) + "/.config/XrealVisionStereo/calibration";
+#endif
+}
+
+std::string CalibrationCache::pathFor(const std::string &serialNumber) {
+    // 序列号只保留字母数字,避免出现路径分隔符
+    std::string fileName;
+    for (const char c: serialNumber) {
+        fileName += std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_';
+    }
+    return directory() + "/" + fileName + ".cal";
+}
+
+bool CalibrationCache::load(const std::string &serialNumber, IMU_CALIBRATION &out) {
+    if (serialNumber.empty() || directory().empty()) {
+        return false;
+    }
+    std::ifstream file(pathFor(serialNumber));
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    if (!std::getline(file, line) || line != FILE_HEADER) {
+        Logger::warning("忽略无法识别的校准缓存: %s", pathFor(serialNumber));
+        return false;
+    }
+
+    IMU_CALIBRATION calibration;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        fields >> name;
+        float *axes = nullptr;
+        if (name == "gyro_bias") {
+            axes = calibration.gyro_bias;
+        } else if (name == "accel_offset") {
+            axes = calibration.accel_offset;
+        } else if (name == "accel_scale") {
+            axes = calibration.accel_scale;
+        } else if (name == "gravity_positive") {
+            axes = calibration.gravity_positive;
+        } else if (name == "gravity_negative") {
+            axes = calibration.gravity_negative;
+        } else if (name == "temperature") {
+            fields >> calibration.temperature;
+        } else if (name == "stationary_windows") {
+            fields >> calibration.stationary_windows;
+        }
+        if (axes) {
+            fields >> axes[0] >> axes[1] >> axes[2];
+        }
+        if (fields.fail()) {
+            Logger::warning("校准缓存格式错误: %s", pathFor(serialNumber));
+            return false;
+        }
+    }
+    if (!calibration.valid()) {
+        return false;
+    }
+    out = calibration;
+    return true;
+}
+
+bool CalibrationCache::save(const std::string &serialNumber, const IMU_CALIBRATION &calibration) {
+    const std::string folder = directory();
+    if (serialNumber.empty() || folder.empty() || !calibration.valid()) {
+        return false;
+    }
+    if (!makeDirectories(folder)) {
+        Logger::warning("无法创建校准缓存目录: %s", folder);
+        return false;
+    }
+
+    const std::string path = pathFor(serialNumber);
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::trunc);
+        if (!file) {
+            Logger::warning("无法写入校准缓存: %s", temporaryPath);
+            return false;
+        }
+        file.precision(9);
+        file << FILE_HEADER << '\n';
+        writeAxes(file, "gyro_bias", calibration.gyro_bias);
+        writeAxes(file, "accel_offset", calibration.accel_offset);
+        writeAxes(file, "accel_scale", calibration.accel_scale);
+        writeAxes(file, "gravity_positive", calibration.gravity_positive);
+        writeAxes(file, "gravity_negative", calibration.gravity_negative);
+        file << "temperature " << calibration.temperature << '\n';
+        file << "stationary_windows " << calibration.stationary_windows << '\n';
+        if (!file.flush()) {
+            Logger::warning("无法写入校准缓存: %s", temporaryPath);
+            return false;
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        Logger::warning("无法保存校准缓存: %s", path);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+//
+// Created by Norman Wang on 2025/5/13.
+//
+
+#ifndef CALIBRATIONCACHE_H
+#define CALIBRATIONCACHE_H
+#include <string>
+
+#include "IMU_CALIBRATION.h"
+
+
+/**
+ * 按眼镜序列号保存的IMU校准缓存
+ * 每副眼镜一个文本文件(<序列号>.cal),重新连接时立即读取,不需要重新等待静止校准.
+ * 目录:
+ *   macOS - ~/Library/Application Support/XrealVisionStereo/calibration
+ *   其他  - $XDG_CONFIG_HOME(默认~/.config)/XrealVisionStereo/calibration
+ *   可以用环境变量XREAL_CALIBRATION_DIR指定
+ */
+class CalibrationCache {
+public:
+    /**
+     * 读取某副眼镜的校准
+     * @param serialNumber - 眼镜序列号(GLASSES_INFO::serialNumber)
+     * @param out - 输出
+     * @return - 是否读到了有效的校准
+     */
+    static bool load(const std::string &serialNumber, IMU_CALIBRATION &out);
+
+    /**
+     * 保存某副眼镜的校准(先写临时文件再替换,中途退出不会留下半个文件)
+     * @return - 是否保存成功
+     */
+    static bool save(const std::string &serialNumber, const IMU_CALIBRATION &calibration);
+
+    /**
+     * 缓存目录,无法确定时返回空字符串
+     */
+    static std::string directory();
+
+    /**
+     * 某副眼镜的缓存文件路径
+     */
+    static std::string pathFor(const std::string &serialNumber);
+};
+
+
+#endif //CALIBRATIONCACHE_H
@@ -0,0 +1,176 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#include "CaptureReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Crc32.h"
+#include "Logger.h"
+
+static uint64_t readLittleEndian(const uint8_t *data, const REPORT_FIELD &field) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < field.size; i++) {
+        value |= static_cast<uint64_t>(data[field.offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+bool CaptureReader::open(const std::string &path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::error("无法打开录制文件: %s", path);
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < CAPTURE_FORMAT::FILE_HEADER_SIZE) {
+        Logger::error("录制文件太短: %s", path);
+        ::close(fd);
+        return false;
+    }
+    void *address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        Logger::error("无法映射录制文件: %s", path);
+        return false;
+    }
+    mapped = static_cast<uint8_t *>(address);
+    mappedSize = static_cast<size_t>(info.st_size);
+    filePath = path;
+
+    if (std::memcmp(mapped, CAPTURE_FORMAT::MAGIC, sizeof(CAPTURE_FORMAT::MAGIC)) != 0 ||
+        readLittleEndian(mapped, CAPTURE_FORMAT::FILE_VERSION) != CAPTURE_FORMAT::VERSION) {
+        Logger::error("不是可识别的录制文件: %s", path);
+        close();
+        return false;
+    }
+    // 回放时顺序读取
+    madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+    buildIndex();
+    collectDevices();
+    return true;
+}
+
+void CaptureReader::close() {
+    if (mapped) {
+        munmap(mapped, mappedSize);
+    }
+    mapped = nullptr;
+    mappedSize = 0;
+    index.clear();
+    deviceEntries.clear();
+    totalRecords = 0;
+}
+
+void CaptureReader::buildIndex() {
+    size_t position = CAPTURE_FORMAT::FILE_HEADER_SIZE;
+    while (position + CAPTURE_FORMAT::CHUNK_HEADER_SIZE <= mappedSize) {
+        const uint8_t *header = mapped + position;
+        Chunk chunk;
+        chunk.payload_offset = position + CAPTURE_FORMAT::CHUNK_HEADER_SIZE;
+        chunk.payload_size = readLittleEndian(header, CAPTURE_FORMAT::CHUNK_PAYLOAD_SIZE);
+        chunk.records = static_cast<uint32_t>(readLittleEndian(header, CAPTURE_FORMAT::CHUNK_RECORD_COUNT));
+        chunk.first_ns = readLittleEndian(header, CAPTURE_FORMAT::CHUNK_FIRST_NS);
+        chunk.last_ns = readLittleEndian(header, CAPTURE_FORMAT::CHUNK_LAST_NS);
+        if (readLittleEndian(header, CAPTURE_FORMAT::CHUNK_TAG) != CAPTURE_FORMAT::CHUNK_MAGIC ||
+            chunk.payload_size > mappedSize - chunk.payload_offset ||
+            Crc32::compute(mapped + chunk.payload_offset, chunk.payload_size) !=
+            readLittleEndian(header, CAPTURE_FORMAT::CHUNK_CRC)) {
+            // 通常是录制时崩溃留下的最后一个块
+            Logger::warning("录制文件在第%u个块处损坏或不完整,忽略之后的内容: %s", index.size() + 1, filePath);
+            break;
+        }
+        index.push_back(chunk);
+        totalRecords += chunk.records;
+        position = chunk.payload_offset + chunk.payload_size;
+    }
+}
+
+void CaptureReader::collectDevices() {
+    Cursor cursor = begin();
+    Record record;
+    while (next(cursor, record)) {
+        if (record.kind != CaptureRecordKind::DEVICE || record.length < 4) {
+            continue;
+        }
+        HID_DEVICE_ENTRY entry;
+        entry.vendor_id = static_cast<uint16_t>(record.data[0] | (record.data[1] << 8));
+        entry.product_id = static_cast<uint16_t>(record.data[2] | (record.data[3] << 8));
+        entry.interface_number = record.interface_number;
+        size_t position = 4;
+        for (std::string *text: {&entry.path, &entry.serial_number, &entry.manufacturer, &entry.product}) {
+            const auto *begin = record.data + position;
+            const auto *end = static_cast<const uint8_t *>(std::memchr(begin, 0, record.length - position));
+            if (!end) {
+                break;
+            }
+            text->assign(reinterpret_cast<const char *>(begin), end - begin);
+            position = end - record.data + 1;
+        }
+        const bool known = std::any_of(deviceEntries.begin(), deviceEntries.end(),
+                                       [&entry](const HID_DEVICE_ENTRY &existing) {
+                                           return existing.path == entry.path;
+                                       });
+        if (!known) {
+            deviceEntries.push_back(entry);
+        }
+    }
+}
+
+uint64_t CaptureReader::firstNs() const {
+    return index.empty() ? 0 : index.front().first_ns;
+}
+
+uint64_t CaptureReader::lastNs() const {
+    return index.empty() ? 0 : index.back().last_ns;
+}
+
+CaptureReader::Cursor CaptureReader::seek(const uint64_t hostNs) const {
+    const auto found = std::lower_bound(index.begin(), index.end(), hostNs,
+                                        [](const Chunk &chunk, const uint64_t target) {
+                                            return chunk.last_ns < target;
+                                        });
+    Cursor cursor{static_cast<size_t>(found - index.begin()), 0};
+    Cursor previous = cursor;
+    Record record;
+    while (next(cursor, record)) {
+        if (record.host_ns >= hostNs) {
+            return previous;
+        }
+        previous = cursor;
+    }
+    return cursor;
+}
+
+bool CaptureReader::next(Cursor &cursor, Record &out) const {
+    while (cursor.chunk < index.size()) {
+        const Chunk &chunk = index[cursor.chunk];
+        if (cursor.offset + CAPTURE_FORMAT::RECORD_HEADER_SIZE <= chunk.payload_size) {
+            const uint8_t *header = mapped + chunk.payload_offset + cursor.offset;
+            const size_t length = readLittleEndian(header, CAPTURE_FORMAT::RECORD_LENGTH);
+            if (cursor.offset + CAPTURE_FORMAT::RECORD_HEADER_SIZE + length <= chunk.payload_size) {
+                out.host_ns = readLittleEndian(header, CAPTURE_FORMAT::RECORD_HOST_NS);
+                out.kind = static_cast<CaptureRecordKind>(readLittleEndian(header, CAPTURE_FORMAT::RECORD_KIND));
+                out.interface_number = static_cast<int>(readLittleEndian(header, CAPTURE_FORMAT::RECORD_INTERFACE));
+                out.data = header + CAPTURE_FORMAT::RECORD_HEADER_SIZE;
+                out.length = length;
+                cursor.offset += CAPTURE_FORMAT::RECORD_HEADER_SIZE + length;
+                return true;
+            }
+        }
+        cursor.chunk++;
+        cursor.offset = 0;
+    }
+    return false;
+}
@@ -0,0 +1,133 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#ifndef CAPTUREREADER_H
+#define CAPTUREREADER_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CAPTURE_FORMAT.h"
+#include "HID_DEVICE_ENTRY.h"
+
+
+/**
+ * 录制文件的读取(格式见CAPTURE_FORMAT)
+ * 整个文件用mmap映射,打开时只遍历块头并校验CRC,建立按时间排序的块索引,
+ * 记录的数据直接指向映射的内存,不拷贝.
+ * 打开后只读,可以在多个线程中用各自的游标同时读取.
+ */
+class CaptureReader {
+public:
+    /**
+     * 一条记录
+     */
+    struct Record {
+        uint64_t host_ns = 0;
+        CaptureRecordKind kind = CaptureRecordKind::INPUT;
+        int interface_number = 0;
+        //指向映射的文件内容,CaptureReader销毁后失效
+        const uint8_t *data = nullptr;
+        size_t length = 0;
+    };
+
+    /**
+     * 块索引中的一项
+     */
+    struct Chunk {
+        //负载在文件中的位置
+        size_t payload_offset = 0;
+        size_t payload_size = 0;
+        uint32_t records = 0;
+        uint64_t first_ns = 0;
+        uint64_t last_ns = 0;
+    };
+
+    /**
+     * 读取位置
+     */
+    struct Cursor {
+        size_t chunk = 0;
+        //在块负载中的位置
+        size_t offset = 0;
+    };
+
+    CaptureReader() = default;
+
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    /**
+     * 打开并映射录制文件
+     * @return - 是否是有效的录制文件(末尾损坏的块会被丢弃,不算失败)
+     */
+    bool open(const std::string &path);
+
+    void close();
+
+    [[nodiscard]] bool isOpen() const {
+        return mapped != nullptr;
+    }
+
+    [[nodiscard]] const std::vector<Chunk> &chunks() const {
+        return index;
+    }
+
+    /**
+     * 录制中出现过的接口(DEVICE记录,按路径去重)
+     */
+    [[nodiscard]] const std::vector<HID_DEVICE_ENTRY> &devices() const {
+        return deviceEntries;
+    }
+
+    /**
+     * 记录总数
+     */
+    [[nodiscard]] uint64_t recordCount() const {
+        return totalRecords;
+    }
+
+    /**
+     * 第一条/最后一条记录的主机时间
+     */
+    [[nodiscard]] uint64_t firstNs() const;
+
+    [[nodiscard]] uint64_t lastNs() const;
+
+    /**
+     * 从头开始的游标
+     */
+    [[nodiscard]] Cursor begin() const {
+        return Cursor{};
+    }
+
+    /**
+     * 定位到第一条主机时间不早于hostNs的记录: 先在块索引中二分查找,再在块内顺序跳过
+     */
+    [[nodiscard]] Cursor seek(uint64_t hostNs) const;
+
+    /**
+     * 读取游标处的记录并前进
+     * @return - 是否读到(false表示已到末尾)
+     */
+    bool next(Cursor &cursor, Record &out) const;
+
+private:
+    void buildIndex();
+
+    void collectDevices();
+
+    std::string filePath;
+    uint8_t *mapped = nullptr;
+    size_t mappedSize = 0;
+    std::vector<Chunk> index;
+    std::vector<HID_DEVICE_ENTRY> deviceEntries;
+    uint64_t totalRecords = 0;
+};
+
+
+#endif //CAPTUREREADER_H
@@ -0,0 +1,189 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#include "CaptureWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Crc32.h"
+#include "Logger.h"
+
+static void writeLittleEndian(uint8_t *out, const REPORT_FIELD &field, const uint64_t value) {
+    for (size_t i = 0; i < field.size; i++) {
+        out[field.offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// 一个块的缓冲区最多装下: 未满64KB的负载 + 一条最长的记录
+static constexpr size_t CHUNK_CAPACITY =
+        CAPTURE_FORMAT::MAX_CHUNK_PAYLOAD + CAPTURE_FORMAT::RECORD_HEADER_SIZE + UINT16_MAX;
+
+CaptureWriter::CaptureWriter(const std::string &path) : filePath(path) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        Logger::error("无法创建录制文件: %s", path);
+        return;
+    }
+    uint8_t header[CAPTURE_FORMAT::FILE_HEADER_SIZE] = {0};
+    std::memcpy(header, CAPTURE_FORMAT::MAGIC, sizeof(CAPTURE_FORMAT::MAGIC));
+    writeLittleEndian(header, CAPTURE_FORMAT::FILE_VERSION, CAPTURE_FORMAT::VERSION);
+    if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        Logger::error("无法写入录制文件: %s", path);
+        std::fclose(file);
+        file = nullptr;
+        return;
+    }
+    counters.bytes = sizeof(header);
+    chunk.reserve(CHUNK_CAPACITY);
+    writerThread = std::thread(&CaptureWriter::run, this);
+}
+
+CaptureWriter::~CaptureWriter() {
+    if (!file) {
+        return;
+    }
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        stopping = true;
+    }
+    chunkReady.notify_all();
+    writerThread.join();
+    std::fclose(file);
+    const Stats result = stats();
+    Logger::info("录制已保存: %s, 记录 %llu, 块 %llu, %lluKB", filePath,
+                 static_cast<unsigned long long>(result.records), static_cast<unsigned long long>(result.chunks),
+                 static_cast<unsigned long long>(result.bytes / 1024));
+}
+
+void CaptureWriter::append(const CaptureRecordKind kind, const int interfaceNumber, const uint8_t *data,
+                           size_t length, const uint64_t hostNs) {
+    length = std::min<size_t>(length, UINT16_MAX);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!file || failed) {
+        counters.lost_records++;
+        return;
+    }
+    if (chunkRecords > 0 && (chunk.size() >= CAPTURE_FORMAT::MAX_CHUNK_PAYLOAD ||
+                             hostNs > chunkFirstNs + CAPTURE_FORMAT::MAX_CHUNK_SPAN_NS)) {
+        sealChunkLocked();
+    }
+
+    uint8_t header[CAPTURE_FORMAT::RECORD_HEADER_SIZE];
+    writeLittleEndian(header, CAPTURE_FORMAT::RECORD_HOST_NS, hostNs);
+    writeLittleEndian(header, CAPTURE_FORMAT::RECORD_LENGTH, length);
+    writeLittleEndian(header, CAPTURE_FORMAT::RECORD_INTERFACE, static_cast<uint8_t>(interfaceNumber));
+    writeLittleEndian(header, CAPTURE_FORMAT::RECORD_KIND, static_cast<uint8_t>(kind));
+    chunk.insert(chunk.end(), header, header + sizeof(header));
+    chunk.insert(chunk.end(), data, data + length);
+
+    // 不同线程的记录可能有微小的乱序,块的时间范围取最小/最大值
+    chunkFirstNs = chunkRecords == 0 ? hostNs : std::min(chunkFirstNs, hostNs);
+    chunkLastNs = chunkRecords == 0 ? hostNs : std::max(chunkLastNs, hostNs);
+    chunkRecords++;
+    counters.records++;
+}
+
+void CaptureWriter::appendDevice(const HID_DEVICE_ENTRY &entry, const uint64_t hostNs) {
+    std::vector<uint8_t> data(4);
+    data[0] = entry.vendor_id & 0xFF;
+    data[1] = (entry.vendor_id >> 8) & 0xFF;
+    data[2] = entry.product_id & 0xFF;
+    data[3] = (entry.product_id >> 8) & 0xFF;
+    for (const std::string *text: {&entry.path, &entry.serial_number, &entry.manufacturer, &entry.product}) {
+        data.insert(data.end(), text->begin(), text->end());
+        data.push_back(0);
+    }
+    append(CaptureRecordKind::DEVICE, entry.interface_number, data.data(), data.size(), hostNs);
+}
+
+void CaptureWriter::flush() {
+    std::unique_lock<std::mutex> lock(writeMutex);
+    if (!file) {
+        return;
+    }
+    if (!failed && chunkRecords > 0) {
+        sealChunkLocked();
+    }
+    chunksWritten.wait(lock, [this]() { return pending.empty() && !writing; });
+}
+
+void CaptureWriter::sealChunkLocked() {
+    if (pending.size() >= MAX_PENDING_CHUNKS) {
+        if (counters.lost_records == 0) {
+            Logger::warning("录制文件写入跟不上,丢弃部分记录: %s", filePath);
+        }
+        counters.lost_records += chunkRecords;
+        chunk.clear();
+    } else {
+        PendingChunk sealed;
+        sealed.payload.swap(chunk);
+        sealed.records = chunkRecords;
+        sealed.first_ns = chunkFirstNs;
+        sealed.last_ns = chunkLastNs;
+        pending.push_back(std::move(sealed));
+        if (!spareBuffers.empty()) {
+            chunk.swap(spareBuffers.back());
+            spareBuffers.pop_back();
+        } else {
+            chunk.reserve(CHUNK_CAPACITY);
+        }
+        chunkReady.notify_one();
+    }
+    chunkRecords = 0;
+}
+
+void CaptureWriter::run() {
+    std::unique_lock<std::mutex> lock(writeMutex);
+    while (true) {
+        chunkReady.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            return;
+        }
+        PendingChunk current = std::move(pending.front());
+        pending.pop_front();
+        writing = true;
+        const bool skip = failed;
+
+        lock.unlock();
+        const bool written = !skip && writeChunk(current);
+        lock.lock();
+
+        writing = false;
+        if (written) {
+            counters.chunks++;
+            counters.bytes += CAPTURE_FORMAT::CHUNK_HEADER_SIZE + current.payload.size();
+        } else {
+            if (!failed) {
+                Logger::error("写入录制文件失败,停止录制: %s", filePath);
+                failed = true;
+            }
+            counters.lost_records += current.records;
+        }
+        current.payload.clear();
+        spareBuffers.push_back(std::move(current.payload));
+        chunksWritten.notify_all();
+    }
+}
+
+bool CaptureWriter::writeChunk(const PendingChunk &sealed) {
+    uint8_t header[CAPTURE_FORMAT::CHUNK_HEADER_SIZE];
+    writeLittleEndian(header, CAPTURE_FORMAT::CHUNK_TAG, CAPTURE_FORMAT::CHUNK_MAGIC);
+    writeLittleEndian(header, CAPTURE_FORMAT::CHUNK_PAYLOAD_SIZE, sealed.payload.size());
+    writeLittleEndian(header, CAPTURE_FORMAT::CHUNK_RECORD_COUNT, sealed.records);
+    writeLittleEndian(header, CAPTURE_FORMAT::CHUNK_CRC,
+                      Crc32::compute(sealed.payload.data(), sealed.payload.size()));
+    writeLittleEndian(header, CAPTURE_FORMAT::CHUNK_FIRST_NS, sealed.first_ns);
+    writeLittleEndian(header, CAPTURE_FORMAT::CHUNK_LAST_NS, sealed.last_ns);
+
+    return std::fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+           std::fwrite(sealed.payload.data(), 1, sealed.payload.size(), file) == sealed.payload.size() &&
+           std::fflush(file) == 0;
+}
+
+CaptureWriter::Stats CaptureWriter::stats() const {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    return counters;
+}
@@ -0,0 +1,131 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CAPTURE_FORMAT.h"
+#include "HID_DEVICE_ENTRY.h"
+
+
+/**
+ * 录制文件的写入(格式见CAPTURE_FORMAT)
+ * 记录先追加到内存中的当前块,块满(64KB)或跨度超过1秒时整块交给后台的写文件线程,
+ * 所以录制时崩溃最多丢失最后约1秒的数据,已写出的块不受影响.
+ * 线程安全: 各接口的读线程和命令线程可以同时追加,追加时只在锁内拷贝数据,不做文件IO;
+ * 磁盘跟不上、待写的块超过MAX_PENDING_CHUNKS时丢弃新的块(计入lost_records),不阻塞读线程.
+ */
+class CaptureWriter {
+public:
+    struct Stats {
+        uint64_t records = 0;
+        uint64_t chunks = 0;
+        uint64_t bytes = 0;
+        //写文件失败后丢弃的记录数
+        uint64_t lost_records = 0;
+    };
+
+    /**
+     * 创建(覆盖)录制文件
+     */
+    explicit CaptureWriter(const std::string &path);
+
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    [[nodiscard]] bool isOpen() const {
+        return file != nullptr;
+    }
+
+    [[nodiscard]] const std::string &path() const {
+        return filePath;
+    }
+
+    /**
+     * 追加一条记录
+     * @param kind - 类型
+     * @param interfaceNumber - 接口编号
+     * @param data - 数据(超过65535字节的部分被截断)
+     * @param length - 数据字节数
+     * @param hostNs - 主机时间(steady_clock纳秒)
+     */
+    void append(CaptureRecordKind kind, int interfaceNumber, const uint8_t *data, size_t length, uint64_t hostNs);
+
+    /**
+     * 追加一个枚举到的接口
+     */
+    void appendDevice(const HID_DEVICE_ENTRY &entry, uint64_t hostNs);
+
+    /**
+     * 写出当前块,并等待所有待写的块写入文件
+     */
+    void flush();
+
+    Stats stats() const;
+
+private:
+    /**
+     * 已封好、等待写文件线程写出的块
+     */
+    struct PendingChunk {
+        std::vector<uint8_t> payload;
+        uint32_t records = 0;
+        uint64_t first_ns = 0;
+        uint64_t last_ns = 0;
+    };
+
+    // 待写块的上限(约1MB),超过后丢弃新的块
+    static constexpr size_t MAX_PENDING_CHUNKS = 16;
+
+    /**
+     * 把当前块交给写文件线程,换一个空的缓冲区继续追加(调用方持有writeMutex)
+     */
+    void sealChunkLocked();
+
+    /**
+     * 写文件线程: 取出待写的块,在锁外计算CRC并写入
+     */
+    void run();
+
+    /**
+     * 写出一个块(只在写文件线程中调用)
+     * @return - 是否写入成功
+     */
+    bool writeChunk(const PendingChunk &sealed);
+
+    std::string filePath;
+    //只在构造/析构和写文件线程中使用
+    FILE *file = nullptr;
+
+    mutable std::mutex writeMutex;
+    std::condition_variable chunkReady;
+    std::condition_variable chunksWritten;
+    std::vector<uint8_t> chunk;
+    uint32_t chunkRecords = 0;
+    uint64_t chunkFirstNs = 0;
+    uint64_t chunkLastNs = 0;
+    std::deque<PendingChunk> pending;
+    //写完的缓冲区,留给下一个块复用
+    std::vector<std::vector<uint8_t>> spareBuffers;
+    //写文件线程正在写一个块(已从pending中取出)
+    bool writing = false;
+    //写文件失败后不再接受记录
+    bool failed = false;
+    bool stopping = false;
+    Stats counters;
+    std::thread writerThread;
+};
+
+
+#endif //CAPTUREWRITER_H
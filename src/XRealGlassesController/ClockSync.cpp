@@ -0,0 +1,156 @@
+//
+// Created by Norman Wang on 2025/5/14.
+//
+
+#include "ClockSync.h"
+
+#include <algorithm>
+#include <cmath>
+
+ClockSync::ClockSync() : ClockSync(Config()) {
+}
+
+ClockSync::ClockSync(const Config &config) :
+    config(config), windows(std::max<size_t>(config.max_windows, 2)), x(windows.size()), y(windows.size()),
+    residuals(windows.size()), sorted(windows.size()), inlier(windows.size()) {
+}
+
+bool ClockSync::observe(const uint64_t deviceNs, const uint64_t hostNs) {
+    if (hasLastDevice && (deviceNs + config.reset_gap_ns < lastDeviceNs || deviceNs > lastDeviceNs + config.reset_gap_ns)) {
+        // 设备时间戳倒退或长时间中断(设备重启/重新连接),之前的窗口不再可用
+        resets++;
+        reset();
+    }
+    lastDeviceNs = deviceNs;
+    hasLastDevice = true;
+
+    const auto offset = static_cast<int64_t>(hostNs - deviceNs);
+    if (!windowOpen) {
+        windowOpen = true;
+        windowStartNs = deviceNs;
+        current = {deviceNs, offset};
+    } else if (offset < current.offset_ns) {
+        current = {deviceNs, offset};
+    }
+    if (deviceNs - windowStartNs < config.window_ns) {
+        return false;
+    }
+    finishWindow();
+    return true;
+}
+
+void ClockSync::finishWindow() {
+    windows[windowHead] = current;
+    windowHead = (windowHead + 1) % windows.size();
+    windowCount = std::min(windowCount + 1, windows.size());
+    windowOpen = false;
+    fit();
+}
+
+void ClockSync::fit() {
+    Estimate result;
+    result.resets = resets;
+    result.windows = windowCount;
+    if (windowCount < std::max<size_t>(config.min_windows, 2)) {
+        std::lock_guard<std::mutex> lock(estimateMutex);
+        published = result;
+        return;
+    }
+
+    // 以最新的窗口为原点,x为秒,y为相对偏移(纳秒),避免大数相减损失精度
+    const Window &newest = windows[(windowHead + windows.size() - 1) % windows.size()];
+    for (size_t i = 0; i < windowCount; i++) {
+        const Window &window = windows[(windowHead + windows.size() - windowCount + i) % windows.size()];
+        x[i] = static_cast<double>(static_cast<int64_t>(window.device_ns - newest.device_ns)) * 1e-9;
+        y[i] = static_cast<double>(window.offset_ns - newest.offset_ns);
+        inlier[i] = true;
+    }
+
+    double intercept = 0;
+    double slope = 0;
+    const auto regress = [&]() {
+        double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (size_t i = 0; i < windowCount; i++) {
+            if (!inlier[i]) {
+                continue;
+            }
+            n += 1;
+            sx += x[i];
+            sy += y[i];
+            sxx += x[i] * x[i];
+            sxy += x[i] * y[i];
+        }
+        const double denominator = n * sxx - sx * sx;
+        slope = denominator > 0 ? (n * sxy - sx * sy) / denominator : 0;
+        intercept = (sy - slope * sx) / n;
+    };
+
+    regress();
+    for (size_t i = 0; i < windowCount; i++) {
+        residuals[i] = std::fabs(y[i] - (intercept + slope * x[i]));
+    }
+    std::copy(residuals.begin(), residuals.begin() + windowCount, sorted.begin());
+    std::nth_element(sorted.begin(), sorted.begin() + windowCount / 2, sorted.begin() + windowCount);
+    const double threshold = std::max(static_cast<double>(config.outlier_floor_ns),
+                                      sorted[windowCount / 2] * config.outlier_mad_factor);
+    size_t inliers = 0;
+    for (size_t i = 0; i < windowCount; i++) {
+        inlier[i] = residuals[i] <= threshold;
+        inliers += inlier[i] ? 1 : 0;
+    }
+    if (inliers >= 2 && inliers < windowCount) {
+        regress();
+    } else {
+        std::fill(inlier.begin(), inlier.begin() + windowCount, true);
+        inliers = windowCount;
+    }
+
+    double squares = 0;
+    for (size_t i = 0; i < windowCount; i++) {
+        if (inlier[i]) {
+            const double residual = y[i] - (intercept + slope * x[i]);
+            squares += residual * residual;
+        }
+    }
+
+    result.synced = true;
+    result.reference_device_ns = newest.device_ns;
+    result.offset_ns = newest.offset_ns + static_cast<int64_t>(std::llround(intercept));
+    // slope为每秒的偏移变化(纳秒),即漂移率×1e9
+    result.skew_ppm = slope * 1e-3;
+    result.residual_rms_ns = std::sqrt(squares / static_cast<double>(inliers));
+    result.rejected_windows = windowCount - inliers;
+
+    std::lock_guard<std::mutex> lock(estimateMutex);
+    published = result;
+}
+
+ClockSync::Estimate ClockSync::estimate() const {
+    std::lock_guard<std::mutex> lock(estimateMutex);
+    return published;
+}
+
+bool ClockSync::toHost(const uint64_t deviceNs, uint64_t &out) const {
+    const Estimate snapshot = estimate();
+    if (!snapshot.synced) {
+        return false;
+    }
+    out = toHost(snapshot, deviceNs);
+    return true;
+}
+
+uint64_t ClockSync::toHost(const Estimate &estimate, const uint64_t deviceNs) {
+    const auto elapsed = static_cast<double>(static_cast<int64_t>(deviceNs - estimate.reference_device_ns));
+    return deviceNs + estimate.offset_ns + std::llround(estimate.skew_ppm * 1e-6 * elapsed);
+}
+
+void ClockSync::reset() {
+    windowCount = 0;
+    windowHead = 0;
+    windowOpen = false;
+    hasLastDevice = false;
+    Estimate result;
+    result.resets = resets;
+    std::lock_guard<std::mutex> lock(estimateMutex);
+    published = result;
+}
@@ -0,0 +1,131 @@
+//
+// Created by Norman Wang on 2025/5/14.
+//
+
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+/**
+ * 设备时钟到主机时钟的同步
+ * IMU样本带有设备时间戳,而主机上的其他事件(收到上报、按键、网页渲染帧)使用主机的steady_clock.
+ * 把两者换算到同一个时间基准上: 主机时间 = 设备时间 + 偏移,偏移随时钟漂移线性变化.
+ *
+ * 每条样本的(主机收到时间 - 设备时间)= 真实偏移 + 传输延迟,传输延迟只会让它变大,
+ * 所以每个窗口只取最小值(最接近真实偏移的一条),对最近的若干窗口做线性回归得到偏移和漂移率,
+ * 残差超过门限的点(例如整个窗口都被阻塞)剔除后重新回归. 窗口不断滑动,漂移率的变化(温度等)会被跟上.
+ *
+ * observe只在一个线程中调用(融合线程),estimate/toHost可以在任意线程调用.
+ */
+class ClockSync {
+public:
+    struct Config {
+        //每个窗口的设备时长(纳秒)
+        uint64_t window_ns = 100000000ULL;
+        //参与回归的窗口数(默认约6.4秒)
+        size_t max_windows = 64;
+        //至少有几个窗口才开始给出结果
+        size_t min_windows = 4;
+        //剔除残差超过 max(门限, 中位残差 × 倍数) 的窗口
+        int64_t outlier_floor_ns = 100000;
+        double outlier_mad_factor = 4.0;
+        //设备时间倒退或跳变超过这个值时认为设备重启,重新同步
+        uint64_t reset_gap_ns = 1000000000ULL;
+    };
+
+    /**
+     * 当前的换算关系: 主机时间 = 设备时间 + offset_ns + skew × (设备时间 - reference_device_ns)
+     */
+    struct Estimate {
+        //是否已经同步
+        bool synced = false;
+        //回归的参考点(最近一个窗口的设备时间)
+        uint64_t reference_device_ns = 0;
+        //参考点上的偏移(纳秒)
+        int64_t offset_ns = 0;
+        //漂移率(主机时钟相对设备时钟,百万分之一)
+        double skew_ppm = 0;
+        //参与回归的窗口残差的均方根(纳秒)
+        double residual_rms_ns = 0;
+        //参与回归/被剔除的窗口数
+        size_t windows = 0;
+        size_t rejected_windows = 0;
+        //重新同步的次数(设备重启)
+        uint64_t resets = 0;
+    };
+
+    ClockSync();
+
+    explicit ClockSync(const Config &config);
+
+    /**
+     * 观察一条样本
+     * @param deviceNs - 设备时间戳
+     * @param hostNs - 主机收到的时间(steady_clock)
+     * @return - 是否结束了一个窗口(换算关系已更新)
+     */
+    bool observe(uint64_t deviceNs, uint64_t hostNs);
+
+    /**
+     * 当前的换算关系
+     */
+    Estimate estimate() const;
+
+    /**
+     * 把设备时间换算成主机时间
+     * @return - 是否已经同步(未同步时out不变)
+     */
+    bool toHost(uint64_t deviceNs, uint64_t &out) const;
+
+    /**
+     * 按某个换算关系把设备时间换算成主机时间
+     */
+    static uint64_t toHost(const Estimate &estimate, uint64_t deviceNs);
+
+    /**
+     * 丢弃所有窗口,重新同步
+     */
+    void reset();
+
+private:
+    struct Window {
+        uint64_t device_ns = 0;
+        //窗口内(主机时间 - 设备时间)的最小值
+        int64_t offset_ns = 0;
+    };
+
+    void finishWindow();
+
+    void fit();
+
+    Config config;
+
+    // 以下只在observe的线程中使用
+    // 最近的窗口(环形,windowHead为下一个写入位置)
+    std::vector<Window> windows;
+    size_t windowCount = 0;
+    size_t windowHead = 0;
+    bool windowOpen = false;
+    uint64_t windowStartNs = 0;
+    // 上一条样本的设备时间(刚结束一个窗口时也要用它判断跳变)
+    uint64_t lastDeviceNs = 0;
+    bool hasLastDevice = false;
+    Window current;
+    uint64_t resets = 0;
+    // 回归用的临时数组,与windows等长
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> residuals;
+    std::vector<double> sorted;
+    std::vector<char> inlier;
+
+    mutable std::mutex estimateMutex;
+    Estimate published;
+};
+
+
+#endif //CLOCKSYNC_H
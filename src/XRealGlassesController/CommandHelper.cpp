@@ -4,10 +4,21 @@
 
 #include "CommandHelper.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "Utils.h"
 
+/**
+ * 按小端写入一个整数字段
+ */
+static void writeLittleEndian(uint8_t *out, const uint32_t value, const size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
 /**
 * 将字符串转换为字节数组
 * @param str - 输入字符串
@@ -40,54 +51,48 @@ std::vector<uint8_t> CommandHelper::buildCustomDisplayCommand(
     const uint8_t refresh,
     const uint16_t length
 ) {
-    // 构造基本命令结构
-    std::vector<uint8_t> buffer(64, 0);  // 初始化64字节缓冲区，填充0
-
-    // 设置基本字段
-    buffer[0] = 0xFD;  // 命令头标识
-
-    // 设置随机序列号
-    const uint32_t seqNum = Utils::generateRandomU32();
-    // const uint32_t seqNum =  402284073;//Utils::generateRandomU32();
-    buffer[7] = seqNum & 0xFF;
-    buffer[8] = (seqNum >> 8) & 0xFF;
-    buffer[9] = (seqNum >> 16) & 0xFF;
-    buffer[10] = (seqNum >> 24) & 0xFF;
-
-    // 设置消息ID
-    buffer[15] = msgId & 0xFF;
-    buffer[16] = (msgId >> 8) & 0xFF;
-
-    // 设置长度字段
-    buffer[5] = length & 0xFF;
-    buffer[6] = (length >> 8) & 0xFF;
-
-    // 设置主要模式参数
-    buffer[22] = mode;
-
-    // 设置附加参数
-    if (length > 0x12) {
-        buffer[23] = subMode;
-
-        if (length > 0x13) {
-            buffer[24] = param1;
-
-            if (length > 0x14) {
-                buffer[25] = param2;
+    // 负载依次是模式和各附加参数,自定义长度超过已知参数的部分补0
+    uint8_t payload[MCU_REPORT_LAYOUT::MAX_PAYLOAD] = {mode, subMode, param1, param2, refresh};
+    const size_t payloadLength = length > MCU_REPORT_LAYOUT::HEADER_LENGTH
+                                     ? length - MCU_REPORT_LAYOUT::HEADER_LENGTH
+                                     : 0;
+
+    McuReport report;
+    encode(report, msgId, Utils::generateRandomU32(), payload, payloadLength);
+    return std::vector<uint8_t>(report.begin(), report.end());
+}
 
-                if (length > 0x15) {
-                    buffer[26] = refresh;
-                }
-            }
-        }
+size_t CommandHelper::encode(McuReport &out, const uint16_t msgId, const uint32_t sequence, const uint8_t *payload,
+                             size_t payloadLength, const uint32_t deviceTime) {
+    payloadLength = std::min(payloadLength, MCU_REPORT_LAYOUT::MAX_PAYLOAD);
+    const auto length = static_cast<uint16_t>(MCU_REPORT_LAYOUT::HEADER_LENGTH + payloadLength);
+
+    out.fill(0);
+    out[MCU_REPORT_LAYOUT::HEAD.offset] = MCU_REPORT_LAYOUT::HEAD_BYTE;
+    writeLittleEndian(&out[MCU_REPORT_LAYOUT::LENGTH.offset], length, MCU_REPORT_LAYOUT::LENGTH.size);
+    writeLittleEndian(&out[MCU_REPORT_LAYOUT::SEQUENCE.offset], sequence, MCU_REPORT_LAYOUT::SEQUENCE.size);
+    writeLittleEndian(&out[MCU_REPORT_LAYOUT::DEVICE_TIME.offset], deviceTime, MCU_REPORT_LAYOUT::DEVICE_TIME.size);
+    writeLittleEndian(&out[MCU_REPORT_LAYOUT::MSG_ID.offset], msgId, MCU_REPORT_LAYOUT::MSG_ID.size);
+    if (payloadLength > 0) {
+        std::memcpy(&out[MCU_REPORT_LAYOUT::PAYLOAD.offset], payload, payloadLength);
     }
 
-    // 计算CRC校验
-    uint32_t crc = Utils::calculateCRC32(&buffer[5], length);
-    buffer[1] = crc & 0xFF;
-    buffer[2] = (crc >> 8) & 0xFF;
-    buffer[3] = (crc >> 16) & 0xFF;
-    buffer[4] = (crc >> 24) & 0xFF;
+    // 所有字段写完后一次性计算CRC
+    const uint32_t crc = Utils::calculateCRC32(&out[MCU_REPORT_LAYOUT::LENGTH.offset], length);
+    writeLittleEndian(&out[MCU_REPORT_LAYOUT::CRC.offset], crc, MCU_REPORT_LAYOUT::CRC.size);
+    return out.size();
+}
+
+size_t CommandHelper::encodeDisplayMode(McuReport &out, const uint8_t mode, const uint8_t subMode,
+                                        const uint8_t param1, const uint8_t param2, const uint8_t refresh) {
+    return encodeCommand<McuMsgId::SET_DISPLAY_MODE>(out, Utils::generateRandomU32(), mode, subMode, param1, param2,
+                                                     refresh);
+}
 
-    return buffer;
-}
\ No newline at end of file
+size_t CommandHelper::encodeText(McuReport &out, const std::string &text) {
+    const size_t length = std::min(text.size(), out.size() - 1);
+    out.fill(0);
+    out[0] = MCU_REPORT_LAYOUT::HEAD_BYTE;
+    std::memcpy(&out[1], text.data(), length);
+    return length + 1;
+}
@@ -4,12 +4,72 @@
 
 #ifndef COMMANDHELPER_H
 #define COMMANDHELPER_H
+#include <array>
+#include <cstddef>
+#include <string>
 #include <vector>
 
+#include "MCU_MESSAGE.h"
+
 
 class CommandHelper {
 
 public:
+    // 一条完整的0xFD报文,由调用方提供存储,编码过程不做任何堆分配
+    using McuReport = std::array<uint8_t, MCU_REPORT_LAYOUT::REPORT_SIZE>;
+
+    /**
+     * 按MCU_REPORT_LAYOUT编码一条0xFD报文
+     * 先清零,再写入各字段,最后对[长度字段, 负载末尾)一次性计算CRC
+     * @param out - 输出报文
+     * @param msgId - 消息ID
+     * @param sequence - 序号
+     * @param payload - 负载
+     * @param payloadLength - 负载字节数,超过42字节的部分被截断
+     * @param deviceTime - 设备时间字段(主机发出的命令为0,模拟眼镜的主动上报时填写)
+     * @return - 需要写入设备的字节数(固定64)
+     */
+    static size_t encode(McuReport &out, uint16_t msgId, uint32_t sequence, const uint8_t *payload,
+                         size_t payloadLength, uint32_t deviceTime = 0);
+
+    /**
+     * 按命令描述编码一条已知命令,参数个数在编译期检查
+     * 参数依次写入负载,不足的部分补0
+     * @param out - 输出报文
+     * @param sequence - 序号
+     * @param params - 负载参数(每个参数占1字节)
+     * @return - 需要写入设备的字节数
+     */
+    template<McuMsgId ID, typename... Params>
+    static size_t encodeCommand(McuReport &out, const uint32_t sequence, const Params... params) {
+        constexpr MCU_COMMAND_SPEC SPEC = MCU_REPORT_LAYOUT::spec(ID);
+        static_assert(SPEC.payload_length <= MCU_REPORT_LAYOUT::MAX_PAYLOAD, "负载超出报文长度");
+        static_assert(sizeof...(Params) <= SPEC.payload_length, "参数个数超过该命令的负载长度");
+        const std::array<uint8_t, SPEC.payload_length> payload = {static_cast<uint8_t>(params)...};
+        return encode(out, static_cast<uint16_t>(ID), sequence, payload.data(), payload.size());
+    }
+
+    /**
+     * 编码设置显示模式命令(使用随机序号)
+     * @param out - 输出报文
+     * @param mode - 主要模式值 (1为2D, 3为3D)
+     * @param subMode - 子模式/附加参数1
+     * @param param1 - 分辨率参数1
+     * @param param2 - 分辨率参数2
+     * @param refresh - 刷新率参数
+     * @return - 需要写入设备的字节数
+     */
+    static size_t encodeDisplayMode(McuReport &out, uint8_t mode, uint8_t subMode = 1, uint8_t param1 = 3,
+                                    uint8_t param2 = 0xB4, uint8_t refresh = 0);
+
+    /**
+     * 编码文本命令(如探测用的"v"): 0xFD + 命令文本,不再先生成负载再在头部插入0xFD
+     * @param out - 输出报文
+     * @param text - 命令文本,超过63字节的部分被截断
+     * @return - 需要写入设备的字节数
+     */
+    static size_t encodeText(McuReport &out, const std::string &text);
+
     /**
      * 构建自定义显示模式命令
      * 允许完全自定义所有参数以测试不同组合
@@ -22,6 +82,7 @@ public:
      * @param refresh - 刷新率参数 (位置26的值)
      * @param length - 命令数据长度 (默认0x18=24)
      * @return - 构造好的命令
+     * 需要避免堆分配时使用encodeDisplayMode
      */
     static std::vector<uint8_t> buildCustomDisplayCommand(
         uint16_t msgId = 0x0008,
@@ -0,0 +1,183 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#include "CommandWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Logger.h"
+#include "Metrics.h"
+#include "Utils.h"
+
+CommandWriter::CommandWriter(std::shared_ptr<HidDeviceHandle> device, const size_t capacity)
+    : device(std::move(device)), queue(std::max<size_t>(capacity, 1)) {
+}
+
+void CommandWriter::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (writerThread.joinable() || stopping) {
+        return;
+    }
+    // 线程持有一份引用,即使所有者在完成回调中释放了写入器,线程退出前它也不会析构
+    std::shared_ptr<CommandWriter> self = shared_from_this();
+    writerThread = std::thread([self]() {
+        self->run();
+    });
+}
+
+bool CommandWriter::submit(const uint8_t *data, const size_t length, Completion completion,
+                           const std::chrono::milliseconds maxWait) {
+    if (!data || length == 0 || length > HID_REPORT::MAX_SIZE) {
+        Logger::error("命令长度无效: %zu", length);
+        return false;
+    }
+    const uint64_t enqueuedAtNs = Utils::steadyNowNs();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // 队列满时等待写入线程腾出位置,等不到就拒绝,避免调用方无限堆积命令
+        if (!notFull.wait_for(lock, maxWait, [this]() { return stopping || count < queue.size(); }) || stopping) {
+            static MetricCounter &rejected = Metrics::counter("xreal_hid_writes_total", "写入设备的命令报文",
+                                                              {{"result", "rejected"}});
+            rejected.add();
+            writerStats.rejected++;
+            return false;
+        }
+        PendingCommand &slot = queue[(head + count) % queue.size()];
+        std::memcpy(slot.report.data, data, length);
+        slot.report.length = static_cast<uint16_t>(length);
+        slot.report.received_at_ns = enqueuedAtNs;
+        slot.completion = std::move(completion);
+        count++;
+        writerStats.high_water = std::max(writerStats.high_water, count);
+    }
+    notEmpty.notify_one();
+    return true;
+}
+
+bool CommandWriter::isWriterThread() const {
+    return writerThreadId.load() == std::this_thread::get_id();
+}
+
+bool CommandWriter::writeReport(HidDeviceHandle &device, const uint8_t *data, const size_t length) {
+    // 尝试两种方式发送命令
+    try {
+        // 方式1: 使用sendReport
+        const int result = device.write(data, length);
+        if (result > 0) {  // 只有返回值大于0时才表示成功
+            Logger::success("命令已使用sendReport发送");
+            // 输出result
+            Logger::info("sendReport返回值: %d", result);
+            return true;
+        }
+
+        // 打印错误信息
+        Logger::error("sendReport失败: %s 返回值: %d", device.lastError(), result);
+    } catch (const std::exception &error) {
+        Logger::error("sendReport异常: %s", error.what());
+
+        // 方式2: 尝试使用sendFeatureReport
+        try {
+            const int result = device.sendFeatureReport(data, length);
+            if (result > 0) {  // 只有返回值大于0时才表示成功
+                Logger::success("命令已使用sendFeatureReport发送");
+                // 输出result
+                Logger::info("sendFeatureReport返回值: %d", result);
+                return true;
+            }
+            Logger::error("sendFeatureReport失败: %s 返回值: %d", device.lastError(), result);
+        } catch (const std::exception &featureError) {
+            Logger::error("sendFeatureReport也异常: %s", featureError.what());
+        }
+    }
+
+    Logger::error("所有发送方法都失败");
+    return false;
+}
+
+void CommandWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+    if (!writerThread.joinable()) {
+        return;
+    }
+    if (isWriterThread()) {
+        writerThread.detach();
+    } else {
+        writerThread.join();
+    }
+}
+
+CommandWriter::Stats CommandWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return writerStats;
+}
+
+size_t CommandWriter::queuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+void CommandWriter::run() {
+    // 所有接口的写入线程共用
+    static MetricCounter &sentCounter = Metrics::counter("xreal_hid_writes_total", "写入设备的命令报文",
+                                                         {{"result", "sent"}});
+    static MetricCounter &failedCounter = Metrics::counter("xreal_hid_writes_total", "写入设备的命令报文",
+                                                           {{"result", "failed"}});
+    static MetricHistogram &writeLatency = Metrics::histogram("xreal_hid_write_seconds",
+                                                              "命令从提交到写入设备完成的时间(含排队)");
+    writerThreadId = std::this_thread::get_id();
+    while (true) {
+        PendingCommand command;
+        bool discard;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this]() { return stopping || count > 0; });
+            if (count == 0) {
+                return;
+            }
+            command = std::move(queue[head]);
+            head = (head + 1) % queue.size();
+            count--;
+            // 停止后队列中剩下的命令不再写入,直接以失败完成
+            discard = stopping;
+        }
+        notFull.notify_one();
+
+        bool sent = false;
+        if (!discard) {
+            sent = writeReport(*device, command.report.data, command.report.length);
+        }
+        const uint64_t latencyNs = Utils::steadyNowNs() - command.report.received_at_ns;
+        if (sent) {
+            sentCounter.add();
+            writeLatency.record(latencyNs);
+        } else {
+            failedCounter.add();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (sent) {
+                writerStats.sent++;
+                writerStats.last_latency_ns = latencyNs;
+                writerStats.max_latency_ns = std::max(writerStats.max_latency_ns, latencyNs);
+                writerStats.total_latency_ns += latencyNs;
+            } else {
+                writerStats.failed++;
+            }
+        }
+
+        if (command.completion) {
+            try {
+                command.completion(sent);
+            } catch (const std::exception &error) {
+                Logger::error("命令完成回调异常: %s", error.what());
+            }
+        }
+    }
+}
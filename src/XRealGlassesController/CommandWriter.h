@@ -0,0 +1,129 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#ifndef COMMANDWRITER_H
+#define COMMANDWRITER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "HID_REPORT.h"
+#include "HidTransport.h"
+
+
+/**
+ * 每个设备一个的命令写入线程
+ * 所有线程发送的命令先进入有界的多生产者/单消费者队列,再由这一个线程依次写入设备,
+ * 同一设备上的写入不会再并发执行,也不会因为突发的命令产生突发的线程.
+ * 队列满时提交方最多等待指定时间(背压),仍然没有空位则提交失败.
+ * 完成回调总是在写入线程中按提交顺序执行,不能长时间阻塞.
+ * 写入线程持有自身的一份引用,需由所有者显式调用stop()结束(可以在完成回调里调用).
+ */
+class CommandWriter : public std::enable_shared_from_this<CommandWriter> {
+public:
+    /**
+     * 命令完成回调
+     * @param sent - 是否已写入设备
+     */
+    using Completion = std::function<void(bool sent)>;
+
+    /**
+     * 写入统计
+     */
+    struct Stats {
+        //已写入的命令数
+        uint64_t sent = 0;
+        //写入失败(包括停止时被丢弃)的命令数
+        uint64_t failed = 0;
+        //队列已满被拒绝的命令数
+        uint64_t rejected = 0;
+        //最近一条命令从提交到写入完成的耗时
+        uint64_t last_latency_ns = 0;
+        //从提交到写入完成的最大耗时
+        uint64_t max_latency_ns = 0;
+        //从提交到写入完成的累计耗时,除以sent得到平均值
+        uint64_t total_latency_ns = 0;
+        //队列中同时排队的最大命令数
+        size_t high_water = 0;
+    };
+
+    /**
+     * @param device - 要写入的设备
+     * @param capacity - 队列容量
+     */
+    explicit CommandWriter(std::shared_ptr<HidDeviceHandle> device, size_t capacity = 64);
+
+    CommandWriter(const CommandWriter &) = delete;
+    CommandWriter &operator=(const CommandWriter &) = delete;
+
+    /**
+     * 启动写入线程(构造后调用一次)
+     */
+    void start();
+
+    /**
+     * 提交一条命令(复制到队列的定长槽位中,不产生堆分配)
+     * @param data - 完整的报告数据
+     * @param length - 数据长度,不能超过64字节
+     * @param completion - 写入完成后在写入线程中调用(可为空);提交失败时不会调用
+     * @param maxWait - 队列满时最多等待多久,0表示不等待
+     * @return - 是否已进入队列
+     */
+    bool submit(const uint8_t *data, size_t length, Completion completion,
+                std::chrono::milliseconds maxWait = std::chrono::milliseconds(100));
+
+    /**
+     * 当前是否在写入线程中(在完成回调里同步发送命令时直接写入,避免等待自己)
+     */
+    bool isWriterThread() const;
+
+    /**
+     * 直接写入一条报告(使用输出报告,写入异常时再尝试特征报告)
+     * @return - 是否写入成功
+     */
+    static bool writeReport(HidDeviceHandle &device, const uint8_t *data, size_t length);
+
+    /**
+     * 停止写入线程,队列中尚未写入的命令以失败完成
+     * 在其他线程调用时等待写入线程退出;在完成回调中调用时写入线程处理完剩余命令后自行退出
+     */
+    void stop();
+
+    Stats stats() const;
+
+    size_t queuedCount() const;
+
+private:
+    struct PendingCommand {
+        //received_at_ns记录提交时间
+        HID_REPORT report;
+        Completion completion;
+    };
+
+    void run();
+
+    std::shared_ptr<HidDeviceHandle> device;
+    // 固定容量的循环队列,head为下一条要写入的位置
+    std::vector<PendingCommand> queue;
+    size_t head = 0;
+    size_t count = 0;
+    bool stopping = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    Stats writerStats;
+
+    std::thread writerThread;
+    std::atomic<std::thread::id> writerThreadId{};
+};
+
+
+#endif //COMMANDWRITER_H
@@ -0,0 +1,312 @@
+//
+// Created by Norman Wang on 2025/5/10.
+//
+
+#include "Crc32.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC32_HAS_PCLMUL 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define CRC32_HAS_ARMV8 1
+#if defined(__clang__)
+#define CRC32_ARMV8_TARGET __attribute__((target("crc")))
+#else
+#define CRC32_ARMV8_TARGET __attribute__((target("+crc")))
+#endif
+#endif
+
+// PCLMUL折叠每次处理64字节,不足时不值得使用
+static constexpr size_t PCLMUL_MIN_LENGTH = 64;
+
+// slice-by-8的8张表,第0张就是逐字节表(与Utils::CRC32_TABLE相同)
+// 这里自己生成,不依赖其他编译单元静态变量的初始化顺序
+static const std::array<std::array<uint32_t, 256>, 8> SLICE8_TABLES = []() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (uint32_t j = 0; j < 8; j++) {
+            c = ((c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1));
+        }
+        tables[0][i] = c;
+    }
+    for (size_t k = 1; k < 8; k++) {
+        for (size_t i = 0; i < 256; i++) {
+            const uint32_t previous = tables[k - 1][i];
+            tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+        }
+    }
+    return tables;
+}();
+
+static inline uint32_t loadLE32(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/**
+ * 逐字节查表(Utils::calculateCRC32原来的实现)
+ * @param crc - 未取反的CRC寄存器
+ */
+static uint32_t tableUpdate(uint32_t crc, const uint8_t *data, size_t length) {
+    const auto &table = SLICE8_TABLES[0];
+    while (length--) {
+        crc = (crc >> 8) ^ table[(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+/**
+ * slice-by-8: 每次处理8字节,8次查表互不依赖
+ */
+static uint32_t slice8Update(uint32_t crc, const uint8_t *data, size_t length) {
+    const auto &t = SLICE8_TABLES;
+    while (length >= 8) {
+        const uint32_t one = loadLE32(data) ^ crc;
+        const uint32_t two = loadLE32(data + 4);
+        crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+              t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+        data += 8;
+        length -= 8;
+    }
+    return tableUpdate(crc, data, length);
+}
+
+#ifdef CRC32_HAS_PCLMUL
+/**
+ * 无进位乘法折叠(Intel "Fast CRC Computation Using PCLMULQDQ"中反射域的常数)
+ * 要求length >= 64且为16的倍数
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t pclmulFold(const uint32_t crc, const uint8_t *data, size_t length) {
+    alignas(16) static const uint64_t k1k2[2] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const uint64_t k3k4[2] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const uint64_t k5k0[2] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[2] = {0x01db710641, 0x01f7011641};
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+    data += 64;
+    length -= 64;
+
+    // 4路并行,每次折叠64字节
+    while (length >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+        y6 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+        y7 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+        y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        data += 64;
+        length -= 64;
+    }
+
+    // 4路合并为128位
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // 剩余的16字节块
+    while (length >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        data += 16;
+        length -= 16;
+    }
+
+    // 128位折叠到64位
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett约减到32位
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+static uint32_t pclmulUpdate(uint32_t crc, const uint8_t *data, size_t length) {
+    if (length >= PCLMUL_MIN_LENGTH) {
+        const size_t folded = length & ~static_cast<size_t>(15);
+        crc = pclmulFold(crc, data, folded);
+        data += folded;
+        length -= folded;
+    }
+    return slice8Update(crc, data, length);
+}
+#endif
+
+#ifdef CRC32_HAS_ARMV8
+/**
+ * ARMv8 CRC32指令(CRC32B/CRC32X使用的正是0x04C11DB7的反射多项式)
+ */
+CRC32_ARMV8_TARGET
+static uint32_t armv8Update(uint32_t crc, const uint8_t *data, size_t length) {
+    while (length >= 8) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc = __crc32d(crc, value);
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32b(crc, *data++);
+    }
+    return crc;
+}
+#endif
+
+bool Crc32::supported(const Implementation implementation) {
+    switch (implementation) {
+        case Implementation::TABLE:
+        case Implementation::SLICE8:
+            return true;
+        case Implementation::PCLMUL:
+#ifdef CRC32_HAS_PCLMUL
+            return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#else
+            return false;
+#endif
+        case Implementation::ARMV8:
+#if defined(CRC32_HAS_ARMV8) && defined(__APPLE__)
+            // 所有Apple芯片都支持CRC32指令
+            return true;
+#elif defined(CRC32_HAS_ARMV8) && defined(__linux__)
+            return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *Crc32::name(const Implementation implementation) {
+    switch (implementation) {
+        case Implementation::TABLE:
+            return "table";
+        case Implementation::SLICE8:
+            return "slice8";
+        case Implementation::PCLMUL:
+            return "pclmul";
+        case Implementation::ARMV8:
+            return "armv8";
+    }
+    return "unknown";
+}
+
+/**
+ * 选择当前CPU上最快的实现,环境变量XREAL_CRC32可以强制指定
+ */
+static Crc32::Implementation detect() {
+    using Implementation = Crc32::Implementation;
+    if (const char *forced = std::getenv("XREAL_CRC32")) {
+        for (const auto implementation: {Implementation::TABLE, Implementation::SLICE8, Implementation::PCLMUL,
+                                         Implementation::ARMV8}) {
+            if (std::string(forced) == Crc32::name(implementation) && Crc32::supported(implementation)) {
+                return implementation;
+            }
+        }
+    }
+    if (Crc32::supported(Implementation::ARMV8)) {
+        return Implementation::ARMV8;
+    }
+    if (Crc32::supported(Implementation::PCLMUL)) {
+        return Implementation::PCLMUL;
+    }
+    return Implementation::SLICE8;
+}
+
+Crc32::Implementation Crc32::selected() {
+    static const Implementation implementation = detect();
+    return implementation;
+}
+
+/**
+ * 按实现更新CRC寄存器
+ */
+static uint32_t updateWith(const Crc32::Implementation implementation, const uint32_t crc, const uint8_t *data,
+                           const size_t length) {
+    switch (implementation) {
+        case Crc32::Implementation::TABLE:
+            return tableUpdate(crc, data, length);
+#ifdef CRC32_HAS_PCLMUL
+        case Crc32::Implementation::PCLMUL:
+            return pclmulUpdate(crc, data, length);
+#endif
+#ifdef CRC32_HAS_ARMV8
+        case Crc32::Implementation::ARMV8:
+            return armv8Update(crc, data, length);
+#endif
+        default:
+            return slice8Update(crc, data, length);
+    }
+}
+
+uint32_t Crc32::compute(const uint8_t *data, const size_t length) {
+    return ~updateWith(selected(), 0xFFFFFFFF, data, length);
+}
+
+uint32_t Crc32::compute(const Implementation implementation, const uint8_t *data, const size_t length) {
+    const Implementation effective = supported(implementation) ? implementation : Implementation::SLICE8;
+    return ~updateWith(effective, 0xFFFFFFFF, data, length);
+}
+
+Crc32 &Crc32::update(const uint8_t *data, const size_t length) {
+    state = updateWith(selected(), state, data, length);
+    return *this;
+}
@@ -0,0 +1,78 @@
+//
+// Created by Norman Wang on 2025/5/10.
+//
+
+#ifndef CRC32_H
+#define CRC32_H
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * CRC32(反射多项式0xEDB88320,初值和结果异或0xFFFFFFFF),结果与Utils::calculateCRC32逐位一致
+ * 运行时选择当前CPU上最快的实现:
+ *   ARMv8   - CRC32指令
+ *   x86     - 64字节以上使用PCLMULQDQ无进位乘法折叠,其余部分用slice-by-8
+ *   其他    - slice-by-8查表
+ * 可以用环境变量XREAL_CRC32=table/slice8/pclmul/armv8强制指定实现(用于对比测量).
+ *
+ * 一次性计算: Crc32::compute(data, length)
+ * 分段计算:   Crc32 crc; crc.update(a, n); crc.update(b, m); crc.finalize()
+ */
+class Crc32 {
+public:
+    enum class Implementation {
+        TABLE,    // 每字节查一次表(原实现)
+        SLICE8,   // 每次处理8字节
+        PCLMUL,   // x86无进位乘法折叠
+        ARMV8     // ARMv8 CRC32指令
+    };
+
+    /**
+     * 一次性计算一段数据的CRC32
+     */
+    static uint32_t compute(const uint8_t *data, size_t length);
+
+    /**
+     * 使用指定实现计算(当前CPU不支持时退回slice-by-8)
+     */
+    static uint32_t compute(Implementation implementation, const uint8_t *data, size_t length);
+
+    /**
+     * 当前选中的实现
+     */
+    static Implementation selected();
+
+    /**
+     * 当前CPU是否支持该实现
+     */
+    static bool supported(Implementation implementation);
+
+    static const char *name(Implementation implementation);
+
+    /**
+     * 追加一段数据
+     */
+    Crc32 &update(const uint8_t *data, size_t length);
+
+    /**
+     * 得到目前为止所有数据的CRC32(不影响继续追加)
+     */
+    [[nodiscard]] uint32_t finalize() const {
+        return ~state;
+    }
+
+    /**
+     * 重新开始计算
+     */
+    void reset() {
+        state = 0xFFFFFFFF;
+    }
+
+private:
+    // 未取反的CRC寄存器
+    uint32_t state = 0xFFFFFFFF;
+};
+
+
+#endif //CRC32_H
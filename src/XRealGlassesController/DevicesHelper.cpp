@@ -3,55 +3,29 @@
 //
 
 #include "DevicesHelper.h"
-#include <hidapi/hidapi.h>
-#include <locale>
-#include <codecvt>
-#include <thread>
+#include <algorithm>
 
 #include "CommandHelper.h"
+#include "InterfaceProber.h"
+#include "Logger.h"
 #include "Utils.h"
 
-// 辅助函数: 将wchar_t*转换为std::string
-std::string wcharToString(const wchar_t *wstr) {
-    if (!wstr) return "";
-
-    try {
-        // 使用C++标准库进行转换
-        std::wstring_convert<std::codecvt_utf8<wchar_t> > converter;
-        return converter.to_bytes(wstr);
-    } catch (const std::exception &e) {
-        Utils::log(std::string("字符转换异常: ") + e.what(), LogLevel::ERROR);
-        return "";
-    }
-}
-
 std::vector<GLASSES_INFO> DevicesHelper::enumerateClassesByHid() {
-    // Initialize the HIDAPI library
-    if (hid_init() != 0) {
-        Utils::log("无法初始化HID库", LogLevel::ERROR);
-        return {};
-    }
-
     std::vector<GLASSES_INFO> glassesList;
 
     try {
-        //根据VID查询所有XREAL设备的所有接口
-        struct hid_device_info *deviceList = hid_enumerate(XREAL_VID, 0);
-        if (!deviceList) {
+        //根据VID查询所有XREAL设备的所有接口(真实设备或模拟设备,由当前传输层决定)
+        const std::vector<HID_DEVICE_ENTRY> deviceList = HidTransport::current().enumerate(XREAL_VID);
+        if (deviceList.empty()) {
             Utils::log("未找到任何XREAL设备", LogLevel::WARNING);
-            hid_exit();  // 确保退出HID库
             return {};
         }
-        
-        //指针游标
-        const struct hid_device_info *currentDevice = deviceList;
 
-        while (currentDevice) {
+        for (const auto &currentDevice: deviceList) {
             //如果glassesList已经有了这个序列号的设备,则向其接口列表中添加当前"device"作为接口
-            auto sn = currentDevice->serial_number ? wcharToString(currentDevice->serial_number) : "";
+            const auto &sn = currentDevice.serial_number;
             if (sn.empty()) {
                 Utils::log("设备没有序列号，跳过", LogLevel::WARNING);
-                currentDevice = currentDevice->next;
                 continue;
             }
             
@@ -62,24 +36,22 @@ std::vector<GLASSES_INFO> DevicesHelper::enumerateClassesByHid() {
             if (thisDevice != glassesList.end()) {
                 // 找到匹配的设备，添加接口
                 INTERFACE_INFO interfaceInfo{};
-                interfaceInfo.interface_number = currentDevice->interface_number;
-                interfaceInfo.hid_path = currentDevice->path ? currentDevice->path : "";
+                interfaceInfo.interface_number = currentDevice.interface_number;
+                interfaceInfo.hid_path = currentDevice.path;
                 thisDevice->interfaces.push_back(interfaceInfo);
                 Utils::log("找到子设备: Interface = " + std::to_string(interfaceInfo.interface_number), LogLevel::INFO);
             } else {
                 // 没有找到匹配的设备，创建新的GLASSES_INFO对象
                 GLASSES_INFO newGlassesInfo;
-                newGlassesInfo.vendorId = currentDevice->vendor_id;
-                newGlassesInfo.productId = currentDevice->product_id;
+                newGlassesInfo.vendorId = currentDevice.vendor_id;
+                newGlassesInfo.productId = currentDevice.product_id;
                 newGlassesInfo.serialNumber = sn;
-                newGlassesInfo.manufacturer = currentDevice->manufacturer_string ? 
-                                             wcharToString(currentDevice->manufacturer_string) : "";
-                newGlassesInfo.product = currentDevice->product_string ? 
-                                         wcharToString(currentDevice->product_string) : "";
+                newGlassesInfo.manufacturer = currentDevice.manufacturer;
+                newGlassesInfo.product = currentDevice.product;
                 newGlassesInfo.interfaces.clear();
                 auto interfaceInfo = INTERFACE_INFO{};
-                interfaceInfo.interface_number = currentDevice->interface_number;
-                interfaceInfo.hid_path = currentDevice->path ? currentDevice->path : "";
+                interfaceInfo.interface_number = currentDevice.interface_number;
+                interfaceInfo.hid_path = currentDevice.path;
                 newGlassesInfo.interfaces.push_back(interfaceInfo);
 
                 Utils::log(
@@ -89,168 +61,87 @@ std::vector<GLASSES_INFO> DevicesHelper::enumerateClassesByHid() {
 
                 glassesList.push_back(newGlassesInfo);
             }
-            currentDevice = currentDevice->next;
         }
-
-        // Free the device list allocated by HIDAPI
-        hid_free_enumeration(deviceList);
     } catch (const std::exception &e) {
         Utils::log(std::string("遍历设备时发生异常: ") + e.what(), LogLevel::ERROR);
     }
-
-    // Finalize the HIDAPI library
-    if (hid_exit() != 0) {
-        Utils::log("无法关闭HID库", LogLevel::WARNING);
-    }
     return glassesList;
 }
 
-INTERFACE_INFO DevicesHelper::getValidHidInterface(const std::vector<INTERFACE_INFO> &interfaces) {
+INTERFACE_INFO DevicesHelper::getValidHidInterface(const std::vector<INTERFACE_INFO> &interfaces,
+                                                   const std::chrono::milliseconds deadline) {
     // 检查接口列表是否为空
     if (interfaces.empty()) {
         Utils::log("接口列表为空，无法查找有效接口", LogLevel::ERROR);
         return INTERFACE_INFO{};
     }
 
-    //向每一个接口发送一条v消息
-    for (auto &interface: interfaces) {
-        const auto nonConstInterface = const_cast<INTERFACE_INFO *>(&interface);
-        //打开设备
-        if (!nonConstInterface->open()) {
-            Utils::log("无法打开接口 " + std::to_string(interface.interface_number), LogLevel::WARNING);
-            continue;
-        }
-        //使用异步方式发送命令
-        sendCommandAsync(nonConstInterface, "v", [](bool result) {
-            if (result) {
-                Utils::log("命令发送成功", LogLevel::SUCCESS);
-            } else {
-                Utils::log("命令发送失败", LogLevel::ERROR);
-            }
-        });
-    }
-    // 等待1秒钟
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    
-    // 用于保存找到的有效接口
-    INTERFACE_INFO validInterface;
-    bool found = false;
-    
-    //检查所有接口上收到的消息列表,如果最后一条是0xFD开头的消息,则这个接口就是有效的用于通讯的接口
-    for (const auto &interface: interfaces) {
-        // 检查最后一条消息是否以0xFD开头
-        if (!interface.received_messages.empty() && !interface.received_messages.back().empty() &&
-            interface.received_messages.back()[0] == 0xFD) {
-            Utils::log("找到有效的通讯接口: " + std::to_string(interface.interface_number), LogLevel::SUCCESS);
-            validInterface = interface;
-            found = true;
-            break;
-        }
-    }
-    
-    // 关闭无效的接口，保持有效接口打开
-    for (auto &interface: interfaces) {
-        // 如果不是找到的有效接口，则关闭它
-        if (found && interface.interface_number != validInterface.interface_number) {
-            const auto nonConstInterface = const_cast<INTERFACE_INFO *>(&interface);
-            nonConstInterface->close();
-        }
-        // 如果没找到有效接口，或者遍历到的就是有效接口，则不关闭
-    }
-    
-    if (!found) {
+    // 所有接口同时探测,第一个给出0xFD应答的就是用于通讯的接口,其余接口由探测器立即关闭
+    InterfaceProber prober(deadline);
+    const int winner = prober.probe(interfaces);
+    if (winner < 0) {
         Utils::log("没有找到有效的通讯接口", LogLevel::ERROR);
-        
-        // 如果没找到有效接口，关闭所有接口
-        for (auto &interface: interfaces) {
-            const auto nonConstInterface = const_cast<INTERFACE_INFO *>(&interface);
-            nonConstInterface->close();
-        }
-        
         return INTERFACE_INFO{};
     }
-    
-    return validInterface;
+
+    Logger::success("找到有效的通讯接口: %d", interfaces[winner].interface_number);
+    return interfaces[winner];
 }
 
 /**
- * 发送命令到眼镜设备（字节数组版本）
+ * 发送命令到眼镜设备
  * @param interface
- * @param command - 命令数据
+ * @param data - 命令数据(完整报文,如CommandHelper::encode的结果)
+ * @param length - 数据长度
  * @return - 发送是否成功
  */
-bool DevicesHelper::sendCommand(const INTERFACE_INFO *interface, const std::vector<uint8_t> &command) {
+bool DevicesHelper::sendCommand(const INTERFACE_INFO *interface, const uint8_t *data, const size_t length) {
     // 检查设备是否连接
-    if (!interface || !interface->is_connected || !interface->original_hid_device()) {
-        Utils::log("设备未打开或无效，无法发送命令", LogLevel::ERROR);
+    if (!interface || !interface->is_connected || !interface->device_handle()) {
+        Logger::error("设备未打开或无效，无法发送命令");
         return false;
     }
-    Utils::log("设备状态正常", LogLevel::SUCCESS);
+    Logger::success("设备状态正常");
     try {
-        // 不再添加0xFD前缀，直接使用command
-        // 因为buildCustomDisplayCommand已经设置了buffer[0] = 0xFD
-        const std::vector<uint8_t>& data = command;
-        
         // 检查数据有效性
-        if (data.empty()) {
-            Utils::log("命令数据为空", LogLevel::ERROR);
+        if (!data || length == 0) {
+            Logger::error("命令数据为空");
             return false;
         }
         
-        // 打印数据内容以便调试
-        std::string hexData = "发送数据: ";
-        for (size_t i = 0; i < std::min(data.size(), static_cast<size_t>(32)); i++) {
-            char hexBuf[8];
-            snprintf(hexBuf, sizeof(hexBuf), "%02X ", data[i]);
-            hexData += hexBuf;
-        }
-        Utils::log(hexData, LogLevel::INFO);
+        // 打印数据内容以便调试(只复制字节,由日志线程转成十六进制)
+        Logger::info("发送数据: %s", Logger::Hex{data, std::min(length, static_cast<size_t>(32))});
 
-        // 获取设备句柄
-        hid_device* deviceHandle = interface->original_hid_device();
-        
-        // 尝试两种方式发送命令
-        try {
-            // 方式1: 使用sendReport
-            const int result = hid_write(deviceHandle, data.data(), data.size());
-            if (result > 0) {  // 只有返回值大于0时才表示成功
-                Utils::log("命令已使用sendReport发送", LogLevel::SUCCESS);
-                // 输出result
-                Utils::log("sendReport返回值: " + std::to_string(result), LogLevel::INFO);
-                return true;
-            }
-            
-            // 打印错误信息
-            const wchar_t* err = hid_error(deviceHandle);
-            Utils::log("sendReport失败: " + (err ? wcharToString(err) : "未知错误") + " 返回值: " + std::to_string(result), LogLevel::ERROR);
-            
-        } catch (const std::exception &error) {
-            Utils::log(std::string("sendReport异常: ") + error.what(), LogLevel::ERROR);
-
-            // 方式2: 尝试使用sendFeatureReport
-            try {
-                const int result = hid_send_feature_report(deviceHandle, data.data(), data.size());
-                if (result > 0) {  // 只有返回值大于0时才表示成功
-                    Utils::log("命令已使用sendFeatureReport发送", LogLevel::SUCCESS);
-                    // 输出result
-                    Utils::log("sendFeatureReport返回值: " + std::to_string(result), LogLevel::INFO);
-                    return true;
-                }
-                const wchar_t* err = hid_error(deviceHandle);
-                Utils::log("sendFeatureReport失败: " + (err ? wcharToString(err) : "未知错误") + " 返回值: " + std::to_string(result), LogLevel::ERROR);
-            } catch (const std::exception &featureError) {
-                Utils::log(std::string("sendFeatureReport也异常: ") + featureError.what(), LogLevel::ERROR);
-            }
+        // 在写入线程的完成回调里同步发送时直接写入,不能等待自己
+        const std::shared_ptr<CommandWriter> writer = interface->command_writer();
+        if (writer->isWriterThread()) {
+            return CommandWriter::writeReport(*interface->device_handle(), data, length);
         }
 
-        Utils::log("所有发送方法都失败", LogLevel::ERROR);
-        return false;
+        // 交给设备的写入线程,和其他线程发来的命令依次写入
+        const auto sent = std::make_shared<std::promise<bool>>();
+        std::future<bool> result = sent->get_future();
+        if (!writer->submit(data, length, [sent](const bool success) { sent->set_value(success); })) {
+            Logger::error("命令队列已满，发送失败");
+            return false;
+        }
+        return result.get();
     } catch (const std::exception &error) {
-        Utils::log(std::string("发送命令错误: ") + error.what(), LogLevel::ERROR);
+        Logger::error("发送命令错误: %s", error.what());
         return false;
     }
 }
 
+/**
+ * 发送命令到眼镜设备（字节数组版本）
+ * @param interface
+ * @param command - 命令数据
+ * @return - 发送是否成功
+ */
+bool DevicesHelper::sendCommand(const INTERFACE_INFO *interface, const std::vector<uint8_t> &command) {
+    return sendCommand(interface, command.data(), command.size());
+}
+
 
 /**
  * 发送命令到眼镜设备（字符串版本）
@@ -260,47 +151,50 @@ bool DevicesHelper::sendCommand(const INTERFACE_INFO *interface, const std::vect
  */
 bool DevicesHelper::sendCommand(const INTERFACE_INFO *interface, const std::string &command) {
     // 记录命令文本
-    Utils::log(std::string("命令文本: ") + command, LogLevel::INFO);
-    auto payload = CommandHelper::strToPayload(command);
-    //第一个字节0xfd + 命令的全部字节
-    payload.insert(payload.begin(), 0xFD);
-    // 将字符串转换为字节数组并发送
-    return sendCommand(interface, payload);
+    Logger::info("命令文本: %s", command);
+    //第一个字节0xfd + 命令的全部字节,直接编码到栈上的报文
+    CommandHelper::McuReport report;
+    const size_t length = CommandHelper::encodeText(report, command);
+    return sendCommand(interface, report.data(), length);
 }
 
 
 /**
  * 异步发送命令到眼镜设备
  * @param interface - 设备接口
- * @param command - 命令数据
+ * @param data - 命令数据
+ * @param length - 数据长度
  * @param callback - 命令发送完成后的回调函数，参数为是否发送成功
  */
-void DevicesHelper::sendCommandAsync(const INTERFACE_INFO *interface, const std::vector<uint8_t> &command,
-                                     std::function<void(bool)> callback) {
+void DevicesHelper::sendCommandAsync(const INTERFACE_INFO *interface, const uint8_t *data, const size_t length,
+                                     const std::function<void(bool)> &callback) {
     // 先检查接口是否有效
-    if (!interface || !interface->is_connected || !interface->original_hid_device()) {
-        Utils::log("设备未打开或无效，无法异步发送命令", LogLevel::ERROR);
+    if (!interface || !interface->is_connected || !interface->device_handle()) {
+        Logger::error("设备未打开或无效，无法异步发送命令");
         if (callback) {
             callback(false);
         }
         return;
     }
 
-    // 使用单独的线程异步发送命令
-    std::thread([interface, command, callback]() {
-        try {
-            bool result = sendCommand(interface, command);
-            // 调用回调函数传递结果
-            if (callback) {
-                callback(result);
-            }
-        } catch (const std::exception &error) {
-            Utils::log(std::string("异步发送命令错误: ") + error.what(), LogLevel::ERROR);
-            if (callback) {
-                callback(false);
-            }
+    // 交给设备的写入线程,回调在写入线程中执行;不再为每条命令创建线程,也不再持有接口指针
+    if (!interface->command_writer()->submit(data, length, callback)) {
+        Logger::error("命令队列已满，无法异步发送命令");
+        if (callback) {
+            callback(false);
         }
-    }).detach(); // 使用detach分离线程
+    }
+}
+
+/**
+ * 异步发送命令到眼镜设备（字节数组版本）
+ * @param interface - 设备接口
+ * @param command - 命令数据
+ * @param callback - 命令发送完成后的回调函数，参数为是否发送成功
+ */
+void DevicesHelper::sendCommandAsync(const INTERFACE_INFO *interface, const std::vector<uint8_t> &command,
+                                     std::function<void(bool)> callback) {
+    sendCommandAsync(interface, command.data(), command.size(), callback);
 }
 
 /**
@@ -311,20 +205,107 @@ void DevicesHelper::sendCommandAsync(const INTERFACE_INFO *interface, const std:
  */
 void DevicesHelper::sendCommandAsync(const INTERFACE_INFO *interface, const std::string &command,
                                      const std::function<void(bool)> &callback) {
-    // 先检查接口是否有效
-    if (!interface || !interface->is_connected || !interface->original_hid_device()) {
-        Utils::log("设备未打开或无效，无法异步发送命令: " + command, LogLevel::ERROR);
-        if (callback) {
-            callback(false);
+    CommandHelper::McuReport report;
+    const size_t length = CommandHelper::encodeText(report, command);
+    sendCommandAsync(interface, report.data(), length, callback);
+}
+
+
+
+/**
+ * 从0xFD命令中读出序号和消息ID
+ */
+static void readRequestKey(const uint8_t *command, uint32_t &sequence, uint16_t &msgId) {
+    const uint8_t *seq = command + MCU_REPORT_LAYOUT::SEQUENCE.offset;
+    sequence = seq[0] | (seq[1] << 8) | (seq[2] << 16) | (static_cast<uint32_t>(seq[3]) << 24);
+    const uint8_t *id = command + MCU_REPORT_LAYOUT::MSG_ID.offset;
+    msgId = static_cast<uint16_t>(id[0] | (id[1] << 8));
+}
+
+/**
+ * 立即以失败完成一个请求
+ */
+static std::future<COMMAND_RESULT> failedRequest(const std::string &error, const PendingRequestTable::Callback &callback) {
+    std::promise<COMMAND_RESULT> failed;
+    COMMAND_RESULT result;
+    result.error = error;
+    if (callback) {
+        callback(result);
+    }
+    failed.set_value(result);
+    return failed.get_future();
+}
+
+/**
+ * 异步写入已登记的请求,写入失败时立即以失败完成该请求,不必等到超时
+ * 回调只持有请求表,接口在写入完成前被关闭也不会访问到它
+ */
+static void failRequestIfNotSent(const INTERFACE_INFO *interface, const uint8_t *data, const size_t length,
+                                 const uint32_t sequence, const uint16_t msgId) {
+    const std::shared_ptr<PendingRequestTable> pending = interface->pending_requests;
+    DevicesHelper::sendCommandAsync(interface, data, length, [pending, sequence, msgId](const bool sent) {
+        if (!sent) {
+            pending->fail(sequence, msgId, "命令发送失败");
         }
-        return;
+    });
+}
+
+/**
+ * 发送命令并等待设备应答
+ * @param interface - 设备接口
+ * @param data - 0xFD命令
+ * @param length - 命令长度
+ * @param timeout - 等待应答的最长时间
+ * @param callback - 完成时的回调
+ * @return - 应答结果
+ */
+std::future<COMMAND_RESULT> DevicesHelper::sendRequest(const INTERFACE_INFO *interface, const uint8_t *data,
+                                                       const size_t length, const std::chrono::milliseconds timeout,
+                                                       PendingRequestTable::Callback callback) {
+    if (!interface || !interface->pending_requests || !data || length < MCU_REPORT_LAYOUT::MSG_ID.end() ||
+        data[0] != MCU_REPORT_LAYOUT::HEAD_BYTE) {
+        return failedRequest("接口无效或命令格式错误", callback);
     }
-    
-    auto payload = CommandHelper::strToPayload(command);
-    //第一个字节0xfd + 命令的全部字节
-    payload.insert(payload.begin(), 0xFD);
-    // 将字符串转换为字节数组并发送
-    sendCommandAsync(interface, payload, callback);
+
+    uint32_t sequence;
+    uint16_t msgId;
+    readRequestKey(data, sequence, msgId);
+
+    // 先登记再写入,避免应答比登记先到;写入交给设备的写入线程,调用方不等待hid_write
+    auto future = interface->pending_requests->add(sequence, msgId, timeout, std::move(callback));
+    failRequestIfNotSent(interface, data, length, sequence, msgId);
+    return future;
+}
+
+/**
+ * 发送命令并等待设备应答（字节数组版本）
+ */
+std::future<COMMAND_RESULT> DevicesHelper::sendRequest(const INTERFACE_INFO *interface,
+                                                       const std::vector<uint8_t> &command,
+                                                       const std::chrono::milliseconds timeout,
+                                                       PendingRequestTable::Callback callback) {
+    return sendRequest(interface, command.data(), command.size(), timeout, std::move(callback));
 }
 
+/**
+ * 发送字符串命令并等待该接口上的任意0xFD应答
+ * @param interface - 设备接口
+ * @param command - 命令字符串
+ * @param timeout - 等待应答的最长时间
+ * @param callback - 完成时的回调
+ * @return - 应答结果
+ */
+std::future<COMMAND_RESULT> DevicesHelper::sendRequest(const INTERFACE_INFO *interface, const std::string &command,
+                                                       const std::chrono::milliseconds timeout,
+                                                       PendingRequestTable::Callback callback) {
+    if (!interface || !interface->pending_requests) {
+        return failedRequest("接口无效", callback);
+    }
 
+    // 字符串命令没有序号,序号记为0,匹配任意0xFD应答
+    auto future = interface->pending_requests->add(0, PendingRequestTable::ANY_MSG_ID, timeout, std::move(callback));
+    CommandHelper::McuReport report;
+    const size_t length = CommandHelper::encodeText(report, command);
+    failRequestIfNotSent(interface, report.data(), length, 0, PendingRequestTable::ANY_MSG_ID);
+    return future;
+}
@@ -4,9 +4,13 @@
 
 #ifndef DEVICESHELPER_H
 #define DEVICESHELPER_H
+#include <chrono>
+#include <future>
 #include <map>
 #include <vector>
 
+#include "COMMAND_RESULT.h"
+#include "CommandHelper.h"
 #include "GLASSES_INFO.h"
 
 
@@ -28,9 +32,11 @@ public:
     /**
      * 测试设备通讯
      * @param interfaces - 要测试的接口列表
+     * @param deadline - 等待接口应答的最长时间
      * @return - 有效接口路径列表
      */
-    static INTERFACE_INFO getValidHidInterface(const std::vector<INTERFACE_INFO>& interfaces);
+    static INTERFACE_INFO getValidHidInterface(const std::vector<INTERFACE_INFO>& interfaces,
+                                               std::chrono::milliseconds deadline = std::chrono::milliseconds(1000));
     /**
      * 发送命令到眼镜设备
      * @param interface 要使用哪个接口发送
@@ -39,13 +45,59 @@ public:
      */
     static bool sendCommand(const INTERFACE_INFO *interface, const std::vector<uint8_t>& command);
 
+    /**
+     * 发送一条已编码的报文(如CommandHelper::McuReport),不产生额外的拷贝和分配
+     * @param interface 要使用哪个接口发送
+     * @param data - 报文数据
+     * @param length - 报文长度
+     * @return - 发送是否成功
+     */
+    static bool sendCommand(const INTERFACE_INFO *interface, const uint8_t *data, size_t length);
+
+    /**
+     * 异步发送命令,命令进入设备写入线程的队列后立即返回
+     * @param interface 要使用哪个接口发送
+     * @param command - 命令数据
+     * @param callback - 写入完成后在写入线程中调用;队列已满或接口无效时在当前线程以false调用
+     */
     static void sendCommandAsync(const INTERFACE_INFO *interface, const std::vector<uint8_t> &command,
                                  std::function<void(bool)> callback);
 
+    static void sendCommandAsync(const INTERFACE_INFO *interface, const uint8_t *data, size_t length,
+                                 const std::function<void(bool)> &callback);
+
     static void sendCommandAsync(const INTERFACE_INFO *interface, const std::string &command,
                           const std::function<void(bool)> &callback);
 
     static bool sendCommand(const INTERFACE_INFO *interface, const std::string &command);
+
+    /**
+     * 发送命令并等待设备应答
+     * 按命令中的(序号, msgId)登记到接口的请求表,收到匹配的应答立即完成
+     * 命令交给设备的写入线程后立即返回,不等待写入;写入失败时请求立即以失败完成
+     * @param interface - 要使用哪个接口发送
+     * @param command - 0xFD命令(buildCustomDisplayCommand的结果)
+     * @param timeout - 等待应答的最长时间
+     * @param callback - 完成时的回调,在反应器线程中执行(可为空)
+     * @return - 应答结果
+     */
+    static std::future<COMMAND_RESULT> sendRequest(const INTERFACE_INFO *interface, const std::vector<uint8_t> &command,
+                                                   std::chrono::milliseconds timeout,
+                                                   PendingRequestTable::Callback callback = nullptr);
+
+    /**
+     * 发送一条已编码的0xFD报文并等待设备应答
+     */
+    static std::future<COMMAND_RESULT> sendRequest(const INTERFACE_INFO *interface, const uint8_t *data, size_t length,
+                                                   std::chrono::milliseconds timeout,
+                                                   PendingRequestTable::Callback callback = nullptr);
+
+    /**
+     * 发送字符串命令并等待该接口上的任意0xFD应答(用于"v"这类探测命令)
+     */
+    static std::future<COMMAND_RESULT> sendRequest(const INTERFACE_INFO *interface, const std::string &command,
+                                                   std::chrono::milliseconds timeout,
+                                                   PendingRequestTable::Callback callback = nullptr);
 };
 
 
@@ -0,0 +1,231 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#ifndef FLOAT4_H
+#define FLOAT4_H
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define FLOAT4_SSE 1
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define FLOAT4_NEON 1
+#endif
+
+
+/**
+ * 4个float的向量(四元数按w,x,y,z存放),用于姿态融合的四元数运算
+ * Float4Scalar - 普通标量实现,任何平台都可用,也用于和SIMD实现对比
+ * Float4Simd   - x86上为SSE,ARM上为NEON,都没有时等同于Float4Scalar
+ * 两者接口完全一致,融合算法写成模板后两种实现都可以实例化.
+ */
+struct Float4Scalar {
+    float v[4];
+
+    static Float4Scalar set(const float w, const float x, const float y, const float z) {
+        return {{w, x, y, z}};
+    }
+
+    static Float4Scalar splat(const float value) {
+        return {{value, value, value, value}};
+    }
+
+    static Float4Scalar load(const float *data) {
+        return {{data[0], data[1], data[2], data[3]}};
+    }
+
+    void store(float *out) const {
+        out[0] = v[0];
+        out[1] = v[1];
+        out[2] = v[2];
+        out[3] = v[3];
+    }
+
+    template<int I>
+    [[nodiscard]] float lane() const {
+        return v[I];
+    }
+
+    /**
+     * 按下标重新排列: 结果的第i个分量 = 原来的第(A,B,C,D)[i]个分量
+     */
+    template<int A, int B, int C, int D>
+    [[nodiscard]] Float4Scalar shuffle() const {
+        return {{v[A], v[B], v[C], v[D]}};
+    }
+
+    friend Float4Scalar operator+(const Float4Scalar &a, const Float4Scalar &b) {
+        return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+    }
+
+    friend Float4Scalar operator-(const Float4Scalar &a, const Float4Scalar &b) {
+        return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+    }
+
+    friend Float4Scalar operator*(const Float4Scalar &a, const Float4Scalar &b) {
+        return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+    }
+
+    friend Float4Scalar operator*(const Float4Scalar &a, const float s) {
+        return {{a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s}};
+    }
+
+    /**
+     * 点积
+     */
+    friend float dot(const Float4Scalar &a, const Float4Scalar &b) {
+        return a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3];
+    }
+};
+
+#if defined(FLOAT4_SSE)
+struct Float4Simd {
+    __m128 v;
+
+    static Float4Simd set(const float w, const float x, const float y, const float z) {
+        return {_mm_setr_ps(w, x, y, z)};
+    }
+
+    static Float4Simd splat(const float value) {
+        return {_mm_set1_ps(value)};
+    }
+
+    static Float4Simd load(const float *data) {
+        return {_mm_loadu_ps(data)};
+    }
+
+    void store(float *out) const {
+        _mm_storeu_ps(out, v);
+    }
+
+    template<int I>
+    [[nodiscard]] float lane() const {
+        return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(I, I, I, I)));
+    }
+
+    template<int A, int B, int C, int D>
+    [[nodiscard]] Float4Simd shuffle() const {
+        return {_mm_shuffle_ps(v, v, _MM_SHUFFLE(D, C, B, A))};
+    }
+
+    friend Float4Simd operator+(const Float4Simd &a, const Float4Simd &b) {
+        return {_mm_add_ps(a.v, b.v)};
+    }
+
+    friend Float4Simd operator-(const Float4Simd &a, const Float4Simd &b) {
+        return {_mm_sub_ps(a.v, b.v)};
+    }
+
+    friend Float4Simd operator*(const Float4Simd &a, const Float4Simd &b) {
+        return {_mm_mul_ps(a.v, b.v)};
+    }
+
+    friend Float4Simd operator*(const Float4Simd &a, const float s) {
+        return {_mm_mul_ps(a.v, _mm_set1_ps(s))};
+    }
+
+    friend float dot(const Float4Simd &a, const Float4Simd &b) {
+        const __m128 product = _mm_mul_ps(a.v, b.v);
+        const __m128 pairs = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+};
+#define FLOAT4_SIMD_NAME "sse"
+#elif defined(FLOAT4_NEON)
+struct Float4Simd {
+    float32x4_t v;
+
+    static Float4Simd set(const float w, const float x, const float y, const float z) {
+        const float data[4] = {w, x, y, z};
+        return {vld1q_f32(data)};
+    }
+
+    static Float4Simd splat(const float value) {
+        return {vdupq_n_f32(value)};
+    }
+
+    static Float4Simd load(const float *data) {
+        return {vld1q_f32(data)};
+    }
+
+    void store(float *out) const {
+        vst1q_f32(out, v);
+    }
+
+    template<int I>
+    [[nodiscard]] float lane() const {
+        return vgetq_lane_f32(v, I);
+    }
+
+    template<int A, int B, int C, int D>
+    [[nodiscard]] Float4Simd shuffle() const {
+        return {__builtin_shufflevector(v, v, A, B, C, D)};
+    }
+
+    friend Float4Simd operator+(const Float4Simd &a, const Float4Simd &b) {
+        return {vaddq_f32(a.v, b.v)};
+    }
+
+    friend Float4Simd operator-(const Float4Simd &a, const Float4Simd &b) {
+        return {vsubq_f32(a.v, b.v)};
+    }
+
+    friend Float4Simd operator*(const Float4Simd &a, const Float4Simd &b) {
+        return {vmulq_f32(a.v, b.v)};
+    }
+
+    friend Float4Simd operator*(const Float4Simd &a, const float s) {
+        return {vmulq_n_f32(a.v, s)};
+    }
+
+    friend float dot(const Float4Simd &a, const Float4Simd &b) {
+        return vaddvq_f32(vmulq_f32(a.v, b.v));
+    }
+};
+#define FLOAT4_SIMD_NAME "neon"
+#else
+using Float4Simd = Float4Scalar;
+#define FLOAT4_SIMD_NAME "scalar"
+#endif
+
+/**
+ * 四元数乘法 a ⊗ b (Hamilton约定,分量顺序w,x,y,z)
+ */
+template<typename V>
+V quaternionMultiply(const V &a, const V &b) {
+    // 每一项是a的一个分量乘以b的重排并带符号
+    const V SIGN_X = V::set(-1, 1, -1, 1);
+    const V SIGN_Y = V::set(-1, 1, 1, -1);
+    const V SIGN_Z = V::set(-1, -1, 1, 1);
+    return V::splat(a.template lane<0>()) * b +
+           V::splat(a.template lane<1>()) * b.template shuffle<1, 0, 3, 2>() * SIGN_X +
+           V::splat(a.template lane<2>()) * b.template shuffle<2, 3, 0, 1>() * SIGN_Y +
+           V::splat(a.template lane<3>()) * b.template shuffle<3, 2, 1, 0>() * SIGN_Z;
+}
+
+/**
+ * 三维向量叉积,向量放在x,y,z三个分量上,结果的w分量为0
+ */
+template<typename V>
+V cross3(const V &a, const V &b) {
+    return a.template shuffle<0, 2, 3, 1>() * b.template shuffle<0, 3, 1, 2>() -
+           a.template shuffle<0, 3, 1, 2>() * b.template shuffle<0, 2, 3, 1>();
+}
+
+/**
+ * 归一化,长度为0时原样返回
+ */
+template<typename V>
+V normalize(const V &a) {
+    const float lengthSquared = dot(a, a);
+    if (lengthSquared <= 0.0f) {
+        return a;
+    }
+    return a * (1.0f / std::sqrt(lengthSquared));
+}
+
+
+#endif //FLOAT4_H
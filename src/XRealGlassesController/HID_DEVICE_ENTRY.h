@@ -0,0 +1,26 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#ifndef HID_DEVICE_ENTRY_H
+#define HID_DEVICE_ENTRY_H
+#include <cstdint>
+#include <string>
+
+
+/**
+ * 枚举到的一个HID接口(与具体传输层无关)
+ */
+struct HID_DEVICE_ENTRY {
+    //接口路径,打开接口时使用
+    std::string path;
+    uint16_t vendor_id = 0;
+    uint16_t product_id = 0;
+    std::string serial_number;
+    std::string manufacturer;
+    std::string product;
+    int interface_number = 0;
+};
+
+
+#endif //HID_DEVICE_ENTRY_H
@@ -0,0 +1,30 @@
+//
+// Created by Norman Wang on 2025/5/6.
+//
+
+#ifndef HID_REPORT_H
+#define HID_REPORT_H
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * 一条HID上报数据(定长槽位)
+ * XREAL眼镜所有接口的上报都是64字节,超出部分会被截断
+ */
+struct HID_REPORT {
+    // 单条上报的最大字节数
+    static constexpr size_t MAX_SIZE = 64;
+
+    //在所属环形缓冲区中的序号(从1开始单调递增)
+    uint64_t sequence = 0;
+    //主机收到这条上报的时间(steady_clock, 纳秒)
+    uint64_t received_at_ns = 0;
+    //有效数据长度
+    uint16_t length = 0;
+    //原始数据
+    uint8_t data[MAX_SIZE] = {0};
+};
+
+
+#endif //HID_REPORT_H
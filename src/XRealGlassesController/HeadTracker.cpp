@@ -0,0 +1,207 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#include "HeadTracker.h"
+
+#include <cstdlib>
+#include <fstream>
+
+#include "Logger.h"
+#include "Utils.h"
+
+HeadTracker::HeadTracker(std::shared_ptr<ImuSampleBuffer> samples, const SensorFusion::Config &config,
+                         const PosePredictor::Config &predictorConfig) :
+    samples(std::move(samples)), fusion(config), requestedAlgorithm(static_cast<int>(config.algorithm)),
+    predictor(predictorConfig) {
+}
+
+HeadTracker::~HeadTracker() {
+    stop();
+}
+
+void HeadTracker::setCalibration(const IMU_CALIBRATION &calibration) {
+    calibrator.setCalibration(calibration);
+    publishedCalibration.store(calibration);
+}
+
+IMU_CALIBRATION HeadTracker::calibration() const {
+    return publishedCalibration.load();
+}
+
+void HeadTracker::start() {
+    if (worker.joinable() || !samples) {
+        return;
+    }
+    stopRequested = false;
+    startedAtNs = Utils::steadyNowNs();
+    Logger::info("姿态融合: %s / %s", SensorFusion::name(fusion.algorithm()), SensorFusion::name(fusion.path()));
+    worker = std::thread([this]() { run(); });
+}
+
+void HeadTracker::stop() {
+    if (!worker.joinable()) {
+        return;
+    }
+    stopRequested = true;
+    worker.join();
+
+    const Stats result = stats();
+    if (result.samples > 0 && result.elapsed_ns > 0) {
+        Logger::info("姿态融合已停止: 样本 %u, 批次 %u, 每条 %uns, CPU占用 %.2f%%", result.samples, result.batches,
+                     result.busy_ns / result.samples,
+                     100.0 * static_cast<double>(result.busy_ns) / static_cast<double>(result.elapsed_ns));
+    }
+
+    const Latency delays = latency();
+    if (delays.consume.count > 0) {
+        Logger::info("IMU延迟(p50/p99/max): 传输 %.1f/%.1f/%.1fus, 消费 %.1f/%.1f/%.1fus",
+                     static_cast<double>(delays.transit.percentile(0.5)) / 1e3,
+                     static_cast<double>(delays.transit.percentile(0.99)) / 1e3,
+                     static_cast<double>(delays.transit.max_ns) / 1e3,
+                     static_cast<double>(delays.consume.percentile(0.5)) / 1e3,
+                     static_cast<double>(delays.consume.percentile(0.99)) / 1e3,
+                     static_cast<double>(delays.consume.max_ns) / 1e3);
+    }
+
+    const ClockSync::Estimate clock = clockSync.estimate();
+    if (clock.synced) {
+        Logger::info("时钟同步: 偏移 %.3fms, 漂移 %.2fppm, 残差 %.1fus, 剔除 %zu/%zu个窗口",
+                     static_cast<double>(clock.offset_ns) / 1e6, clock.skew_ppm, clock.residual_rms_ns / 1e3,
+                     clock.rejected_windows, clock.windows);
+    }
+
+    // 融合线程已经退出,predictor不会再被修改
+    for (const auto &error: predictor.errorStats()) {
+        if (error.count == 0) {
+            continue;
+        }
+        Logger::info("预测 %.1fms: 平均误差 %.3f°, RMS %.3f°, 最大 %.3f° (%llu次)",
+                     static_cast<double>(error.horizon_ns) / 1e6, error.mean_degrees, error.rms_degrees,
+                     error.max_degrees, error.count);
+    }
+    if (const char *tracePath = std::getenv("XREAL_PREDICTION_TRACE")) {
+        std::ofstream trace(tracePath);
+        if (trace) {
+            predictor.writeTrace(trace);
+            Logger::info("预测误差记录已写入: %s", tracePath);
+        } else {
+            Logger::warning("无法写入预测误差记录: %s", tracePath);
+        }
+    }
+}
+
+void HeadTracker::run() {
+    IMU_SAMPLE batch[BATCH_SIZE];
+    ImuSampleBuffer::Cursor cursor = samples->cursorAtEnd();
+    bool calibratedThisRun = false;
+
+    while (!stopRequested) {
+        const auto requested = static_cast<SensorFusion::Algorithm>(requestedAlgorithm.load(std::memory_order_relaxed));
+        if (requested != fusion.algorithm()) {
+            fusion.setAlgorithm(requested);
+            Logger::info("姿态融合切换为: %s", SensorFusion::name(requested));
+        }
+
+        const uint64_t droppedBefore = cursor.dropped;
+        const size_t count = samples->read(cursor, batch, BATCH_SIZE);
+        if (count == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        const uint64_t beginNs = Utils::steadyNowNs();
+        for (size_t i = 0; i < count; i++) {
+            consumeLatency.record(beginNs - batch[i].received_at_ns);
+            clockSync.observe(batch[i].device_timestamp_ns, batch[i].received_at_ns);
+            // 先用原始样本判断静止/更新校准参数,再校准这条样本
+            if (calibrator.observe(batch[i])) {
+                publishedCalibration.store(calibrator.calibration());
+                if (!calibratedThisRun) {
+                    calibratedThisRun = true;
+                    const IMU_CALIBRATION &calibration = calibrator.calibration();
+                    Logger::info("检测到静止,陀螺仪零偏: %.5f %.5f %.5f rad/s",
+                                 calibration.gyro_bias[0], calibration.gyro_bias[1], calibration.gyro_bias[2]);
+                }
+            }
+            calibrator.apply(batch[i]);
+        }
+        const ClockSync::Estimate clock = clockSync.estimate();
+        if (clock.synced) {
+            for (size_t i = 0; i < count; i++) {
+                const uint64_t sampledAtNs = ClockSync::toHost(clock, batch[i].device_timestamp_ns);
+                transitLatency.record(batch[i].received_at_ns > sampledAtNs
+                                          ? batch[i].received_at_ns - sampledAtNs
+                                          : 0);
+            }
+        }
+        ORIENTATION orientation = fusion.update(batch, count, cursor.next - count);
+        // 预测从采样时刻算起,而不是从收到的时刻(后者包含USB传输和调度的抖动)
+        orientation.host_timestamp_ns = clock.synced ? ClockSync::toHost(clock, orientation.device_timestamp_ns)
+                                                     : orientation.host_timestamp_ns;
+        busyNs.fetch_add(Utils::steadyNowNs() - beginNs, std::memory_order_relaxed);
+        predictor.update(orientation);
+        published.store(predictor.state());
+        publishErrors();
+
+        fusedSamples.fetch_add(count, std::memory_order_relaxed);
+        batches.fetch_add(1, std::memory_order_relaxed);
+        if (cursor.dropped != droppedBefore) {
+            overwritten.fetch_add(cursor.dropped - droppedBefore, std::memory_order_relaxed);
+        }
+    }
+}
+
+ORIENTATION HeadTracker::latest() const {
+    return published.load().orientation;
+}
+
+bool HeadTracker::predict(const uint64_t targetNs, ORIENTATION &out) const {
+    PosePredictor::State state;
+    if (published.load(state) == 0) {
+        return false;
+    }
+    PosePredictor::extrapolate(state, static_cast<int64_t>(targetNs - state.orientation.host_timestamp_ns),
+                               predictor.configuration(), out);
+    return true;
+}
+
+std::vector<PosePredictor::ErrorStats> HeadTracker::predictionErrors() const {
+    const PublishedErrors errors = publishedErrors.load();
+    return {errors.horizons, errors.horizons + errors.count};
+}
+
+void HeadTracker::publishErrors() {
+    PublishedErrors errors;
+    errors.count = predictor.errorStats(errors.horizons, MAX_PUBLISHED_HORIZONS);
+    publishedErrors.store(errors);
+}
+
+ClockSync::Estimate HeadTracker::clockEstimate() const {
+    return clockSync.estimate();
+}
+
+bool HeadTracker::deviceTimeToHost(const uint64_t deviceNs, uint64_t &out) const {
+    return clockSync.toHost(deviceNs, out);
+}
+
+void HeadTracker::setAlgorithm(const SensorFusion::Algorithm algorithm) {
+    requestedAlgorithm.store(static_cast<int>(algorithm), std::memory_order_relaxed);
+}
+
+HeadTracker::Stats HeadTracker::stats() const {
+    Stats result;
+    result.samples = fusedSamples.load(std::memory_order_relaxed);
+    result.batches = batches.load(std::memory_order_relaxed);
+    result.overwritten = overwritten.load(std::memory_order_relaxed);
+    result.busy_ns = busyNs.load(std::memory_order_relaxed);
+    result.elapsed_ns = startedAtNs ? Utils::steadyNowNs() - startedAtNs : 0;
+    return result;
+}
+
+HeadTracker::Latency HeadTracker::latency() const {
+    Latency result;
+    result.transit = transitLatency.snapshot();
+    result.consume = consumeLatency.snapshot();
+    return result;
+}
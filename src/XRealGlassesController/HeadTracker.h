@@ -0,0 +1,176 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#ifndef HEADTRACKER_H
+#define HEADTRACKER_H
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "ClockSync.h"
+#include "IMU_CALIBRATION.h"
+#include "ImuCalibrator.h"
+#include "ImuSampleBuffer.h"
+#include "LatencyHistogram.h"
+#include "ORIENTATION.h"
+#include "PosePredictor.h"
+#include "SeqLock.h"
+#include "SensorFusion.h"
+
+
+/**
+ * 头部追踪
+ * 独立线程按游标从IMU样本缓冲区成批取出新样本,经ImuCalibrator校准后交给SensorFusion,并发布最新的朝向;
+ * 校准参数在静止时持续更新,可以在启动前设置缓存的校准参数,一开始就使用.
+ * 同时用ClockSync把设备时间戳换算到主机时钟,朝向的host_timestamp_ns和预测都以此为准.
+ * 每个新朝向同时交给PosePredictor,其他线程可以把朝向预测到下一帧的出光时间.
+ * 最新的朝向和外推状态、预测误差统计、校准参数都通过SeqLock发布,其他线程读取时不加锁,不会阻塞融合线程.
+ * 没有新样本时每1ms检查一次(约等于1kHz的上报周期),有积压时一次最多处理一批.
+ * 设置环境变量XREAL_PREDICTION_TRACE=文件路径时,停止时把最近的预测误差记录写成CSV.
+ */
+class HeadTracker {
+public:
+    /**
+     * 融合统计
+     */
+    struct Stats {
+        //已融合的样本数
+        uint64_t samples = 0;
+        //处理过的批次数
+        uint64_t batches = 0;
+        //读取太慢而被覆盖的样本数
+        uint64_t overwritten = 0;
+        //融合计算的总耗时(纳秒)
+        uint64_t busy_ns = 0;
+        //从启动到现在的时间(纳秒)
+        uint64_t elapsed_ns = 0;
+    };
+
+    /**
+     * 样本从采样到被融合的各段延迟,与读取线程的处理耗时(StreamHealth)一起定位延迟尖峰的来源
+     */
+    struct Latency {
+        //主机收到的时间 - 设备时间戳换算到主机的时间,即超出最小传输延迟的部分(USB/内核/读取线程的唤醒)
+        LatencyHistogram::Snapshot transit;
+        //样本写入缓冲区到被融合线程读走的时间(消费者)
+        LatencyHistogram::Snapshot consume;
+    };
+
+    /**
+     * @param samples - IMU样本缓冲区
+     * @param config - 融合配置
+     */
+    explicit HeadTracker(std::shared_ptr<ImuSampleBuffer> samples,
+                         const SensorFusion::Config &config = SensorFusion::defaultConfig(),
+                         const PosePredictor::Config &predictorConfig = PosePredictor::Config());
+
+    ~HeadTracker();
+
+    HeadTracker(const HeadTracker&) = delete;
+    HeadTracker& operator=(const HeadTracker&) = delete;
+
+    /**
+     * 设置初始的校准参数(需在start之前调用)
+     */
+    void setCalibration(const IMU_CALIBRATION &calibration);
+
+    /**
+     * 当前的校准参数(含本次运行中的更新)
+     */
+    IMU_CALIBRATION calibration() const;
+
+    void start();
+
+    void stop();
+
+    /**
+     * 最新的朝向
+     */
+    ORIENTATION latest() const;
+
+    /**
+     * 把最新的朝向预测到指定时刻
+     * @param targetNs - 主机时间(steady_clock纳秒),通常是下一帧的预计出光时间
+     * @param out - 预测的朝向
+     * @return - 是否已有朝向数据
+     */
+    bool predict(uint64_t targetNs, ORIENTATION &out) const;
+
+    /**
+     * 各预测时长的误差统计
+     */
+    std::vector<PosePredictor::ErrorStats> predictionErrors() const;
+
+    /**
+     * 设备时钟与主机时钟的换算关系
+     */
+    ClockSync::Estimate clockEstimate() const;
+
+    /**
+     * 把设备时间戳换算成主机时间(steady_clock)
+     * @return - 是否已经同步
+     */
+    bool deviceTimeToHost(uint64_t deviceNs, uint64_t &out) const;
+
+    /**
+     * 切换融合算法,下一批样本开始生效
+     */
+    void setAlgorithm(SensorFusion::Algorithm algorithm);
+
+    Stats stats() const;
+
+    Latency latency() const;
+
+private:
+    void run();
+
+    // 发布predictor当前的误差统计(融合线程)
+    void publishErrors();
+
+    // 每批最多处理的样本数
+    static constexpr size_t BATCH_SIZE = 64;
+
+    std::shared_ptr<ImuSampleBuffer> samples;
+    SensorFusion fusion;
+    ImuCalibrator calibrator;
+    ClockSync clockSync;
+    std::thread worker;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<int> requestedAlgorithm;
+
+    // 发布的预测时长个数上限(默认统计4个)
+    static constexpr size_t MAX_PUBLISHED_HORIZONS = 8;
+
+    /**
+     * 发布给其他线程的误差统计(SeqLock要求定长)
+     */
+    struct PublishedErrors {
+        size_t count = 0;
+        PosePredictor::ErrorStats horizons[MAX_PUBLISHED_HORIZONS];
+    };
+
+    // 只在融合线程中使用(停止后由调用stop的线程读取)
+    PosePredictor predictor;
+
+    // 融合线程写入,其他线程随时读取
+    // 最新的外推状态(latest/predict)
+    SeqLock<PosePredictor::State> published;
+    // 各预测时长的误差统计(predictionErrors)
+    SeqLock<PublishedErrors> publishedErrors;
+    // 当前的校准参数(calibration),start之前由setCalibration写入
+    SeqLock<IMU_CALIBRATION> publishedCalibration;
+
+    uint64_t startedAtNs = 0;
+    std::atomic<uint64_t> fusedSamples{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> overwritten{0};
+    std::atomic<uint64_t> busyNs{0};
+
+    // 只由融合线程记录
+    LatencyHistogram transitLatency;
+    LatencyHistogram consumeLatency;
+};
+
+
+#endif //HEADTRACKER_H
@@ -0,0 +1,467 @@
+//
+// Created by Norman Wang on 2025/5/7.
+//
+
+#include "HidReactor.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include "Logger.h"
+#include "Utils.h"
+
+// 唤醒句柄在epoll中使用的ID(注册ID从1开始)
+static constexpr uint64_t WAKE_ID = 0;
+// 单次唤醒中每个接口最多读取的上报条数,避免一个高频接口饿死其他接口
+static constexpr size_t MAX_REPORTS_PER_WAKE = 32;
+// 等待线程只读取一个接口时单次读取的超时,只用于检查新注册/注销的接口
+static constexpr int WAITER_TIMEOUT_MS = 100;
+// 等待线程读取多个接口时,在一个接口上阻塞的时间片(其他接口的上报最多因此晚这么久)
+static constexpr int WAITER_SLICE_MS = 1;
+// 表示句柄出错/设备断开的事件
+#ifdef __linux__
+static constexpr uint32_t READY_ERROR_EVENTS = EPOLLERR | EPOLLHUP;
+#else
+static constexpr short READY_ERROR_EVENTS = POLLERR | POLLHUP | POLLNVAL;
+#endif
+
+HidReactor &HidReactor::instance() {
+    static HidReactor reactor;
+    return reactor;
+}
+
+HidReactor::HidReactor() {
+#ifdef __linux__
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        Logger::error("无法创建HID反应器的epoll/eventfd句柄");
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+#else
+    if (pipe(wakePipe) != 0) {
+        Logger::error("无法创建HID反应器的唤醒管道");
+        return;
+    }
+    for (const int fd: wakePipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+}
+
+HidReactor::~HidReactor() {
+    stopRequested = true;
+    wake();
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(waiterMutex);
+        waiterStopRequested = true;
+    }
+    waiterChanged.notify_all();
+    if (waiterThread.joinable()) {
+        waiterThread.join();
+    }
+    {
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        registrations.clear();
+        retiredInboxes.clear();
+    }
+    waitEntries.clear();
+#ifdef __linux__
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+#else
+    if (wakePipe[0] >= 0) ::close(wakePipe[0]);
+    if (wakePipe[1] >= 0) ::close(wakePipe[1]);
+#endif
+}
+
+void HidReactor::ensureStarted() {
+    if (!started.exchange(true)) {
+        loopThread = std::thread(&HidReactor::run, this);
+    }
+}
+
+void HidReactor::wake() const {
+#ifdef __linux__
+    if (wakeFd >= 0) {
+        const uint64_t one = 1;
+        (void) ::write(wakeFd, &one, sizeof(one));
+    }
+#else
+    if (wakePipe[1] >= 0) {
+        const uint8_t one = 1;
+        (void) ::write(wakePipe[1], &one, sizeof(one));
+    }
+#endif
+}
+
+uint64_t HidReactor::registerDevice(std::shared_ptr<HidDeviceHandle> device, ReportHandler handler) {
+    if (!device || !handler) {
+        return 0;
+    }
+
+    Registration registration;
+    registration.fd = device->pollFd();
+    registration.device = std::move(device);
+    registration.handler = std::move(handler);
+
+    uint64_t id;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        id = nextId++;
+#ifdef __linux__
+        if (registration.fd >= 0) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = id;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, registration.fd, &event) != 0) {
+                Logger::warning("无法把接口加入epoll,改为等待线程读取");
+                registration.fd = -1;
+            }
+        }
+#endif
+        if (registration.fd < 0) {
+            // 等待线程只持有接口句柄和收件箱,不引用注册项(注册表rehash时注册项会移动)
+            registration.inbox = std::make_shared<Inbox>();
+            {
+                std::lock_guard<std::mutex> waiterLock(waiterMutex);
+                waitEntries.push_back(WaitEntry{registration.device, registration.inbox});
+                if (!waiterThread.joinable()) {
+                    waiterThread = std::thread(&HidReactor::waitForReports, this);
+                }
+            }
+            waiterChanged.notify_all();
+            inboxCount++;
+        }
+        registrations.emplace(id, std::move(registration));
+    }
+
+    ensureStarted();
+    // 让反应器线程重新计算等待方式
+    wake();
+    return id;
+}
+
+void HidReactor::unregisterDevice(const uint64_t id) {
+    // 反应器线程分发期间一直持有这把锁,这里拿到锁就意味着该接口的处理函数已经不在执行;
+    // 递归锁允许处理函数在反应器线程里直接注销自己
+    {
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        removeLocked(id);
+    }
+    // 等待线程从不调用处理函数,在锁外移除不影响上面的保证;返回后等待线程不会再读取该接口
+    retireInboxes();
+}
+
+void HidReactor::removeLocked(const uint64_t id) {
+    const auto it = registrations.find(id);
+    if (it == registrations.end() || it->second.removed) {
+        return;
+    }
+    // 处理函数在分发过程中注销了接口,先做标记,等本轮分发结束再移除,避免引用失效
+    if (dispatching) {
+        it->second.removed = true;
+        pendingRemovals.push_back(id);
+        return;
+    }
+    if (it->second.fd >= 0) {
+#ifdef __linux__
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+#endif
+    } else if (it->second.inbox) {
+        retiredInboxes.push_back(it->second.inbox);
+        if (!it->second.failed) {
+            inboxCount--;
+        }
+    }
+    registrations.erase(it);
+}
+
+size_t HidReactor::registeredCount() const {
+    std::lock_guard<std::recursive_mutex> lock(registryMutex);
+    return registrations.size();
+}
+
+uint64_t HidReactor::scheduleAt(const uint64_t deadlineNs, std::function<void()> callback) {
+    uint64_t timerId;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        timerId = nextTimerId++;
+        timers.emplace(std::make_pair(deadlineNs, timerId), std::move(callback));
+        timerDeadlines.emplace(timerId, deadlineNs);
+    }
+    ensureStarted();
+    // 新的定时器可能比当前等待的更早到期
+    wake();
+    return timerId;
+}
+
+void HidReactor::cancelTimer(const uint64_t timerId) {
+    std::lock_guard<std::recursive_mutex> lock(registryMutex);
+    const auto it = timerDeadlines.find(timerId);
+    if (it == timerDeadlines.end()) {
+        return;
+    }
+    timers.erase(std::make_pair(it->second, timerId));
+    timerDeadlines.erase(it);
+}
+
+int HidReactor::runDueTimers() {
+    std::lock_guard<std::recursive_mutex> lock(registryMutex);
+    const uint64_t now = Utils::steadyNowNs();
+    while (!timers.empty() && timers.begin()->first.first <= now) {
+        // 先移出再执行,回调里可以安全地再添加/取消定时器
+        auto callback = std::move(timers.begin()->second);
+        timerDeadlines.erase(timers.begin()->first.second);
+        timers.erase(timers.begin());
+        callback();
+    }
+    if (timers.empty()) {
+        return -1;
+    }
+    // 向上取整到毫秒,避免提前醒来空转
+    const uint64_t remainingNs = timers.begin()->first.first - now;
+    return static_cast<int>((remainingNs + 999999) / 1000000);
+}
+
+size_t HidReactor::drain(Registration &registration) {
+    uint8_t buffer[256];
+    size_t count = 0;
+    while (count < MAX_REPORTS_PER_WAKE && !registration.failed && !registration.removed) {
+        const int bytesRead = registration.device->read(buffer, sizeof(buffer), 0);
+        if (bytesRead < 0) {
+            // 设备已拔出或出错,停止读取它,避免每次唤醒都刷一次错误日志
+            Logger::error("读取设备数据失败,停止读取该接口: %s", registration.device->lastError());
+            markFailedLocked(registration);
+            break;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        registration.handler(buffer, static_cast<size_t>(bytesRead), Utils::steadyNowNs());
+        count++;
+    }
+    return count;
+}
+
+void HidReactor::markFailedLocked(Registration &registration) {
+    if (registration.failed) {
+        return;
+    }
+    registration.failed = true;
+    if (registration.fd >= 0) {
+#ifdef __linux__
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, registration.fd, nullptr);
+#endif
+        registration.fd = -1;
+    } else if (registration.inbox) {
+        // 等待线程读取出错时已经不再读取它
+        inboxCount--;
+    }
+}
+
+size_t HidReactor::drainInbox(Registration &registration) {
+    Inbox &inbox = *registration.inbox;
+    HID_REPORT report;
+    size_t count = 0;
+    while (count < MAX_REPORTS_PER_WAKE && !registration.failed && !registration.removed &&
+           inbox.reports.next(inbox.cursor, report)) {
+        registration.handler(report.data, report.length, report.received_at_ns);
+        count++;
+    }
+    if (count == MAX_REPORTS_PER_WAKE) {
+        // 还有没分发完的,下一轮接着处理
+        wake();
+    } else if (inbox.readFailed && !registration.failed && !registration.removed) {
+        // 出错前收到的上报已经全部分发
+        Logger::error("读取设备数据失败,停止读取该接口: %s", registration.device->lastError());
+        markFailedLocked(registration);
+    }
+    return count;
+}
+
+void HidReactor::waitForReports() {
+    uint8_t buffer[256];
+    // 下一个轮到的接口
+    size_t next = 0;
+    // 连续没有读到上报的次数,把所有接口都不阻塞地轮过一遍之后才开始阻塞
+    size_t emptyReads = 0;
+    std::unique_lock<std::mutex> lock(waiterMutex);
+    while (!waiterStopRequested) {
+        if (waitEntries.empty()) {
+            waiterChanged.wait(lock, [this] { return waiterStopRequested || !waitEntries.empty(); });
+            continue;
+        }
+        const WaitEntry &entry = waitEntries[next++ % waitEntries.size()];
+        HidDeviceHandle *device = entry.device.get();
+        Inbox *inbox = entry.inbox.get();
+        int timeoutMs = 0;
+        if (emptyReads >= waitEntries.size()) {
+            // 多个接口时只阻塞一个时间片,一个安静的接口不会拖住其他接口的上报
+            timeoutMs = waitEntries.size() == 1 ? WAITER_TIMEOUT_MS : WAITER_SLICE_MS;
+        }
+        // 锁外读取,移除该接口的一方会等这次读取返回
+        waiterReading = inbox;
+        lock.unlock();
+        const int bytesRead = device->read(buffer, sizeof(buffer), timeoutMs);
+        if (bytesRead > 0) {
+            inbox->reports.push(buffer, static_cast<size_t>(bytesRead), Utils::steadyNowNs());
+            wake();
+        }
+        lock.lock();
+        waiterReading = nullptr;
+        waiterChanged.notify_all();
+        emptyReads = bytesRead > 0 ? 0 : emptyReads + 1;
+        if (bytesRead < 0) {
+            inbox->readFailed = true;
+            takeWaitEntryLocked(inbox);
+            wake();
+        }
+    }
+}
+
+HidReactor::WaitEntry HidReactor::takeWaitEntryLocked(const Inbox *inbox) {
+    for (auto it = waitEntries.begin(); it != waitEntries.end(); ++it) {
+        if (it->inbox.get() == inbox) {
+            WaitEntry entry = std::move(*it);
+            waitEntries.erase(it);
+            return entry;
+        }
+    }
+    return WaitEntry();
+}
+
+void HidReactor::retireInboxes() {
+    std::vector<std::shared_ptr<Inbox>> inboxes;
+    {
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        if (retiredInboxes.empty()) {
+            return;
+        }
+        inboxes.swap(retiredInboxes);
+    }
+    std::unique_lock<std::mutex> lock(waiterMutex);
+    for (const auto &inbox: inboxes) {
+        // 先移出列表,等待线程不会再轮到它;它可能正在读取这个接口,等这次读取返回后再释放接口句柄
+        const WaitEntry entry = takeWaitEntryLocked(inbox.get());
+        waiterChanged.wait(lock, [&] { return waiterReading != inbox.get(); });
+    }
+}
+
+void HidReactor::run() {
+    while (!stopRequested) {
+        retireInboxes();
+        const int timeoutMs = runDueTimers();
+
+#ifdef __linux__
+        epoll_event events[32];
+        const int ready = epoll_wait(epollFd, events, 32, timeoutMs);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                Logger::error("epoll等待失败: %d", errno);
+            }
+            continue;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        dispatching = true;
+        for (int i = 0; i < ready; i++) {
+            const uint64_t id = events[i].data.u64;
+            const uint32_t readyEvents = events[i].events;
+            if (id == WAKE_ID) {
+                uint64_t value;
+                (void) ::read(wakeFd, &value, sizeof(value));
+                continue;
+            }
+#else
+        pollEvents.clear();
+        pollEventIds.clear();
+        {
+            std::lock_guard<std::recursive_mutex> lock(registryMutex);
+            pollEvents.push_back(pollfd{wakePipe[0], POLLIN, 0});
+            pollEventIds.push_back(WAKE_ID);
+            for (const auto &entry: registrations) {
+                if (entry.second.fd >= 0 && !entry.second.failed && !entry.second.removed) {
+                    pollEvents.push_back(pollfd{entry.second.fd, POLLIN, 0});
+                    pollEventIds.push_back(entry.first);
+                }
+            }
+        }
+        if (poll(pollEvents.data(), static_cast<nfds_t>(pollEvents.size()), timeoutMs) < 0) {
+            if (errno != EINTR) {
+                Logger::error("poll等待失败: %d", errno);
+            }
+            continue;
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(registryMutex);
+        dispatching = true;
+        for (size_t i = 0; i < pollEvents.size(); i++) {
+            if (!pollEvents[i].revents) {
+                continue;
+            }
+            const uint64_t id = pollEventIds[i];
+            const short readyEvents = pollEvents[i].revents;
+            if (id == WAKE_ID) {
+                uint8_t discard[64];
+                while (::read(wakePipe[0], discard, sizeof(discard)) > 0) {
+                }
+                continue;
+            }
+#endif
+            // 同一批事件中靠前的处理函数可能已经注销了这个接口
+            const auto it = registrations.find(id);
+            if (it == registrations.end() || it->second.removed || it->second.failed) {
+                continue;
+            }
+            if (readyEvents & READY_ERROR_EVENTS) {
+                Logger::warning("设备已断开,停止读取该接口");
+                markFailedLocked(it->second);
+                continue;
+            }
+            drain(it->second);
+        }
+
+        // 没有可等待句柄的接口,分发等待线程放进收件箱的上报
+        // 先收集ID,处理函数中注册新接口导致的rehash不会影响遍历
+        if (inboxCount > 0) {
+            inboxIds.clear();
+            for (const auto &entry: registrations) {
+                if (entry.second.inbox && !entry.second.failed && !entry.second.removed) {
+                    inboxIds.push_back(entry.first);
+                }
+            }
+            for (const uint64_t id: inboxIds) {
+                const auto it = registrations.find(id);
+                if (it != registrations.end()) {
+                    drainInbox(it->second);
+                }
+            }
+        }
+
+        dispatching = false;
+        for (const uint64_t id: pendingRemovals) {
+            const auto it = registrations.find(id);
+            if (it != registrations.end()) {
+                it->second.removed = false;
+                removeLocked(id);
+            }
+        }
+        pendingRemovals.clear();
+    }
+}
@@ -0,0 +1,190 @@
+//
+// Created by Norman Wang on 2025/5/7.
+//
+
+#ifndef HIDREACTOR_H
+#define HIDREACTOR_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef __linux__
+#include <poll.h>
+#endif
+
+#include "HidTransport.h"
+#include "ReportRingBuffer.h"
+
+
+/**
+ * HID读取反应器
+ * 用一个固定的I/O线程等待所有已打开接口的上报,再分发给各接口自己的处理函数.
+ * 打开接口 = 注册, 关闭接口 = 注销, 不再为每个接口单独创建读取线程,
+ * 无论连接多少个接口/多少副眼镜,线程数量都不变(反应器线程,加上最多一个等待线程).
+ *
+ * 接口提供了可等待句柄(Linux hidraw后端/模拟设备)时使用epoll(其他平台为poll)等待;
+ * 拿不到可等待句柄的接口(macOS / libusb后端)共用一个等待线程: 它轮流对各接口做带超时的读取(hid_read_timeout),
+ * 只有一个接口时阻塞整个读取超时,多个接口时每次只阻塞一个短时间片.
+ * 收到的上报放进该接口的收件箱再唤醒反应器线程,处理函数仍然只在反应器线程中调用,反应器线程空闲时不会定时唤醒.
+ * 反应器还提供简单的定时器,用于请求超时等截止时间处理.
+ */
+class HidReactor {
+public:
+    /**
+     * 上报处理函数(在反应器线程中调用,不能阻塞)
+     * @param data - 原始数据
+     * @param length - 数据长度
+     * @param receivedAtNs - 接收时间(steady_clock纳秒)
+     */
+    using ReportHandler = std::function<void(const uint8_t *data, size_t length, uint64_t receivedAtNs)>;
+
+    /**
+     * 获取全局唯一的反应器(首次注册接口时启动线程)
+     */
+    static HidReactor &instance();
+
+    HidReactor(const HidReactor &) = delete;
+    HidReactor &operator=(const HidReactor &) = delete;
+    ~HidReactor();
+
+    /**
+     * 注册一个已打开的接口
+     * @param device - 接口句柄
+     * @param handler - 上报处理函数
+     * @return - 注册ID,注销时使用;0表示注册失败
+     */
+    uint64_t registerDevice(std::shared_ptr<HidDeviceHandle> device, ReportHandler handler);
+
+    /**
+     * 注销接口,返回后保证该接口的处理函数不会再被调用
+     * @param id - 注册ID
+     */
+    void unregisterDevice(uint64_t id);
+
+    /**
+     * 当前注册的接口数量
+     */
+    size_t registeredCount() const;
+
+    /**
+     * 在指定时间点于反应器线程中执行一次回调(不能阻塞)
+     * @param deadlineNs - 触发时间(steady_clock纳秒)
+     * @param callback - 回调
+     * @return - 定时器ID,取消时使用
+     */
+    uint64_t scheduleAt(uint64_t deadlineNs, std::function<void()> callback);
+
+    /**
+     * 取消尚未触发的定时器
+     * @param timerId - 定时器ID
+     */
+    void cancelTimer(uint64_t timerId);
+
+private:
+    /**
+     * 没有可等待句柄的接口的收件箱: 等待线程写入,反应器线程读取
+     */
+    struct Inbox {
+        ReportRingBuffer reports{256};
+        // 反应器线程的读取位置
+        ReportRingBuffer::Cursor cursor;
+        // 等待线程读取出错后不再读取它,由反应器线程标记接口失败
+        std::atomic<bool> readFailed{false};
+    };
+
+    struct Registration {
+        std::shared_ptr<HidDeviceHandle> device;
+        // 可等待的读取句柄(归接口句柄所有),-1表示由等待线程读取
+        int fd = -1;
+        // 读取出错(设备已拔出),不再读取
+        bool failed = false;
+        // 在分发过程中被注销,等本轮分发结束后再真正移除
+        bool removed = false;
+        ReportHandler handler;
+        // 只有fd为-1的接口才有
+        std::shared_ptr<Inbox> inbox;
+    };
+
+    /**
+     * 等待线程轮流读取的接口
+     */
+    struct WaitEntry {
+        std::shared_ptr<HidDeviceHandle> device;
+        std::shared_ptr<Inbox> inbox;
+    };
+
+    HidReactor();
+
+    void ensureStarted();
+    void wake() const;
+    void run();
+    // 读取一个接口当前所有可读的上报,返回读到的条数
+    size_t drain(Registration &registration);
+    // 分发收件箱中的上报,返回分发的条数
+    size_t drainInbox(Registration &registration);
+    // 等待线程: 轮流读取所有没有可等待句柄的接口
+    void waitForReports();
+    // 把已注销的接口从等待线程中移除(不能持有registryMutex,最多等待一次读取超时)
+    void retireInboxes();
+    // 从等待线程的接口列表中取出该接口(调用方需持有waiterMutex)
+    WaitEntry takeWaitEntryLocked(const Inbox *inbox);
+    // 接口出错后不再等待/读取它(调用方需持有锁)
+    void markFailedLocked(Registration &registration);
+    void removeLocked(uint64_t id);
+    // 执行所有已到期的定时器,返回距离下一个定时器的毫秒数(-1表示没有定时器)
+    int runDueTimers();
+
+    // 反应器线程在分发期间持有这个锁,注销时借此等待正在进行的分发结束
+    mutable std::recursive_mutex registryMutex;
+    std::unordered_map<uint64_t, Registration> registrations;
+    // 反应器线程正在分发上报(此时注销只做标记)
+    bool dispatching = false;
+    std::vector<uint64_t> pendingRemovals;
+    // 本轮需要检查收件箱的接口ID(复用,避免每轮分配)
+    std::vector<uint64_t> inboxIds;
+    // 已注销接口的收件箱,在锁外从等待线程中移除
+    std::vector<std::shared_ptr<Inbox>> retiredInboxes;
+    uint64_t nextId = 1;
+    // 定时器: (触发时间, 定时器ID) -> 回调
+    std::map<std::pair<uint64_t, uint64_t>, std::function<void()>> timers;
+    // 定时器ID -> 触发时间,用于取消
+    std::unordered_map<uint64_t, uint64_t> timerDeadlines;
+    uint64_t nextTimerId = 1;
+    // 由等待线程读取的接口数量
+    size_t inboxCount = 0;
+
+    std::thread loopThread;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> started{false};
+
+    // 保护等待线程的接口列表,等待线程从不获取registryMutex
+    std::mutex waiterMutex;
+    std::condition_variable waiterChanged;
+    std::vector<WaitEntry> waitEntries;
+    // 等待线程正在(锁外)读取的接口,移除它之前要等这次读取返回
+    const Inbox *waiterReading = nullptr;
+    bool waiterStopRequested = false;
+    // 第一个没有可等待句柄的接口注册时启动
+    std::thread waiterThread;
+
+#ifdef __linux__
+    int epollFd = -1;
+    int wakeFd = -1;
+#else
+    // 自管道,用于唤醒poll
+    int wakePipe[2] = {-1, -1};
+    // poll等待的句柄列表(复用,避免每轮分配)
+    std::vector<pollfd> pollEvents;
+    std::vector<uint64_t> pollEventIds;
+#endif
+};
+
+
+#endif //HIDREACTOR_H
@@ -0,0 +1,51 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#include "HidTransport.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "HidapiTransport.h"
+#include "Logger.h"
+#include "RecordingTransport.h"
+#include "ReplayTransport.h"
+#include "SimulatedTransport.h"
+
+static std::mutex transportMutex;
+static std::shared_ptr<HidTransport> currentTransport;
+
+HidTransport &HidTransport::current() {
+    std::lock_guard<std::mutex> lock(transportMutex);
+    if (!currentTransport) {
+        if (const char *replay = std::getenv("XREAL_REPLAY")) {
+            auto replayTransport = std::make_shared<ReplayTransport>(replay);
+            if (replayTransport->isOpen()) {
+                currentTransport = replayTransport;
+                return *currentTransport;
+            }
+        }
+        const char *simulate = std::getenv("XREAL_SIMULATE");
+        if (simulate && std::strcmp(simulate, "1") == 0) {
+            Logger::warning("使用模拟XREAL眼镜");
+            currentTransport = std::make_shared<SimulatedTransport>();
+        } else {
+            currentTransport = std::make_shared<HidapiTransport>();
+        }
+        if (const char *record = std::getenv("XREAL_RECORD")) {
+            auto writer = std::make_shared<CaptureWriter>(record);
+            if (writer->isOpen()) {
+                Logger::info("录制所有HID上报到: %s", record);
+                currentTransport = std::make_shared<RecordingTransport>(currentTransport, writer);
+            }
+        }
+    }
+    return *currentTransport;
+}
+
+void HidTransport::use(std::shared_ptr<HidTransport> transport) {
+    std::lock_guard<std::mutex> lock(transportMutex);
+    currentTransport = std::move(transport);
+}
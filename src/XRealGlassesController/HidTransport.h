@@ -0,0 +1,96 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#ifndef HIDTRANSPORT_H
+#define HIDTRANSPORT_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HID_DEVICE_ENTRY.h"
+
+
+/**
+ * 一个已打开的HID接口
+ * 由传输层创建,所有方法都可以在任意线程调用
+ */
+class HidDeviceHandle {
+public:
+    virtual ~HidDeviceHandle() = default;
+
+    /**
+     * 写入一条输出报告
+     * @return - 写入的字节数,<0表示失败
+     */
+    virtual int write(const uint8_t *data, size_t length) = 0;
+
+    /**
+     * 发送一条特征报告
+     * @return - 发送的字节数,<0表示失败
+     */
+    virtual int sendFeatureReport(const uint8_t *data, size_t length) = 0;
+
+    /**
+     * 读取一条上报
+     * @param buffer - 输出缓冲区
+     * @param length - 缓冲区长度
+     * @param timeoutMs - 0为不等待,-1为一直等待,>0为最长等待毫秒数
+     * @return - 读到的字节数,0表示没有数据,<0表示出错
+     */
+    virtual int read(uint8_t *buffer, size_t length, int timeoutMs) = 0;
+
+    /**
+     * 可以交给poll/epoll等待的句柄,可读时调用read(...,0)即可取到数据
+     * @return - 文件描述符,-1表示不支持(只能带超时阻塞读取)
+     */
+    virtual int pollFd() const {
+        return -1;
+    }
+
+    /**
+     * 最近一次错误的描述
+     */
+    virtual std::string lastError() = 0;
+};
+
+
+/**
+ * HID传输层
+ * 眼镜的枚举/打开/读写都经过这里,真实设备使用hidapi,
+ * 没有眼镜时可以换成模拟设备,在任何平台上跑通连接/探测/切换模式/读取的完整流程.
+ */
+class HidTransport {
+public:
+    virtual ~HidTransport() = default;
+
+    /**
+     * 枚举指定厂商的所有HID接口
+     * @param vendorId - 厂商ID
+     * @return - 接口列表
+     */
+    virtual std::vector<HID_DEVICE_ENTRY> enumerate(uint16_t vendorId) = 0;
+
+    /**
+     * 打开一个接口
+     * @param path - 枚举得到的接口路径
+     * @return - 接口句柄,失败返回nullptr
+     */
+    virtual std::shared_ptr<HidDeviceHandle> open(const std::string &path) = 0;
+
+    /**
+     * 当前使用的传输层
+     * 默认使用hidapi;设置了环境变量XREAL_SIMULATE=1时使用模拟眼镜,XREAL_REPLAY=文件路径时回放录制文件;
+     * 设置了XREAL_RECORD=文件路径时录制所有读写(见RecordingTransport/ReplayTransport)
+     */
+    static HidTransport &current();
+
+    /**
+     * 替换当前使用的传输层(需在打开任何接口之前调用)
+     */
+    static void use(std::shared_ptr<HidTransport> transport);
+};
+
+
+#endif //HIDTRANSPORT_H
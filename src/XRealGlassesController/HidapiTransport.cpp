@@ -0,0 +1,151 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#include "HidapiTransport.h"
+
+#include <codecvt>
+#include <locale>
+#include <hidapi/hidapi.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "Logger.h"
+
+// 辅助函数: 将wchar_t*转换为std::string
+static std::string wcharToString(const wchar_t *wstr) {
+    if (!wstr) return "";
+
+    try {
+        // 使用C++标准库进行转换
+        std::wstring_convert<std::codecvt_utf8<wchar_t> > converter;
+        return converter.to_bytes(wstr);
+    } catch (const std::exception &e) {
+        Logger::error("字符转换异常: %s", e.what());
+        return "";
+    }
+}
+
+/**
+ * hidapi打开的接口
+ * Linux hidraw后端下额外打开一个/dev/hidrawN的只读句柄,用于poll/epoll等待和读取,
+ * 每个hidraw句柄都会收到完整的上报;其他平台直接使用hid_read_timeout.
+ */
+class HidapiDeviceHandle : public HidDeviceHandle {
+public:
+    HidapiDeviceHandle(hid_device *device, const std::string &path) : device(device) {
+#ifdef __linux__
+        if (path.rfind("/dev/", 0) == 0) {
+            readFd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            if (readFd < 0) {
+                Logger::warning("无法打开hidraw读取句柄,改用hid_read: %s", path);
+            }
+        }
+#else
+        (void) path;
+#endif
+    }
+
+    ~HidapiDeviceHandle() override {
+#ifdef __linux__
+        if (readFd >= 0) {
+            ::close(readFd);
+        }
+#endif
+        hid_close(device);
+    }
+
+    int write(const uint8_t *data, const size_t length) override {
+        return hid_write(device, data, length);
+    }
+
+    int sendFeatureReport(const uint8_t *data, const size_t length) override {
+        return hid_send_feature_report(device, data, length);
+    }
+
+    int read(uint8_t *buffer, const size_t length, const int timeoutMs) override {
+#ifdef __linux__
+        if (readFd >= 0) {
+            if (timeoutMs != 0) {
+                pollfd event{readFd, POLLIN, 0};
+                const int ready = poll(&event, 1, timeoutMs);
+                if (ready <= 0) {
+                    return ready < 0 && errno != EINTR ? -1 : 0;
+                }
+                if (event.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                    return -1;
+                }
+            }
+            const ssize_t bytesRead = ::read(readFd, buffer, length);
+            if (bytesRead < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+            }
+            return static_cast<int>(bytesRead);
+        }
+#endif
+        return hid_read_timeout(device, buffer, length, timeoutMs);
+    }
+
+    int pollFd() const override {
+#ifdef __linux__
+        return readFd;
+#else
+        return -1;
+#endif
+    }
+
+    std::string lastError() override {
+        const wchar_t *err = hid_error(device);
+        return err ? wcharToString(err) : "未知错误";
+    }
+
+private:
+    hid_device *device;
+#ifdef __linux__
+    int readFd = -1;
+#endif
+};
+
+std::vector<HID_DEVICE_ENTRY> HidapiTransport::enumerate(const uint16_t vendorId) {
+    // Initialize the HIDAPI library
+    if (hid_init() != 0) {
+        Logger::error("无法初始化HID库");
+        return {};
+    }
+
+    std::vector<HID_DEVICE_ENTRY> entries;
+    struct hid_device_info *deviceList = hid_enumerate(vendorId, 0);
+    for (const struct hid_device_info *current = deviceList; current; current = current->next) {
+        HID_DEVICE_ENTRY entry;
+        entry.path = current->path ? current->path : "";
+        entry.vendor_id = current->vendor_id;
+        entry.product_id = current->product_id;
+        entry.serial_number = current->serial_number ? wcharToString(current->serial_number) : "";
+        entry.manufacturer = current->manufacturer_string ? wcharToString(current->manufacturer_string) : "";
+        entry.product = current->product_string ? wcharToString(current->product_string) : "";
+        entry.interface_number = current->interface_number;
+        entries.push_back(entry);
+    }
+
+    // Free the device list allocated by HIDAPI
+    hid_free_enumeration(deviceList);
+
+    // Finalize the HIDAPI library
+    if (hid_exit() != 0) {
+        Logger::warning("无法关闭HID库");
+    }
+    return entries;
+}
+
+std::shared_ptr<HidDeviceHandle> HidapiTransport::open(const std::string &path) {
+    hid_device *device = hid_open_path(path.c_str());
+    if (!device) {
+        return nullptr;
+    }
+    return std::make_shared<HidapiDeviceHandle>(device, path);
+}
@@ -0,0 +1,21 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#ifndef HIDAPITRANSPORT_H
+#define HIDAPITRANSPORT_H
+#include "HidTransport.h"
+
+
+/**
+ * 基于hidapi的真实设备传输层
+ */
+class HidapiTransport : public HidTransport {
+public:
+    std::vector<HID_DEVICE_ENTRY> enumerate(uint16_t vendorId) override;
+
+    std::shared_ptr<HidDeviceHandle> open(const std::string &path) override;
+};
+
+
+#endif //HIDAPITRANSPORT_H
@@ -0,0 +1,35 @@
+//
+// Created by Norman Wang on 2025/5/13.
+//
+
+#ifndef IMU_CALIBRATION_H
+#define IMU_CALIBRATION_H
+#include <cstdint>
+
+
+/**
+ * 一副眼镜的IMU校准参数
+ * 校准后: 陀螺仪 = 原始值 - 零偏; 加速度计 = (原始值 - 偏移) × 比例
+ */
+struct IMU_CALIBRATION {
+    //陀螺仪零偏(弧度/秒)
+    float gyro_bias[3] = {0, 0, 0};
+    //加速度计偏移(g)
+    float accel_offset[3] = {0, 0, 0};
+    //加速度计比例
+    float accel_scale[3] = {1, 1, 1};
+    //各轴朝上/朝下静止时测得的重力(原始值,0表示还没有测到),两者都有时才能得到该轴的偏移和比例
+    float gravity_positive[3] = {0, 0, 0};
+    float gravity_negative[3] = {0, 0, 0};
+    //最近一次估计零偏时的IMU温度(摄氏度)
+    float temperature = 0;
+    //参与估计的静止窗口数,0表示没有校准过
+    uint64_t stationary_windows = 0;
+
+    [[nodiscard]] bool valid() const {
+        return stationary_windows > 0;
+    }
+};
+
+
+#endif //IMU_CALIBRATION_H
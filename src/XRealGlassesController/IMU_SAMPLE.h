@@ -0,0 +1,76 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#ifndef IMU_SAMPLE_H
+#define IMU_SAMPLE_H
+#include <cstddef>
+#include <cstdint>
+
+#include "MCU_MESSAGE.h"
+
+
+/**
+ * IMU接口上报的布局(64字节,不是0xFD报文,没有CRC)
+ * [0..1] 0x01 0x02 | [2..3] 温度 | [4..11] 设备时间戳(纳秒)
+ * 每个传感器: 乘数(u16) + 除数(u32) + 三轴原始值, 实际值 = 原始值 * 乘数 / 除数
+ *   陀螺仪(度/秒)  - 三轴为24位有符号数
+ *   加速度计(g)    - 三轴为24位有符号数
+ *   磁力计         - 三轴为16位有符号数,除数为0表示没有磁力计
+ */
+struct IMU_REPORT_LAYOUT {
+    static constexpr size_t REPORT_SIZE = 64;
+    static constexpr uint8_t SIGNATURE_0 = 0x01;
+    static constexpr uint8_t SIGNATURE_1 = 0x02;
+
+    static constexpr REPORT_FIELD SIGNATURE{0, 2};
+    static constexpr REPORT_FIELD TEMPERATURE{2, 2};
+    static constexpr REPORT_FIELD TIMESTAMP{4, 8};
+
+    static constexpr REPORT_FIELD GYRO_MULTIPLIER{12, 2};
+    static constexpr REPORT_FIELD GYRO_DIVISOR{14, 4};
+    static constexpr REPORT_FIELD GYRO_X{18, 3};
+    static constexpr REPORT_FIELD GYRO_Y{21, 3};
+    static constexpr REPORT_FIELD GYRO_Z{24, 3};
+
+    static constexpr REPORT_FIELD ACCEL_MULTIPLIER{27, 2};
+    static constexpr REPORT_FIELD ACCEL_DIVISOR{29, 4};
+    static constexpr REPORT_FIELD ACCEL_X{33, 3};
+    static constexpr REPORT_FIELD ACCEL_Y{36, 3};
+    static constexpr REPORT_FIELD ACCEL_Z{39, 3};
+
+    static constexpr REPORT_FIELD MAG_MULTIPLIER{42, 2};
+    static constexpr REPORT_FIELD MAG_DIVISOR{44, 4};
+    static constexpr REPORT_FIELD MAG_X{48, 2};
+    static constexpr REPORT_FIELD MAG_Y{50, 2};
+    static constexpr REPORT_FIELD MAG_Z{52, 2};
+
+    // 温度换算: 摄氏度 = 原始值 / 132.48 + 25
+    static constexpr float TEMPERATURE_SCALE = 132.48f;
+    static constexpr float TEMPERATURE_OFFSET = 25.0f;
+};
+
+static_assert(IMU_REPORT_LAYOUT::MAG_Z.end() <= IMU_REPORT_LAYOUT::REPORT_SIZE, "IMU字段超出报文长度");
+
+/**
+ * 一条解码后的IMU样本
+ */
+struct IMU_SAMPLE {
+    //设备时间戳(纳秒,设备自己的时钟)
+    uint64_t device_timestamp_ns = 0;
+    //主机收到这条上报的时间(steady_clock, 纳秒)
+    uint64_t received_at_ns = 0;
+    //陀螺仪(弧度/秒)
+    float gyro[3] = {0, 0, 0};
+    //加速度计(g)
+    float accel[3] = {0, 0, 0};
+    //磁力计(设备单位),没有磁力计时为0
+    float mag[3] = {0, 0, 0};
+    //IMU温度(摄氏度)
+    float temperature = 0;
+    //这条上报是否带有磁力计数据
+    bool has_magnetometer = false;
+};
+
+
+#endif //IMU_SAMPLE_H
@@ -0,0 +1,68 @@
+//
+// Created by Norman Wang on 2025/5/19.
+//
+
+#ifndef INPUT_EVENT_H
+#define INPUT_EVENT_H
+#include <cstdint>
+
+
+/**
+ * 眼镜输入事件的类型
+ */
+enum class InputEventType {
+    // 按下了眼镜上的按键
+    BUTTON,
+    // 眼镜切换了显示(开关显示等,值为新的显示状态)
+    DISPLAY_TOGGLED,
+    // 其他未识别的眼镜主动上报(msgId为0x6Cxx,心跳和文本日志除外),例如接近传感器
+    OTHER
+};
+
+/**
+ * 眼镜上的物理按键(按键事件负载的第0字节)
+ */
+enum class GlassesButton : uint8_t {
+    NONE = 0x00,
+    DISPLAY = 0x01,
+    BRIGHTNESS_UP = 0x02,
+    BRIGHTNESS_DOWN = 0x03
+};
+
+/**
+ * 按键触发的动作(按键事件负载的第4字节),同一个物理按键短按/长按时动作不同
+ * 例如README中按住亮度+切换3D/2D,上报的就是MODE_3D/MODE_2D
+ */
+enum class GlassesAction : uint8_t {
+    NONE = 0x00,
+    DISPLAY_TOGGLE = 0x01,
+    MENU_TOGGLE = 0x03,
+    BRIGHTNESS_UP = 0x06,
+    BRIGHTNESS_DOWN = 0x07,
+    UP = 0x08,
+    DOWN = 0x09,
+    MODE_2D = 0x0A,
+    MODE_3D = 0x0B,
+    BLEND_CYCLE = 0x0C,
+    CONTROL_TOGGLE = 0x0F
+};
+
+/**
+ * 一条解码后的眼镜输入事件
+ */
+struct INPUT_EVENT {
+    InputEventType type = InputEventType::OTHER;
+    GlassesButton button = GlassesButton::NONE;
+    GlassesAction action = GlassesAction::NONE;
+    //按键: 动作之后的值(亮度等级或显示模式); 显示切换: 新的显示状态; 其他: 负载第0字节
+    uint8_t value = 0;
+    //报文中的设备时间和序号
+    uint32_t device_time = 0;
+    uint32_t sequence = 0;
+    uint16_t msg_id = 0;
+    //主机收到这条上报的时间(steady_clock, 纳秒)
+    uint64_t received_at_ns = 0;
+};
+
+
+#endif //INPUT_EVENT_H
@@ -5,20 +5,31 @@
 #include "INTERFACE_INFO.h"
 
 #include <thread>
-#include <locale>
-#include <codecvt>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 #include "DevicesHelper.h"
+#include "HidReactor.h"
+#include "ImuDecoder.h"
+#include "InputDecoder.h"
+#include "Logger.h"
 #include "Utils.h"
 
-// 声明wcharToString函数，它在DevicesHelper.cpp中定义
-extern std::string wcharToString(const wchar_t *wstr);
-
 // 构造函数实现
 INTERFACE_INFO::INTERFACE_INFO() : 
     interface_number(0), 
     is_connected(false),
-    deviceResource(nullptr) {
+    deviceResource(nullptr),
+    received_reports(std::make_shared<ReportRingBuffer>(128)),
+    pending_requests(std::make_shared<PendingRequestTable>()),
+    report_decoder(std::make_shared<McuDecoder>()),
+    stream_health(std::make_shared<StreamHealth>()),
+    input_events(std::make_shared<InputEventChannel>()) {
 }
 
 // 拷贝构造函数实现
@@ -26,8 +37,14 @@ INTERFACE_INFO::INTERFACE_INFO(const INTERFACE_INFO& other) :
     interface_number(other.interface_number),
     is_connected(other.is_connected),
     hid_path(other.hid_path),
+    reader_mode(other.reader_mode),
     deviceResource(other.deviceResource), // 共享设备资源，引用计数会自动增加
-    received_messages(other.received_messages) {
+    received_reports(other.received_reports),
+    pending_requests(other.pending_requests),
+    report_decoder(other.report_decoder),
+    stream_health(other.stream_health),
+    input_events(other.input_events),
+    imu_samples(other.imu_samples) {
     // 注意：std::shared_ptr自动处理引用计数
 }
 
@@ -37,8 +54,14 @@ INTERFACE_INFO& INTERFACE_INFO::operator=(const INTERFACE_INFO& other) {
         interface_number = other.interface_number;
         is_connected = other.is_connected;
         hid_path = other.hid_path;
+        reader_mode = other.reader_mode;
         deviceResource = other.deviceResource; // shared_ptr会自动处理引用计数
-        received_messages = other.received_messages;
+        received_reports = other.received_reports;
+        pending_requests = other.pending_requests;
+        report_decoder = other.report_decoder;
+        stream_health = other.stream_health;
+        input_events = other.input_events;
+        imu_samples = other.imu_samples;
     }
     return *this;
 }
@@ -50,30 +73,24 @@ INTERFACE_INFO::~INTERFACE_INFO() {
     // shared_ptr会自动处理引用计数和资源释放
 }
 
-void INTERFACE_INFO::setOriginalHidDevice(hid_device* device) {
+void INTERFACE_INFO::setDeviceHandle(std::shared_ptr<HidDeviceHandle> device) {
     if (device) {
-        deviceResource = std::make_shared<DeviceResource>(device);
+        deviceResource = std::make_shared<DeviceResource>(std::move(device));
     } else {
         deviceResource.reset();
     }
 }
 
 bool INTERFACE_INFO::open() {
-    hid_device* device = hid_open_path(hid_path.c_str());
+    // 由当前传输层打开(真实设备为hidapi,也可以是模拟设备),读取超时由每次read指定
+    std::shared_ptr<HidDeviceHandle> device = HidTransport::current().open(hid_path);
     if (!device) {
         Utils::log("打开设备失败: " + hid_path, LogLevel::ERROR);
         return false;
     }
     
-    // 设置非阻塞模式
-    if (hid_set_nonblocking(device, 1) < 0) {
-        Utils::log("设置非阻塞模式失败", LogLevel::ERROR);
-        hid_close(device);
-        return false;
-    }
-    
     // 设置设备资源
-    setOriginalHidDevice(device);
+    setDeviceHandle(std::move(device));
     
     // 开始消息轮询
     is_connected = true;
@@ -83,70 +100,280 @@ bool INTERFACE_INFO::open() {
 }
 
 bool INTERFACE_INFO::close() {
-    if (is_connected) {
-        stopMessagePolling();
+    // 最后一个持有者关闭时,等待中的命令不可能再收到应答
+    if (deviceResource && deviceResource.use_count() == 1 && pending_requests) {
+        pending_requests->cancelAll("接口已关闭");
+    }
+    // 格式错误的上报平时只计数,关闭时汇总输出一次
+    if (deviceResource && deviceResource.use_count() == 1 && report_decoder) {
+        const McuDecoder::Stats stats = report_decoder->stats();
+        if (stats.rejected() > 0) {
+            Logger::warning("接口 %d 丢弃了格式错误的上报: 截断 %u, 长度错误 %u, CRC错误 %u", interface_number,
+                            stats.truncated, stats.bad_length, stats.bad_crc);
+        }
+    }
+    if (deviceResource && deviceResource.use_count() == 1 && stream_health) {
+        // 有丢失/错误时总是输出;探测时短暂打开的接口没有问题就不输出
+        const StreamHealth::Snapshot health = stream_health->snapshot();
+        if (health.imu_missing > 0 || health.sequence_missing > 0 || health.crc_failures > 0 ||
+            health.read_errors > 0) {
+            Logger::warning("%s", health.summary());
+        } else if (health.imu_reports > 0) {
+            Logger::info("%s", health.summary());
+        }
     }
-
     is_connected = false;
     
     // 释放设备资源，让shared_ptr负责处理引用计数
+    // 最后一个引用释放时会停止读取线程并关闭设备
     deviceResource.reset();
     
     Utils::log("设备已关闭: " + hid_path, LogLevel::INFO);
     return true;
 }
 
-void INTERFACE_INFO::startMessagePolling() {
-    std::thread([this]() {
-        while (is_connected && deviceResource && deviceResource->device) {
-            uint8_t buffer[256] = {0}; // 初始化缓冲区为0
-            const int bytesRead = hid_read(deviceResource->device, buffer, sizeof(buffer));
-            
+/**
+ * 每个接口收到上报后要交给的对象(拷贝出来的INTERFACE_INFO共享同一份)
+ */
+struct ReportSinks {
+    std::shared_ptr<ReportRingBuffer> reports;
+    std::shared_ptr<PendingRequestTable> pending;
+    std::shared_ptr<McuDecoder> decoder;
+    std::shared_ptr<StreamHealth> health;
+    std::shared_ptr<InputEventChannel> events;
+    // 可为空,只有IMU接口才有
+    std::shared_ptr<ImuSampleBuffer> imu;
+};
+
+// 按上报类型交给IMU样本缓冲区或0xFD解码器/输入事件
+static void dispatchReport(const ReportSinks &sinks, const uint8_t *buffer, const size_t length,
+                           const uint64_t receivedAtNs) {
+    // 直接写入预分配的槽位,不产生任何堆分配
+    sinks.reports->push(buffer, length, receivedAtNs);
+
+    // IMU上报直接解码写入样本缓冲区,同样不产生堆分配
+    if (sinks.imu && length > 0 && buffer[0] != MCU_REPORT_LAYOUT::HEAD_BYTE) {
+        IMU_SAMPLE sample;
+        switch (ImuDecoder::decode(buffer, length, sample)) {
+            case ImuDecoder::Status::OK:
+                sample.received_at_ns = receivedAtNs;
+                sinks.imu->push(sample);
+                sinks.health->onImu(sample.device_timestamp_ns);
+                break;
+            case ImuDecoder::Status::NOT_IMU:
+                break;
+            default:
+                sinks.imu->countRejected();
+                sinks.health->onMalformed();
+                break;
+        }
+        return;
+    }
+
+    // 校验通过的0xFD报文立即交给等待中的请求;格式错误的报文只在解码器里计数
+    MCU_MESSAGE_VIEW message;
+    switch (sinks.decoder->decodeAndCount(buffer, length, message)) {
+        case McuDecoder::Status::OK: {
+            sinks.health->onMcu(message);
+            sinks.pending->complete(message, receivedAtNs);
+            // 按键等输入事件在这次唤醒中直接交给订阅者
+            INPUT_EVENT event;
+            if (InputDecoder::decode(message, receivedAtNs, event)) {
+                sinks.events->publish(event);
+            }
+            break;
+        }
+        case McuDecoder::Status::NOT_MCU:
+            break;
+        case McuDecoder::Status::BAD_CRC:
+            sinks.health->onCrcFailure();
+            break;
+        default:
+            sinks.health->onMalformed();
+            break;
+    }
+}
+
+/**
+ * 处理一条收到的上报
+ * @param sinks - 接口的环形缓冲区/请求应答表/解码器/健康统计/输入事件/IMU样本缓冲区
+ * @param buffer - 原始数据
+ * @param length - 数据长度
+ * @param receivedAtNs - 接收时间
+ */
+static void onReportReceived(const ReportSinks &sinks, const uint8_t *buffer, const size_t length,
+                             const uint64_t receivedAtNs) {
+    sinks.health->onReport(receivedAtNs);
+    dispatchReport(sinks, buffer, length, receivedAtNs);
+    sinks.health->onHandled(Utils::steadyNowNs() - receivedAtNs);
+}
+
+/**
+ * 旧的轮询读取循环: 非阻塞读取,每轮固定sleep 5ms
+ */
+static void pollingReadLoop(HidDeviceHandle &device, const std::atomic<bool> &stopRequested,
+                            const ReportSinks &sinks) {
+    while (!stopRequested) {
+        uint8_t buffer[256] = {0}; // 初始化缓冲区为0
+        const int bytesRead = device.read(buffer, sizeof(buffer), 0);
+
+        if (bytesRead > 0) {
+            onReportReceived(sinks, buffer, static_cast<size_t>(bytesRead), Utils::steadyNowNs());
+        } else if (bytesRead < 0) {
+            // 读取错误处理
+            sinks.health->onReadError();
+            Logger::error("读取设备数据失败: %s", device.lastError());
+
+            // 如果连续出现错误，可以考虑短暂暂停避免频繁日志
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        // 添加短暂延时，避免CPU占用过高
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+/**
+ * 带超时的阻塞读取循环
+ * 有数据时立即返回;超时只用于检查停止标志,空闲时每秒仅唤醒几次
+ */
+static void blockingReadLoop(HidDeviceHandle &device, const std::atomic<bool> &stopRequested,
+                            const ReportSinks &sinks) {
+    // 取消等待的最长时间
+    constexpr int CANCEL_CHECK_INTERVAL_MS = 100;
+    while (!stopRequested) {
+        uint8_t buffer[256] = {0};
+        const int bytesRead = device.read(buffer, sizeof(buffer), CANCEL_CHECK_INTERVAL_MS);
+
+        if (bytesRead > 0) {
+            onReportReceived(sinks, buffer, static_cast<size_t>(bytesRead), Utils::steadyNowNs());
+        } else if (bytesRead < 0) {
+            sinks.health->onReadError();
+            Logger::error("读取设备数据失败: %s", device.lastError());
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+#ifdef __linux__
+/**
+ * Linux下基于poll的读取循环: 等待接口的可等待句柄和取消用的eventfd,
+ * 有上报立即唤醒,空闲时完全不唤醒,关闭时写eventfd立即退出
+ */
+static void pollReadLoop(HidDeviceHandle &device, const int wakeFd, const std::atomic<bool> &stopRequested,
+                         const ReportSinks &sinks) {
+    pollfd fds[2] = {
+        {device.pollFd(), POLLIN, 0},
+        {wakeFd, POLLIN, 0}
+    };
+    while (!stopRequested) {
+        const int ready = poll(fds, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::error("poll等待设备数据失败: %d", errno);
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            Logger::warning("设备已断开,停止读取");
+            return;
+        }
+        if (fds[0].revents & POLLIN) {
+            uint8_t buffer[256];
+            const int bytesRead = device.read(buffer, sizeof(buffer), 0);
             if (bytesRead > 0) {
-                std::vector<uint8_t> message(buffer, buffer + bytesRead);
-                
-                // 接收缓冲区限制大小，避免内存无限增长
-                if (received_messages.size() > 100) {
-                    received_messages.erase(received_messages.begin());
-                }
-                
-                received_messages.push_back(message);
-                
-                // 处理消息
-                // Utils::log("收到消息: " + Utils::bytesToHex(message), LogLevel::INFO);
-
-                //如果收到0xFD开头的消息,则日志输出
-                if (!message.empty() && message[0] == 0xFD) {
-                    std::string hexData = "收到数据: ";
-                    for (size_t i = 0; i < std::min(message.size(), static_cast<size_t>(32)); i++) {
-                        char hexBuf[8];
-                        snprintf(hexBuf, sizeof(hexBuf), "%02X ", message[i]);
-                        hexData += hexBuf;
-                    }
-                    Utils::log(hexData, LogLevel::INFO);
-                }
+                onReportReceived(sinks, buffer, static_cast<size_t>(bytesRead), Utils::steadyNowNs());
             } else if (bytesRead < 0) {
-                // 读取错误处理
-                const wchar_t* err = hid_error(deviceResource->device);
-                Utils::log("读取设备数据失败: " + (err ? wcharToString(err) : "未知错误"), LogLevel::ERROR);
-                
-                // 如果连续出现错误，可以考虑短暂暂停避免频繁日志
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                sinks.health->onReadError();
+                Logger::error("读取设备数据失败: %s", device.lastError());
             }
-            
-            // 添加短暂延时，避免CPU占用过高
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
         }
-    }).detach();
+    }
+}
+#endif
+
+void INTERFACE_INFO::startMessagePolling() {
+    if (!deviceResource || !deviceResource->device || deviceResource->reader.joinable() ||
+        deviceResource->reactorId != 0) {
+        return;
+    }
+    // 读取线程只持有设备资源的裸指针(资源析构时会先join线程)和环形缓冲区的一份引用,
+    // 不再捕获this,INTERFACE_INFO先析构也不会访问悬空指针
+    DeviceResource *resource = deviceResource.get();
+    stream_health->setInterfaceNumber(interface_number);
+    const ReportSinks sinks{received_reports, pending_requests, report_decoder, stream_health, input_events,
+                            imu_samples};
+    resource->stopRequested = false;
+
+    if (reader_mode == ReaderMode::REACTOR) {
+        resource->reactorId = HidReactor::instance().registerDevice(
+            resource->device,
+            [sinks](const uint8_t *data, const size_t length, const uint64_t receivedAtNs) {
+                onReportReceived(sinks, data, length, receivedAtNs);
+            });
+        if (resource->reactorId != 0) {
+            return;
+        }
+        Logger::warning("注册到HID反应器失败,改用独立读取线程: %s", hid_path);
+    }
+
+    if (reader_mode == ReaderMode::POLLING) {
+        resource->reader = std::thread([resource, sinks]() {
+            pollingReadLoop(*resource->device, resource->stopRequested, sinks);
+        });
+        return;
+    }
+
+#ifdef __linux__
+    // 接口提供了可等待句柄(hidraw/模拟设备)时,同时等待它和取消用的eventfd
+    if (resource->device->pollFd() >= 0) {
+        resource->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (resource->wakeFd >= 0) {
+            resource->reader = std::thread([resource, sinks]() {
+                pollReadLoop(*resource->device, resource->wakeFd, resource->stopRequested, sinks);
+            });
+            return;
+        }
+        Logger::warning("无法创建取消句柄,改用带超时的读取: %s", hid_path);
+    }
+#endif
+
+    resource->reader = std::thread([resource, sinks]() {
+        blockingReadLoop(*resource->device, resource->stopRequested, sinks);
+    });
 }
 
 void INTERFACE_INFO::stopMessagePolling() {
-    // 先设置连接标志为false，这样消息轮询线程会自行退出
-    is_connected = false;
-    
-    // 给轮询线程一点时间退出
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
-    
-    // 不在这里关闭设备，避免与close方法冲突
-    // 让close方法负责关闭设备
+    // 停止读取线程(所有共享这个设备的INTERFACE_INFO都会停止接收)
+    if (deviceResource) {
+        deviceResource->stopReader();
+    }
+}
+
+void INTERFACE_INFO::DeviceResource::stopReader() {
+    // 反应器模式: 注销返回后处理函数不会再被调用,可以安全关闭设备
+    if (reactorId != 0) {
+        HidReactor::instance().unregisterDevice(reactorId);
+        reactorId = 0;
+    }
+    stopRequested = true;
+#ifdef __linux__
+    if (wakeFd >= 0) {
+        const uint64_t one = 1;
+        (void) ::write(wakeFd, &one, sizeof(one));
+    }
+#endif
+    if (reader.joinable()) {
+        reader.join();
+    }
+#ifdef __linux__
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+#endif
 }
@@ -2,23 +2,53 @@
 #define INTERFACE_INFO_H
 #include <string>
 #include <vector>
-#include <hidapi/hidapi.h>
 #include <atomic>
+#include <memory>
+#include <thread>
+
+#include "CommandWriter.h"
+#include "HidTransport.h"
+#include "InputEventChannel.h"
+#include "ImuSampleBuffer.h"
+#include "McuDecoder.h"
+#include "PendingRequestTable.h"
+#include "READER_MODE.h"
+#include "ReportRingBuffer.h"
+#include "StreamHealth.h"
 
 class INTERFACE_INFO {
 private:
     // 添加共享引用计数，确保多个对象安全共享设备句柄
+    // 读取线程也归设备资源所有,最后一个引用释放时先停止读取线程再关闭设备
     struct DeviceResource {
-        hid_device* device;
+        std::shared_ptr<HidDeviceHandle> device;
+        // 命令写入线程,该设备的所有写入都经过它
+        std::shared_ptr<CommandWriter> writer;
         std::atomic<int> refCount;
+        // 上报读取线程
+        std::thread reader;
+        std::atomic<bool> stopRequested{false};
+        // 在HidReactor中的注册ID,0表示未注册
+        uint64_t reactorId = 0;
+#ifdef __linux__
+        // eventfd,用于立即唤醒并取消读取线程
+        int wakeFd = -1;
+#endif
 
-        explicit DeviceResource(hid_device* dev) : device(dev), refCount(1) {}
+        explicit DeviceResource(std::shared_ptr<HidDeviceHandle> dev) :
+            device(std::move(dev)), writer(std::make_shared<CommandWriter>(device)), refCount(1) {
+            writer->start();
+        }
         ~DeviceResource() {
-            if (device) {
-                hid_close(device);
-                device = nullptr;
-            }
+            stopReader();
+            // 排队中的命令以失败完成
+            writer->stop();
+            // 句柄的最后一个引用释放时关闭设备
+            device.reset();
         }
+
+        // 停止读取(注销反应器/停止读取线程)并等待其退出
+        void stopReader();
     };
     
     // 共享的设备资源
@@ -29,19 +59,41 @@ public:
     bool is_connected;
     //定义一个用于保存path的,防止到时候连错了设备
     std::string hid_path;
+    //上报的读取方式,需在open之前设置
+    ReaderMode reader_mode = ReaderMode::REACTOR;
+    
+    // 访问设备句柄的属性（只读）
+    [[nodiscard]] HidDeviceHandle* device_handle() const {
+        return deviceResource ? deviceResource->device.get() : nullptr;
+    }
     
-    // 访问原始设备指针的属性（只读）
-    [[nodiscard]] hid_device* original_hid_device() const {
-        return deviceResource ? deviceResource->device : nullptr;
+    // 访问命令写入器的属性（只读）
+    [[nodiscard]] std::shared_ptr<CommandWriter> command_writer() const {
+        return deviceResource ? deviceResource->writer : nullptr;
     }
     
-    //最近收到的消息列表的原始数据(字节流)
-    std::vector<std::vector<uint8_t>> received_messages;
+    //最近收到的上报(无锁环形缓冲区,拷贝出来的INTERFACE_INFO共享同一个缓冲区)
+    std::shared_ptr<ReportRingBuffer> received_reports;
+
+    //等待设备应答的命令(拷贝出来的INTERFACE_INFO共享同一张表)
+    std::shared_ptr<PendingRequestTable> pending_requests;
+
+    //0xFD上报的解码统计(拷贝出来的INTERFACE_INFO共享同一份)
+    std::shared_ptr<McuDecoder> report_decoder;
+
+    //上报流的健康统计(丢失/抖动/频率/错误,拷贝出来的INTERFACE_INFO共享同一份)
+    std::shared_ptr<StreamHealth> stream_health;
+
+    //眼镜主动上报的输入事件(按键/显示切换,拷贝出来的INTERFACE_INFO共享同一份)
+    std::shared_ptr<InputEventChannel> input_events;
+
+    //IMU样本缓冲区,不为空时解码该接口的IMU上报写入其中(需在open之前设置)
+    std::shared_ptr<ImuSampleBuffer> imu_samples;
     
     // 构造函数
     INTERFACE_INFO();
     
-    // 拷贝构造函数 - 特别注意处理hid_device指针
+    // 拷贝构造函数 - 特别注意处理设备句柄
     INTERFACE_INFO(const INTERFACE_INFO& other);
     
     // 赋值运算符
@@ -55,7 +107,7 @@ public:
     void startMessagePolling();
     void stopMessagePolling();
     
-    // 设置原始设备指针的方法
-    void setOriginalHidDevice(hid_device* device);
+    // 设置设备句柄的方法
+    void setDeviceHandle(std::shared_ptr<HidDeviceHandle> device);
 };
 #endif //INTERFACE_INFO_H
@@ -0,0 +1,103 @@
+//
+// Created by Norman Wang on 2025/5/13.
+//
+
+#include "ImuCalibrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+// 某个轴的读数占重力模长的比例超过这个值时,认为该轴正对重力方向
+static constexpr float AXIS_ALIGNED_RATIO = 0.9f;
+// 各轴朝上/朝下重力读数的平滑系数
+static constexpr float GRAVITY_SMOOTHING = 0.2f;
+
+ImuCalibrator::ImuCalibrator() : ImuCalibrator(Config()) {
+}
+
+ImuCalibrator::ImuCalibrator(const Config &config) : config(config) {
+}
+
+bool ImuCalibrator::observe(const IMU_SAMPLE &raw) {
+    const float values[6] = {raw.gyro[0], raw.gyro[1], raw.gyro[2], raw.accel[0], raw.accel[1], raw.accel[2]};
+    if (windowCount == 0) {
+        std::copy(values, values + 6, reference);
+    }
+    for (int i = 0; i < 6; i++) {
+        const double delta = values[i] - reference[i];
+        sum[i] += delta;
+        sumSquares[i] += delta * delta;
+    }
+    temperatureSum += raw.temperature;
+
+    if (++windowCount < config.window_samples) {
+        return false;
+    }
+    const uint64_t windowsBefore = current.stationary_windows;
+    finishWindow();
+    return current.stationary_windows != windowsBefore;
+}
+
+void ImuCalibrator::finishWindow() {
+    const auto n = static_cast<double>(windowCount);
+    float mean[6];
+    float deviation[6];
+    for (int i = 0; i < 6; i++) {
+        const double average = sum[i] / n;
+        mean[i] = static_cast<float>(reference[i] + average);
+        deviation[i] = static_cast<float>(std::sqrt(std::max(sumSquares[i] / n - average * average, 0.0)));
+    }
+    const auto temperature = static_cast<float>(temperatureSum / n);
+
+    windowCount = 0;
+    std::fill(sum, sum + 6, 0.0);
+    std::fill(sumSquares, sumSquares + 6, 0.0);
+    temperatureSum = 0;
+
+    const float gravity = std::sqrt(mean[3] * mean[3] + mean[4] * mean[4] + mean[5] * mean[5]);
+    stationary = std::fabs(gravity - 1.0f) < config.gravity_tolerance;
+    for (int axis = 0; axis < 3 && stationary; axis++) {
+        stationary = deviation[axis] < config.gyro_stddev_limit && std::fabs(mean[axis]) < config.gyro_mean_limit &&
+                     deviation[3 + axis] < config.accel_stddev_limit;
+    }
+    if (!stationary) {
+        return;
+    }
+
+    // 陀螺仪零偏: 静止时的均值
+    const float smoothing = current.valid() ? config.bias_smoothing : 1.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        current.gyro_bias[axis] += smoothing * (mean[axis] - current.gyro_bias[axis]);
+    }
+    current.temperature = temperature;
+
+    // 加速度计: 记下正对重力的轴在这个方向上的读数
+    for (int axis = 0; axis < 3; axis++) {
+        const float reading = mean[3 + axis];
+        if (std::fabs(reading) < AXIS_ALIGNED_RATIO * gravity) {
+            continue;
+        }
+        float &recorded = reading > 0 ? current.gravity_positive[axis] : current.gravity_negative[axis];
+        recorded = recorded == 0 ? reading : recorded + GRAVITY_SMOOTHING * (reading - recorded);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        const float positive = current.gravity_positive[axis];
+        const float negative = current.gravity_negative[axis];
+        if (positive != 0 && negative != 0) {
+            current.accel_offset[axis] = (positive + negative) * 0.5f;
+            current.accel_scale[axis] = 2.0f / (positive - negative);
+        } else {
+            // 只见过一个方向时无法区分偏移和比例,只把重力模长修正为1g
+            current.accel_offset[axis] = 0;
+            current.accel_scale[axis] = 1.0f / gravity;
+        }
+    }
+    current.stationary_windows++;
+}
+
+void ImuCalibrator::apply(IMU_SAMPLE &sample) const {
+    for (int axis = 0; axis < 3; axis++) {
+        sample.gyro[axis] -= current.gyro_bias[axis];
+        sample.accel[axis] = (sample.accel[axis] - current.accel_offset[axis]) * current.accel_scale[axis];
+    }
+}
@@ -0,0 +1,87 @@
+//
+// Created by Norman Wang on 2025/5/13.
+//
+
+#ifndef IMUCALIBRATOR_H
+#define IMUCALIBRATOR_H
+#include <cstddef>
+
+#include "IMU_CALIBRATION.h"
+#include "IMU_SAMPLE.h"
+
+
+/**
+ * IMU在线校准
+ * 把原始样本按固定长度分成窗口,窗口内陀螺仪和加速度计都几乎不变、加速度约为1g时认为眼镜静止:
+ *   陀螺仪零偏 - 静止窗口的陀螺仪均值(第一次直接采用,之后平滑更新)
+ *   加速度计   - 某个轴朝上/朝下静止时分别记下该轴的重力读数,两个方向都有了就得到该轴的偏移和比例;
+ *               还没有的轴只按重力的模长修正比例
+ * 不是线程安全的,只在融合线程中使用.
+ */
+class ImuCalibrator {
+public:
+    struct Config {
+        //每个窗口的样本数(1kHz下为0.2秒)
+        size_t window_samples = 200;
+        //静止判定: 陀螺仪各轴的标准差上限(弧度/秒)
+        float gyro_stddev_limit = 0.01f;
+        //静止判定: 陀螺仪均值的上限(超过说明在缓慢转动,而不是零偏)
+        float gyro_mean_limit = 0.1f;
+        //静止判定: 加速度计各轴的标准差上限(g)
+        float accel_stddev_limit = 0.01f;
+        //静止判定: 重力模长允许的偏差(g)
+        float gravity_tolerance = 0.2f;
+        //零偏的平滑系数
+        float bias_smoothing = 0.2f;
+    };
+
+    ImuCalibrator();
+
+    explicit ImuCalibrator(const Config &config);
+
+    /**
+     * 使用已有的校准参数(例如从缓存中读取的),之后在此基础上继续更新
+     */
+    void setCalibration(const IMU_CALIBRATION &calibration) {
+        current = calibration;
+    }
+
+    [[nodiscard]] const IMU_CALIBRATION &calibration() const {
+        return current;
+    }
+
+    /**
+     * 观察一条原始样本
+     * @return - 这条样本结束了一个静止窗口(校准参数已更新)
+     */
+    bool observe(const IMU_SAMPLE &raw);
+
+    /**
+     * 对样本应用当前的校准参数
+     */
+    void apply(IMU_SAMPLE &sample) const;
+
+    /**
+     * 最近一个完整窗口是否静止
+     */
+    [[nodiscard]] bool isStationary() const {
+        return stationary;
+    }
+
+private:
+    void finishWindow();
+
+    Config config;
+    IMU_CALIBRATION current;
+    bool stationary = false;
+
+    // 当前窗口的累计值(以窗口第一条样本为参考点,减小浮点误差)
+    size_t windowCount = 0;
+    float reference[6] = {0, 0, 0, 0, 0, 0};
+    double sum[6] = {0, 0, 0, 0, 0, 0};
+    double sumSquares[6] = {0, 0, 0, 0, 0, 0};
+    double temperatureSum = 0;
+};
+
+
+#endif //IMUCALIBRATOR_H
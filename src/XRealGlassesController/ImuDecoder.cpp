@@ -0,0 +1,75 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#include "ImuDecoder.h"
+
+#include <cmath>
+
+/**
+ * 按小端读取一个无符号字段(最多8字节)
+ */
+static uint64_t readUnsigned(const uint8_t *data, const REPORT_FIELD &field) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < field.size; i++) {
+        value |= static_cast<uint64_t>(data[field.offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * 按小端读取一个有符号字段(16/24位),并做符号扩展
+ */
+static int32_t readSigned(const uint8_t *data, const REPORT_FIELD &field) {
+    const auto value = static_cast<uint32_t>(readUnsigned(data, field));
+    const unsigned shift = 32 - 8 * static_cast<unsigned>(field.size);
+    return static_cast<int32_t>(value << shift) >> shift;
+}
+
+/**
+ * 读取一个传感器的三轴数据并换算
+ * @return - 除数是否有效
+ */
+static bool readAxes(const uint8_t *data, const REPORT_FIELD &multiplier, const REPORT_FIELD &divisor,
+                     const REPORT_FIELD (&axes)[3], const float unit, float (&out)[3]) {
+    const auto divisorValue = static_cast<uint32_t>(readUnsigned(data, divisor));
+    if (divisorValue == 0) {
+        return false;
+    }
+    const float scale = static_cast<float>(readUnsigned(data, multiplier)) / static_cast<float>(divisorValue) * unit;
+    for (int i = 0; i < 3; i++) {
+        out[i] = static_cast<float>(readSigned(data, axes[i])) * scale;
+    }
+    return true;
+}
+
+ImuDecoder::Status ImuDecoder::decode(const uint8_t *data, const size_t length, IMU_SAMPLE &out) {
+    using Layout = IMU_REPORT_LAYOUT;
+    if (!data || length < Layout::SIGNATURE.end() ||
+        data[0] != Layout::SIGNATURE_0 || data[1] != Layout::SIGNATURE_1) {
+        return Status::NOT_IMU;
+    }
+    if (length < Layout::MAG_Z.end()) {
+        return Status::TRUNCATED;
+    }
+
+    static constexpr REPORT_FIELD GYRO_AXES[3] = {Layout::GYRO_X, Layout::GYRO_Y, Layout::GYRO_Z};
+    static constexpr REPORT_FIELD ACCEL_AXES[3] = {Layout::ACCEL_X, Layout::ACCEL_Y, Layout::ACCEL_Z};
+    static constexpr REPORT_FIELD MAG_AXES[3] = {Layout::MAG_X, Layout::MAG_Y, Layout::MAG_Z};
+    // 陀螺仪上报的是度/秒,统一换成弧度/秒
+    static constexpr float DEGREES_TO_RADIANS = static_cast<float>(M_PI / 180.0);
+
+    if (!readAxes(data, Layout::GYRO_MULTIPLIER, Layout::GYRO_DIVISOR, GYRO_AXES, DEGREES_TO_RADIANS, out.gyro) ||
+        !readAxes(data, Layout::ACCEL_MULTIPLIER, Layout::ACCEL_DIVISOR, ACCEL_AXES, 1.0f, out.accel)) {
+        return Status::BAD_SCALE;
+    }
+    out.has_magnetometer = readAxes(data, Layout::MAG_MULTIPLIER, Layout::MAG_DIVISOR, MAG_AXES, 1.0f, out.mag);
+    if (!out.has_magnetometer) {
+        out.mag[0] = out.mag[1] = out.mag[2] = 0;
+    }
+
+    out.temperature = static_cast<float>(readSigned(data, Layout::TEMPERATURE)) / Layout::TEMPERATURE_SCALE +
+                      Layout::TEMPERATURE_OFFSET;
+    out.device_timestamp_ns = readUnsigned(data, Layout::TIMESTAMP);
+    return Status::OK;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#ifndef IMUDECODER_H
+#define IMUDECODER_H
+#include <cstddef>
+#include <cstdint>
+
+#include "IMU_SAMPLE.h"
+
+
+/**
+ * IMU上报解码器
+ * 按IMU_REPORT_LAYOUT读出温度/时间戳和各传感器的三轴数据,按上报中的乘数/除数换算成物理量.
+ * 无状态,不做任何分配,可以在读取线程中以上报频率调用.
+ */
+class ImuDecoder {
+public:
+    // 解码结果
+    enum class Status {
+        OK,          // 解码成功
+        NOT_IMU,     // 签名不对(例如0xFD报文),不算错误
+        TRUNCATED,   // 数据不足一条完整的IMU上报
+        BAD_SCALE    // 陀螺仪或加速度计的除数为0
+    };
+
+    /**
+     * 解码一条IMU上报
+     * @param data - 原始数据
+     * @param length - 数据长度
+     * @param out - 解码成功时输出的样本(received_at_ns不填写)
+     * @return - 解码结果
+     */
+    static Status decode(const uint8_t *data, size_t length, IMU_SAMPLE &out);
+};
+
+
+#endif //IMUDECODER_H
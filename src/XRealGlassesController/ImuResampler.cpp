@@ -0,0 +1,512 @@
+//
+// Created by Norman Wang on 2025/5/17.
+//
+
+#include "ImuResampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "Float4.h"
+#include "Utils.h"
+
+// 一起滤波的通道数(陀螺仪/加速度计/磁力计/温度),按Float4补齐到12
+static constexpr size_t CHANNELS = static_cast<size_t>(ImuChannel::COUNT);
+static constexpr size_t VECTORS = (CHANNELS + 3) / 4;
+static constexpr size_t LANES = VECTORS * 4;
+// 每次从来源读取的条数
+static constexpr size_t BATCH_SIZE = 64;
+// 估计输入周期用的样本数
+static constexpr size_t PERIOD_PROBE_SAMPLES = 16;
+// 4阶巴特沃斯分成两节双二阶的Q值
+static constexpr double BUTTERWORTH_Q[2] = {0.54119610, 1.30656296};
+
+static_assert(offsetof(IMU_SAMPLE, temperature) - offsetof(IMU_SAMPLE, gyro) == (CHANNELS - 1) * sizeof(float),
+              "IMU_SAMPLE的通道必须连续存放");
+
+static void loadLanes(const IMU_SAMPLE &sample, float (&lanes)[LANES]) {
+    std::memcpy(lanes, sample.gyro, CHANNELS * sizeof(float));
+    std::fill(lanes + CHANNELS, lanes + LANES, 0.0f);
+}
+
+static void storeLanes(const float (&lanes)[LANES], IMU_SAMPLE &sample) {
+    std::memcpy(sample.gyro, lanes, CHANNELS * sizeof(float));
+}
+
+/**
+ * 一种输出频率: 低通滤波 + 抽取
+ */
+struct ImuResampler::Stage {
+    double rateHz = 0;
+    uint64_t periodNs = 0;
+    std::shared_ptr<ImuSampleBuffer> source;
+    //来源是另一个阶段时为该阶段的频率
+    double sourceRateHz = 0;
+    //来源阶段(来源是原始数据时为nullptr)
+    Stage *upstream = nullptr;
+    std::shared_ptr<ImuSampleBuffer> output;
+    //订阅者数,由订阅句柄增减(句柄可能比阶段活得更久,所以单独共享)
+    std::shared_ptr<std::atomic<long>> subscribers = std::make_shared<std::atomic<long>>(0);
+    //本轮处理中是否计算(有订阅者,或者下游阶段在计算)
+    bool active = false;
+    ImuSampleBuffer::Cursor cursor;
+
+    // 滤波器在收到最初几条样本、测出输入周期后才设计
+    bool designed = false;
+    std::vector<IMU_SAMPLE> probe;
+    uint64_t nextOutputNs = 0;
+
+    // IIR: 两节双二阶的系数和状态(直接II型转置)
+    float b0[2] = {}, b1[2] = {}, b2[2] = {}, a1[2] = {}, a2[2] = {};
+    alignas(16) float z1[2][LANES] = {};
+    alignas(16) float z2[2][LANES] = {};
+
+    // FIR: 系数和最近fir_taps条输入(环形)
+    std::vector<float> taps;
+    std::vector<float> history;
+    size_t historyHead = 0;
+
+    std::atomic<uint64_t> inputs{0};
+    std::atomic<uint64_t> outputs{0};
+    std::atomic<uint64_t> busyNs{0};
+};
+
+/**
+ * 一个订阅: 持有阶段的输出,释放时减少订阅者数
+ * subscribe()返回的指针与它共用引用计数(别名构造),消费者的拷贝也算同一个订阅
+ */
+struct ImuResamplerSubscription {
+    std::shared_ptr<ImuSampleBuffer> output;
+    std::shared_ptr<std::atomic<long>> subscribers;
+
+    ImuResamplerSubscription(std::shared_ptr<ImuSampleBuffer> output, std::shared_ptr<std::atomic<long>> subscribers)
+        : output(std::move(output)), subscribers(std::move(subscribers)) {
+        this->subscribers->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~ImuResamplerSubscription() {
+        subscribers->fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+static std::shared_ptr<ImuSampleBuffer> makeSubscription(const std::shared_ptr<ImuSampleBuffer> &output,
+                                                         const std::shared_ptr<std::atomic<long>> &subscribers) {
+    auto subscription = std::make_shared<ImuResamplerSubscription>(output, subscribers);
+    ImuSampleBuffer *buffer = subscription->output.get();
+    return std::shared_ptr<ImuSampleBuffer>(std::move(subscription), buffer);
+}
+
+ImuResampler::ImuResampler(std::shared_ptr<ImuSampleBuffer> source) : ImuResampler(std::move(source), Config()) {
+}
+
+ImuResampler::ImuResampler(std::shared_ptr<ImuSampleBuffer> source, const Config &config)
+    : source(std::move(source)), config(config) {
+    this->config.fir_taps |= 1;
+}
+
+ImuResampler::~ImuResampler() {
+    stop();
+}
+
+std::shared_ptr<ImuSampleBuffer> ImuResampler::subscribe(const double rateHz) {
+    if (rateHz <= 0 || !source) {
+        return source;
+    }
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    std::shared_ptr<ImuSampleBuffer> subscription;
+    for (const auto &stage: stages) {
+        if (std::fabs(stage->rateHz - rateHz) < rateHz * 0.01) {
+            subscription = makeSubscription(stage->output, stage->subscribers);
+            break;
+        }
+    }
+
+    if (!subscription) {
+        auto stage = std::make_unique<Stage>();
+        stage->rateHz = rateHz;
+        stage->periodNs = static_cast<uint64_t>(1e9 / rateHz);
+        stage->output = std::make_shared<ImuSampleBuffer>(config.output_capacity);
+        // 从最低的、仍然足够高的已有阶段级联
+        stage->source = source;
+        for (const auto &candidate: stages) {
+            if (candidate->rateHz >= rateHz * config.cascade_ratio) {
+                stage->source = candidate->output;
+                stage->sourceRateHz = candidate->rateHz;
+                stage->upstream = candidate.get();
+            }
+        }
+        stage->cursor = stage->source->cursorAtEnd();
+        subscription = makeSubscription(stage->output, stage->subscribers);
+
+        const auto position = std::find_if(stages.begin(), stages.end(),
+                                           [rateHz](const std::unique_ptr<Stage> &existing) {
+                                               return existing->rateHz < rateHz;
+                                           });
+        stages.insert(position, std::move(stage));
+    }
+
+    if (workerEnabled && !workerRunning) {
+        launchWorkerLocked();
+    }
+    return subscription;
+}
+
+void ImuResampler::start() {
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    if (workerEnabled || !source) {
+        return;
+    }
+    workerEnabled = true;
+    if (hasSubscribersLocked()) {
+        launchWorkerLocked();
+    }
+}
+
+void ImuResampler::stop() {
+    std::thread exiting;
+    {
+        std::lock_guard<std::mutex> lock(stagesMutex);
+        workerEnabled = false;
+        stopRequested = true;
+        exiting = std::move(worker);
+    }
+    if (exiting.joinable()) {
+        exiting.join();
+    }
+}
+
+void ImuResampler::launchWorkerLocked() {
+    // 上一个处理线程已经在锁内标记了退出,之后不再取锁,可以在这里等待
+    if (worker.joinable()) {
+        worker.join();
+    }
+    stopRequested = false;
+    workerRunning = true;
+    worker = std::thread([this]() { run(); });
+}
+
+bool ImuResampler::hasSubscribersLocked() const {
+    return std::any_of(stages.begin(), stages.end(), [](const std::unique_ptr<Stage> &stage) {
+        return stage->subscribers->load(std::memory_order_relaxed) > 0;
+    });
+}
+
+void ImuResampler::run() {
+    while (!stopRequested) {
+        bool active = false;
+        if (processStages(active) > 0) {
+            continue;
+        }
+        if (!active) {
+            // 最后一个订阅者已释放: 退出线程,下次订阅时再启动
+            std::lock_guard<std::mutex> lock(stagesMutex);
+            if (!hasSubscribersLocked()) {
+                workerRunning = false;
+                return;
+            }
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    workerRunning = false;
+}
+
+size_t ImuResampler::process() {
+    bool active = false;
+    return processStages(active);
+}
+size_t ImuResampler::processStages(bool &active) {
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    size_t produced = 0;
+    IMU_SAMPLE batch[BATCH_SIZE];
+
+    // 从低频往高频标记: 有订阅者的阶段计算,它的来源阶段也要计算
+    for (const auto &stagePointer: stages) {
+        stagePointer->active = false;
+    }
+    for (auto it = stages.rbegin(); it != stages.rend(); ++it) {
+        Stage &stage = **it;
+        if (stage.subscribers->load(std::memory_order_relaxed) > 0) {
+            stage.active = true;
+        }
+        if (stage.active && stage.upstream) {
+            stage.upstream->active = true;
+        }
+    }
+
+    for (const auto &stagePointer: stages) {
+        Stage &stage = *stagePointer;
+        if (!stage.active) {
+            stage.cursor = stage.source->cursorAtEnd();
+            continue;
+        }
+        active = true;
+
+        size_t count;
+        while ((count = stage.source->read(stage.cursor, batch, BATCH_SIZE)) > 0) {
+            const uint64_t beginNs = Utils::steadyNowNs();
+            const IMU_SAMPLE *samples = batch;
+            size_t remaining = count;
+            if (!stage.designed) {
+                // 用最初的几条样本测出输入周期,这些样本之后同样经过滤波
+                const size_t taken = std::min(remaining, PERIOD_PROBE_SAMPLES - stage.probe.size());
+                stage.probe.insert(stage.probe.end(), samples, samples + taken);
+                samples += taken;
+                remaining -= taken;
+                if (stage.probe.size() < PERIOD_PROBE_SAMPLES) {
+                    continue;
+                }
+                const uint64_t spanNs = stage.probe.back().device_timestamp_ns - stage.probe.front().device_timestamp_ns;
+                const double inputRateHz = spanNs > 0
+                                               ? 1e9 * static_cast<double>(PERIOD_PROBE_SAMPLES - 1) /
+                                                 static_cast<double>(spanNs)
+                                               : stage.rateHz;
+                design(stage, inputRateHz, stage.probe.front());
+                produced += filter(stage, stage.probe.data(), stage.probe.size());
+                stage.probe.clear();
+                stage.probe.shrink_to_fit();
+            }
+            produced += filter(stage, samples, remaining);
+            stage.inputs.fetch_add(count, std::memory_order_relaxed);
+            stage.busyNs.fetch_add(Utils::steadyNowNs() - beginNs, std::memory_order_relaxed);
+        }
+    }
+    return produced;
+}
+
+void ImuResampler::design(Stage &stage, const double inputRateHz, const IMU_SAMPLE &first) const {
+    // 截止频率不超过输入的奈奎斯特频率
+    const double cutoff = std::min(stage.rateHz * config.cutoff_ratio, inputRateHz * 0.45) / inputRateHz;
+    float lanes[LANES];
+    loadLanes(first, lanes);
+
+    if (config.filter == Filter::IIR) {
+        const double k = std::tan(M_PI * cutoff);
+        for (int section = 0; section < 2; section++) {
+            const double q = BUTTERWORTH_Q[section];
+            const double norm = 1.0 / (1.0 + k / q + k * k);
+            stage.b0[section] = static_cast<float>(k * k * norm);
+            stage.b1[section] = 2 * stage.b0[section];
+            stage.b2[section] = stage.b0[section];
+            stage.a1[section] = static_cast<float>(2.0 * (k * k - 1.0) * norm);
+            stage.a2[section] = static_cast<float>((1.0 - k / q + k * k) * norm);
+            // 稳态: 输入一直是第一条样本时的状态(直流增益为1,每节的输入输出相同)
+            for (size_t lane = 0; lane < LANES; lane++) {
+                stage.z2[section][lane] = (stage.b2[section] - stage.a2[section]) * lanes[lane];
+                stage.z1[section][lane] = (stage.b1[section] - stage.a1[section]) * lanes[lane] +
+                                          stage.z2[section][lane];
+            }
+        }
+    } else {
+        const size_t count = config.fir_taps;
+        stage.taps.assign(count, 0.0f);
+        const double middle = static_cast<double>(count - 1) / 2.0;
+        double sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            const double x = static_cast<double>(i) - middle;
+            const double sinc = x == 0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+            const double window = 0.54 - 0.46 * std::cos(2.0 * M_PI * static_cast<double>(i) /
+                                                         static_cast<double>(count - 1));
+            stage.taps[i] = static_cast<float>(sinc * window);
+            sum += stage.taps[i];
+        }
+        // 直流增益归一为1
+        for (float &tap: stage.taps) {
+            tap = static_cast<float>(tap / sum);
+        }
+        stage.history.resize(count * LANES);
+        for (size_t i = 0; i < count; i++) {
+            std::copy(lanes, lanes + LANES, stage.history.begin() + static_cast<std::ptrdiff_t>(i * LANES));
+        }
+        stage.historyHead = 0;
+    }
+
+    // 输出时刻对齐到周期的整数倍
+    stage.nextOutputNs = (first.device_timestamp_ns / stage.periodNs + 1) * stage.periodNs;
+    stage.designed = true;
+}
+
+size_t ImuResampler::filter(Stage &stage, const IMU_SAMPLE *samples, const size_t count) const {
+    return config.filter == Filter::IIR ? filterIir(stage, samples, count) : filterFir(stage, samples, count);
+}
+
+/**
+ * 到达输出时刻时写出一条样本
+ * @return - 是否写出
+ */
+static bool emitIfDue(uint64_t &nextOutputNs, const uint64_t periodNs, const IMU_SAMPLE &input,
+                      const float (&lanes)[LANES], ImuSampleBuffer &output) {
+    if (input.device_timestamp_ns < nextOutputNs) {
+        return false;
+    }
+    IMU_SAMPLE sample;
+    sample.device_timestamp_ns = input.device_timestamp_ns;
+    sample.received_at_ns = input.received_at_ns;
+    sample.has_magnetometer = input.has_magnetometer;
+    storeLanes(lanes, sample);
+    output.push(sample);
+
+    nextOutputNs += periodNs;
+    // 输入中断过(或来源比输出还慢)时不补发,从下一个网格点继续
+    if (nextOutputNs <= input.device_timestamp_ns) {
+        nextOutputNs = (input.device_timestamp_ns / periodNs + 1) * periodNs;
+    }
+    return true;
+}
+
+size_t ImuResampler::filterIir(Stage &stage, const IMU_SAMPLE *samples, const size_t count) const {
+    // 状态在整批处理期间放在向量里
+    Float4Simd z1[2][VECTORS];
+    Float4Simd z2[2][VECTORS];
+    Float4Simd b0[2], b1[2], b2[2], a1[2], a2[2];
+    for (int section = 0; section < 2; section++) {
+        for (size_t v = 0; v < VECTORS; v++) {
+            z1[section][v] = Float4Simd::load(stage.z1[section] + v * 4);
+            z2[section][v] = Float4Simd::load(stage.z2[section] + v * 4);
+        }
+        b0[section] = Float4Simd::splat(stage.b0[section]);
+        b1[section] = Float4Simd::splat(stage.b1[section]);
+        b2[section] = Float4Simd::splat(stage.b2[section]);
+        a1[section] = Float4Simd::splat(stage.a1[section]);
+        a2[section] = Float4Simd::splat(stage.a2[section]);
+    }
+
+    size_t produced = 0;
+    float lanes[LANES];
+    for (size_t i = 0; i < count; i++) {
+        loadLanes(samples[i], lanes);
+        for (size_t v = 0; v < VECTORS; v++) {
+            Float4Simd x = Float4Simd::load(lanes + v * 4);
+            for (int section = 0; section < 2; section++) {
+                const Float4Simd y = b0[section] * x + z1[section][v];
+                z1[section][v] = b1[section] * x - a1[section] * y + z2[section][v];
+                z2[section][v] = b2[section] * x - a2[section] * y;
+                x = y;
+            }
+            x.store(lanes + v * 4);
+        }
+        if (emitIfDue(stage.nextOutputNs, stage.periodNs, samples[i], lanes, *stage.output)) {
+            produced++;
+        }
+    }
+
+    for (int section = 0; section < 2; section++) {
+        for (size_t v = 0; v < VECTORS; v++) {
+            z1[section][v].store(stage.z1[section] + v * 4);
+            z2[section][v].store(stage.z2[section] + v * 4);
+        }
+    }
+    stage.outputs.fetch_add(produced, std::memory_order_relaxed);
+    return produced;
+}
+
+size_t ImuResampler::filterFir(Stage &stage, const IMU_SAMPLE *samples, const size_t count) const {
+    const size_t taps = stage.taps.size();
+    size_t produced = 0;
+    float lanes[LANES];
+    for (size_t i = 0; i < count; i++) {
+        // 每条输入只写入历史,卷积只在输出时刻计算
+        loadLanes(samples[i], lanes);
+        std::copy(lanes, lanes + LANES, stage.history.begin() + static_cast<std::ptrdiff_t>(stage.historyHead * LANES));
+        stage.historyHead = stage.historyHead + 1 == taps ? 0 : stage.historyHead + 1;
+        if (samples[i].device_timestamp_ns < stage.nextOutputNs) {
+            continue;
+        }
+
+        Float4Simd sum[VECTORS];
+        for (auto &vector: sum) {
+            vector = Float4Simd::splat(0);
+        }
+        // historyHead现在指向最旧的一条
+        size_t slot = stage.historyHead;
+        for (size_t tap = 0; tap < taps; tap++) {
+            const float *row = stage.history.data() + slot * LANES;
+            for (size_t v = 0; v < VECTORS; v++) {
+                sum[v] = sum[v] + Float4Simd::load(row + v * 4) * stage.taps[tap];
+            }
+            slot = slot + 1 == taps ? 0 : slot + 1;
+        }
+        for (size_t v = 0; v < VECTORS; v++) {
+            sum[v].store(lanes + v * 4);
+        }
+        if (emitIfDue(stage.nextOutputNs, stage.periodNs, samples[i], lanes, *stage.output)) {
+            produced++;
+        }
+    }
+    stage.outputs.fetch_add(produced, std::memory_order_relaxed);
+    return produced;
+}
+
+std::vector<ImuResampler::StageStats> ImuResampler::stats() const {
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    std::vector<StageStats> result;
+    result.reserve(stages.size());
+    for (const auto &stage: stages) {
+        StageStats stats;
+        stats.rate_hz = stage->rateHz;
+        stats.source_rate_hz = stage->sourceRateHz;
+        stats.inputs = stage->inputs.load(std::memory_order_relaxed);
+        stats.outputs = stage->outputs.load(std::memory_order_relaxed);
+        stats.busy_ns = stage->busyNs.load(std::memory_order_relaxed);
+        stats.subscribers = stage->subscribers->load(std::memory_order_relaxed);
+        result.push_back(stats);
+    }
+    return result;
+}
+
+bool ImuResampler::interpolate(const ImuSampleBuffer &buffer, const uint64_t deviceNs, IMU_SAMPLE &out) {
+    const uint64_t last = buffer.lastSequence();
+    if (last == 0) {
+        return false;
+    }
+    // 留出一段余量,查找期间生产者继续写入也不会覆盖到查找范围
+    const uint64_t margin = buffer.capacity() / 8;
+    uint64_t low = last > buffer.capacity() - margin ? last - (buffer.capacity() - margin) + 1 : 1;
+    uint64_t high = last;
+    const uint64_t *timestamps = buffer.deviceTimestamps();
+    if (deviceNs < timestamps[buffer.slotOf(low)] || deviceNs > timestamps[buffer.slotOf(high)]) {
+        return false;
+    }
+    // 找到最后一条时间戳不大于deviceNs的样本
+    while (low < high) {
+        const uint64_t middle = low + (high - low + 1) / 2;
+        if (timestamps[buffer.slotOf(middle)] <= deviceNs) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    IMU_SAMPLE before, after;
+    if (!buffer.read(low, before)) {
+        return false;
+    }
+    if (low == last || before.device_timestamp_ns == deviceNs) {
+        out = before;
+        out.device_timestamp_ns = deviceNs;
+        return before.device_timestamp_ns == deviceNs;
+    }
+    // 查找期间读到的时间戳可能已被覆盖,以一致地读出的两条样本为准
+    if (!buffer.read(low + 1, after) || before.device_timestamp_ns > deviceNs || after.device_timestamp_ns < deviceNs) {
+        return false;
+    }
+
+    const float t = static_cast<float>(static_cast<double>(deviceNs - before.device_timestamp_ns) /
+                                       static_cast<double>(after.device_timestamp_ns - before.device_timestamp_ns));
+    float a[LANES], b[LANES];
+    loadLanes(before, a);
+    loadLanes(after, b);
+    for (size_t v = 0; v < VECTORS; v++) {
+        const Float4Simd start = Float4Simd::load(a + v * 4);
+        (start + (Float4Simd::load(b + v * 4) - start) * t).store(a + v * 4);
+    }
+    storeLanes(a, out);
+    out.device_timestamp_ns = deviceNs;
+    out.received_at_ns = before.received_at_ns + static_cast<uint64_t>(
+                             t * static_cast<float>(after.received_at_ns - before.received_at_ns));
+    out.has_magnetometer = before.has_magnetometer && after.has_magnetometer;
+    return true;
+}
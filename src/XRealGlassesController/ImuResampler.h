@@ -0,0 +1,149 @@
+//
+// Created by Norman Wang on 2025/5/17.
+//
+
+#ifndef IMURESAMPLER_H
+#define IMURESAMPLER_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ImuSampleBuffer.h"
+
+
+/**
+ * IMU重采样
+ * 位于IMU解码和各消费者之间: 融合使用原始的全速率数据,网页桥接只需要显示刷新率,日志只需要几Hz.
+ * 每个消费者按自己需要的频率订阅,得到一个同样是ImuSampleBuffer的输出(用游标读取,用法与原始数据相同).
+ *
+ * 每种输出频率是一个阶段: 先低通滤波(抗混叠),再按设备时间戳的等间隔网格抽取.
+ *   IIR - 4阶巴特沃斯(两节双二阶),每条输入都要计算
+ *   FIR - 加汉明窗的sinc,只在输出时刻计算,抽取比例大时更省
+ * 滤波对10个通道(陀螺仪/加速度计/磁力计各3个和温度)一起做,用Float4一次处理4个通道.
+ *
+ * 共享: 相同频率的订阅共用一个阶段;低频阶段从足够高(至少cascade_ratio倍)的已有阶段的输出继续抽取,
+ * 而不是都从原始数据开始. 每个阶段显式地记录订阅者数,没有订阅者、也没有正在计算的下游阶段时暂停计算.
+ * start()之后由独立线程每1ms处理一次新数据;线程只在有订阅者时运行,最后一个订阅者释放后自行退出.
+ */
+class ImuResampler {
+public:
+    enum class Filter {
+        IIR,
+        FIR
+    };
+
+    struct Config {
+        Filter filter = Filter::IIR;
+        //低通截止频率 = 输出频率 × cutoff_ratio(应小于0.5)
+        float cutoff_ratio = 0.25f;
+        //FIR的阶数(奇数)
+        size_t fir_taps = 31;
+        //来源频率至少是输出频率的几倍时才从该阶段级联抽取
+        double cascade_ratio = 4.0;
+        //每个输出缓冲区的容量
+        size_t output_capacity = 1024;
+    };
+
+    /**
+     * 某个阶段的统计
+     */
+    struct StageStats {
+        double rate_hz = 0;
+        //来源的频率,0表示来源是原始数据
+        double source_rate_hz = 0;
+        uint64_t inputs = 0;
+        uint64_t outputs = 0;
+        //计算耗时(纳秒)
+        uint64_t busy_ns = 0;
+        //当前的订阅者数
+        long subscribers = 0;
+    };
+
+    explicit ImuResampler(std::shared_ptr<ImuSampleBuffer> source);
+
+    ImuResampler(std::shared_ptr<ImuSampleBuffer> source, const Config &config);
+
+    ~ImuResampler();
+
+    ImuResampler(const ImuResampler&) = delete;
+    ImuResampler& operator=(const ImuResampler&) = delete;
+
+    /**
+     * 按指定频率订阅
+     * @param rateHz - 输出频率,<=0表示全速率(直接返回原始数据)
+     * @return - 输出缓冲区,消费者保留这个指针(及其拷贝)即为订阅中,全部释放后取消订阅;
+     *           可以比ImuResampler活得更久(之后不再有新数据)
+     */
+    std::shared_ptr<ImuSampleBuffer> subscribe(double rateHz);
+
+    /**
+     * 允许后台处理: 有订阅者时启动处理线程(没有时等到第一次订阅)
+     */
+    void start();
+
+    /**
+     * 停止后台处理并等待处理线程退出
+     */
+    void stop();
+
+    /**
+     * 处理一遍所有阶段的新数据(由内部线程调用;不启动线程时也可以手动调用,例如离线处理)
+     * @return - 本次输出的样本总数
+     */
+    size_t process();
+
+    std::vector<StageStats> stats() const;
+
+    /**
+     * 在缓冲区中按设备时间戳线性插值
+     * @param buffer - 样本缓冲区(原始或某个输出)
+     * @param deviceNs - 查询时刻(设备时间)
+     * @param out - 插值结果
+     * @return - 查询时刻是否在缓冲区现有数据的时间范围内
+     */
+    static bool interpolate(const ImuSampleBuffer &buffer, uint64_t deviceNs, IMU_SAMPLE &out);
+
+private:
+    struct Stage;
+
+    void run();
+
+    /**
+     * 处理所有有订阅者(或下游阶段在计算)的阶段
+     * @param active - 输出: 是否有阶段在计算
+     */
+    size_t processStages(bool &active);
+
+    // 启动处理线程(调用方持有stagesMutex)
+    void launchWorkerLocked();
+
+    bool hasSubscribersLocked() const;
+
+    // 按测出的输入频率设计该阶段的滤波器,状态初始化为第一条样本的稳态(避免启动时的过渡过程)
+    void design(Stage &stage, double inputRateHz, const IMU_SAMPLE &first) const;
+
+    size_t filter(Stage &stage, const IMU_SAMPLE *samples, size_t count) const;
+
+    size_t filterIir(Stage &stage, const IMU_SAMPLE *samples, size_t count) const;
+
+    size_t filterFir(Stage &stage, const IMU_SAMPLE *samples, size_t count) const;
+
+    std::shared_ptr<ImuSampleBuffer> source;
+    Config config;
+
+    // 保护stages(订阅时增加阶段,处理线程遍历)
+    mutable std::mutex stagesMutex;
+    // 按频率从高到低排列,级联的来源总在前面
+    std::vector<std::unique_ptr<Stage>> stages;
+
+    std::thread worker;
+    std::atomic<bool> stopRequested{false};
+    // 以下由stagesMutex保护: start()之后允许运行处理线程 / 处理线程正在运行
+    bool workerEnabled = false;
+    bool workerRunning = false;
+};
+
+
+#endif //IMURESAMPLER_H
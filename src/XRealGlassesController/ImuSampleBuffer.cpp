@@ -0,0 +1,169 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#include "ImuSampleBuffer.h"
+
+#include <algorithm>
+
+// 计算不小于n的2的幂
+static size_t roundUpToPowerOfTwo(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// 统计上报频率的窗口(设备时间)
+static constexpr uint64_t RATE_WINDOW_NS = 1000000000ULL;
+
+ImuSampleBuffer::ImuSampleBuffer(const size_t capacity) {
+    const size_t actualCapacity = roundUpToPowerOfTwo(std::max<size_t>(capacity, 2));
+    channels = std::make_unique<float[]>(actualCapacity * static_cast<size_t>(ImuChannel::COUNT));
+    deviceTimestampNs = std::make_unique<uint64_t[]>(actualCapacity);
+    receivedAtNs = std::make_unique<uint64_t[]>(actualCapacity);
+    magnetometerFlags = std::make_unique<bool[]>(actualCapacity);
+    mask = actualCapacity - 1;
+}
+
+uint64_t ImuSampleBuffer::push(const IMU_SAMPLE &sample) {
+    const uint64_t sequence = nextSequence++;
+    const size_t slot = sequence & mask;
+    const size_t stride = mask + 1;
+
+    // 各通道分别写入,全部写完后才发布序号
+    float *base = channels.get() + slot;
+    for (int axis = 0; axis < 3; axis++) {
+        base[(static_cast<size_t>(ImuChannel::GYRO_X) + axis) * stride] = sample.gyro[axis];
+        base[(static_cast<size_t>(ImuChannel::ACCEL_X) + axis) * stride] = sample.accel[axis];
+        base[(static_cast<size_t>(ImuChannel::MAG_X) + axis) * stride] = sample.mag[axis];
+    }
+    base[static_cast<size_t>(ImuChannel::TEMPERATURE) * stride] = sample.temperature;
+    deviceTimestampNs[slot] = sample.device_timestamp_ns;
+    receivedAtNs[slot] = sample.received_at_ns;
+    magnetometerFlags[slot] = sample.has_magnetometer;
+
+    head.store(sequence, std::memory_order_release);
+
+    track(sample.device_timestamp_ns);
+    if (sample.has_magnetometer && !hasMagnetometer.load(std::memory_order_relaxed)) {
+        hasMagnetometer.store(true, std::memory_order_relaxed);
+    }
+    return sequence;
+}
+
+void ImuSampleBuffer::track(const uint64_t deviceTimestampNs) {
+    const uint64_t previous = lastDeviceTimestampNs;
+    lastDeviceTimestampNs = deviceTimestampNs;
+
+    // 第一条样本,或者设备时钟回退(设备重启)时重新开始统计
+    if (previous == 0 || deviceTimestampNs <= previous) {
+        periodNs = 0;
+        windowStartNs = deviceTimestampNs;
+        windowSamples = 0;
+        return;
+    }
+
+    const uint64_t interval = deviceTimestampNs - previous;
+    if (periodNs == 0) {
+        periodNs = interval;
+    } else if (interval * 2 > periodNs * 3) {
+        // 间隔超过1.5个周期,按周期推算中间丢了几条,周期本身不受影响
+        const uint64_t missing = (interval + periodNs / 2) / periodNs - 1;
+        dropped.fetch_add(missing, std::memory_order_relaxed);
+    } else {
+        // 平滑周期,吸收上报的抖动
+        periodNs = periodNs - periodNs / 16 + interval / 16;
+    }
+
+    windowSamples++;
+    const uint64_t windowNs = deviceTimestampNs - windowStartNs;
+    if (windowNs >= RATE_WINDOW_NS) {
+        rateHz.store(static_cast<double>(windowSamples) * 1e9 / static_cast<double>(windowNs),
+                     std::memory_order_relaxed);
+        windowStartNs = deviceTimestampNs;
+        windowSamples = 0;
+    }
+}
+
+void ImuSampleBuffer::copyOut(const uint64_t sequence, IMU_SAMPLE &out) const {
+    const size_t slot = sequence & mask;
+    const size_t stride = mask + 1;
+    const float *base = channels.get() + slot;
+    for (int axis = 0; axis < 3; axis++) {
+        out.gyro[axis] = base[(static_cast<size_t>(ImuChannel::GYRO_X) + axis) * stride];
+        out.accel[axis] = base[(static_cast<size_t>(ImuChannel::ACCEL_X) + axis) * stride];
+        out.mag[axis] = base[(static_cast<size_t>(ImuChannel::MAG_X) + axis) * stride];
+    }
+    out.temperature = base[static_cast<size_t>(ImuChannel::TEMPERATURE) * stride];
+    out.device_timestamp_ns = deviceTimestampNs[slot];
+    out.received_at_ns = receivedAtNs[slot];
+    out.has_magnetometer = magnetometerFlags[slot];
+}
+
+bool ImuSampleBuffer::isIntact(const uint64_t oldestSequence) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // 生产者可能正在写 head+1 所在的槽位,它覆盖的是序号 head+1-容量 的样本
+    return head.load(std::memory_order_relaxed) - oldestSequence < mask;
+}
+
+bool ImuSampleBuffer::read(const uint64_t sequence, IMU_SAMPLE &out) const {
+    if (sequence == 0 || sequence > head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    copyOut(sequence, out);
+    return isIntact(sequence);
+}
+
+bool ImuSampleBuffer::latest(IMU_SAMPLE &out) const {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        if (read(head.load(std::memory_order_acquire), out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ImuSampleBuffer::read(Cursor &cursor, IMU_SAMPLE *out, const size_t maxCount) const {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        const uint64_t newest = head.load(std::memory_order_acquire);
+        if (cursor.next > newest || maxCount == 0) {
+            return 0;
+        }
+
+        // 游标已经落后于最旧的可用样本,跳过被覆盖的部分
+        const uint64_t oldest = newest >= mask ? newest - mask + 1 : 1;
+        if (cursor.next < oldest) {
+            cursor.dropped += oldest - cursor.next;
+            cursor.next = oldest;
+        }
+
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(maxCount, newest - cursor.next + 1));
+        for (size_t i = 0; i < count; i++) {
+            copyOut(cursor.next + i, out[i]);
+        }
+        if (isIntact(cursor.next)) {
+            cursor.next += count;
+            return count;
+        }
+        // 拷贝期间最旧的几条被覆盖,重新定位后再读一次
+    }
+    return 0;
+}
+
+ImuSampleBuffer::Cursor ImuSampleBuffer::cursorAtEnd() const {
+    Cursor cursor;
+    cursor.next = head.load(std::memory_order_acquire) + 1;
+    return cursor;
+}
+
+ImuSampleBuffer::Stats ImuSampleBuffer::stats() const {
+    Stats result;
+    result.samples = head.load(std::memory_order_acquire);
+    result.dropped = dropped.load(std::memory_order_relaxed);
+    result.rejected = rejected.load(std::memory_order_relaxed);
+    result.rate_hz = rateHz.load(std::memory_order_relaxed);
+    result.has_magnetometer = hasMagnetometer.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,187 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#ifndef IMUSAMPLEBUFFER_H
+#define IMUSAMPLEBUFFER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "IMU_SAMPLE.h"
+
+
+/**
+ * IMU样本的通道,ImuSampleBuffer中每个通道是一段连续的float数组
+ */
+enum class ImuChannel {
+    GYRO_X,
+    GYRO_Y,
+    GYRO_Z,
+    ACCEL_X,
+    ACCEL_Y,
+    ACCEL_Z,
+    MAG_X,
+    MAG_Y,
+    MAG_Z,
+    TEMPERATURE,
+    // 通道数量
+    COUNT
+};
+
+/**
+ * IMU样本的环形缓冲区(结构数组形式,单生产者/多消费者)
+ * 每个通道单独存成连续数组,滤波/融合可以直接按通道成批处理;容量在构造时一次性分配,写入不再有堆分配.
+ * 生产者是IMU接口的读取线程,写完一条样本后才发布序号;读者拷贝后再检查一次序号,
+ * 读取期间被覆盖的样本会被丢弃并计入游标的丢失数.
+ *
+ * 同时按设备时间戳统计:
+ *   实际上报频率 - 每1秒设备时间计算一次
+ *   丢失样本数   - 相邻时间戳的间隔超过1.5个周期时,按间隔推算丢了几条(内核队列溢出/USB丢包)
+ */
+class ImuSampleBuffer {
+public:
+    /**
+     * 基于游标的顺序读取位置,每个消费者各自持有一个
+     */
+    struct Cursor {
+        //下一条要读的序号
+        uint64_t next = 1;
+        //因读取太慢而被覆盖掉(跳过)的条数
+        uint64_t dropped = 0;
+    };
+
+    /**
+     * 上报统计
+     */
+    struct Stats {
+        //已写入的样本数
+        uint64_t samples = 0;
+        //按设备时间戳推算的丢失样本数
+        uint64_t dropped = 0;
+        //无法解码的IMU上报数
+        uint64_t rejected = 0;
+        //最近1秒(设备时间)的实际上报频率,还没有统计出来时为0
+        double rate_hz = 0;
+        //是否收到过带磁力计数据的样本
+        bool has_magnetometer = false;
+    };
+
+    /**
+     * @param capacity - 能保存的样本数,会向上取整为2的幂(默认约4秒的1kHz数据)
+     */
+    explicit ImuSampleBuffer(size_t capacity = 4096);
+
+    ImuSampleBuffer(const ImuSampleBuffer&) = delete;
+    ImuSampleBuffer& operator=(const ImuSampleBuffer&) = delete;
+
+    /**
+     * 写入一条样本(只能由单一生产者线程调用)
+     * @return - 分配给这条样本的序号(从1开始)
+     */
+    uint64_t push(const IMU_SAMPLE &sample);
+
+    /**
+     * 记录一条无法解码的IMU上报
+     */
+    void countRejected() {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * 按序号读取一条样本
+     * @return - 是否读到(还没写入或者已被覆盖时返回false)
+     */
+    bool read(uint64_t sequence, IMU_SAMPLE &out) const;
+
+    /**
+     * 读取最新的一条样本
+     */
+    bool latest(IMU_SAMPLE &out) const;
+
+    /**
+     * 按游标成批读取,游标落后太多时跳到最旧的可用数据并累计丢失数
+     * @param cursor - 消费者自己的游标
+     * @param out - 输出数组
+     * @param maxCount - 最多读取多少条
+     * @return - 实际读到的条数
+     */
+    size_t read(Cursor &cursor, IMU_SAMPLE *out, size_t maxCount) const;
+
+    /**
+     * 创建一个从"当前最新样本之后"开始读取的游标
+     */
+    Cursor cursorAtEnd() const;
+
+    /**
+     * 直接访问某个通道的数组,序号为s的样本位于下标slotOf(s)
+     * 直接读取后需要用isIntact确认读取期间没有被覆盖
+     */
+    const float *channel(const ImuChannel channel) const {
+        return channels.get() + static_cast<size_t>(channel) * (mask + 1);
+    }
+
+    const uint64_t *deviceTimestamps() const {
+        return deviceTimestampNs.get();
+    }
+
+    const uint64_t *receivedTimestamps() const {
+        return receivedAtNs.get();
+    }
+
+    size_t slotOf(const uint64_t sequence) const {
+        return sequence & mask;
+    }
+
+    /**
+     * 序号不小于oldestSequence的样本在这之前读到的数据是否仍然有效
+     */
+    bool isIntact(uint64_t oldestSequence) const;
+
+    /**
+     * 最近一次写入的序号,0表示还没有任何样本
+     */
+    uint64_t lastSequence() const {
+        return head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    Stats stats() const;
+
+private:
+    // 拷贝一条样本(不做一致性检查)
+    void copyOut(uint64_t sequence, IMU_SAMPLE &out) const;
+
+    // 按设备时间戳更新频率和丢失统计(生产者线程)
+    void track(uint64_t deviceTimestampNs);
+
+    std::unique_ptr<float[]> channels;
+    std::unique_ptr<uint64_t[]> deviceTimestampNs;
+    std::unique_ptr<uint64_t[]> receivedAtNs;
+    std::unique_ptr<bool[]> magnetometerFlags;
+    size_t mask;
+
+    // 生产者私有的下一个序号
+    uint64_t nextSequence = 1;
+    // 最近一次发布的序号
+    std::atomic<uint64_t> head{0};
+
+    // 生产者私有的统计状态
+    uint64_t lastDeviceTimestampNs = 0;
+    // 平滑后的上报周期,0表示还没有测出
+    uint64_t periodNs = 0;
+    uint64_t windowStartNs = 0;
+    uint64_t windowSamples = 0;
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<double> rateHz{0};
+    std::atomic<bool> hasMagnetometer{false};
+};
+
+
+#endif //IMUSAMPLEBUFFER_H
@@ -0,0 +1,82 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#include "ImuStream.h"
+
+#include <thread>
+
+#include "Logger.h"
+#include "Utils.h"
+
+ImuStream::ImuStream(const size_t capacity) : capacity(capacity) {
+}
+
+ImuStream::~ImuStream() {
+    stop();
+}
+
+bool ImuStream::start(const std::vector<INTERFACE_INFO> &interfaces, const int commandInterfaceNumber,
+                      const std::chrono::milliseconds deadline) {
+    stop();
+    const uint64_t startNs = Utils::steadyNowNs();
+
+    // 每个候选接口一个独立的缓冲区,选中后只保留选中的那个
+    std::vector<INTERFACE_INFO> candidates;
+    candidates.reserve(interfaces.size());
+    for (const auto &interface: interfaces) {
+        if (interface.interface_number == commandInterfaceNumber) {
+            continue;
+        }
+        INTERFACE_INFO &candidate = candidates.emplace_back();
+        candidate.interface_number = interface.interface_number;
+        candidate.hid_path = interface.hid_path;
+        candidate.reader_mode = interface.reader_mode;
+        candidate.imu_samples = std::make_shared<ImuSampleBuffer>(capacity);
+    }
+    for (auto &candidate: candidates) {
+        candidate.open();
+    }
+
+    // 等到某个接口解码出第一条IMU样本
+    int found = -1;
+    const auto giveUpAt = std::chrono::steady_clock::now() + deadline;
+    while (found < 0 && std::chrono::steady_clock::now() < giveUpAt) {
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (candidates[i].is_connected && candidates[i].imu_samples->lastSequence() > 0) {
+                found = static_cast<int>(i);
+                break;
+            }
+        }
+        if (found < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    if (found >= 0) {
+        imuInterface = std::make_unique<INTERFACE_INFO>(candidates[found]);
+        sampleBuffer = imuInterface->imu_samples;
+    }
+    // 其余接口随候选列表析构而关闭
+    candidates.clear();
+
+    if (found < 0) {
+        Logger::warning("没有找到上报IMU数据的接口");
+        return false;
+    }
+    Logger::success("IMU接口: %d, 查找耗时: %uus", imuInterface->interface_number,
+                    (Utils::steadyNowNs() - startNs) / 1000);
+    return true;
+}
+
+void ImuStream::stop() {
+    if (!imuInterface) {
+        return;
+    }
+    imuInterface->close();
+    const ImuSampleBuffer::Stats stats = sampleBuffer->stats();
+    Logger::log(stats.dropped > 0 || stats.rejected > 0 ? LogLevel::WARNING : LogLevel::INFO,
+                "IMU接口 %d 已停止: 样本 %u, 丢失 %u, 无法解码 %u, 频率 %.0fHz", imuInterface->interface_number,
+                stats.samples, stats.dropped, stats.rejected, stats.rate_hz);
+    imuInterface.reset();
+}
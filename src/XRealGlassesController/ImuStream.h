@@ -0,0 +1,80 @@
+//
+// Created by Norman Wang on 2025/5/11.
+//
+
+#ifndef IMUSTREAM_H
+#define IMUSTREAM_H
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "ImuSampleBuffer.h"
+#include "INTERFACE_INFO.h"
+
+
+/**
+ * 眼镜的IMU数据流
+ * 通讯接口以外的接口中有一个持续上报陀螺仪/加速度计/磁力计数据.
+ * start时同时打开这些接口,第一个上报出可解码IMU数据的接口保持打开,其余立即关闭;
+ * 之后该接口的每条上报都在读取线程中解码写入样本缓冲区(约1kHz).
+ */
+class ImuStream {
+public:
+    /**
+     * @param capacity - 样本缓冲区容量
+     */
+    explicit ImuStream(size_t capacity = 4096);
+
+    ~ImuStream();
+
+    ImuStream(const ImuStream&) = delete;
+    ImuStream& operator=(const ImuStream&) = delete;
+
+    /**
+     * 查找并打开IMU接口
+     * @param interfaces - 眼镜的所有接口
+     * @param commandInterfaceNumber - 通讯接口的编号(不参与查找)
+     * @param deadline - 等待IMU上报的最长时间
+     * @return - 是否找到了IMU接口
+     */
+    bool start(const std::vector<INTERFACE_INFO> &interfaces, int commandInterfaceNumber,
+               std::chrono::milliseconds deadline = std::chrono::milliseconds(300));
+
+    /**
+     * 关闭IMU接口并输出统计
+     */
+    void stop();
+
+    [[nodiscard]] bool isRunning() const {
+        return imuInterface != nullptr;
+    }
+
+    /**
+     * IMU接口编号,未运行时为-1
+     */
+    [[nodiscard]] int interfaceNumber() const {
+        return imuInterface ? imuInterface->interface_number : -1;
+    }
+
+    /**
+     * 样本缓冲区(停止后仍可读取已有的样本)
+     */
+    [[nodiscard]] std::shared_ptr<ImuSampleBuffer> samples() const {
+        return sampleBuffer;
+    }
+
+    /**
+     * IMU接口上报流的健康统计,未运行时为nullptr
+     */
+    [[nodiscard]] std::shared_ptr<StreamHealth> health() const {
+        return imuInterface ? imuInterface->stream_health : nullptr;
+    }
+
+private:
+    size_t capacity;
+    std::shared_ptr<ImuSampleBuffer> sampleBuffer;
+    std::unique_ptr<INTERFACE_INFO> imuInterface;
+};
+
+
+#endif //IMUSTREAM_H
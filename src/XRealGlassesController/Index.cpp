@@ -4,21 +4,76 @@
 
 #include "Index.h"
 
+#include <future>
+
+#include "CalibrationCache.h"
 #include "CommandHelper.h"
+#include "InputDecoder.h"
+#include "Logger.h"
+#include "Metrics.h"
 #include "Utils.h"
 
-INTERFACE_INFO* Index::current_connected_device_interface = nullptr;
+std::mutex Index::current_mutex;
+std::shared_ptr<INTERFACE_INFO> Index::current_connected_device_interface;
+std::shared_ptr<ImuStream> Index::current_imu_stream;
+std::shared_ptr<ImuResampler> Index::current_imu_resampler;
+std::shared_ptr<HeadTracker> Index::current_head_tracker;
+uint64_t Index::current_input_subscription = 0;
+std::string Index::current_serial_number;
+uint64_t Index::current_metrics_collector = 0;
+
+/**
+ * 传感器数据流的指标: 各接口的StreamHealth和IMU延迟,取快照时读出
+ */
+static void collectStreamMetrics(Metrics::Writer &writer) {
+    for (const StreamHealth::Snapshot &health: Index::streamHealth()) {
+        const Metrics::Labels labels = {{"interface", std::to_string(health.interface_number)}};
+        const auto withKind = [&labels](const char *kind) {
+            Metrics::Labels result = labels;
+            result.emplace_back("kind", kind);
+            return result;
+        };
+        writer.counter("xreal_stream_reports_total", "收到的上报", withKind("all"), health.reports);
+        writer.counter("xreal_stream_reports_total", "收到的上报", withKind("imu"), health.imu_reports);
+        writer.counter("xreal_stream_reports_total", "收到的上报", withKind("mcu"), health.mcu_reports);
+        writer.counter("xreal_stream_errors_total", "上报的错误", withKind("crc"), health.crc_failures);
+        writer.counter("xreal_stream_errors_total", "上报的错误", withKind("malformed"), health.malformed);
+        writer.counter("xreal_stream_errors_total", "上报的错误", withKind("read"), health.read_errors);
+        writer.counter("xreal_stream_errors_total", "上报的错误", withKind("timestamp_regression"),
+                       health.timestamp_regressions);
+        writer.counter("xreal_stream_imu_missing_samples_total", "按设备时间戳推算丢失的IMU样本", labels,
+                       health.imu_missing);
+        writer.counter("xreal_stream_imu_gaps_total", "发生IMU样本丢失的次数", labels, health.imu_gaps);
+        writer.counter("xreal_stream_sequence_missing_total", "按序号推算丢失的0xFD报文", labels,
+                       health.sequence_missing);
+        writer.gauge("xreal_stream_rate_hz", "最近1秒的平均上报频率", labels, health.rate_1s_hz);
+        writer.gauge("xreal_stream_idle_seconds", "最近一条上报距现在的时间", labels,
+                     static_cast<double>(health.idle_ns) / 1e9);
+        writer.histogram("xreal_stream_arrival_interval_seconds", "主机收到相邻两条上报的间隔", labels,
+                         health.arrival);
+        writer.histogram("xreal_stream_device_interval_seconds", "相邻两条IMU样本的设备时间戳间隔", labels,
+                         health.device_interval);
+        writer.histogram("xreal_stream_handling_seconds", "读取线程处理一条上报的耗时", labels, health.handling);
+    }
+    HeadTracker::Latency latency;
+    if (Index::imuLatency(latency)) {
+        writer.histogram("xreal_imu_transit_seconds", "IMU样本超出最小传输延迟的部分", {}, latency.transit);
+        writer.histogram("xreal_imu_consume_seconds", "IMU样本写入缓冲区到被融合线程读走的时间", {},
+                         latency.consume);
+    }
+}
 
 Index::Index() = default;
 
 Index::~Index() {
-    if (current_connected_device_interface) {
+    if (isConnected()) {
         // Attempt to disconnect the connected device cleanly
         disconnectGlasses();
     }
 }
 
 bool Index::connectGlasses() {
+    const uint64_t startNs = Utils::steadyNowNs();
     const std::vector<GLASSES_INFO> allGlassesList = DevicesHelper::enumerateClassesByHid();
 
     if (allGlassesList.empty()) {
@@ -41,36 +96,111 @@ bool Index::connectGlasses() {
     INTERFACE_INFO validInterface = DevicesHelper::getValidHidInterface(selectedDevice.interfaces);
     
     // 确保找到了有效接口
-    if (!validInterface.is_connected || !validInterface.original_hid_device()) {
+    if (!validInterface.is_connected || !validInterface.device_handle()) {
         Utils::log("无法获取有效的通讯接口", LogLevel::ERROR);
         return false;
     }
     
     // 创建新的INTERFACE_INFO实例并设置为当前通讯接口
     // 注意：不要关闭validInterface，因为我们要继续使用它
-    if (current_connected_device_interface) {
+    if (isConnected()) {
         // 如果之前有连接，先断开
         disconnectGlasses();
     }
     
-    current_connected_device_interface = new INTERFACE_INFO(validInterface);
-    Utils::log("设备连接成功", LogLevel::SUCCESS);
+    // 先在锁外创建好所有对象,最后一次性发布,其他线程不会看到连接到一半的状态
+    const auto interface = std::make_shared<INTERFACE_INFO>(validInterface);
+    const std::string serialNumber = selectedDevice.serialNumber;
+    current_input_subscription = interface->input_events->subscribe(
+        [](const INPUT_EVENT &event) {
+            // 先分发再记日志,订阅者不必等待日志输出
+            inputEvents().publish(event);
+            Logger::info("眼镜输入: %s", InputDecoder::describe(event));
+        });
+
+    // 其余接口中上报IMU数据的那个保持打开;找不到不影响显示模式的控制
+    auto stream = std::make_shared<ImuStream>();
+    std::shared_ptr<HeadTracker> tracker;
+    if (!stream->start(selectedDevice.interfaces, validInterface.interface_number)) {
+        stream.reset();
+    } else {
+        tracker = std::make_shared<HeadTracker>(stream->samples());
+        // 有这副眼镜的校准缓存时直接使用,不必等待静止校准
+        IMU_CALIBRATION calibration;
+        if (CalibrationCache::load(serialNumber, calibration)) {
+            tracker->setCalibration(calibration);
+            Logger::info("已读取IMU校准缓存: %s", CalibrationCache::pathFor(serialNumber));
+        }
+        tracker->start();
+    }
+    {
+        std::lock_guard<std::mutex> lock(current_mutex);
+        current_connected_device_interface = interface;
+        current_serial_number = serialNumber;
+        current_imu_stream = stream;
+        current_head_tracker = tracker;
+    }
+    current_metrics_collector = Metrics::addCollector(&collectStreamMetrics);
+
+    static MetricHistogram &connectTime = Metrics::histogram("xreal_connect_seconds",
+                                                             "连接眼镜(枚举+探测+打开数据流)的耗时");
+    const uint64_t elapsedNs = Utils::steadyNowNs() - startNs;
+    connectTime.record(elapsedNs);
+    Logger::success("设备连接成功,耗时: %uus", elapsedNs / 1000);
     return true;
 }
 
 bool Index::disconnectGlasses() {
-    if (!current_connected_device_interface) {
+    // 在锁内摘下当前连接,之后其他线程取不到这些对象;已经取到的在用完后才销毁
+    std::shared_ptr<INTERFACE_INFO> interface;
+    std::shared_ptr<ImuStream> stream;
+    std::shared_ptr<ImuResampler> resampler;
+    std::shared_ptr<HeadTracker> tracker;
+    std::string serialNumber;
+    {
+        std::lock_guard<std::mutex> lock(current_mutex);
+        interface.swap(current_connected_device_interface);
+        stream.swap(current_imu_stream);
+        resampler.swap(current_imu_resampler);
+        tracker.swap(current_head_tracker);
+        serialNumber.swap(current_serial_number);
+    }
+    if (!interface) {
         Utils::log("No device is currently connected.", LogLevel::WARNING);
         return false;
     }
 
     try {
+        // 先删除收集函数(返回时它已经不在执行),之后才能释放它读取的对象
+        if (current_metrics_collector) {
+            Metrics::removeCollector(current_metrics_collector);
+            current_metrics_collector = 0;
+        }
+        if (tracker) {
+            tracker->stop();
+            // 本次运行中更新过的校准参数留给下次连接
+            if (CalibrationCache::save(serialNumber, tracker->calibration())) {
+                Logger::info("已保存IMU校准缓存: %s", CalibrationCache::pathFor(serialNumber));
+            }
+            tracker.reset();
+        }
+        if (resampler) {
+            resampler->stop();
+            resampler.reset();
+        }
+        if (stream) {
+            stream->stop();
+            stream.reset();
+        }
+
+        interface->input_events->unsubscribe(current_input_subscription);
+        current_input_subscription = 0;
+
         // 先关闭连接
-        current_connected_device_interface->close();
+        interface->close();
         
         // 释放指针
-        delete current_connected_device_interface;
-        current_connected_device_interface = nullptr;
+        interface.reset();
 
         Utils::log("Successfully disconnected the device.", LogLevel::SUCCESS);
         return true;
@@ -80,39 +210,175 @@ bool Index::disconnectGlasses() {
     }
 }
 
+std::shared_ptr<INTERFACE_INFO> Index::connectedInterface() {
+    std::lock_guard<std::mutex> lock(current_mutex);
+    return current_connected_device_interface;
+}
+
+std::shared_ptr<ImuStream> Index::imuStream() {
+    std::lock_guard<std::mutex> lock(current_mutex);
+    return current_imu_stream;
+}
+
+std::shared_ptr<HeadTracker> Index::headTracker() {
+    std::lock_guard<std::mutex> lock(current_mutex);
+    return current_head_tracker;
+}
+
 bool Index::isConnected() {
-    return current_connected_device_interface != nullptr;
+    return connectedInterface() != nullptr;
+}
+
+std::string Index::serialNumber() {
+    std::lock_guard<std::mutex> lock(current_mutex);
+    return current_connected_device_interface ? current_serial_number : std::string();
+}
+
+
+InputEventChannel &Index::inputEvents() {
+    static InputEventChannel channel;
+    return channel;
+}
+
+std::shared_ptr<ImuSampleBuffer> Index::imuSamples() {
+    const std::shared_ptr<ImuStream> stream = imuStream();
+    return stream ? stream->samples() : nullptr;
+}
+
+std::shared_ptr<ImuSampleBuffer> Index::imuSamplesAt(const double rateHz) {
+    std::shared_ptr<ImuResampler> resampler;
+    {
+        std::lock_guard<std::mutex> lock(current_mutex);
+        if (!current_imu_stream) {
+            return nullptr;
+        }
+        // 第一次订阅时才创建;处理线程只在有订阅者时运行
+        if (!current_imu_resampler) {
+            current_imu_resampler = std::make_shared<ImuResampler>(current_imu_stream->samples());
+            current_imu_resampler->start();
+        }
+        resampler = current_imu_resampler;
+    }
+    return resampler->subscribe(rateHz);
+}
+
+std::vector<StreamHealth::Snapshot> Index::streamHealth() {
+    std::vector<StreamHealth::Snapshot> result;
+    const std::shared_ptr<INTERFACE_INFO> interface = connectedInterface();
+    if (interface && interface->stream_health) {
+        result.push_back(interface->stream_health->snapshot());
+    }
+    const std::shared_ptr<ImuStream> stream = imuStream();
+    if (stream && stream->health()) {
+        result.push_back(stream->health()->snapshot());
+    }
+    return result;
+}
+
+bool Index::imuLatency(HeadTracker::Latency &out) {
+    const std::shared_ptr<HeadTracker> tracker = headTracker();
+    if (!tracker) {
+        return false;
+    }
+    out = tracker->latency();
+    return true;
+}
+
+bool Index::latestOrientation(ORIENTATION &out) {
+    const std::shared_ptr<HeadTracker> tracker = headTracker();
+    if (!tracker) {
+        return false;
+    }
+    out = tracker->latest();
+    return out.sample_sequence != 0;
+}
+
+bool Index::predictOrientation(const uint64_t photonTimeNs, ORIENTATION &out) {
+    const std::shared_ptr<HeadTracker> tracker = headTracker();
+    return tracker && tracker->predict(photonTimeNs, out);
+}
+
+bool Index::deviceTimeToHost(const uint64_t deviceNs, uint64_t &hostNs) {
+    const std::shared_ptr<HeadTracker> tracker = headTracker();
+    return tracker && tracker->deviceTimeToHost(deviceNs, hostNs);
+}
+
+void Index::setFusionAlgorithm(const SensorFusion::Algorithm algorithm) {
+    if (const std::shared_ptr<HeadTracker> tracker = headTracker()) {
+        tracker->setAlgorithm(algorithm);
+    }
 }
 
 
 /**
- * 切换眼镜显示模式
+ * 切换眼镜显示模式,等待设备应答
  * @param mode3D - true为3D模式，false为2D模式
- * @return - 切换是否成功
+ * @return - 命令是否已发出(设备确认或等待应答超时)
  */
 bool Index::switchMode(const bool mode3D) {
-    if (!current_connected_device_interface) {
+    std::promise<SwitchResult> done;
+    std::future<SwitchResult> result = done.get_future();
+    switchModeAsync(mode3D, [&done](const SwitchResult switched) {
+        done.set_value(switched);
+    });
+    return result.get() != SwitchResult::FAILED;
+}
+
+/**
+ * 切换眼镜显示模式,不等待设备应答
+ * @param mode3D - true为3D模式，false为2D模式
+ * @param done - 完成时的回调
+ */
+void Index::switchModeAsync(const bool mode3D, std::function<void(SwitchResult)> done) {
+    static MetricCounter &confirmed = Metrics::counter("xreal_mode_switches_total", "切换显示模式的命令",
+                                                       {{"result", "confirmed"}});
+    static MetricCounter &unconfirmed = Metrics::counter("xreal_mode_switches_total", "切换显示模式的命令",
+                                                         {{"result", "unconfirmed"}});
+    static MetricCounter &failed = Metrics::counter("xreal_mode_switches_total", "切换显示模式的命令",
+                                                    {{"result", "failed"}});
+    static MetricHistogram &switchTime = Metrics::histogram("xreal_mode_switch_seconds", "切换显示模式命令的耗时");
+    const std::shared_ptr<INTERFACE_INFO> interface = connectedInterface();
+    if (!interface) {
         Utils::log("设备未连接，请先连接设备", LogLevel::ERROR);
-        return false;
+        failed.add();
+        if (done) {
+            done(SwitchResult::FAILED);
+        }
+        return;
     }
 
     // 构建显示模式命令
     const uint8_t mode = mode3D ? 3 : 1;  // 假设3是3D模式，1是2D模式
-    auto command = CommandHelper::buildCustomDisplayCommand(0x0008, mode);
+    CommandHelper::McuReport command;
+    const size_t commandLength = CommandHelper::encodeDisplayMode(command, mode);
     
     // 发送命令
-    Utils::log(std::string("切换到") + (mode3D ? "3D" : "2D") + "模式", LogLevel::INFO);
-    
-    // 使用同步发送，确保命令成功发送并获取结果
-    bool result = DevicesHelper::sendCommand(current_connected_device_interface, command);
-    
-    if (result) {
-        Utils::log("切换模式命令发送成功", LogLevel::SUCCESS);
-    } else {
-        Utils::log("切换模式命令发送失败", LogLevel::ERROR);
-    }
+    Logger::info("切换到%s模式", mode3D ? "3D" : "2D");
     
-    return result;
+    // 收到应答(或超时)时在反应器线程中完成,调用方不等待
+    const uint64_t startNs = Utils::steadyNowNs();
+    DevicesHelper::sendRequest(interface.get(), command.data(), commandLength, std::chrono::seconds(1),
+                               [startNs, done = std::move(done)](const COMMAND_RESULT &result) {
+        switchTime.record(Utils::steadyNowNs() - startNs);
+        SwitchResult switched;
+        if (result.success) {
+            confirmed.add();
+            Logger::success("切换模式命令已确认,往返耗时: %uus", result.round_trip_ns / 1000);
+            switched = SwitchResult::CONFIRMED;
+        } else if (result.timed_out) {
+            // 命令已写入设备,只是没有收到应答;是否生效由分辨率检查来确认
+            unconfirmed.add();
+            Logger::warning("切换模式命令已发送,但未收到设备应答");
+            switched = SwitchResult::UNCONFIRMED;
+        } else {
+            failed.add();
+            Logger::error("切换模式命令发送失败: %s", result.error);
+            switched = SwitchResult::FAILED;
+        }
+        if (done) {
+            done(switched);
+        }
+    });
 }
 
 /**
@@ -123,7 +389,7 @@ bool Index::restoreTo2DMode() {
     bool success = true;
     
     // 检查是否有连接的设备
-    if (current_connected_device_interface) {
+    if (isConnected()) {
         // 创建临时索引对象用于调用实例方法
         Index tempIndex;
         
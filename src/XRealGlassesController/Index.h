@@ -4,14 +4,42 @@
 
 #ifndef INDEX_H
 #define INDEX_H
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "DevicesHelper.h"
+#include "HeadTracker.h"
+#include "ImuResampler.h"
+#include "ImuStream.h"
+#include "InputEventChannel.h"
 
 
 class Index {
 private:
-    static INTERFACE_INFO *current_connected_device_interface;
+    //保护下面的当前连接: 连接/断开在界面线程中进行,RPC/指标/页面帧等其他线程也会读取.
+    //读取方在锁内复制shared_ptr,锁外使用,断开连接时正在使用的对象要等最后一个使用者释放后才销毁
+    static std::mutex current_mutex;
+    static std::shared_ptr<INTERFACE_INFO> current_connected_device_interface;
+    //当前眼镜的IMU数据流(没有找到IMU接口时为nullptr)
+    static std::shared_ptr<ImuStream> current_imu_stream;
+    //按各消费者需要的频率重采样IMU数据(第一次调用imuSamplesAt时创建,之前为nullptr)
+    static std::shared_ptr<ImuResampler> current_imu_resampler;
+    //由IMU数据融合头部朝向(没有IMU数据时为nullptr)
+    static std::shared_ptr<HeadTracker> current_head_tracker;
+    //当前眼镜的序列号(用于保存校准缓存)
+    static std::string current_serial_number;
+    //以下只在连接/断开的线程(界面线程)中使用,不需要加锁
+    //把通讯接口的输入事件转发到inputEvents()的订阅ID
+    static uint64_t current_input_subscription;
+    //传感器数据流指标的收集函数ID(见Metrics),未连接时为0
+    static uint64_t current_metrics_collector;
+
+    // 在锁内取得当前连接的对象(未连接时为nullptr)
+    static std::shared_ptr<INTERFACE_INFO> connectedInterface();
+    static std::shared_ptr<ImuStream> imuStream();
+    static std::shared_ptr<HeadTracker> headTracker();
 public:
     Index();
     ~Index();
@@ -38,12 +66,96 @@ public:
      * @return - 设备是否已连接
      */
     static bool isConnected();
+
+    /**
+     * 当前眼镜的序列号
+     * @return - 未连接时为空
+     */
+    static std::string serialNumber();
+    /**
+     * 切换显示模式的结果
+     */
+    enum class SwitchResult {
+        //设备确认了命令
+        CONFIRMED,
+        //命令已写入,但等待应答超时(是否生效由分辨率检查来确认)
+        UNCONFIRMED,
+        //未连接或写入失败
+        FAILED
+    };
+
     /**
-     * 切换眼镜显示模式
+     * 切换眼镜显示模式,等待设备应答(最多1秒)
+     * 只用于事件循环之外(启动时/退出前),界面线程和RPC中使用switchModeAsync
      * @param mode3D - true为3D模式，false为2D模式
-     * @return - 切换是否成功
+     * @return - 命令是否已发出(设备确认或等待应答超时)
      */
     static bool switchMode(bool mode3D);
+
+    /**
+     * 切换眼镜显示模式,立即返回
+     * @param mode3D - true为3D模式，false为2D模式
+     * @param done - 收到应答/超时/失败时调用一次,在反应器线程中执行(未连接时在当前线程中执行);
+     *               界面代码应转到主线程处理
+     */
+    static void switchModeAsync(bool mode3D, std::function<void(SwitchResult)> done);
+
+    /**
+     * 眼镜的输入事件(按键/显示切换等),重新连接后订阅仍然有效
+     * 回调在读取线程中收到上报时立即执行,界面代码应转到主线程处理
+     */
+    static InputEventChannel &inputEvents();
+
+    /**
+     * 当前眼镜的IMU样本缓冲区
+     * @return - 未连接或没有IMU数据时为nullptr
+     */
+    static std::shared_ptr<ImuSampleBuffer> imuSamples();
+
+    /**
+     * 按指定频率订阅重采样(低通滤波+抽取)后的IMU样本,相同频率的订阅者共用一份数据
+     * @param rateHz - 输出频率,<=0时与imuSamples()相同
+     * @return - 未连接或没有IMU数据时为nullptr;持有返回的缓冲区即为订阅中
+     */
+    static std::shared_ptr<ImuSampleBuffer> imuSamplesAt(double rateHz);
+
+    /**
+     * 通讯接口和IMU接口上报流的健康统计(丢失/抖动/频率/错误)
+     * @return - 未连接时为空
+     */
+    static std::vector<StreamHealth::Snapshot> streamHealth();
+
+    /**
+     * IMU样本的传输延迟和被融合线程读走的延迟
+     * @return - 是否有数据(没有IMU数据时为false)
+     */
+    static bool imuLatency(HeadTracker::Latency &out);
+
+    /**
+     * 当前的头部朝向
+     * @param out - 输出
+     * @return - 是否有朝向数据(未连接或还没有融合过样本时为false)
+     */
+    static bool latestOrientation(ORIENTATION &out);
+
+    /**
+     * 把头部朝向预测到指定时刻(下一帧的预计出光时间)
+     * @param photonTimeNs - 主机时间(steady_clock纳秒)
+     * @param out - 预测的朝向
+     * @return - 是否有朝向数据
+     */
+    static bool predictOrientation(uint64_t photonTimeNs, ORIENTATION &out);
+
+    /**
+     * 把IMU的设备时间戳换算成主机时间(steady_clock纳秒)
+     * @return - 是否已经完成时钟同步(连接后约0.4秒)
+     */
+    static bool deviceTimeToHost(uint64_t deviceNs, uint64_t &hostNs);
+
+    /**
+     * 切换姿态融合算法
+     */
+    static void setFusionAlgorithm(SensorFusion::Algorithm algorithm);
 };
 
 
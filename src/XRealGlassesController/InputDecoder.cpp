@@ -0,0 +1,119 @@
+//
+// Created by Norman Wang on 2025/5/19.
+//
+
+#include "InputDecoder.h"
+
+#include <cstdio>
+
+#include "MCU_MESSAGE.h"
+
+/**
+ * 读取负载中的一个字节字段,负载不够长时为0
+ */
+static uint8_t payloadByte(const MCU_MESSAGE_VIEW &message, const REPORT_FIELD &field) {
+    return field.offset < message.payload_length ? message.payload[field.offset] : 0;
+}
+
+bool InputDecoder::decode(const MCU_MESSAGE_VIEW &message, const uint64_t receivedAtNs, INPUT_EVENT &out) {
+    switch (message.kind) {
+        case McuMessageKind::BUTTON_EVENT:
+            out.type = InputEventType::BUTTON;
+            out.button = static_cast<GlassesButton>(payloadByte(message, MCU_EVENT_LAYOUT::BUTTON));
+            out.action = static_cast<GlassesAction>(payloadByte(message, MCU_EVENT_LAYOUT::ACTION));
+            out.value = payloadByte(message, MCU_EVENT_LAYOUT::VALUE);
+            break;
+        case McuMessageKind::DISPLAY_TOGGLED:
+            out.type = InputEventType::DISPLAY_TOGGLED;
+            out.button = GlassesButton::NONE;
+            out.action = GlassesAction::NONE;
+            out.value = payloadByte(message, MCU_EVENT_LAYOUT::DISPLAY_STATE);
+            break;
+        case McuMessageKind::UNKNOWN:
+            // 未识别的主动上报也交给订阅者,便于从录制文件中找出它们的含义
+            if ((message.msg_id & MCU_EVENT_LAYOUT::UNSOLICITED_MASK) != MCU_EVENT_LAYOUT::UNSOLICITED_PREFIX) {
+                return false;
+            }
+            out.type = InputEventType::OTHER;
+            out.button = GlassesButton::NONE;
+            out.action = GlassesAction::NONE;
+            out.value = message.payload_length > 0 ? message.payload[0] : 0;
+            break;
+        default:
+            return false;
+    }
+    out.device_time = message.device_time;
+    out.sequence = message.sequence;
+    out.msg_id = message.msg_id;
+    out.received_at_ns = receivedAtNs;
+    return true;
+}
+
+bool InputDecoder::changesDisplayMode(const INPUT_EVENT &event) {
+    if (event.type == InputEventType::DISPLAY_TOGGLED) {
+        return true;
+    }
+    return event.type == InputEventType::BUTTON &&
+           (event.action == GlassesAction::MODE_2D || event.action == GlassesAction::MODE_3D ||
+            event.action == GlassesAction::DISPLAY_TOGGLE);
+}
+
+const char *InputDecoder::buttonName(const GlassesButton button) {
+    switch (button) {
+        case GlassesButton::NONE:
+            return "无";
+        case GlassesButton::DISPLAY:
+            return "显示键";
+        case GlassesButton::BRIGHTNESS_UP:
+            return "亮度+";
+        case GlassesButton::BRIGHTNESS_DOWN:
+            return "亮度-";
+    }
+    return "未知按键";
+}
+
+const char *InputDecoder::actionName(const GlassesAction action) {
+    switch (action) {
+        case GlassesAction::NONE:
+            return "无";
+        case GlassesAction::DISPLAY_TOGGLE:
+            return "开关显示";
+        case GlassesAction::MENU_TOGGLE:
+            return "菜单";
+        case GlassesAction::BRIGHTNESS_UP:
+            return "调亮";
+        case GlassesAction::BRIGHTNESS_DOWN:
+            return "调暗";
+        case GlassesAction::UP:
+            return "上";
+        case GlassesAction::DOWN:
+            return "下";
+        case GlassesAction::MODE_2D:
+            return "切换到2D";
+        case GlassesAction::MODE_3D:
+            return "切换到3D";
+        case GlassesAction::BLEND_CYCLE:
+            return "切换透明度";
+        case GlassesAction::CONTROL_TOGGLE:
+            return "切换控制";
+    }
+    return "未知动作";
+}
+
+std::string InputDecoder::describe(const INPUT_EVENT &event) {
+    char text[128];
+    switch (event.type) {
+        case InputEventType::BUTTON:
+            snprintf(text, sizeof(text), "按键 %s -> %s (值 %u, 设备时间 %u)", buttonName(event.button),
+                     actionName(event.action), event.value, event.device_time);
+            break;
+        case InputEventType::DISPLAY_TOGGLED:
+            snprintf(text, sizeof(text), "显示切换 (值 %u, 设备时间 %u)", event.value, event.device_time);
+            break;
+        default:
+            snprintf(text, sizeof(text), "未识别的上报 msgId=0x%04X (值 %u, 设备时间 %u)", event.msg_id, event.value,
+                     event.device_time);
+            break;
+    }
+    return text;
+}
@@ -0,0 +1,46 @@
+//
+// Created by Norman Wang on 2025/5/19.
+//
+
+#ifndef INPUTDECODER_H
+#define INPUTDECODER_H
+#include <cstdint>
+#include <string>
+
+#include "INPUT_EVENT.h"
+#include "MCU_MESSAGE_VIEW.h"
+
+
+/**
+ * 眼镜输入事件解码器
+ * 从已校验的0xFD报文中识别按键/显示切换等眼镜主动上报的事件,按MCU_EVENT_LAYOUT读出负载.
+ * 无状态,不做任何分配,在读取线程中收到报文时直接调用.
+ */
+class InputDecoder {
+public:
+    /**
+     * 解码一条输入事件
+     * @param message - 已校验的0xFD报文
+     * @param receivedAtNs - 收到报文的时间
+     * @param out - 输出事件
+     * @return - 是否是输入事件(命令应答/心跳/文本日志不是)
+     */
+    static bool decode(const MCU_MESSAGE_VIEW &message, uint64_t receivedAtNs, INPUT_EVENT &out);
+
+    /**
+     * 这个事件是否意味着眼镜的显示模式变了(应重新检查分辨率/布局)
+     */
+    static bool changesDisplayMode(const INPUT_EVENT &event);
+
+    static const char *buttonName(GlassesButton button);
+
+    static const char *actionName(GlassesAction action);
+
+    /**
+     * 事件的文字描述,用于日志
+     */
+    static std::string describe(const INPUT_EVENT &event);
+};
+
+
+#endif //INPUTDECODER_H
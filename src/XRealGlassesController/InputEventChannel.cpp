@@ -0,0 +1,41 @@
+//
+// Created by Norman Wang on 2025/5/19.
+//
+
+#include "InputEventChannel.h"
+
+#include <algorithm>
+
+uint64_t InputEventChannel::subscribe(Listener listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint64_t id = nextId++;
+    subscriptions.push_back({id, std::move(listener)});
+    return id;
+}
+
+void InputEventChannel::unsubscribe(const uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                       [id](const Subscription &subscription) {
+                                           return subscription.id == id;
+                                       }),
+                        subscriptions.end());
+}
+
+void InputEventChannel::publish(const INPUT_EVENT &event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastEvent = event;
+    publishedCount.fetch_add(1, std::memory_order_relaxed);
+    for (const auto &subscription: subscriptions) {
+        subscription.listener(event);
+    }
+}
+
+bool InputEventChannel::latest(INPUT_EVENT &out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (publishedCount.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    out = lastEvent;
+    return true;
+}
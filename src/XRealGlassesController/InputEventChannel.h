@@ -0,0 +1,72 @@
+//
+// Created by Norman Wang on 2025/5/19.
+//
+
+#ifndef INPUTEVENTCHANNEL_H
+#define INPUTEVENTCHANNEL_H
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "INPUT_EVENT.h"
+
+
+/**
+ * 眼镜输入事件的分发
+ * 读取线程解码出事件后立即在同一次唤醒中调用所有订阅者,不经过队列也不需要轮询.
+ * 回调在读取线程中执行,必须很快返回;界面代码应把事件转到主线程处理(例如wxApp::CallAfter).
+ * 同时保留最近的一条事件,供只需要查询的调用者使用.
+ */
+class InputEventChannel {
+public:
+    using Listener = std::function<void(const INPUT_EVENT &event)>;
+
+    InputEventChannel() = default;
+
+    InputEventChannel(const InputEventChannel&) = delete;
+    InputEventChannel& operator=(const InputEventChannel&) = delete;
+
+    /**
+     * 订阅
+     * @return - 订阅ID,用于取消订阅
+     */
+    uint64_t subscribe(Listener listener);
+
+    /**
+     * 取消订阅,返回后回调不会再被调用(回调中不能取消订阅)
+     */
+    void unsubscribe(uint64_t id);
+
+    /**
+     * 分发一条事件(由读取线程调用)
+     */
+    void publish(const INPUT_EVENT &event);
+
+    /**
+     * 最近的一条事件
+     * @return - 是否有过事件
+     */
+    bool latest(INPUT_EVENT &out) const;
+
+    uint64_t published() const {
+        return publishedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Subscription {
+        uint64_t id;
+        Listener listener;
+    };
+
+    // 保护订阅者列表和最近的事件,分发期间一直持有(事件很少,不会有竞争)
+    mutable std::mutex mutex;
+    std::vector<Subscription> subscriptions;
+    uint64_t nextId = 1;
+    INPUT_EVENT lastEvent;
+    std::atomic<uint64_t> publishedCount{0};
+};
+
+
+#endif //INPUTEVENTCHANNEL_H
@@ -0,0 +1,131 @@
+//
+// Created by Norman Wang on 2025/5/8.
+//
+
+#include "InterfaceProber.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+#include "DevicesHelper.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Utils.h"
+
+InterfaceProber::InterfaceProber(const std::chrono::milliseconds deadline) : deadline(deadline) {
+}
+
+int InterfaceProber::probe(const std::vector<INTERFACE_INFO> &interfaces) {
+    lastResults.assign(interfaces.size(), PROBE_RESULT{});
+    for (size_t i = 0; i < interfaces.size(); i++) {
+        lastResults[i].interface_number = interfaces[i].interface_number;
+    }
+    if (interfaces.empty()) {
+        return -1;
+    }
+
+    // 探测的共享状态,应答回调在反应器线程中写入
+    struct RaceState {
+        std::mutex mutex;
+        std::condition_variable condition;
+        int winner = -1;
+        size_t finished = 0;
+        std::vector<PROBE_RESULT> results;
+    };
+    const auto state = std::make_shared<RaceState>();
+    state->results = lastResults;
+
+    const uint64_t startNs = Utils::steadyNowNs();
+    // 截止时间从探测开始算起,包括打开接口的时间
+    const auto deadlineAt = std::chrono::steady_clock::now() + deadline;
+
+    // 同时打开所有候选接口,每个接口打开后立即发出探测,不等待其他接口的打开或写入
+    std::vector<std::future<void>> opening;
+    opening.reserve(interfaces.size());
+    for (size_t i = 0; i < interfaces.size(); i++) {
+        const auto interface = const_cast<INTERFACE_INFO *>(&interfaces[i]);
+        opening.push_back(std::async(std::launch::async, [interface, state, i, startNs, timeout = deadline]() {
+            if (!interface->open()) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->results[i].error = "无法打开接口";
+                state->finished++;
+                state->condition.notify_all();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->results[i].opened = true;
+            }
+
+            // 请求的超时同样截止到探测开始后的deadline
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::nanoseconds(Utils::steadyNowNs() - startNs));
+            const auto remaining = std::max(std::chrono::milliseconds(0), timeout - elapsed);
+
+            //收到应答立即记录并唤醒等待;写入在设备的写入线程中进行,这里不会被没有命令端点的接口卡住
+            DevicesHelper::sendRequest(interface, "v", remaining, [state, i, startNs](const COMMAND_RESULT &result) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                PROBE_RESULT &probeResult = state->results[i];
+                probeResult.answered = result.success;
+                probeResult.elapsed_ns = result.success ? result.round_trip_ns : Utils::steadyNowNs() - startNs;
+                probeResult.error = result.error;
+                state->finished++;
+                if (result.success && state->winner < 0) {
+                    state->winner = static_cast<int>(i);
+                }
+                state->condition.notify_all();
+            });
+        }));
+    }
+
+    // 等到第一个应答,或者所有探测都结束,或者到达截止时间
+    int winner;
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->condition.wait_until(lock, deadlineAt, [&]() {
+            return state->winner >= 0 || state->finished >= interfaces.size();
+        });
+        winner = state->winner;
+        if (winner >= 0) {
+            state->results[winner].selected = true;
+        }
+    }
+
+    // 关闭接口之前确认所有打开操作都已返回
+    for (auto &open: opening) {
+        open.get();
+    }
+
+    // 立即关闭落选的接口,它们还在等待的探测会以"接口已关闭"结束
+    for (size_t i = 0; i < interfaces.size(); i++) {
+        if (static_cast<int>(i) != winner && interfaces[i].is_connected) {
+            const_cast<INTERFACE_INFO &>(interfaces[i]).close();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        lastResults = state->results;
+    }
+
+    for (const auto &result: lastResults) {
+        if (result.answered) {
+            Logger::info("接口 %d 应答耗时: %uus%s", result.interface_number, result.elapsed_ns / 1000,
+                         result.selected ? " (选中)" : "");
+        } else {
+            Logger::info("接口 %d 未应答: %s", result.interface_number,
+                         result.error.empty() ? std::string("已取消") : result.error);
+        }
+    }
+    static MetricHistogram &probeTime = Metrics::histogram("xreal_probe_seconds", "探测控制接口的总耗时");
+    static MetricCounter &probeFailures = Metrics::counter("xreal_probe_failures_total", "没有任何接口应答的探测");
+    const uint64_t elapsedNs = Utils::steadyNowNs() - startNs;
+    probeTime.record(elapsedNs);
+    if (winner < 0) {
+        probeFailures.add();
+    }
+    Logger::info("接口探测总耗时: %uus", elapsedNs / 1000);
+    return winner;
+}
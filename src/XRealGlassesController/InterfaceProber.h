@@ -0,0 +1,48 @@
+//
+// Created by Norman Wang on 2025/5/8.
+//
+
+#ifndef INTERFACEPROBER_H
+#define INTERFACEPROBER_H
+#include <chrono>
+#include <vector>
+
+#include "INTERFACE_INFO.h"
+#include "PROBE_RESULT.h"
+
+
+/**
+ * 通讯接口探测器
+ * 同时打开眼镜的所有候选接口并发出"v"探测,谁先给出0xFD应答就选谁,
+ * 选中后立即关闭其余接口;到截止时间(从探测开始算起)仍无应答则放弃.
+ * 探测命令由各接口的写入线程发送,一个接口写入缓慢不会推迟其他接口的探测.
+ * 每个接口的应答耗时都会记录下来.
+ */
+class InterfaceProber {
+public:
+    /**
+     * @param deadline - 等待应答的最长时间
+     */
+    explicit InterfaceProber(std::chrono::milliseconds deadline = std::chrono::milliseconds(1000));
+
+    /**
+     * 探测通讯接口
+     * @param interfaces - 候选接口列表(探测过程中会被打开/关闭)
+     * @return - 选中的接口在列表中的下标,-1表示没有接口应答
+     */
+    int probe(const std::vector<INTERFACE_INFO> &interfaces);
+
+    /**
+     * 最近一次探测中每个接口的结果(与候选接口列表一一对应)
+     */
+    const std::vector<PROBE_RESULT> &results() const {
+        return lastResults;
+    }
+
+private:
+    std::chrono::milliseconds deadline;
+    std::vector<PROBE_RESULT> lastResults;
+};
+
+
+#endif //INTERFACEPROBER_H
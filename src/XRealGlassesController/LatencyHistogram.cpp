@@ -0,0 +1,91 @@
+//
+// Created by Norman Wang on 2025/5/18.
+//
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+size_t LatencyHistogram::bucketOf(const uint64_t ns) {
+    // 小于一个子桶组的值每个值一个桶
+    if (ns < SUB_BUCKETS) {
+        return static_cast<size_t>(ns);
+    }
+    const unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+    if (exponent > MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    const unsigned group = exponent - SUB_BUCKET_BITS + 1;
+    const uint64_t sub = (ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(group * SUB_BUCKETS + sub);
+}
+
+uint64_t LatencyHistogram::lowerBound(const size_t bucket) {
+    const uint64_t group = bucket / SUB_BUCKETS;
+    const uint64_t sub = bucket % SUB_BUCKETS;
+    if (group == 0) {
+        return sub;
+    }
+    return (SUB_BUCKETS + sub) << (group - 1);
+}
+
+uint64_t LatencyHistogram::upperBound(const size_t bucket) {
+    const uint64_t group = bucket / SUB_BUCKETS;
+    const uint64_t sub = bucket % SUB_BUCKETS;
+    if (group == 0) {
+        return sub + 1;
+    }
+    return (SUB_BUCKETS + sub + 1) << (group - 1);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot result;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        result.counts[i] = counts[i].load(std::memory_order_relaxed);
+    }
+    // 总数取各桶之和,与分位数的计算一致
+    result.count = 0;
+    for (const uint64_t bucketCount: result.counts) {
+        result.count += bucketCount;
+    }
+    result.sum_ns = sumNs.load(std::memory_order_relaxed);
+    result.max_ns = maxNs.load(std::memory_order_relaxed);
+    return result;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(const double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            // 最大值所在的桶用实际的最大值,不用桶的上界
+            return std::min(upperBound(i), max_ns > 0 ? max_ns : upperBound(i));
+        }
+    }
+    return max_ns;
+}
+
+uint64_t LatencyHistogram::Snapshot::countAbove(const uint64_t thresholdNs) const {
+    uint64_t result = 0;
+    for (size_t i = bucketOf(thresholdNs); i < BUCKETS; i++) {
+        result += counts[i];
+    }
+    return result;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::since(const Snapshot &earlier) const {
+    Snapshot result;
+    result.count = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        result.counts[i] = counts[i] >= earlier.counts[i] ? counts[i] - earlier.counts[i] : 0;
+        result.count += result.counts[i];
+    }
+    result.sum_ns = sum_ns >= earlier.sum_ns ? sum_ns - earlier.sum_ns : 0;
+    result.max_ns = max_ns;
+    return result;
+}
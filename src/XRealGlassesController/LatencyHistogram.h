@@ -0,0 +1,114 @@
+//
+// Created by Norman Wang on 2025/5/18.
+//
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * 时间间隔的直方图(HDR风格的对数-线性分桶,单位纳秒)
+ * 每个2的幂区间再均分为8个子桶,任何值的相对误差不超过12.5%;范围约为0~68秒,更大的值计入最后一个桶.
+ * 桶在构造时一次分配好,记录只是几次原子读写,没有分配也没有锁.
+ *
+ * record只允许一个线程调用(例如某个接口的读取线程);多个线程记录同一个直方图时用recordConcurrent.
+ * 任何线程都可以随时取快照.
+ */
+class LatencyHistogram {
+public:
+    // 每个2的幂区间的子桶数 = 2^SUB_BUCKET_BITS
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BUCKET_BITS;
+    // 能区分的最大值约为2^MAX_EXPONENT纳秒
+    static constexpr unsigned MAX_EXPONENT = 36;
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    /**
+     * 某一时刻的拷贝,可以计算分位数,也可以和更早的快照相减得到一段时间内的分布
+     */
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts{};
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+
+        /**
+         * 分位数(取所在桶的上界)
+         * @param quantile - 0~1,例如0.99
+         * @return - 没有数据时为0
+         */
+        [[nodiscard]] uint64_t percentile(double quantile) const;
+
+        [[nodiscard]] double mean() const {
+            return count > 0 ? static_cast<double>(sum_ns) / static_cast<double>(count) : 0;
+        }
+
+        /**
+         * 超过阈值的记录数(按桶计算,阈值所在的桶整体计入)
+         */
+        [[nodiscard]] uint64_t countAbove(uint64_t thresholdNs) const;
+
+        /**
+         * 减去更早的快照,得到这段时间内的分布(max_ns仍为累计的最大值)
+         */
+        [[nodiscard]] Snapshot since(const Snapshot &earlier) const;
+    };
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /**
+     * 记录一个值(只能由单一线程调用)
+     */
+    void record(const uint64_t ns) {
+        bump(counts[bucketOf(ns)], 1);
+        bump(sumNs, ns);
+        if (ns > maxNs.load(std::memory_order_relaxed)) {
+            maxNs.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 记录一个值(多个线程可以同时调用,比record多几次原子的读-改-写)
+     */
+    void recordConcurrent(const uint64_t ns) {
+        counts[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = maxNs.load(std::memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    [[nodiscard]] Snapshot snapshot() const;
+
+    /**
+     * 值所在的桶
+     */
+    static size_t bucketOf(uint64_t ns);
+
+    /**
+     * 桶的下界(含)和上界(不含)
+     */
+    static uint64_t lowerBound(size_t bucket);
+
+    static uint64_t upperBound(size_t bucket);
+
+private:
+    // 单一写入者: 读出再写回,不需要原子的读-改-写
+    static void bump(std::atomic<uint64_t> &value, const uint64_t amount) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+    std::atomic<uint64_t> sumNs{0};
+    std::atomic<uint64_t> maxNs{0};
+};
+
+
+#endif //LATENCYHISTOGRAM_H
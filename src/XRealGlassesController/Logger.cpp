@@ -0,0 +1,625 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#include "Logger.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "RotatingLogFile.h"
+#include "Utils.h"
+
+/**
+ * 一个线程的环形缓冲区(单生产者单消费者)
+ * head只由写日志的线程推进,tail只由输出日志的一方推进.
+ */
+struct LogRing {
+    alignas(64) std::atomic<uint64_t> head{0};
+    //写日志的线程缓存的tail,只有空间不够时才重新读取
+    uint64_t cachedTail = 0;
+    std::atomic<uint64_t> dropped{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    //已经报告过的丢弃条数(只由输出日志的一方访问)
+    uint64_t reportedDropped = 0;
+    //线程已退出,读空后可以释放
+    std::atomic<bool> retired{false};
+    uint8_t data[Logger::RING_BYTES];
+};
+
+/**
+ * 输出日志的一方读取一条记录
+ */
+struct LogReader {
+    const uint8_t *ring;
+    uint64_t position;
+
+    void get(void *target, const size_t length) {
+        const size_t offset = position & (Logger::RING_BYTES - 1);
+        const size_t first = std::min(length, Logger::RING_BYTES - offset);
+        std::memcpy(target, ring + offset, first);
+        std::memcpy(static_cast<uint8_t *>(target) + first, ring, length - first);
+        position += length;
+    }
+
+    template<typename T>
+    T value() {
+        T result;
+        get(&result, sizeof(result));
+        return result;
+    }
+};
+
+/**
+ * 解码后的一个参数
+ */
+struct LogArg {
+    Logger::ArgType type = Logger::ArgType::INT;
+    uint64_t bits = 0;
+    std::string bytes;
+};
+
+struct LogLine {
+    uint64_t timeNs;
+    LogLevel level;
+    std::string message;
+};
+
+static int severityFromName(const char *name) {
+    const std::string value(name);
+    if (value == "error") {
+        return Logger::severity(LogLevel::ERROR);
+    }
+    if (value == "warning") {
+        return Logger::severity(LogLevel::WARNING);
+    }
+    if (value == "success") {
+        return Logger::severity(LogLevel::SUCCESS);
+    }
+    return Logger::severity(LogLevel::INFO);
+}
+
+static int initialSeverity() {
+    const char *level = std::getenv("XREAL_LOG_LEVEL");
+    return level ? severityFromName(level) : Logger::severity(LogLevel::INFO);
+}
+
+std::atomic<int> Logger::minSeverity{initialSeverity()};
+
+/**
+ * 按一个printf转换说明格式化一个参数
+ * 调用时的类型已经记录在参数中,说明符的长度修饰被忽略,按记录的类型重新补上,
+ * 因此%d传入uint64_t或%u传入int都能得到正确的结果.
+ */
+static void formatArg(std::string &out, std::string spec, const char conversion, const LogArg &arg) {
+    using ArgType = Logger::ArgType;
+    char text[128];
+    const ArgType type = arg.type;
+    const bool isString = type == ArgType::STRING || type == ArgType::HEX;
+    int64_t asInt = 0;
+    uint64_t asUint = 0;
+    double asDouble = 0;
+    std::memcpy(&asInt, &arg.bits, sizeof(asInt));
+    std::memcpy(&asDouble, &arg.bits, sizeof(asDouble));
+    asUint = arg.bits;
+    if (type == ArgType::DOUBLE) {
+        asInt = static_cast<int64_t>(asDouble);
+        asUint = static_cast<uint64_t>(asDouble);
+    } else {
+        asDouble = type == ArgType::INT ? static_cast<double>(asInt) : static_cast<double>(asUint);
+    }
+
+    switch (conversion) {
+        case 'd':
+        case 'i':
+            if (isString) {
+                break;
+            }
+            snprintf(text, sizeof(text), (spec + "lld").c_str(), static_cast<long long>(asInt));
+            out += text;
+            return;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            if (isString) {
+                break;
+            }
+            snprintf(text, sizeof(text), (spec + "ll" + conversion).c_str(), static_cast<unsigned long long>(asUint));
+            out += text;
+            return;
+        case 'c':
+            if (isString) {
+                break;
+            }
+            snprintf(text, sizeof(text), (spec + "c").c_str(), static_cast<int>(asInt));
+            out += text;
+            return;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (isString) {
+                break;
+            }
+            snprintf(text, sizeof(text), (spec + conversion).c_str(), asDouble);
+            out += text;
+            return;
+        case 'p':
+            snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(asUint));
+            out += text;
+            return;
+        default:
+            break;
+    }
+
+    // %s或者类型对不上: 字符串原样输出,字节按十六进制输出,数值按默认格式输出
+    if (type == ArgType::HEX) {
+        static const char *digits = "0123456789ABCDEF";
+        for (size_t i = 0; i < arg.bytes.size(); i++) {
+            const auto byte = static_cast<uint8_t>(arg.bytes[i]);
+            if (i > 0) {
+                out += ' ';
+            }
+            out += digits[byte >> 4];
+            out += digits[byte & 0xF];
+        }
+    } else if (type == ArgType::STRING) {
+        out += arg.bytes;
+    } else if (type == ArgType::DOUBLE) {
+        snprintf(text, sizeof(text), "%g", asDouble);
+        out += text;
+    } else if (type == ArgType::INT) {
+        out += std::to_string(asInt);
+    } else {
+        out += std::to_string(asUint);
+    }
+}
+
+/**
+ * 按格式字符串和解码后的参数生成消息
+ */
+static std::string formatMessage(const char *format, const std::vector<LogArg> &args) {
+    std::string out;
+    size_t next = 0;
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') {
+            out += *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p++;
+            continue;
+        }
+        // 标志/宽度/精度原样保留,长度修饰去掉
+        std::string spec = "%";
+        const char *q = p + 1;
+        while (*q && std::strchr("-+ #0123456789.", *q)) {
+            spec += *q++;
+        }
+        while (*q && std::strchr("hljztL", *q)) {
+            q++;
+        }
+        if (!*q) {
+            out.append(p);
+            break;
+        }
+        if (next < args.size()) {
+            formatArg(out, spec, *q, args[next++]);
+        } else {
+            out += "<?>";
+        }
+        p = q;
+    }
+    return out;
+}
+
+/**
+ * 日志的全局状态和后台线程
+ * 有意不析构(进程退出时其他静态对象的析构函数里仍可能写日志),退出时由LogShutdown输出剩余的日志.
+ */
+class LogState {
+public:
+    LogState() {
+        if (const char *path = std::getenv("XREAL_LOG_FILE")) {
+            const char *megabytes = std::getenv("XREAL_LOG_FILE_MB");
+            const char *files = std::getenv("XREAL_LOG_FILES");
+            openFile(path, static_cast<size_t>((megabytes ? std::atof(megabytes) : 8.0) * 1024 * 1024),
+                     files ? std::atoi(files) : 3);
+        }
+        worker = std::thread([this]() {
+            run();
+        });
+    }
+
+    std::shared_ptr<LogRing> createRing() {
+        auto ring = std::make_shared<LogRing>();
+        std::lock_guard<std::mutex> lock(drainMutex);
+        rings.push_back(ring);
+        threadCount++;
+        return ring;
+    }
+
+    /**
+     * 线程退出后仍在写日志时(例如thread_local的析构函数)使用的共享缓冲区
+     */
+    LogRing &lockOrphanRing() {
+        orphanMutex.lock();
+        if (!orphan) {
+            orphan = createRing();
+        }
+        return *orphan;
+    }
+
+    void unlockOrphanRing() {
+        orphanMutex.unlock();
+    }
+
+    void wake() {
+        wakeRequested.store(true, std::memory_order_relaxed);
+        wakeCondition.notify_one();
+    }
+
+    bool isStopped() const {
+        return stopped.load(std::memory_order_acquire);
+    }
+
+    /**
+     * 把所有缓冲区中的日志输出(后台线程或flush调用)
+     */
+    void drain() {
+        if (inDrain) {
+            // 输出回调中又写了日志,留到下一次
+            return;
+        }
+        std::lock_guard<std::mutex> lock(drainMutex);
+        inDrain = true;
+        drainLocked();
+        inDrain = false;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            if (stopped.load()) {
+                return;
+            }
+            stopped.store(true, std::memory_order_release);
+        }
+        wakeCondition.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+        drain();
+    }
+
+    uint64_t addSink(const LogLevel minLevel, Logger::Sink sink) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        const uint64_t id = nextSinkId++;
+        sinks.push_back({id, Logger::severity(minLevel), std::move(sink)});
+        return id;
+    }
+
+    void removeSink(const uint64_t id) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        sinks.erase(std::remove_if(sinks.begin(), sinks.end(), [id](const SinkEntry &entry) {
+            return entry.id == id;
+        }), sinks.end());
+    }
+
+    bool openFile(const std::string &path, const size_t maxBytes, const int keepFiles) {
+        auto opened = std::make_unique<RotatingLogFile>(path, maxBytes, keepFiles);
+        if (!opened->isOpen()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(drainMutex);
+        file = std::move(opened);
+        return true;
+    }
+
+    void setConsole(const bool enabled) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        console = enabled;
+    }
+
+    Logger::Stats stats() {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        Logger::Stats result;
+        result.written = written;
+        result.dropped = droppedRetired;
+        for (const auto &ring: rings) {
+            result.dropped += ring->dropped.load(std::memory_order_relaxed);
+        }
+        result.threads = threadCount;
+        return result;
+    }
+
+private:
+    struct SinkEntry {
+        uint64_t id;
+        int minSeverity;
+        Logger::Sink sink;
+    };
+
+    //保护缓冲区列表/输出/统计;格式化和输出都在持有它时进行
+    std::mutex drainMutex;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    std::vector<SinkEntry> sinks;
+    uint64_t nextSinkId = 1;
+    std::unique_ptr<RotatingLogFile> file;
+    bool console = true;
+    uint64_t written = 0;
+    uint64_t droppedRetired = 0;
+    size_t threadCount = 0;
+    std::vector<LogLine> batch;
+
+    std::mutex orphanMutex;
+    std::shared_ptr<LogRing> orphan;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> wakeRequested{false};
+    std::atomic<bool> stopped{false};
+    std::thread worker;
+
+    static thread_local bool inDrain;
+
+    void run() {
+        while (!stopped.load(std::memory_order_acquire)) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                // 平时每20ms输出一批;警告和错误会立即唤醒
+                wakeCondition.wait_for(lock, std::chrono::milliseconds(20), [this]() {
+                    return wakeRequested.load(std::memory_order_relaxed) || stopped.load();
+                });
+                wakeRequested.store(false, std::memory_order_relaxed);
+            }
+            drain();
+        }
+    }
+
+    void readRing(LogRing &ring) {
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        std::vector<LogArg> args;
+        while (tail < head) {
+            LogReader reader{ring.data, tail};
+            const auto size = reader.value<uint32_t>();
+            const auto level = static_cast<LogLevel>(reader.value<uint8_t>());
+            const auto argCount = reader.value<uint8_t>();
+            const auto format = reinterpret_cast<const char *>(reader.value<uint64_t>());
+            const auto timeNs = reader.value<uint64_t>();
+            args.resize(argCount);
+            for (auto &arg: args) {
+                arg.type = reader.value<Logger::ArgType>();
+                if (arg.type == Logger::ArgType::STRING || arg.type == Logger::ArgType::HEX) {
+                    const auto length = reader.value<uint32_t>();
+                    arg.bytes.resize(length);
+                    reader.get(&arg.bytes[0], length);
+                } else {
+                    arg.bits = reader.value<uint64_t>();
+                }
+            }
+            batch.push_back({timeNs, level, formatMessage(format, args)});
+            tail += size;
+        }
+        ring.tail.store(tail, std::memory_order_release);
+
+        const uint64_t dropped = ring.dropped.load(std::memory_order_relaxed);
+        if (dropped != ring.reportedDropped) {
+            batch.push_back({Utils::steadyNowNs(), LogLevel::WARNING,
+                             "日志缓冲区已满,丢弃了" + std::to_string(dropped - ring.reportedDropped) + "条日志"});
+            ring.reportedDropped = dropped;
+        }
+    }
+
+    void drainLocked() {
+        for (auto &ring: rings) {
+            readRing(*ring);
+        }
+        // 已退出线程的缓冲区读空后释放
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [this](const std::shared_ptr<LogRing> &ring) {
+            if (!ring->retired.load(std::memory_order_acquire) ||
+                ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            droppedRetired += ring->dropped.load(std::memory_order_relaxed);
+            return true;
+        }), rings.end());
+        if (batch.empty()) {
+            return;
+        }
+
+        // 各线程的日志按写入时间合并
+        std::stable_sort(batch.begin(), batch.end(), [](const LogLine &a, const LogLine &b) {
+            return a.timeNs < b.timeNs;
+        });
+        bool wroteOut = false;
+        bool wroteErr = false;
+        for (const auto &line: batch) {
+            if (console) {
+                writeConsole(line);
+                wroteOut |= line.level != LogLevel::ERROR;
+                wroteErr |= line.level == LogLevel::ERROR;
+            }
+            if (file) {
+                file->write(line.level, line.timeNs, line.message);
+            }
+            for (const auto &entry: sinks) {
+                if (Logger::severity(line.level) >= entry.minSeverity) {
+                    entry.sink(line.level, line.timeNs, line.message);
+                }
+            }
+        }
+        if (wroteOut) {
+            std::cout.flush();
+        }
+        if (wroteErr) {
+            std::cerr.flush();
+        }
+        if (file) {
+            file->flush();
+        }
+        written += batch.size();
+        batch.clear();
+    }
+
+    static void writeConsole(const LogLine &line) {
+        // 根据日志级别选择输出流和前缀
+        std::ostream &out = line.level == LogLevel::ERROR ? std::cerr : std::cout;
+        switch (line.level) {
+            case LogLevel::INFO:
+                out << "[INFO] ";
+                break;
+            case LogLevel::SUCCESS:
+                out << "[SUCCESS] ";
+                break;
+            case LogLevel::WARNING:
+                out << "[WARNING] ";
+                break;
+            case LogLevel::ERROR:
+                out << "[ERROR] ";
+                break;
+        }
+        out << line.message << '\n';
+    }
+};
+
+thread_local bool LogState::inDrain = false;
+
+static LogState &logState() {
+    static LogState *state = new LogState();
+    return *state;
+}
+
+/**
+ * 进程退出时停止后台线程并输出剩余的日志,之后写的日志在调用线程中直接输出
+ */
+static struct LogShutdown {
+    ~LogShutdown() {
+        logState().stop();
+    }
+} logShutdown;
+
+/**
+ * 本线程的缓冲区
+ * 指针是trivial的thread_local,访问时没有初始化检查;LogRingOwner只在创建缓冲区时构造一次,
+ * 它在线程退出时析构,把缓冲区标记为可释放.
+ */
+static thread_local LogRing *localRing = nullptr;
+static thread_local bool threadExiting = false;
+
+static struct LogRingOwner {
+    std::shared_ptr<LogRing> ring;
+
+    ~LogRingOwner() {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+        localRing = nullptr;
+        threadExiting = true;
+    }
+} thread_local localRingOwner;
+
+//线程退出后写日志时从reserve到commit一直持有共享缓冲区的锁
+static thread_local bool holdingOrphan = false;
+
+void Logger::setLevel(const LogLevel level) {
+    minSeverity.store(severity(level), std::memory_order_relaxed);
+}
+
+bool Logger::reserve(const size_t size, Cursor &cursor) {
+    LogRing *ring = localRing;
+    if (!ring) {
+        if (threadExiting) {
+            ring = &logState().lockOrphanRing();
+            holdingOrphan = true;
+        } else {
+            localRingOwner.ring = logState().createRing();
+            ring = localRing = localRingOwner.ring.get();
+        }
+    }
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (size > RING_BYTES - (head - ring->cachedTail)) {
+        ring->cachedTail = ring->tail.load(std::memory_order_acquire);
+        if (size > RING_BYTES - (head - ring->cachedTail)) {
+            ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (holdingOrphan) {
+                holdingOrphan = false;
+                logState().unlockOrphanRing();
+            }
+            return false;
+        }
+    }
+    cursor.owner = ring;
+    cursor.ring = ring->data;
+    cursor.start = head;
+    cursor.position = head;
+    return true;
+}
+
+void Logger::putHeader(Cursor &cursor, const size_t size, const LogLevel level, const char *format,
+                       const uint8_t argCount) {
+    const auto recordSize = static_cast<uint32_t>(size);
+    const auto levelByte = static_cast<uint8_t>(level);
+    const auto formatId = reinterpret_cast<uint64_t>(format);
+    const uint64_t timeNs = Utils::steadyNowNs();
+    cursor.put(&recordSize, sizeof(recordSize));
+    cursor.put(&levelByte, sizeof(levelByte));
+    cursor.put(&argCount, sizeof(argCount));
+    cursor.put(&formatId, sizeof(formatId));
+    cursor.put(&timeNs, sizeof(timeNs));
+}
+
+void Logger::commit(const Cursor &cursor, const LogLevel level) {
+    LogRing *ring = static_cast<LogRing *>(cursor.owner);
+    ring->head.store(cursor.position, std::memory_order_release);
+    LogState &state = logState();
+    if (holdingOrphan) {
+        holdingOrphan = false;
+        state.unlockOrphanRing();
+    }
+    if (state.isStopped()) {
+        state.drain();
+    } else if (severity(level) >= severity(LogLevel::WARNING) ||
+               cursor.start / (RING_BYTES / 4) != cursor.position / (RING_BYTES / 4)) {
+        // 警告/错误立即输出;每写满四分之一个缓冲区也唤醒一次,突发的大量日志不必等到下一批
+        state.wake();
+    }
+}
+
+uint64_t Logger::addSink(const LogLevel minLevel, Sink sink) {
+    return logState().addSink(minLevel, std::move(sink));
+}
+
+void Logger::removeSink(const uint64_t id) {
+    logState().removeSink(id);
+}
+
+bool Logger::openFile(const std::string &path, const size_t maxBytes, const int keepFiles) {
+    return logState().openFile(path, maxBytes, keepFiles);
+}
+
+void Logger::setConsole(const bool enabled) {
+    logState().setConsole(enabled);
+}
+
+void Logger::flush() {
+    logState().drain();
+}
+
+Logger::Stats Logger::stats() {
+    return logState().stats();
+}
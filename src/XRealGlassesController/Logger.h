@@ -0,0 +1,307 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#ifndef LOGGER_H
+#define LOGGER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+#include "LOG_LEVEL.h"
+
+// 编译期的最低日志级别(按Logger::severity: 0信息 1成功 2警告 3错误),低于它的日志语句整个不生成代码
+#ifndef XREAL_LOG_MIN_SEVERITY
+#define XREAL_LOG_MIN_SEVERITY 0
+#endif
+
+
+/**
+ * 异步日志
+ * 调用线程只把格式字符串的地址(格式ID)和原始参数复制进本线程的无锁环形缓冲区,
+ * 由后台线程统一格式化并写到各个输出(控制台/滚动日志文件/注册的回调,例如WebView).
+ *
+ * 用法与printf一致,格式必须是字符串字面量(后台线程格式化时才读取它):
+ *   Logger::info("命令应答 msgId=%u 往返耗时: %lluus", msgId, roundTripUs);
+ *   Logger::info("发送数据: %s", Logger::Hex{data, length});
+ * 参数支持整数/枚举/浮点数/指针/C字符串/std::string/Hex,字符串和字节在调用时复制.
+ *
+ * 关闭的级别只有一次比较;环形缓冲区满时丢弃日志而不阻塞,丢弃的条数由后台线程报告.
+ * 环境变量: XREAL_LOG_LEVEL(info/success/warning/error), XREAL_LOG_FILE(日志文件路径),
+ * XREAL_LOG_FILE_MB(单个文件的大小上限), XREAL_LOG_FILES(保留的文件个数).
+ */
+class Logger {
+public:
+    /**
+     * 以十六进制输出的字节,用%s格式化为"FD 12 ..."
+     */
+    struct Hex {
+        const uint8_t *data;
+        size_t length;
+    };
+
+    /**
+     * 输出回调,在后台线程中调用
+     * @param level - 日志级别
+     * @param timeNs - 写日志时的时间(steady_clock, 纳秒)
+     * @param message - 格式化后的消息(不含级别前缀)
+     */
+    using Sink = std::function<void(LogLevel level, uint64_t timeNs, const std::string &message)>;
+
+    /**
+     * 记录中参数的类型标记
+     */
+    enum class ArgType : uint8_t {
+        INT,
+        UINT,
+        DOUBLE,
+        POINTER,
+        STRING,
+        HEX
+    };
+
+    struct Stats {
+        //已写出的日志条数
+        uint64_t written = 0;
+        //缓冲区满时丢弃的条数
+        uint64_t dropped = 0;
+        //写过日志的线程数
+        size_t threads = 0;
+    };
+
+    //每个线程的环形缓冲区大小
+    static constexpr size_t RING_BYTES = 64 * 1024;
+    //单个字符串参数最多复制的字节数(在UTF-8字符的边界截断)
+    static constexpr size_t MAX_STRING_BYTES = 4096;
+
+    /**
+     * 级别的严重程度,用于过滤(LogLevel的枚举顺序不是严重程度的顺序)
+     */
+    static constexpr int severity(const LogLevel level) {
+        return level == LogLevel::ERROR ? 3 : level == LogLevel::WARNING ? 2 : level == LogLevel::SUCCESS ? 1 : 0;
+    }
+
+    /**
+     * 这个级别当前是否会输出
+     */
+    static bool enabled(const LogLevel level) {
+        return severity(level) >= minSeverity.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 设置运行时的最低级别
+     */
+    static void setLevel(LogLevel level);
+
+    template<size_t N, typename... Args>
+    static void info(const char (&format)[N], const Args &... args) {
+        write<LogLevel::INFO>(format, args...);
+    }
+
+    template<size_t N, typename... Args>
+    static void success(const char (&format)[N], const Args &... args) {
+        write<LogLevel::SUCCESS>(format, args...);
+    }
+
+    template<size_t N, typename... Args>
+    static void warning(const char (&format)[N], const Args &... args) {
+        write<LogLevel::WARNING>(format, args...);
+    }
+
+    template<size_t N, typename... Args>
+    static void error(const char (&format)[N], const Args &... args) {
+        write<LogLevel::ERROR>(format, args...);
+    }
+
+    /**
+     * 级别在编译期确定的日志
+     */
+    template<LogLevel Level, size_t N, typename... Args>
+    static void write(const char (&format)[N], const Args &... args) {
+        if constexpr (severity(Level) >= XREAL_LOG_MIN_SEVERITY) {
+            if (enabled(Level)) {
+                enqueue(Level, format, args...);
+            }
+        }
+    }
+
+    /**
+     * 级别在运行时确定的日志
+     */
+    template<size_t N, typename... Args>
+    static void log(const LogLevel level, const char (&format)[N], const Args &... args) {
+        if (severity(level) >= XREAL_LOG_MIN_SEVERITY && enabled(level)) {
+            enqueue(level, format, args...);
+        }
+    }
+
+    /**
+     * 注册一个输出
+     * @param minLevel - 只输出不低于这个级别的日志
+     * @param sink - 输出回调,在后台线程中调用,应尽快返回
+     * @return - 输出ID,用于取消注册
+     */
+    static uint64_t addSink(LogLevel minLevel, Sink sink);
+
+    /**
+     * 取消注册,返回后回调不会再被调用
+     */
+    static void removeSink(uint64_t id);
+
+    /**
+     * 开始写滚动日志文件(XREAL_LOG_FILE设置时启动后自动打开)
+     * @param path - 文件路径,滚动后的旧文件为path.1, path.2 ...
+     * @param maxBytes - 单个文件的大小上限
+     * @param keepFiles - 保留的旧文件个数
+     * @return - 是否打开成功
+     */
+    static bool openFile(const std::string &path, size_t maxBytes, int keepFiles);
+
+    /**
+     * 是否输出到控制台(默认输出)
+     */
+    static void setConsole(bool enabled);
+
+    /**
+     * 等待调用前写入的所有日志都已输出
+     */
+    static void flush();
+
+    static Stats stats();
+
+private:
+    /**
+     * 环形缓冲区中的写入位置,先计算总长度再依次写入
+     */
+    struct Cursor {
+        //所在的缓冲区(LogRing)
+        void *owner;
+        uint8_t *ring;
+        //记录的起始位置和当前写入位置
+        size_t start;
+        size_t position;
+
+        void put(const void *source, const size_t length) {
+            const size_t offset = position & (RING_BYTES - 1);
+            const size_t first = length < RING_BYTES - offset ? length : RING_BYTES - offset;
+            std::memcpy(ring + offset, source, first);
+            std::memcpy(ring, static_cast<const uint8_t *>(source) + first, length - first);
+            position += length;
+        }
+
+        template<typename T>
+        void putValue(const ArgType type, const T value) {
+            put(&type, 1);
+            put(&value, sizeof(value));
+        }
+
+        void putBytes(const ArgType type, const void *data, const size_t length) {
+            const uint32_t size = static_cast<uint32_t>(length);
+            put(&type, 1);
+            put(&size, sizeof(size));
+            put(data, length);
+        }
+    };
+
+    static std::atomic<int> minSeverity;
+
+    /**
+     * 字符串参数复制的字节数: 超过MAX_STRING_BYTES时在UTF-8字符的边界截断,不留下半个字符
+     * (格式化后的消息会再编码成JSON发给页面,半个字符会让整批消息无法解码)
+     */
+    static size_t clampedLength(const char *text, const size_t length) {
+        if (length <= MAX_STRING_BYTES) {
+            return length;
+        }
+        // 从上限处往前找字符的首字节(不是10xxxxxx的字节);一个字符最多4字节,再往前还找不到说明不是UTF-8
+        for (size_t back = 0; back < 4; back++) {
+            if ((static_cast<unsigned char>(text[MAX_STRING_BYTES - back]) & 0xC0) != 0x80) {
+                return MAX_STRING_BYTES - back;
+            }
+        }
+        return MAX_STRING_BYTES;
+    }
+
+    static size_t stringLength(const char *text) {
+        // 不用strnlen: 参数是较短的字面量时GCC会误报上限超出了字面量的长度;多数一个字节用来判断是否超出
+        size_t length = 0;
+        while (text && length <= MAX_STRING_BYTES && text[length] != '\0') {
+            length++;
+        }
+        return clampedLength(text, length);
+    }
+
+    template<typename T>
+    static size_t encodedSize(const T &value) {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, std::string>) {
+            return 1 + sizeof(uint32_t) + clampedLength(value.data(), value.size());
+        } else if constexpr (std::is_same_v<Type, Hex>) {
+            return 1 + sizeof(uint32_t) + (value.length < MAX_STRING_BYTES ? value.length : MAX_STRING_BYTES);
+        } else if constexpr (std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>) {
+            return 1 + sizeof(uint32_t) + stringLength(value);
+        } else {
+            return 1 + sizeof(uint64_t);
+        }
+    }
+
+    template<typename T>
+    static void encode(Cursor &cursor, const T &value) {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, std::string>) {
+            cursor.putBytes(ArgType::STRING, value.data(), clampedLength(value.data(), value.size()));
+        } else if constexpr (std::is_same_v<Type, Hex>) {
+            cursor.putBytes(ArgType::HEX, value.data,
+                            value.length < MAX_STRING_BYTES ? value.length : MAX_STRING_BYTES);
+        } else if constexpr (std::is_same_v<Type, const char *> || std::is_same_v<Type, char *>) {
+            cursor.putBytes(ArgType::STRING, value, stringLength(value));
+        } else if constexpr (std::is_enum_v<Type>) {
+            encode(cursor, static_cast<std::underlying_type_t<Type>>(value));
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            cursor.putValue(ArgType::DOUBLE, static_cast<double>(value));
+        } else if constexpr (std::is_pointer_v<Type>) {
+            cursor.putValue(ArgType::POINTER, reinterpret_cast<uint64_t>(value));
+        } else if constexpr (std::is_signed_v<Type>) {
+            static_assert(std::is_integral_v<Type>, "不支持的日志参数类型");
+            cursor.putValue(ArgType::INT, static_cast<int64_t>(value));
+        } else {
+            static_assert(std::is_integral_v<Type>, "不支持的日志参数类型");
+            cursor.putValue(ArgType::UINT, static_cast<uint64_t>(value));
+        }
+    }
+
+    template<typename... Args>
+    static void enqueue(const LogLevel level, const char *format, const Args &... args) {
+        const size_t size = HEADER_BYTES + (size_t{0} + ... + encodedSize(args));
+        Cursor cursor{};
+        if (!reserve(size, cursor)) {
+            return;
+        }
+        putHeader(cursor, size, level, format, static_cast<uint8_t>(sizeof...(args)));
+        (encode(cursor, args), ...);
+        commit(cursor, level);
+    }
+
+    //记录头: 长度(4) + 级别(1) + 参数个数(1) + 格式字符串地址(8) + 时间(8)
+    static constexpr size_t HEADER_BYTES = 4 + 1 + 1 + 8 + 8;
+
+    /**
+     * 在本线程的缓冲区中预留一条记录的空间
+     * @return - 是否有空间(没有时计入丢弃)
+     */
+    static bool reserve(size_t size, Cursor &cursor);
+
+    static void putHeader(Cursor &cursor, size_t size, LogLevel level, const char *format, uint8_t argCount);
+
+    /**
+     * 发布已写完的记录
+     */
+    static void commit(const Cursor &cursor, LogLevel level);
+};
+
+
+#endif //LOGGER_H
@@ -0,0 +1,132 @@
+//
+// Created by Norman Wang on 2025/5/10.
+//
+
+#ifndef MCU_MESSAGE_H
+#define MCU_MESSAGE_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * MCU消息ID(0xFD报文的字节15~16)
+ */
+enum class McuMsgId : uint16_t {
+    // 主机发出的命令
+    GET_BRIGHTNESS = 0x0003,
+    SET_BRIGHTNESS = 0x0004,
+    GET_DISPLAY_MODE = 0x0007,
+    SET_DISPLAY_MODE = 0x0008,
+    GET_GLASS_ID = 0x0015,
+    GET_FIRMWARE_VERSION = 0x0026,
+
+    // 眼镜主动上报的事件
+    HEARTBEAT = 0x6C02,
+    DISPLAY_TOGGLED = 0x6C04,
+    BUTTON_PRESSED = 0x6C05,
+    ASYNC_TEXT_LOG = 0x6C09,
+    HEARTBEAT_REPLY = 0x6C12
+};
+
+/**
+ * 报文中的一个字段(多字节字段均为小端)
+ */
+struct REPORT_FIELD {
+    //起始位置
+    size_t offset;
+    //字节数
+    size_t size;
+
+    [[nodiscard]] constexpr size_t end() const {
+        return offset + size;
+    }
+};
+
+/**
+ * 一种命令的描述
+ */
+struct MCU_COMMAND_SPEC {
+    McuMsgId msg_id;
+    //负载字节数,长度字段 = 17 + 负载字节数
+    uint8_t payload_length;
+    const char *name;
+};
+
+/**
+ * 64字节0xFD报文的布局,编码和解码都以这里为准
+ * [0] 0xFD | [1..4] CRC32 | [5..6] 长度 | [7..10] 序号 | [11..14] 设备时间 | [15..16] msgId | [22..] 负载
+ * CRC32从长度字段开始,覆盖"长度"个字节
+ */
+struct MCU_REPORT_LAYOUT {
+    static constexpr size_t REPORT_SIZE = 64;
+    static constexpr uint8_t HEAD_BYTE = 0xFD;
+
+    static constexpr REPORT_FIELD HEAD{0, 1};
+    static constexpr REPORT_FIELD CRC{1, 4};
+    static constexpr REPORT_FIELD LENGTH{5, 2};
+    static constexpr REPORT_FIELD SEQUENCE{7, 4};
+    // 眼镜主动上报时填写的设备时钟(单位由固件决定,只用于同一接口上报之间的先后和间隔),命令中为0
+    static constexpr REPORT_FIELD DEVICE_TIME{11, 4};
+    static constexpr REPORT_FIELD MSG_ID{15, 2};
+    static constexpr REPORT_FIELD PAYLOAD{22, REPORT_SIZE - 22};
+
+    // 没有负载时长度字段的值(从长度字段到负载起始的字节数)
+    static constexpr uint16_t HEADER_LENGTH = PAYLOAD.offset - LENGTH.offset;
+    static constexpr size_t MAX_PAYLOAD = PAYLOAD.size;
+
+    // 已知的全部命令
+    static constexpr std::array<MCU_COMMAND_SPEC, 6> COMMANDS = {{
+        {McuMsgId::GET_BRIGHTNESS, 0, "读取亮度"},
+        {McuMsgId::SET_BRIGHTNESS, 1, "设置亮度"},
+        {McuMsgId::GET_DISPLAY_MODE, 0, "读取显示模式"},
+        // 模式, 子模式, 分辨率参数1, 分辨率参数2, 刷新率, 保留2字节(长度0x18)
+        {McuMsgId::SET_DISPLAY_MODE, 7, "设置显示模式"},
+        {McuMsgId::GET_GLASS_ID, 0, "读取眼镜ID"},
+        {McuMsgId::GET_FIRMWARE_VERSION, 0, "读取固件版本"},
+    }};
+
+    /**
+     * 查找命令的描述,在编译期使用时未知的命令会导致编译失败
+     */
+    static constexpr MCU_COMMAND_SPEC spec(const McuMsgId msgId) {
+        for (const auto &command: COMMANDS) {
+            if (command.msg_id == msgId) {
+                return command;
+            }
+        }
+        throw "未知的MCU命令";
+    }
+};
+
+/**
+ * 眼镜主动上报的按键/显示切换事件在负载中的布局(偏移相对负载起始)
+ * 按键:     [0] 物理按键 | [4] 按键触发的动作 | [8] 动作之后的值(亮度等级或显示模式)
+ * 显示切换: [0] 切换后的显示状态
+ */
+struct MCU_EVENT_LAYOUT {
+    static constexpr REPORT_FIELD BUTTON{0, 1};
+    static constexpr REPORT_FIELD ACTION{4, 1};
+    static constexpr REPORT_FIELD VALUE{8, 1};
+    static constexpr REPORT_FIELD DISPLAY_STATE{0, 1};
+
+    // 眼镜主动上报的msgId的高字节
+    static constexpr uint16_t UNSOLICITED_MASK = 0xFF00;
+    static constexpr uint16_t UNSOLICITED_PREFIX = 0x6C00;
+
+    // 显示模式的值(与设置显示模式命令的模式参数相同)
+    static constexpr uint8_t DISPLAY_MODE_2D = 1;
+    static constexpr uint8_t DISPLAY_MODE_3D = 3;
+};
+
+static_assert(MCU_EVENT_LAYOUT::VALUE.end() <= MCU_REPORT_LAYOUT::MAX_PAYLOAD, "按键事件超出负载长度");
+static_assert(MCU_REPORT_LAYOUT::HEADER_LENGTH == 17, "长度字段与负载起始位置不一致");
+static_assert(MCU_REPORT_LAYOUT::CRC.end() == MCU_REPORT_LAYOUT::LENGTH.offset, "CRC必须紧挨长度字段");
+static_assert(MCU_REPORT_LAYOUT::SEQUENCE.end() <= MCU_REPORT_LAYOUT::DEVICE_TIME.offset, "序号与设备时间重叠");
+static_assert(MCU_REPORT_LAYOUT::DEVICE_TIME.end() <= MCU_REPORT_LAYOUT::MSG_ID.offset, "设备时间与msgId重叠");
+static_assert(MCU_REPORT_LAYOUT::MSG_ID.end() <= MCU_REPORT_LAYOUT::PAYLOAD.offset, "msgId与负载重叠");
+static_assert(MCU_REPORT_LAYOUT::spec(McuMsgId::SET_DISPLAY_MODE).payload_length +
+              MCU_REPORT_LAYOUT::HEADER_LENGTH == 0x18, "设置显示模式的长度应为0x18");
+
+
+#endif //MCU_MESSAGE_H
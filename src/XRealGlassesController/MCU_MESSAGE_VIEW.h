@@ -0,0 +1,59 @@
+//
+// Created by Norman Wang on 2025/5/10.
+//
+
+#ifndef MCU_MESSAGE_VIEW_H
+#define MCU_MESSAGE_VIEW_H
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * 0xFD报文的类型(按msgId归类)
+ */
+enum class McuMessageKind {
+    UNKNOWN,
+    // 命令应答
+    VERSION_REPLY,
+    DISPLAY_MODE_REPLY,
+    DISPLAY_MODE_ACK,
+    BRIGHTNESS_REPLY,
+    BRIGHTNESS_ACK,
+    GLASS_ID_REPLY,
+    // 眼镜主动上报
+    BUTTON_EVENT,
+    DISPLAY_TOGGLED,
+    HEARTBEAT,
+    TEXT_LOG,
+    // 类型数量,用于按类型计数
+    COUNT
+};
+
+/**
+ * 一条已校验的0xFD报文
+ * 只是原始数据上的视图,不拷贝数据;原始数据失效(例如环形缓冲区槽位被覆盖)后不能再使用
+ */
+struct MCU_MESSAGE_VIEW {
+    //原始报文
+    const uint8_t *report = nullptr;
+    size_t report_length = 0;
+
+    //报文中的CRC32(已校验)
+    uint32_t crc = 0;
+    //长度字段
+    uint16_t length = 0;
+    //序号
+    uint32_t sequence = 0;
+    //设备时间(眼镜主动上报时才有)
+    uint32_t device_time = 0;
+    //消息ID
+    uint16_t msg_id = 0;
+    //负载(指向原始报文内部)
+    const uint8_t *payload = nullptr;
+    size_t payload_length = 0;
+
+    McuMessageKind kind = McuMessageKind::UNKNOWN;
+};
+
+
+#endif //MCU_MESSAGE_VIEW_H
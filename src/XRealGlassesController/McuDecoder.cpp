@@ -0,0 +1,142 @@
+//
+// Created by Norman Wang on 2025/5/10.
+//
+
+#include "McuDecoder.h"
+
+#include "MCU_MESSAGE.h"
+#include "Utils.h"
+
+/**
+ * 按小端读取一个整数字段
+ */
+static uint32_t readLittleEndian(const uint8_t *data, const REPORT_FIELD &field) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < field.size; i++) {
+        value |= static_cast<uint32_t>(data[field.offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+McuDecoder::Status McuDecoder::decode(const uint8_t *data, const size_t length, MCU_MESSAGE_VIEW &out) {
+    if (!data || length == 0 || data[0] != MCU_REPORT_LAYOUT::HEAD_BYTE) {
+        return Status::NOT_MCU;
+    }
+    if (length < MCU_REPORT_LAYOUT::PAYLOAD.offset) {
+        return Status::TRUNCATED;
+    }
+
+    const auto messageLength = static_cast<uint16_t>(readLittleEndian(data, MCU_REPORT_LAYOUT::LENGTH));
+    if (messageLength < MCU_REPORT_LAYOUT::HEADER_LENGTH ||
+        MCU_REPORT_LAYOUT::LENGTH.offset + messageLength > length) {
+        return Status::BAD_LENGTH;
+    }
+
+    const uint32_t crc = readLittleEndian(data, MCU_REPORT_LAYOUT::CRC);
+    if (Utils::calculateCRC32(data + MCU_REPORT_LAYOUT::LENGTH.offset, messageLength) != crc) {
+        return Status::BAD_CRC;
+    }
+
+    out.report = data;
+    out.report_length = length;
+    out.crc = crc;
+    out.length = messageLength;
+    out.sequence = readLittleEndian(data, MCU_REPORT_LAYOUT::SEQUENCE);
+    out.device_time = readLittleEndian(data, MCU_REPORT_LAYOUT::DEVICE_TIME);
+    out.msg_id = static_cast<uint16_t>(readLittleEndian(data, MCU_REPORT_LAYOUT::MSG_ID));
+    out.payload = data + MCU_REPORT_LAYOUT::PAYLOAD.offset;
+    out.payload_length = messageLength - MCU_REPORT_LAYOUT::HEADER_LENGTH;
+    out.kind = classify(out.msg_id);
+    return Status::OK;
+}
+
+McuMessageKind McuDecoder::classify(const uint16_t msgId) {
+    switch (static_cast<McuMsgId>(msgId)) {
+        case McuMsgId::GET_FIRMWARE_VERSION:
+            return McuMessageKind::VERSION_REPLY;
+        case McuMsgId::GET_DISPLAY_MODE:
+            return McuMessageKind::DISPLAY_MODE_REPLY;
+        case McuMsgId::SET_DISPLAY_MODE:
+            return McuMessageKind::DISPLAY_MODE_ACK;
+        case McuMsgId::GET_BRIGHTNESS:
+            return McuMessageKind::BRIGHTNESS_REPLY;
+        case McuMsgId::SET_BRIGHTNESS:
+            return McuMessageKind::BRIGHTNESS_ACK;
+        case McuMsgId::GET_GLASS_ID:
+            return McuMessageKind::GLASS_ID_REPLY;
+        case McuMsgId::BUTTON_PRESSED:
+            return McuMessageKind::BUTTON_EVENT;
+        case McuMsgId::DISPLAY_TOGGLED:
+            return McuMessageKind::DISPLAY_TOGGLED;
+        case McuMsgId::HEARTBEAT:
+        case McuMsgId::HEARTBEAT_REPLY:
+            return McuMessageKind::HEARTBEAT;
+        case McuMsgId::ASYNC_TEXT_LOG:
+            return McuMessageKind::TEXT_LOG;
+        default:
+            return McuMessageKind::UNKNOWN;
+    }
+}
+
+const char *McuDecoder::kindName(const McuMessageKind kind) {
+    switch (kind) {
+        case McuMessageKind::VERSION_REPLY:
+            return "固件版本";
+        case McuMessageKind::DISPLAY_MODE_REPLY:
+            return "显示模式";
+        case McuMessageKind::DISPLAY_MODE_ACK:
+            return "显示模式已设置";
+        case McuMessageKind::BRIGHTNESS_REPLY:
+            return "亮度";
+        case McuMessageKind::BRIGHTNESS_ACK:
+            return "亮度已设置";
+        case McuMessageKind::GLASS_ID_REPLY:
+            return "眼镜ID";
+        case McuMessageKind::BUTTON_EVENT:
+            return "按键";
+        case McuMessageKind::DISPLAY_TOGGLED:
+            return "显示开关";
+        case McuMessageKind::HEARTBEAT:
+            return "心跳";
+        case McuMessageKind::TEXT_LOG:
+            return "设备日志";
+        default:
+            return "未知";
+    }
+}
+
+McuDecoder::Status McuDecoder::decodeAndCount(const uint8_t *data, const size_t length, MCU_MESSAGE_VIEW &out) {
+    const Status status = decode(data, length, out);
+    switch (status) {
+        case Status::OK:
+            decoded.fetch_add(1, std::memory_order_relaxed);
+            byKind[static_cast<size_t>(out.kind)].fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Status::NOT_MCU:
+            notMcu.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Status::TRUNCATED:
+            truncated.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Status::BAD_LENGTH:
+            badLength.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case Status::BAD_CRC:
+            badCrc.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+    return status;
+}
+
+McuDecoder::Stats McuDecoder::stats() const {
+    Stats result;
+    result.decoded = decoded.load(std::memory_order_relaxed);
+    result.not_mcu = notMcu.load(std::memory_order_relaxed);
+    result.truncated = truncated.load(std::memory_order_relaxed);
+    result.bad_length = badLength.load(std::memory_order_relaxed);
+    result.bad_crc = badCrc.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < byKind.size(); i++) {
+        result.by_kind[i] = byKind[i].load(std::memory_order_relaxed);
+    }
+    return result;
+}
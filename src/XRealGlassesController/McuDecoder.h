@@ -0,0 +1,89 @@
+//
+// Created by Norman Wang on 2025/5/10.
+//
+
+#ifndef MCUDECODER_H
+#define MCUDECODER_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "HID_REPORT.h"
+#include "MCU_MESSAGE_VIEW.h"
+
+
+/**
+ * 0xFD报文解码器
+ * 按MCU_REPORT_LAYOUT读出各字段并校验长度和CRC32,返回指向原始数据的视图,不做任何分配.
+ * 每个接口一个实例,统计解码结果;格式错误的报文只计数,不逐条写日志.
+ */
+class McuDecoder {
+public:
+    // 解码结果
+    enum class Status {
+        OK,           // 校验通过
+        NOT_MCU,      // 不是0xFD报文(例如IMU上报),不算错误
+        TRUNCATED,    // 数据不足以容纳报文头
+        BAD_LENGTH,   // 长度字段超出报文
+        BAD_CRC       // CRC32不一致
+    };
+
+    /**
+     * 解码统计
+     */
+    struct Stats {
+        uint64_t decoded = 0;
+        uint64_t not_mcu = 0;
+        uint64_t truncated = 0;
+        uint64_t bad_length = 0;
+        uint64_t bad_crc = 0;
+        //按类型统计的已解码报文数,下标为McuMessageKind
+        std::array<uint64_t, static_cast<size_t>(McuMessageKind::COUNT)> by_kind{};
+
+        [[nodiscard]] uint64_t rejected() const {
+            return truncated + bad_length + bad_crc;
+        }
+    };
+
+    /**
+     * 解码并校验一条报文(无状态,不计数)
+     * @param data - 原始数据
+     * @param length - 数据长度
+     * @param out - 校验通过时输出的视图
+     * @return - 解码结果
+     */
+    static Status decode(const uint8_t *data, size_t length, MCU_MESSAGE_VIEW &out);
+
+    static Status decode(const HID_REPORT &report, MCU_MESSAGE_VIEW &out) {
+        return decode(report.data, report.length, out);
+    }
+
+    /**
+     * 按msgId归类
+     */
+    static McuMessageKind classify(uint16_t msgId);
+
+    /**
+     * 类型名称,用于日志
+     */
+    static const char *kindName(McuMessageKind kind);
+
+    /**
+     * 解码并计数(可在读取线程中以上报频率调用)
+     */
+    Status decodeAndCount(const uint8_t *data, size_t length, MCU_MESSAGE_VIEW &out);
+
+    Stats stats() const;
+
+private:
+    std::atomic<uint64_t> decoded{0};
+    std::atomic<uint64_t> notMcu{0};
+    std::atomic<uint64_t> truncated{0};
+    std::atomic<uint64_t> badLength{0};
+    std::atomic<uint64_t> badCrc{0};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(McuMessageKind::COUNT)> byKind{};
+};
+
+
+#endif //MCUDECODER_H
@@ -0,0 +1,408 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "Logger.h"
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (const Shard &shard: shards) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t MetricCounter::shardIndex() {
+    static std::atomic<size_t> nextThread{0};
+    // trivial的thread_local,访问时没有初始化检查;SHARDS表示还没有分配
+    static thread_local size_t index = SHARDS;
+    if (index == SHARDS) {
+        index = nextThread.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    }
+    return index;
+}
+
+/**
+ * 注册表的状态,与日志一样在进程退出时不销毁(其他静态对象的析构函数中仍可能计数)
+ */
+struct MetricsState {
+    struct Entry {
+        std::string name;
+        std::string help;
+        Metrics::Type type = Metrics::Type::COUNTER;
+        Metrics::Labels labels;
+        MetricCounter counter;
+        MetricGauge gauge;
+        MetricHistogram histogram;
+    };
+
+    std::mutex mutex;
+    //名字+标签 -> 指标
+    std::map<std::string, std::unique_ptr<Entry>> entries;
+    //名字 -> 类型,同名的指标(不同标签)必须是同一种类型
+    std::map<std::string, Metrics::Type> types;
+    //与已注册的指标同名不同类型的实例(编程错误),可以使用但不导出
+    std::vector<std::unique_ptr<Entry>> orphans;
+
+    //收集函数单独加锁,removeCollector等待正在执行的收集函数结束
+    std::mutex collectorMutex;
+    std::map<uint64_t, Metrics::Collector> collectors;
+    uint64_t nextCollectorId = 1;
+
+    Entry &find(const std::string &name, const std::string &help, const Metrics::Labels &labels,
+                Metrics::Type type);
+};
+
+static MetricsState &metricsState() {
+    static MetricsState *state = new MetricsState();
+    return *state;
+}
+
+static std::string keyOf(const std::string &name, const Metrics::Labels &labels) {
+    std::string key = name;
+    for (const auto &label: labels) {
+        key += '\x1f';
+        key += label.first;
+        key += '=';
+        key += label.second;
+    }
+    return key;
+}
+
+MetricsState::Entry &MetricsState::find(const std::string &name, const std::string &help,
+                                        const Metrics::Labels &labels, const Metrics::Type type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto registered = types.emplace(name, type).first;
+    if (registered->second != type) {
+        Logger::error("指标 %s 已经注册为另一种类型,这次注册的不会导出", name);
+        orphans.push_back(std::make_unique<Entry>());
+        return *orphans.back();
+    }
+    std::unique_ptr<Entry> &slot = entries[keyOf(name, labels)];
+    if (!slot) {
+        slot = std::make_unique<Entry>();
+        slot->name = name;
+        slot->help = help;
+        slot->type = type;
+        slot->labels = labels;
+    }
+    return *slot;
+}
+
+MetricCounter &Metrics::counter(const std::string &name, const std::string &help, const Labels &labels) {
+    return metricsState().find(name, help, labels, Type::COUNTER).counter;
+}
+
+MetricGauge &Metrics::gauge(const std::string &name, const std::string &help, const Labels &labels) {
+    return metricsState().find(name, help, labels, Type::GAUGE).gauge;
+}
+
+MetricHistogram &Metrics::histogram(const std::string &name, const std::string &help, const Labels &labels) {
+    return metricsState().find(name, help, labels, Type::HISTOGRAM).histogram;
+}
+
+uint64_t Metrics::addCollector(Collector collector) {
+    MetricsState &state = metricsState();
+    std::lock_guard<std::mutex> lock(state.collectorMutex);
+    const uint64_t id = state.nextCollectorId++;
+    state.collectors.emplace(id, std::move(collector));
+    return id;
+}
+
+void Metrics::removeCollector(const uint64_t id) {
+    MetricsState &state = metricsState();
+    std::lock_guard<std::mutex> lock(state.collectorMutex);
+    state.collectors.erase(id);
+}
+
+void Metrics::Writer::counter(const std::string &name, const std::string &help, const Labels &labels,
+                              const uint64_t value) {
+    Sample sample;
+    sample.name = name;
+    sample.help = help;
+    sample.type = Type::COUNTER;
+    sample.labels = labels;
+    sample.value = static_cast<double>(value);
+    samples.push_back(std::move(sample));
+}
+
+void Metrics::Writer::gauge(const std::string &name, const std::string &help, const Labels &labels,
+                            const double value) {
+    Sample sample;
+    sample.name = name;
+    sample.help = help;
+    sample.type = Type::GAUGE;
+    sample.labels = labels;
+    sample.value = value;
+    samples.push_back(std::move(sample));
+}
+
+void Metrics::Writer::histogram(const std::string &name, const std::string &help, const Labels &labels,
+                                const LatencyHistogram::Snapshot &snapshot) {
+    Sample sample;
+    sample.name = name;
+    sample.help = help;
+    sample.type = Type::HISTOGRAM;
+    sample.labels = labels;
+    sample.histogram = snapshot;
+    samples.push_back(std::move(sample));
+}
+
+std::vector<Metrics::Sample> Metrics::snapshot() {
+    MetricsState &state = metricsState();
+    Writer writer;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (const auto &entry: state.entries) {
+            const MetricsState::Entry &metric = *entry.second;
+            switch (metric.type) {
+                case Type::COUNTER:
+                    writer.counter(metric.name, metric.help, metric.labels, metric.counter.value());
+                    break;
+                case Type::GAUGE:
+                    writer.gauge(metric.name, metric.help, metric.labels, metric.gauge.value());
+                    break;
+                case Type::HISTOGRAM:
+                    writer.histogram(metric.name, metric.help, metric.labels, metric.histogram.snapshot());
+                    break;
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(state.collectorMutex);
+        for (auto &collector: state.collectors) {
+            collector.second(writer);
+        }
+    }
+    // 同名的指标排在一起,Prometheus格式要求每个名字只有一组HELP/TYPE
+    std::stable_sort(writer.samples.begin(), writer.samples.end(), [](const Sample &a, const Sample &b) {
+        return a.name < b.name;
+    });
+    return std::move(writer.samples);
+}
+
+/**
+ * 追加带引号的字符串,JSON和Prometheus的标签值都适用
+ */
+static void appendQuoted(std::string &out, const std::string &text) {
+    out += '"';
+    for (const char c: text) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) {
+                    out += c;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+static void appendNumber(std::string &out, const double value) {
+    char text[32];
+    if (!std::isfinite(value)) {
+        out += std::isnan(value) ? "NaN" : (value > 0 ? "+Inf" : "-Inf");
+        return;
+    }
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        snprintf(text, sizeof(text), "%.0f", value);
+    } else {
+        snprintf(text, sizeof(text), "%.9g", value);
+    }
+    out += text;
+}
+
+static const char *typeName(const Metrics::Type type) {
+    switch (type) {
+        case Metrics::Type::COUNTER:
+            return "counter";
+        case Metrics::Type::GAUGE:
+            return "gauge";
+        case Metrics::Type::HISTOGRAM:
+            return "histogram";
+    }
+    return "untyped";
+}
+
+std::string Metrics::toJson(const std::vector<Sample> &samples) {
+    std::string out = "{\"metrics\":[";
+    bool first = true;
+    for (const Sample &sample: samples) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        out += "{\"name\":";
+        appendQuoted(out, sample.name);
+        out += ",\"type\":\"";
+        out += typeName(sample.type);
+        out += "\",\"labels\":{";
+        for (size_t i = 0; i < sample.labels.size(); i++) {
+            if (i > 0) {
+                out += ',';
+            }
+            appendQuoted(out, sample.labels[i].first);
+            out += ':';
+            appendQuoted(out, sample.labels[i].second);
+        }
+        out += '}';
+        if (sample.type != Type::HISTOGRAM) {
+            out += ",\"value\":";
+            appendNumber(out, std::isfinite(sample.value) ? sample.value : 0);
+        } else {
+            const LatencyHistogram::Snapshot &histogram = sample.histogram;
+            out += ",\"count\":";
+            appendNumber(out, static_cast<double>(histogram.count));
+            out += ",\"sumSeconds\":";
+            appendNumber(out, static_cast<double>(histogram.sum_ns) / 1e9);
+            out += ",\"meanUs\":";
+            appendNumber(out, histogram.mean() / 1e3);
+            const std::pair<const char *, double> quantiles[] = {{"p50Us", 0.5}, {"p90Us", 0.9}, {"p99Us", 0.99}};
+            for (const auto &quantile: quantiles) {
+                out += ",\"";
+                out += quantile.first;
+                out += "\":";
+                appendNumber(out, static_cast<double>(histogram.percentile(quantile.second)) / 1e3);
+            }
+            out += ",\"maxUs\":";
+            appendNumber(out, static_cast<double>(histogram.max_ns) / 1e3);
+        }
+        out += '}';
+    }
+    out += "]}";
+    return out;
+}
+
+/**
+ * 标签写成{a="1",b="2"},extra为直方图的le
+ */
+static void appendLabels(std::string &out, const Metrics::Labels &labels, const char *extraName = nullptr,
+                         const std::string &extraValue = std::string()) {
+    if (labels.empty() && !extraName) {
+        return;
+    }
+    out += '{';
+    bool first = true;
+    for (const auto &label: labels) {
+        if (!first) {
+            out += ',';
+        }
+        first = false;
+        out += label.first;
+        out += '=';
+        appendQuoted(out, label.second);
+    }
+    if (extraName) {
+        if (!first) {
+            out += ',';
+        }
+        out += extraName;
+        out += '=';
+        appendQuoted(out, extraValue);
+    }
+    out += '}';
+}
+
+std::string Metrics::toPrometheus(const std::vector<Sample> &samples) {
+    // 直方图导出的桶上界(纳秒): 1-2-5间隔,1微秒到10秒
+    static const std::vector<uint64_t> bounds = [] {
+        std::vector<uint64_t> result;
+        for (uint64_t decade = 1000; decade <= 1000000000ull; decade *= 10) {
+            result.push_back(decade);
+            result.push_back(decade * 2);
+            result.push_back(decade * 5);
+        }
+        result.push_back(10000000000ull);
+        return result;
+    }();
+
+    std::string out;
+    out.reserve(samples.size() * 128);
+    const std::string *lastName = nullptr;
+    for (const Sample &sample: samples) {
+        if (!lastName || *lastName != sample.name) {
+            out += "# HELP ";
+            out += sample.name;
+            out += ' ';
+            for (const char c: sample.help) {
+                if (c == '\\') {
+                    out += "\\\\";
+                } else if (c == '\n') {
+                    out += "\\n";
+                } else {
+                    out += c;
+                }
+            }
+            out += "\n# TYPE ";
+            out += sample.name;
+            out += ' ';
+            out += typeName(sample.type);
+            out += '\n';
+            lastName = &sample.name;
+        }
+        if (sample.type != Type::HISTOGRAM) {
+            out += sample.name;
+            appendLabels(out, sample.labels);
+            out += ' ';
+            appendNumber(out, sample.value);
+            out += '\n';
+            continue;
+        }
+
+        // 桶是累计的: 上界不超过le的内部桶全部计入(跨越le的桶计入下一个le,误差在一个内部桶之内)
+        const LatencyHistogram::Snapshot &histogram = sample.histogram;
+        size_t bucket = 0;
+        uint64_t cumulative = 0;
+        for (const uint64_t bound: bounds) {
+            while (bucket < LatencyHistogram::BUCKETS && LatencyHistogram::upperBound(bucket) <= bound) {
+                cumulative += histogram.counts[bucket];
+                bucket++;
+            }
+            char le[32];
+            snprintf(le, sizeof(le), "%g", static_cast<double>(bound) / 1e9);
+            out += sample.name;
+            out += "_bucket";
+            appendLabels(out, sample.labels, "le", le);
+            out += ' ';
+            appendNumber(out, static_cast<double>(cumulative));
+            out += '\n';
+        }
+        out += sample.name;
+        out += "_bucket";
+        appendLabels(out, sample.labels, "le", "+Inf");
+        out += ' ';
+        appendNumber(out, static_cast<double>(histogram.count));
+        out += '\n';
+        out += sample.name;
+        out += "_sum";
+        appendLabels(out, sample.labels);
+        out += ' ';
+        appendNumber(out, static_cast<double>(histogram.sum_ns) / 1e9);
+        out += '\n';
+        out += sample.name;
+        out += "_count";
+        appendLabels(out, sample.labels);
+        out += ' ';
+        appendNumber(out, static_cast<double>(histogram.count));
+        out += '\n';
+    }
+    return out;
+}
@@ -0,0 +1,199 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#ifndef METRICS_H
+#define METRICS_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+
+/**
+ * 计数器: 只增不减
+ * 按线程分片,每个线程加到自己的缓存行上,多个线程频繁计数时互不争用;读取时把各分片相加.
+ */
+class MetricCounter {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    MetricCounter() = default;
+
+    MetricCounter(const MetricCounter&) = delete;
+    MetricCounter& operator=(const MetricCounter&) = delete;
+
+    void add(const uint64_t amount = 1) {
+        shards[shardIndex()].value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, SHARDS> shards{};
+
+    /**
+     * 当前线程的分片(线程第一次计数时分配,之后只是读一个thread_local)
+     */
+    static size_t shardIndex();
+};
+
+/**
+ * 仪表: 可增可减的当前值(队列深度/连接状态等)
+ */
+class MetricGauge {
+public:
+    MetricGauge() = default;
+
+    MetricGauge(const MetricGauge&) = delete;
+    MetricGauge& operator=(const MetricGauge&) = delete;
+
+    void set(const double value) {
+        current.store(value, std::memory_order_relaxed);
+    }
+
+    void add(const double amount) {
+        double seen = current.load(std::memory_order_relaxed);
+        while (!current.compare_exchange_weak(seen, seen + amount, std::memory_order_relaxed)) {
+        }
+    }
+
+    [[nodiscard]] double value() const {
+        return current.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> current{0};
+};
+
+/**
+ * 时间间隔的直方图(单位纳秒,对数-线性分桶,见LatencyHistogram),多个线程可以同时记录
+ */
+class MetricHistogram {
+public:
+    MetricHistogram() = default;
+
+    MetricHistogram(const MetricHistogram&) = delete;
+    MetricHistogram& operator=(const MetricHistogram&) = delete;
+
+    void record(const uint64_t ns) {
+        histogram.recordConcurrent(ns);
+    }
+
+    [[nodiscard]] LatencyHistogram::Snapshot snapshot() const {
+        return histogram.snapshot();
+    }
+
+private:
+    LatencyHistogram histogram;
+};
+
+
+/**
+ * 进程内的指标注册表
+ * 各子系统用名字(和标签)取得计数器/仪表/直方图,通常保存在函数内的static引用中,之后的计数不再查找:
+ *   static MetricCounter &failed = Metrics::counter("xreal_commands_total", "发送的命令", {{"result", "failed"}});
+ *   failed.add();
+ * 已经有自己统计结构的子系统(StreamHealth/WebMessageBatcher等)注册收集函数,取快照时再读出.
+ * 快照可以编码为JSON或Prometheus文本格式,由MetricsExporter定期写到文件或通过本地端口提供.
+ *
+ * 指标的名字用Prometheus的习惯: 小写加下划线,计数器以_total结尾,直方图以_seconds结尾(记录时仍为纳秒).
+ * 注册的指标在进程内一直有效,返回的引用可以在任意线程中使用.
+ */
+class Metrics {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    enum class Type {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    /**
+     * 快照中的一个指标
+     */
+    struct Sample {
+        std::string name;
+        std::string help;
+        Type type = Type::COUNTER;
+        Labels labels;
+        //计数器和仪表的值
+        double value = 0;
+        //直方图的值(纳秒)
+        LatencyHistogram::Snapshot histogram;
+    };
+
+    /**
+     * 收集函数向快照中添加指标
+     */
+    class Writer {
+    public:
+        void counter(const std::string &name, const std::string &help, const Labels &labels, uint64_t value);
+
+        void gauge(const std::string &name, const std::string &help, const Labels &labels, double value);
+
+        void histogram(const std::string &name, const std::string &help, const Labels &labels,
+                       const LatencyHistogram::Snapshot &snapshot);
+
+    private:
+        friend class Metrics;
+        std::vector<Sample> samples;
+    };
+
+    /**
+     * 收集函数,在取快照的线程中调用;不能在其中注册或删除收集函数
+     */
+    using Collector = std::function<void(Writer &writer)>;
+
+    /**
+     * 取得(第一次调用时创建)计数器
+     * @param name - 指标名
+     * @param help - 说明
+     * @param labels - 标签,同名指标的不同标签是不同的计数器
+     */
+    static MetricCounter &counter(const std::string &name, const std::string &help, const Labels &labels = {});
+
+    static MetricGauge &gauge(const std::string &name, const std::string &help, const Labels &labels = {});
+
+    static MetricHistogram &histogram(const std::string &name, const std::string &help, const Labels &labels = {});
+
+    /**
+     * 注册收集函数
+     * @return - ID,用于removeCollector;收集函数引用的对象销毁之前必须删除
+     */
+    static uint64_t addCollector(Collector collector);
+
+    /**
+     * 删除收集函数,返回时它已经不在执行
+     */
+    static void removeCollector(uint64_t id);
+
+    /**
+     * 所有指标的当前值,按名字排序
+     */
+    static std::vector<Sample> snapshot();
+
+    /**
+     * 编码为JSON: {"metrics":[{"name":..,"type":..,"labels":{..},"value":..}, ...]}
+     * 直方图为 count/sumSeconds/meanUs/p50Us/p90Us/p99Us/maxUs
+     */
+    static std::string toJson(const std::vector<Sample> &samples);
+
+    /**
+     * 编码为Prometheus的文本格式(0.0.4),直方图的桶按1-2-5的间隔从1微秒到10秒
+     */
+    static std::string toPrometheus(const std::vector<Sample> &samples);
+};
+
+
+#endif //METRICS_H
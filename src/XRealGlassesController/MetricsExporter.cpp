@@ -0,0 +1,247 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#include "MetricsExporter.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "Logger.h"
+#include "Metrics.h"
+#include "Utils.h"
+
+// 读取请求头的上限和客户端读写的超时(单线程处理,不能被一个慢客户端卡住)
+static constexpr size_t MAX_REQUEST_BYTES = 4096;
+static constexpr int CLIENT_TIMEOUT_MS = 200;
+
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
+MetricsExporter::Config MetricsExporter::configFromEnvironment() {
+    Config config;
+    if (const char *path = std::getenv("XREAL_METRICS_FILE")) {
+        config.file_path = path;
+    }
+    if (const char *interval = std::getenv("XREAL_METRICS_INTERVAL_MS")) {
+        const long ms = std::atol(interval);
+        if (ms >= 100) {
+            config.interval_ns = static_cast<uint64_t>(ms) * 1000000ull;
+        }
+    }
+    if (const char *port = std::getenv("XREAL_METRICS_PORT")) {
+        const int value = std::atoi(port);
+        if (value > 0 && value < 65536) {
+            config.port = value;
+        }
+    }
+    return config;
+}
+
+MetricsExporter::MetricsExporter() : MetricsExporter(Config()) {
+}
+
+MetricsExporter::MetricsExporter(const Config &config) : config(config) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start() {
+    if (running || (config.file_path.empty() && config.port == 0)) {
+        return true;
+    }
+    if (pipe(wakePipe) != 0) {
+        Logger::error("指标导出: 无法创建唤醒管道");
+        return false;
+    }
+    for (const int fd: wakePipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    const bool listening = config.port == 0 || listenOnPort();
+    running = true;
+    worker = std::thread(&MetricsExporter::run, this);
+    if (!config.file_path.empty()) {
+        Logger::info("指标导出: 每%llu毫秒写入 %s", static_cast<unsigned long long>(config.interval_ns / 1000000),
+                     config.file_path);
+    }
+    return listening;
+}
+
+void MetricsExporter::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    const uint8_t one = 1;
+    (void) ::write(wakePipe[1], &one, sizeof(one));
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+    for (int &fd: wakePipe) {
+        ::close(fd);
+        fd = -1;
+    }
+    // 退出前的最后一次,文件中保留整个运行期间的累计值
+    if (!config.file_path.empty()) {
+        writeFile();
+    }
+}
+
+bool MetricsExporter::writeFile() const {
+    if (config.file_path.empty()) {
+        return false;
+    }
+    const std::string text = Metrics::toPrometheus(Metrics::snapshot());
+    const std::string temporaryPath = config.file_path + ".tmp";
+    FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!file) {
+        Logger::warning("指标导出: 无法写入 %s", temporaryPath);
+        return false;
+    }
+    const bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (std::fclose(file) != 0 || !written) {
+        Logger::warning("指标导出: 无法写入 %s", temporaryPath);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    if (std::rename(temporaryPath.c_str(), config.file_path.c_str()) != 0) {
+        Logger::warning("指标导出: 无法保存 %s", config.file_path);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MetricsExporter::listenOnPort() {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        Logger::error("指标导出: 无法创建套接字, errno=%d", errno);
+        return false;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(config.port));
+    // 只允许本机访问
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        Logger::error("指标导出: 无法监听127.0.0.1:%d, errno=%d", config.port, errno);
+        ::close(fd);
+        return false;
+    }
+    listenFd = fd;
+    Logger::info("指标导出: http://127.0.0.1:%d/metrics", config.port);
+    return true;
+}
+
+void MetricsExporter::run() {
+    uint64_t nextWriteNs = Utils::steadyNowNs() + config.interval_ns;
+    while (running) {
+        int timeoutMs = -1;
+        if (!config.file_path.empty()) {
+            const uint64_t nowNs = Utils::steadyNowNs();
+            if (nowNs >= nextWriteNs) {
+                writeFile();
+                nextWriteNs = nowNs + config.interval_ns;
+            }
+            timeoutMs = static_cast<int>((nextWriteNs - nowNs + 999999) / 1000000);
+        }
+
+        pollfd events[2] = {{wakePipe[0], POLLIN, 0}, {listenFd, POLLIN, 0}};
+        const int ready = poll(events, listenFd >= 0 ? 2 : 1, timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            Logger::error("指标导出: poll失败, errno=%d", errno);
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        if (events[0].revents) {
+            uint8_t discard[16];
+            while (::read(wakePipe[0], discard, sizeof(discard)) > 0) {
+            }
+        }
+        if (listenFd >= 0 && (events[1].revents & POLLIN)) {
+            const int clientFd = accept(listenFd, nullptr, nullptr);
+            if (clientFd >= 0) {
+                serve(clientFd);
+                ::close(clientFd);
+            }
+        }
+    }
+}
+
+void MetricsExporter::serve(const int clientFd) const {
+    timeval timeout{};
+    timeout.tv_sec = 0;
+    timeout.tv_usec = CLIENT_TIMEOUT_MS * 1000;
+    setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    const int noSignal = 1;
+    setsockopt(clientFd, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+
+    // 只需要请求行,读到请求头结束为止
+    std::string request;
+    char buffer[1024];
+    while (request.size() < MAX_REQUEST_BYTES && request.find("\r\n\r\n") == std::string::npos) {
+        const ssize_t received = recv(clientFd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    std::string status = "200 OK";
+    std::string contentType;
+    std::string body;
+    if (request.compare(0, 4, "GET ") != 0) {
+        status = "405 Method Not Allowed";
+        contentType = "text/plain; charset=utf-8";
+        body = "only GET is supported\n";
+    } else {
+        const size_t pathEnd = request.find_first_of(" ?\r\n", 4);
+        const std::string path = request.substr(4, pathEnd == std::string::npos ? std::string::npos : pathEnd - 4);
+        const std::vector<Metrics::Sample> samples = Metrics::snapshot();
+        if (path == "/metrics.json") {
+            contentType = "application/json; charset=utf-8";
+            body = Metrics::toJson(samples);
+        } else {
+            contentType = "text/plain; version=0.0.4; charset=utf-8";
+            body = Metrics::toPrometheus(samples);
+        }
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+                           "\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\nConnection: close\r\n\r\n";
+    response += body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        const ssize_t written = send(clientFd, response.data() + sent, response.size() - sent, SEND_FLAGS);
+        if (written <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(written);
+    }
+}
@@ -0,0 +1,75 @@
+//
+// Created by Norman Wang on 2025/5/21.
+//
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+
+/**
+ * 把Metrics的快照导出到进程外
+ * - 文件: 每隔一段时间把Prometheus文本写到临时文件再改名覆盖目标文件,读取方不会读到写了一半的内容;
+ * - 端口: 只监听127.0.0.1,GET /metrics.json 返回JSON,其他路径返回Prometheus文本(可直接被Prometheus抓取).
+ * 两者都在一个后台线程中完成,取快照/编码只在导出时进行,不影响计数的线程.
+ */
+class MetricsExporter {
+public:
+    struct Config {
+        //导出的文件路径,空为不写文件;环境变量XREAL_METRICS_FILE
+        std::string file_path;
+        //写文件的间隔;环境变量XREAL_METRICS_INTERVAL_MS
+        uint64_t interval_ns = 5000000000ull;
+        //本地HTTP端口,0为不监听;环境变量XREAL_METRICS_PORT
+        int port = 0;
+    };
+
+    /**
+     * 按环境变量覆盖的默认配置
+     */
+    static Config configFromEnvironment();
+
+    MetricsExporter();
+
+    explicit MetricsExporter(const Config &config);
+
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * 启动后台线程(文件路径和端口都没有配置时什么也不做)
+     * @return - 端口无法监听时为false,此时仍会写文件
+     */
+    bool start();
+
+    /**
+     * 停止后台线程,配置了文件时再写最后一次
+     */
+    void stop();
+
+    /**
+     * 立即写一次文件
+     */
+    bool writeFile() const;
+
+private:
+    const Config config;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    int listenFd = -1;
+    int wakePipe[2] = {-1, -1};
+
+    void run();
+
+    bool listenOnPort();
+
+    void serve(int clientFd) const;
+};
+
+
+#endif //METRICSEXPORTER_H
@@ -0,0 +1,30 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+#include <cstdint>
+
+
+/**
+ * 姿态融合的输出: 头部朝向和角速度
+ * 坐标系为IMU自身的坐标系,朝向是从IMU坐标系到世界坐标系(z轴与重力方向相反)的旋转
+ */
+struct ORIENTATION {
+    //朝向四元数(w, x, y, z),单位四元数
+    float quaternion[4] = {1, 0, 0, 0};
+    //角速度(弧度/秒,IMU坐标系)
+    float angular_velocity[3] = {0, 0, 0};
+    //最后一条参与融合的样本的设备时间戳(纳秒)
+    uint64_t device_timestamp_ns = 0;
+    //最后一条参与融合的样本被主机收到的时间(steady_clock, 纳秒)
+    uint64_t received_at_ns = 0;
+    //最后一条参与融合的样本的采样时间换算到主机时钟(steady_clock, 纳秒),时钟同步之前等于received_at_ns
+    uint64_t host_timestamp_ns = 0;
+    //最后一条参与融合的样本在ImuSampleBuffer中的序号,0表示还没有融合过任何样本
+    uint64_t sample_sequence = 0;
+};
+
+
+#endif //ORIENTATION_H
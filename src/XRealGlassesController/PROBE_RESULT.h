@@ -0,0 +1,30 @@
+//
+// Created by Norman Wang on 2025/5/8.
+//
+
+#ifndef PROBE_RESULT_H
+#define PROBE_RESULT_H
+#include <cstdint>
+#include <string>
+
+
+/**
+ * 单个接口的探测结果
+ */
+struct PROBE_RESULT {
+    //接口编号
+    int interface_number = 0;
+    //是否成功打开
+    bool opened = false;
+    //是否给出了0xFD应答
+    bool answered = false;
+    //是否被选为通讯接口
+    bool selected = false;
+    //从发出探测到收到应答(或被取消/超时)的耗时(纳秒)
+    uint64_t elapsed_ns = 0;
+    //未应答的原因(打开失败/超时/已取消)
+    std::string error;
+};
+
+
+#endif //PROBE_RESULT_H
@@ -0,0 +1,198 @@
+//
+// Created by Norman Wang on 2025/5/8.
+//
+
+#include "PendingRequestTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "HidReactor.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Utils.h"
+
+std::future<COMMAND_RESULT> PendingRequestTable::add(const uint32_t sequence, const uint16_t msgId,
+                                                     const std::chrono::milliseconds timeout, Callback callback) {
+    Entry entry;
+    entry.sequence = sequence;
+    entry.msgId = msgId;
+    entry.sentAtNs = Utils::steadyNowNs();
+    entry.callback = std::move(callback);
+    std::future<COMMAND_RESULT> future = entry.promise.get_future();
+
+    const uint64_t deadlineNs = entry.sentAtNs + static_cast<uint64_t>(
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count());
+    uint64_t entryId;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entryId = nextEntryId++;
+        entry.id = entryId;
+        entries.push_back(std::move(entry));
+    }
+
+    // 超时由反应器线程触发;表已销毁时定时器什么也不做
+    std::weak_ptr<PendingRequestTable> weakSelf = shared_from_this();
+    const uint64_t timerId = HidReactor::instance().scheduleAt(deadlineNs, [weakSelf, entryId]() {
+        if (const auto self = weakSelf.lock()) {
+            self->expire(entryId);
+        }
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = std::find_if(entries.begin(), entries.end(),
+                                     [entryId](const Entry &e) { return e.id == entryId; });
+        if (it != entries.end()) {
+            it->timerId = timerId;
+        }
+    }
+    return future;
+}
+
+bool PendingRequestTable::complete(const MCU_MESSAGE_VIEW &message, const uint64_t receivedAtNs) {
+    if (!message.report) {
+        return false;
+    }
+    const uint32_t sequence = message.sequence;
+    const uint16_t msgId = message.msg_id;
+
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // 优先按(序号, msgId)精确匹配
+        auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &e) {
+            return e.msgId == msgId && e.sequence == sequence;
+        });
+        // 设备不一定回显序号,退而匹配同一msgId中最早的请求
+        if (it == entries.end()) {
+            it = std::find_if(entries.begin(), entries.end(),
+                              [&](const Entry &e) { return e.msgId == msgId; });
+        }
+        if (it == entries.end()) {
+            it = std::find_if(entries.begin(), entries.end(),
+                              [](const Entry &e) { return e.msgId == ANY_MSG_ID; });
+        }
+        if (it == entries.end()) {
+            return false;
+        }
+        entry = std::move(*it);
+        entries.erase(it);
+    }
+
+    HidReactor::instance().cancelTimer(entry.timerId);
+
+    COMMAND_RESULT result;
+    result.success = true;
+    result.reply.received_at_ns = receivedAtNs;
+    result.reply.length = static_cast<uint16_t>(std::min(message.report_length, HID_REPORT::MAX_SIZE));
+    std::memcpy(result.reply.data, message.report, result.reply.length);
+    result.round_trip_ns = receivedAtNs > entry.sentAtNs ? receivedAtNs - entry.sentAtNs : 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastRoundTrips[entry.msgId] = result.round_trip_ns;
+    }
+    Logger::info("命令应答 msgId=%u 往返耗时: %lluus", msgId, result.round_trip_ns / 1000);
+
+    finish(entry, result);
+    return true;
+}
+
+void PendingRequestTable::fail(const uint32_t sequence, const uint16_t msgId, const std::string &error) {
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &e) {
+            return e.msgId == msgId && e.sequence == sequence;
+        });
+        if (it == entries.end()) {
+            return;
+        }
+        entry = std::move(*it);
+        entries.erase(it);
+    }
+    HidReactor::instance().cancelTimer(entry.timerId);
+
+    COMMAND_RESULT result;
+    result.error = error;
+    finish(entry, result);
+}
+
+void PendingRequestTable::cancelAll(const std::string &reason) {
+    std::vector<Entry> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled.swap(entries);
+    }
+    for (auto &entry: cancelled) {
+        HidReactor::instance().cancelTimer(entry.timerId);
+        COMMAND_RESULT result;
+        result.error = reason;
+        finish(entry, result);
+    }
+}
+
+size_t PendingRequestTable::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+uint64_t PendingRequestTable::lastRoundTripNs(const uint16_t msgId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = lastRoundTrips.find(msgId);
+    return it == lastRoundTrips.end() ? 0 : it->second;
+}
+
+bool PendingRequestTable::takeLocked(const uint64_t entryId, Entry &out) {
+    const auto it = std::find_if(entries.begin(), entries.end(),
+                                 [entryId](const Entry &e) { return e.id == entryId; });
+    if (it == entries.end()) {
+        return false;
+    }
+    out = std::move(*it);
+    entries.erase(it);
+    return true;
+}
+
+void PendingRequestTable::expire(const uint64_t entryId) {
+    Entry entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!takeLocked(entryId, entry)) {
+            return;
+        }
+    }
+    Logger::warning("命令应答超时 msgId=%u", entry.msgId);
+    COMMAND_RESULT result;
+    result.timed_out = true;
+    result.error = "等待应答超时";
+    finish(entry, result);
+}
+
+void PendingRequestTable::finish(Entry &entry, COMMAND_RESULT &result) {
+    static MetricCounter &answered = Metrics::counter("xreal_requests_total", "等待应答的0xFD命令",
+                                                      {{"result", "ok"}});
+    static MetricCounter &timedOut = Metrics::counter("xreal_requests_total", "等待应答的0xFD命令",
+                                                      {{"result", "timeout"}});
+    static MetricCounter &failed = Metrics::counter("xreal_requests_total", "等待应答的0xFD命令",
+                                                    {{"result", "failed"}});
+    static MetricHistogram &roundTrip = Metrics::histogram("xreal_request_round_trip_seconds",
+                                                           "0xFD命令从登记到收到应答的时间");
+    if (result.success) {
+        answered.add();
+        roundTrip.record(result.round_trip_ns);
+    } else if (result.timed_out) {
+        timedOut.add();
+    } else {
+        failed.add();
+    }
+
+    if (entry.callback) {
+        try {
+            entry.callback(result);
+        } catch (const std::exception &e) {
+            Logger::error("命令回调异常: %s", e.what());
+        }
+    }
+    entry.promise.set_value(std::move(result));
+}
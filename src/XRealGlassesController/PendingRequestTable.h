@@ -0,0 +1,97 @@
+//
+// Created by Norman Wang on 2025/5/8.
+//
+
+#ifndef PENDINGREQUESTTABLE_H
+#define PENDINGREQUESTTABLE_H
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "COMMAND_RESULT.h"
+#include "MCU_MESSAGE_VIEW.h"
+
+
+/**
+ * 0xFD命令的请求/应答匹配表
+ * 发送命令前登记(序号, msgId),收到应答时立即完成对应的future/回调,
+ * 到达截止时间仍未应答则以超时失败完成.
+ * 超时由HidReactor的定时器驱动,回调都在反应器线程中执行.
+ */
+class PendingRequestTable : public std::enable_shared_from_this<PendingRequestTable> {
+public:
+    // 匹配任意msgId(用于"v"这类没有结构化头部的探测命令)
+    static constexpr uint16_t ANY_MSG_ID = 0xFFFF;
+
+    using Callback = std::function<void(const COMMAND_RESULT &)>;
+
+    /**
+     * 登记一个等待应答的请求(应在写入设备之前调用,避免应答先于登记到达)
+     * @param sequence - 命令中的序号(字节7~10)
+     * @param msgId - 命令的消息ID(字节15~16),ANY_MSG_ID表示任意0xFD应答都算
+     * @param timeout - 等待应答的最长时间
+     * @param callback - 完成时的回调(可为空)
+     * @return - 应答结果的future
+     */
+    std::future<COMMAND_RESULT> add(uint32_t sequence, uint16_t msgId, std::chrono::milliseconds timeout,
+                                    Callback callback = nullptr);
+
+    /**
+     * 收到一条已校验的0xFD上报时调用,匹配并完成对应的请求
+     * @param message - 解码后的报文
+     * @param receivedAtNs - 接收时间
+     * @return - 是否匹配到了请求
+     */
+    bool complete(const MCU_MESSAGE_VIEW &message, uint64_t receivedAtNs);
+
+    /**
+     * 请求发送失败时立即以失败完成
+     */
+    void fail(uint32_t sequence, uint16_t msgId, const std::string &error);
+
+    /**
+     * 以失败完成所有等待中的请求(例如接口关闭时)
+     */
+    void cancelAll(const std::string &reason);
+
+    /**
+     * 等待中的请求数量
+     */
+    size_t pendingCount() const;
+
+    /**
+     * 某个msgId最近一次的往返时间(纳秒),没有记录时返回0
+     */
+    uint64_t lastRoundTripNs(uint16_t msgId) const;
+
+private:
+    struct Entry {
+        uint64_t id = 0;
+        uint32_t sequence = 0;
+        uint16_t msgId = 0;
+        uint64_t sentAtNs = 0;
+        uint64_t timerId = 0;
+        std::promise<COMMAND_RESULT> promise;
+        Callback callback;
+    };
+
+    // 从表中移出一个请求(调用方需持有锁)
+    bool takeLocked(uint64_t entryId, Entry &out);
+    // 在锁外完成一个请求
+    static void finish(Entry &entry, COMMAND_RESULT &result);
+    void expire(uint64_t entryId);
+
+    mutable std::mutex mutex;
+    // 同时等待的请求很少,线性查找即可
+    std::vector<Entry> entries;
+    uint64_t nextEntryId = 1;
+    std::map<uint16_t, uint64_t> lastRoundTrips;
+};
+
+
+#endif //PENDINGREQUESTTABLE_H
@@ -0,0 +1,150 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#include "PosePredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Float4.h"
+
+// 历史中找到的起点与"现在-预测时长"最多相差多少还算有效(丢包时跳过这次统计)
+static constexpr uint64_t MAX_SOURCE_GAP_NS = 5000000ULL;
+// 两次更新相隔超过这个时间时不计算角加速度
+static constexpr double MAX_ACCELERATION_STEP_SECONDS = 0.1;
+
+PosePredictor::PosePredictor() : PosePredictor(Config()) {
+}
+
+PosePredictor::PosePredictor(const Config &config) :
+    config(config), history(HISTORY_SIZE), accumulators(config.evaluated_horizons_ns.size()), trace(TRACE_SIZE) {
+}
+
+void PosePredictor::update(const ORIENTATION &orientation) {
+    if (hasState) {
+        const double dt = static_cast<double>(orientation.device_timestamp_ns) * 1e-9 -
+                          static_cast<double>(current.orientation.device_timestamp_ns) * 1e-9;
+        for (int axis = 0; axis < 3; axis++) {
+            if (dt > 0 && dt < MAX_ACCELERATION_STEP_SECONDS) {
+                const auto raw = static_cast<float>(
+                    (orientation.angular_velocity[axis] - current.orientation.angular_velocity[axis]) / dt);
+                current.angular_acceleration[axis] += config.acceleration_smoothing *
+                        (raw - current.angular_acceleration[axis]);
+            } else {
+                current.angular_acceleration[axis] = 0;
+            }
+        }
+    }
+    current.orientation = orientation;
+    hasState = true;
+
+    history[historyNext] = current;
+    historyNext = (historyNext + 1) % HISTORY_SIZE;
+    historyCount = std::min(historyCount + 1, HISTORY_SIZE);
+
+    evaluate();
+}
+
+void PosePredictor::extrapolate(const State &state, int64_t horizonNs, const Config &config, ORIENTATION &out) {
+    const auto maxHorizon = static_cast<int64_t>(config.max_horizon_ns);
+    horizonNs = std::max(-maxHorizon, std::min(horizonNs, maxHorizon));
+    const float t = static_cast<float>(horizonNs) * 1e-9f;
+
+    out = state.orientation;
+    // 预测时长内转过的角度(IMU坐标系下的旋转向量): ω·t + ½·α·t²
+    float rotation[3];
+    for (int axis = 0; axis < 3; axis++) {
+        const float acceleration = config.use_acceleration ? state.angular_acceleration[axis] : 0.0f;
+        rotation[axis] = state.orientation.angular_velocity[axis] * t + 0.5f * acceleration * t * t;
+        out.angular_velocity[axis] = state.orientation.angular_velocity[axis] + acceleration * t;
+    }
+
+    const float angle = std::sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2]);
+    Float4Simd delta;
+    if (angle > 1e-9f) {
+        const float s = std::sin(angle * 0.5f) / angle;
+        delta = Float4Simd::set(std::cos(angle * 0.5f), rotation[0] * s, rotation[1] * s, rotation[2] * s);
+    } else {
+        delta = Float4Simd::set(1, rotation[0] * 0.5f, rotation[1] * 0.5f, rotation[2] * 0.5f);
+    }
+    // 角速度在IMU坐标系下,右乘
+    normalize(quaternionMultiply(Float4Simd::load(state.orientation.quaternion), delta)).store(out.quaternion);
+    out.device_timestamp_ns = state.orientation.device_timestamp_ns + horizonNs;
+    out.received_at_ns = state.orientation.received_at_ns + horizonNs;
+    out.host_timestamp_ns = state.orientation.host_timestamp_ns + horizonNs;
+}
+
+double PosePredictor::angleBetween(const float (&a)[4], const float (&b)[4]) {
+    const double cosine = std::fabs(static_cast<double>(a[0]) * b[0] + static_cast<double>(a[1]) * b[1] +
+                                    static_cast<double>(a[2]) * b[2] + static_cast<double>(a[3]) * b[3]);
+    return 2.0 * std::acos(std::min(cosine, 1.0)) * 180.0 / M_PI;
+}
+
+void PosePredictor::evaluate() {
+    const uint64_t now = current.orientation.device_timestamp_ns;
+    for (size_t k = 0; k < config.evaluated_horizons_ns.size(); k++) {
+        const uint64_t horizon = config.evaluated_horizons_ns[k];
+        if (now < horizon) {
+            continue;
+        }
+        // 历史中最近一条不晚于"现在-预测时长"的状态,就是当时做预测的起点
+        const uint64_t sourceTime = now - horizon;
+        const State *source = nullptr;
+        for (size_t i = 1; i <= historyCount; i++) {
+            const State &candidate = history[(historyNext + HISTORY_SIZE - i) % HISTORY_SIZE];
+            if (candidate.orientation.device_timestamp_ns <= sourceTime) {
+                source = &candidate;
+                break;
+            }
+        }
+        if (!source || sourceTime - source->orientation.device_timestamp_ns > MAX_SOURCE_GAP_NS) {
+            continue;
+        }
+
+        ORIENTATION predicted;
+        extrapolate(*source, static_cast<int64_t>(now - source->orientation.device_timestamp_ns), config, predicted);
+        const double error = angleBetween(predicted.quaternion, current.orientation.quaternion);
+
+        Accumulator &accumulator = accumulators[k];
+        accumulator.count++;
+        accumulator.sum += error;
+        accumulator.sumSquares += error * error;
+        accumulator.max = std::max(accumulator.max, error);
+
+        trace[traceNext] = TraceEntry{now, static_cast<uint32_t>(k), static_cast<float>(error)};
+        traceNext = (traceNext + 1) % TRACE_SIZE;
+        traceCount = std::min(traceCount + 1, TRACE_SIZE);
+    }
+}
+
+std::vector<PosePredictor::ErrorStats> PosePredictor::errorStats() const {
+    std::vector<ErrorStats> result(accumulators.size());
+    result.resize(errorStats(result.data(), result.size()));
+    return result;
+}
+
+size_t PosePredictor::errorStats(ErrorStats *out, const size_t capacity) const {
+    const size_t count = std::min(capacity, accumulators.size());
+    for (size_t k = 0; k < count; k++) {
+        const Accumulator &accumulator = accumulators[k];
+        out[k] = ErrorStats();
+        out[k].horizon_ns = config.evaluated_horizons_ns[k];
+        out[k].count = accumulator.count;
+        if (accumulator.count > 0) {
+            out[k].mean_degrees = accumulator.sum / static_cast<double>(accumulator.count);
+            out[k].rms_degrees = std::sqrt(accumulator.sumSquares / static_cast<double>(accumulator.count));
+            out[k].max_degrees = accumulator.max;
+        }
+    }
+    return count;
+}
+
+void PosePredictor::writeTrace(std::ostream &out) const {
+    out << "device_timestamp_ns,horizon_ms,error_degrees\n";
+    for (size_t i = traceCount; i > 0; i--) {
+        const TraceEntry &entry = trace[(traceNext + TRACE_SIZE - i) % TRACE_SIZE];
+        const double horizonMs = static_cast<double>(config.evaluated_horizons_ns[entry.horizon_index]) / 1e6;
+        out << entry.device_timestamp_ns << ',' << horizonMs << ',' << entry.error_degrees << '\n';
+    }
+}
@@ -0,0 +1,151 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#ifndef POSEPREDICTOR_H
+#define POSEPREDICTOR_H
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "ORIENTATION.h"
+
+
+/**
+ * 头部姿态预测
+ * 按最新朝向的角速度和角加速度,把朝向外推到指定的未来时刻(下一帧的预计出光时间),
+ * 抵消从IMU采样到画面显示之间的延迟.
+ *
+ * 同时保留最近一段朝向历史,每收到新朝向就用历史中"一个预测时长之前"的状态重新预测到现在,
+ * 与实际朝向比较得到各预测时长的误差(角度),用于按60/72Hz显示模式调整预测时长.
+ *
+ * 不是线程安全的: update/evaluate在融合线程中调用,其他线程通过state()的拷贝和extrapolate预测.
+ */
+class PosePredictor {
+public:
+    struct Config {
+        //最长预测时长,超过时按这个时长预测
+        uint64_t max_horizon_ns = 50000000ULL;
+        //是否使用角加速度(否则只按角速度匀速外推)
+        bool use_acceleration = true;
+        //角加速度的平滑系数(0~1,越小越平滑)
+        float acceleration_smoothing = 0.1f;
+        //统计误差的预测时长(默认为72Hz/60Hz下的1帧和2帧)
+        std::vector<uint64_t> evaluated_horizons_ns = {13888889ULL, 16666667ULL, 27777778ULL, 33333333ULL};
+    };
+
+    /**
+     * 外推所需的状态
+     */
+    struct State {
+        ORIENTATION orientation;
+        //角加速度(弧度/秒²,IMU坐标系)
+        float angular_acceleration[3] = {0, 0, 0};
+    };
+
+    /**
+     * 某个预测时长的误差统计(角度)
+     */
+    struct ErrorStats {
+        uint64_t horizon_ns = 0;
+        uint64_t count = 0;
+        double mean_degrees = 0;
+        double rms_degrees = 0;
+        double max_degrees = 0;
+    };
+
+    PosePredictor();
+
+    explicit PosePredictor(const Config &config);
+
+    /**
+     * 收到新的朝向: 更新角加速度,记入历史,并统计各预测时长的误差
+     */
+    void update(const ORIENTATION &orientation);
+
+    /**
+     * 当前用于外推的状态
+     */
+    [[nodiscard]] const State &state() const {
+        return current;
+    }
+
+    [[nodiscard]] const Config &configuration() const {
+        return config;
+    }
+
+    /**
+     * 从某个状态外推
+     * @param state - 起点
+     * @param horizonNs - 预测时长(纳秒),不超过config.max_horizon_ns
+     * @param config - 预测配置
+     * @param out - 预测的朝向(角速度也外推到该时刻)
+     */
+    static void extrapolate(const State &state, int64_t horizonNs, const Config &config, ORIENTATION &out);
+
+    /**
+     * 预测到主机时间targetNs(steady_clock),从朝向的host_timestamp_ns算起
+     */
+    void predict(uint64_t targetNs, ORIENTATION &out) const {
+        extrapolate(current, static_cast<int64_t>(targetNs - current.orientation.host_timestamp_ns), config, out);
+    }
+
+    /**
+     * 各预测时长的误差统计
+     */
+    [[nodiscard]] std::vector<ErrorStats> errorStats() const;
+
+    /**
+     * 各预测时长的误差统计,写入调用方的数组(不分配内存,可以在融合线程中每批调用)
+     * @return - 写入的个数(不超过capacity)
+     */
+    size_t errorStats(ErrorStats *out, size_t capacity) const;
+
+    /**
+     * 以CSV输出最近的误差记录: device_timestamp_ns,horizon_ms,error_degrees
+     */
+    void writeTrace(std::ostream &out) const;
+
+    /**
+     * 两个朝向之间的夹角(度)
+     */
+    static double angleBetween(const float (&a)[4], const float (&b)[4]);
+
+private:
+    // 历史容量(1kHz下约0.25秒,需要大于最长的统计时长)
+    static constexpr size_t HISTORY_SIZE = 256;
+    // 误差记录容量
+    static constexpr size_t TRACE_SIZE = 4096;
+
+    struct TraceEntry {
+        uint64_t device_timestamp_ns;
+        uint32_t horizon_index;
+        float error_degrees;
+    };
+
+    struct Accumulator {
+        uint64_t count = 0;
+        double sum = 0;
+        double sumSquares = 0;
+        double max = 0;
+    };
+
+    void evaluate();
+
+    Config config;
+    State current;
+    bool hasState = false;
+
+    std::vector<State> history;
+    // 下一个写入位置/已写入的条数
+    size_t historyNext = 0;
+    size_t historyCount = 0;
+
+    std::vector<Accumulator> accumulators;
+    std::vector<TraceEntry> trace;
+    size_t traceNext = 0;
+    size_t traceCount = 0;
+};
+
+
+#endif //POSEPREDICTOR_H
@@ -0,0 +1,17 @@
+//
+// Created by Norman Wang on 2025/5/6.
+//
+
+#ifndef READER_MODE_H
+#define READER_MODE_H
+
+// 接口上报数据的读取方式
+enum class ReaderMode {
+    // 旧方式: 非阻塞hid_read + 每轮sleep 5ms
+    POLLING,
+    // 事件驱动: 有数据立即唤醒,空闲时不占用CPU,关闭时立即取消
+    BLOCKING,
+    // 交给全局HidReactor统一读取,不单独创建线程
+    REACTOR
+};
+#endif //READER_MODE_H
@@ -0,0 +1,91 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#include "RecordingTransport.h"
+
+#include "Utils.h"
+
+/**
+ * 录制中的一个接口: 读写都转发给实际的接口,成功的读写同时写入录制文件
+ */
+class RecordingDeviceHandle : public HidDeviceHandle {
+public:
+    RecordingDeviceHandle(std::shared_ptr<HidDeviceHandle> inner, const int interfaceNumber,
+                          std::shared_ptr<CaptureWriter> writer)
+        : inner(std::move(inner)), interfaceNumber(interfaceNumber), writer(std::move(writer)) {
+    }
+
+    int write(const uint8_t *data, const size_t length) override {
+        const uint64_t nowNs = Utils::steadyNowNs();
+        const int written = inner->write(data, length);
+        if (written > 0) {
+            writer->append(CaptureRecordKind::OUTPUT, interfaceNumber, data, length, nowNs);
+        }
+        return written;
+    }
+
+    int sendFeatureReport(const uint8_t *data, const size_t length) override {
+        const uint64_t nowNs = Utils::steadyNowNs();
+        const int sent = inner->sendFeatureReport(data, length);
+        if (sent > 0) {
+            writer->append(CaptureRecordKind::FEATURE, interfaceNumber, data, length, nowNs);
+        }
+        return sent;
+    }
+
+    int read(uint8_t *buffer, const size_t length, const int timeoutMs) override {
+        const int count = inner->read(buffer, length, timeoutMs);
+        if (count > 0) {
+            writer->append(CaptureRecordKind::INPUT, interfaceNumber, buffer, static_cast<size_t>(count),
+                           Utils::steadyNowNs());
+        }
+        return count;
+    }
+
+    int pollFd() const override {
+        return inner->pollFd();
+    }
+
+    std::string lastError() override {
+        return inner->lastError();
+    }
+
+private:
+    std::shared_ptr<HidDeviceHandle> inner;
+    const int interfaceNumber;
+    std::shared_ptr<CaptureWriter> writer;
+};
+
+RecordingTransport::RecordingTransport(std::shared_ptr<HidTransport> inner, std::shared_ptr<CaptureWriter> writer)
+    : inner(std::move(inner)), writer(std::move(writer)) {
+}
+
+std::vector<HID_DEVICE_ENTRY> RecordingTransport::enumerate(const uint16_t vendorId) {
+    std::vector<HID_DEVICE_ENTRY> entries = inner->enumerate(vendorId);
+    const uint64_t nowNs = Utils::steadyNowNs();
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    for (const auto &entry: entries) {
+        // 同一个接口只记录一次
+        if (interfaceNumbers.emplace(entry.path, entry.interface_number).second) {
+            writer->appendDevice(entry, nowNs);
+        }
+    }
+    return entries;
+}
+
+std::shared_ptr<HidDeviceHandle> RecordingTransport::open(const std::string &path) {
+    auto handle = inner->open(path);
+    if (!handle) {
+        return nullptr;
+    }
+    int interfaceNumber = -1;
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        const auto found = interfaceNumbers.find(path);
+        if (found != interfaceNumbers.end()) {
+            interfaceNumber = found->second;
+        }
+    }
+    return std::make_shared<RecordingDeviceHandle>(std::move(handle), interfaceNumber, writer);
+}
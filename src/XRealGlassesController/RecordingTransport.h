@@ -0,0 +1,43 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#ifndef RECORDINGTRANSPORT_H
+#define RECORDINGTRANSPORT_H
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "CaptureWriter.h"
+#include "HidTransport.h"
+
+
+/**
+ * 录制模式的传输层
+ * 包装实际的传输层(hidapi或模拟眼镜),把枚举到的接口、每个接口读到的上报和写入的命令
+ * 连同主机时间一起写入录制文件,行为与被包装的传输层完全相同.
+ * 设置环境变量XREAL_RECORD=文件路径时启用,录制文件可以用ReplayTransport回放.
+ */
+class RecordingTransport : public HidTransport {
+public:
+    RecordingTransport(std::shared_ptr<HidTransport> inner, std::shared_ptr<CaptureWriter> writer);
+
+    std::vector<HID_DEVICE_ENTRY> enumerate(uint16_t vendorId) override;
+
+    std::shared_ptr<HidDeviceHandle> open(const std::string &path) override;
+
+    [[nodiscard]] const std::shared_ptr<CaptureWriter> &capture() const {
+        return writer;
+    }
+
+private:
+    std::shared_ptr<HidTransport> inner;
+    std::shared_ptr<CaptureWriter> writer;
+
+    // 路径 -> 接口编号(枚举时记下,打开时用于标记记录)
+    std::mutex entriesMutex;
+    std::map<std::string, int> interfaceNumbers;
+};
+
+
+#endif //RECORDINGTRANSPORT_H
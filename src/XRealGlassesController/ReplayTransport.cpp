@@ -0,0 +1,369 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#include "ReplayTransport.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "HidReactor.h"
+#include "Logger.h"
+#include "McuDecoder.h"
+#include "Utils.h"
+
+// 接口队列最多缓存的上报条数,超出时丢弃最旧的(与SimulatedTransport相同)
+static constexpr size_t MAX_QUEUED_REPORTS = 256;
+// 尽快回放时,每个接口的队列保持的条数(读走一条补一条,由读取速度决定回放速度)
+static constexpr size_t FAST_QUEUE_DEPTH = 64;
+// 实时回放时,一次定时器回调最多补齐的条数
+static constexpr size_t MAX_REPORTS_PER_PUMP = 256;
+
+static double envOr(const char *name, const double fallback) {
+    const char *value = std::getenv(name);
+    return value ? std::atof(value) : fallback;
+}
+
+static uint32_t readLittleEndian(const uint8_t *data, const REPORT_FIELD &field) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < field.size; i++) {
+        value |= static_cast<uint32_t>(data[field.offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * 是否是结构化的0xFD命令(否则是"v"这样的文本探测)
+ */
+static bool isStructuredCommand(const uint8_t *data, const size_t length) {
+    return length >= MCU_REPORT_LAYOUT::MSG_ID.end() && data[0] == MCU_REPORT_LAYOUT::HEAD_BYTE;
+}
+
+/**
+ * 是否是命令的应答(回放时按命令即时生成,不按时间回放)
+ */
+static bool isCommandReply(const McuMessageKind kind) {
+    switch (kind) {
+        case McuMessageKind::VERSION_REPLY:
+        case McuMessageKind::DISPLAY_MODE_REPLY:
+        case McuMessageKind::DISPLAY_MODE_ACK:
+        case McuMessageKind::BRIGHTNESS_REPLY:
+        case McuMessageKind::BRIGHTNESS_ACK:
+        case McuMessageKind::GLASS_ID_REPLY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * 回放中的一个接口
+ * 与SimulatedDeviceHandle一样用队列+管道通知,可以交给poll/epoll等待
+ */
+class ReplayDeviceHandle : public HidDeviceHandle, public std::enable_shared_from_this<ReplayDeviceHandle> {
+public:
+    ReplayDeviceHandle(ReplayTransport &transport, const int interfaceNumber)
+        : transport(transport), interfaceNumber(interfaceNumber) {
+        if (pipe(notifyPipe) == 0) {
+            for (const int fd: notifyPipe) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+        }
+    }
+
+    ~ReplayDeviceHandle() override {
+        if (const uint64_t timerId = pumpTimerId.load()) {
+            HidReactor::instance().cancelTimer(timerId);
+        }
+        for (const int fd: notifyPipe) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    /**
+     * 从当前回放位置开始送出这个接口的上报
+     */
+    void start() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        cursor = transport.reader().seek(transport.recordedTimeNow());
+        if (transport.config().speed > 0) {
+            pumpLocked();
+        } else {
+            fillLocked();
+        }
+    }
+
+    int write(const uint8_t *data, const size_t length) override {
+        CommandHelper::McuReport reply;
+        size_t replyLength = 0;
+        if (transport.replyTo(interfaceNumber, data, length, reply, replyLength)) {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            deliverLocked(reply.data(), replyLength);
+        }
+        return static_cast<int>(length);
+    }
+
+    int sendFeatureReport(const uint8_t *data, const size_t length) override {
+        return write(data, length);
+    }
+
+    int read(uint8_t *buffer, const size_t length, const int timeoutMs) override {
+        if (timeoutMs != 0) {
+            pollfd event{notifyPipe[0], POLLIN, 0};
+            if (poll(&event, 1, timeoutMs) <= 0) {
+                return 0;
+            }
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queue.empty()) {
+            return 0;
+        }
+        const std::vector<uint8_t> report = std::move(queue.front());
+        queue.pop_front();
+        uint8_t token;
+        (void) ::read(notifyPipe[0], &token, 1);
+        if (transport.config().speed <= 0) {
+            fillLocked();
+        }
+        const size_t count = std::min(length, report.size());
+        std::memcpy(buffer, report.data(), count);
+        return static_cast<int>(count);
+    }
+
+    int pollFd() const override {
+        return notifyPipe[0];
+    }
+
+    std::string lastError() override {
+        return finished ? "回放结束" : "";
+    }
+
+private:
+    /**
+     * 取下一条要回放的上报(本接口读到的、不是命令应答的记录)
+     */
+    bool nextReportLocked(CaptureReader::Record &out) {
+        while (transport.reader().next(cursor, out)) {
+            if (out.kind != CaptureRecordKind::INPUT || out.interface_number != interfaceNumber) {
+                continue;
+            }
+            MCU_MESSAGE_VIEW message;
+            if (McuDecoder::decode(out.data, out.length, message) == McuDecoder::Status::OK &&
+                isCommandReply(message.kind)) {
+                continue;
+            }
+            return true;
+        }
+        if (!finished) {
+            finished = true;
+            if (delivered > 0) {
+                Logger::info("接口 %d 回放结束: 共 %u 条", interfaceNumber, delivered);
+            }
+        }
+        return false;
+    }
+
+    void deliverLocked(const uint8_t *data, const size_t length) {
+        if (queue.size() >= MAX_QUEUED_REPORTS) {
+            // 队列满了丢弃最旧的一条,管道中的计数保持不变
+            queue.pop_front();
+            queue.emplace_back(data, data + length);
+            return;
+        }
+        queue.emplace_back(data, data + length);
+        const uint8_t token = 1;
+        (void) ::write(notifyPipe[1], &token, 1);
+    }
+
+    // 尽快回放: 补齐队列
+    void fillLocked() {
+        CaptureReader::Record record;
+        while (queue.size() < FAST_QUEUE_DEPTH && nextReportLocked(record)) {
+            deliverLocked(record.data, record.length);
+            delivered++;
+        }
+    }
+
+    // 实时回放: 送出所有已到期的上报,再按下一条的时间定时
+    void pumpLocked() {
+        const uint64_t nowNs = Utils::steadyNowNs();
+        for (size_t pumped = 0; pumped < MAX_REPORTS_PER_PUMP; pumped++) {
+            if (!pending && !(pending = nextReportLocked(pendingRecord))) {
+                return;
+            }
+            const uint64_t dueNs = transport.replayTimeOf(pendingRecord.host_ns);
+            if (dueNs > nowNs) {
+                scheduleLocked(dueNs);
+                return;
+            }
+            deliverLocked(pendingRecord.data, pendingRecord.length);
+            delivered++;
+            pending = false;
+        }
+        scheduleLocked(nowNs);
+    }
+
+    void scheduleLocked(const uint64_t dueNs) {
+        std::weak_ptr<ReplayDeviceHandle> weakSelf = shared_from_this();
+        pumpTimerId = HidReactor::instance().scheduleAt(dueNs, [weakSelf]() {
+            if (const auto self = weakSelf.lock()) {
+                std::lock_guard<std::mutex> lock(self->queueMutex);
+                self->pumpLocked();
+            }
+        });
+    }
+
+    ReplayTransport &transport;
+    const int interfaceNumber;
+    int notifyPipe[2] = {-1, -1};
+
+    std::mutex queueMutex;
+    std::deque<std::vector<uint8_t>> queue;
+    CaptureReader::Cursor cursor;
+    CaptureReader::Record pendingRecord;
+    bool pending = false;
+    bool finished = false;
+    uint64_t delivered = 0;
+
+    std::atomic<uint64_t> pumpTimerId{0};
+};
+
+ReplayTransport::ReplayTransport(const std::string &path) : ReplayTransport(path, [] {
+    Config config;
+    config.speed = envOr("XREAL_REPLAY_SPEED", config.speed);
+    config.start_offset_ns = static_cast<uint64_t>(envOr("XREAL_REPLAY_START_MS", 0) * 1e6);
+    return config;
+}()) {
+}
+
+ReplayTransport::ReplayTransport(const std::string &path, const Config &config) : replayConfig(config) {
+    if (!capture.open(path)) {
+        return;
+    }
+    indexReplies();
+    Logger::info("回放录制文件: %s, %u 条记录, %ums, %u 个接口", path, capture.recordCount(),
+                 (capture.lastNs() - capture.firstNs()) / 1000000, capture.devices().size());
+}
+
+void ReplayTransport::indexReplies() {
+    // 每个接口上最近一次写入的命令(序号, msgId),文本探测记为没有序号
+    struct LastCommand {
+        bool text = false;
+        uint32_t sequence = 0;
+        uint16_t msgId = 0;
+    };
+    std::map<int, LastCommand> lastCommands;
+
+    CaptureReader::Cursor cursor = capture.begin();
+    CaptureReader::Record record;
+    while (capture.next(cursor, record)) {
+        if (record.kind == CaptureRecordKind::OUTPUT || record.kind == CaptureRecordKind::FEATURE) {
+            if (record.length == 0 || record.data[0] != MCU_REPORT_LAYOUT::HEAD_BYTE) {
+                continue;
+            }
+            LastCommand &command = lastCommands[record.interface_number];
+            command.text = !isStructuredCommand(record.data, record.length);
+            if (!command.text) {
+                command.sequence = readLittleEndian(record.data, MCU_REPORT_LAYOUT::SEQUENCE);
+                command.msgId = static_cast<uint16_t>(readLittleEndian(record.data, MCU_REPORT_LAYOUT::MSG_ID));
+            }
+            continue;
+        }
+        if (record.kind != CaptureRecordKind::INPUT) {
+            continue;
+        }
+        const auto found = lastCommands.find(record.interface_number);
+        MCU_MESSAGE_VIEW message;
+        if (found == lastCommands.end() ||
+            McuDecoder::decode(record.data, record.length, message) != McuDecoder::Status::OK) {
+            continue;
+        }
+        const LastCommand &command = found->second;
+        if (command.text) {
+            probeReplies.emplace(record.interface_number,
+                                 std::vector<uint8_t>(record.data, record.data + record.length));
+        } else if (message.sequence == command.sequence && message.msg_id == command.msgId) {
+            replyPayloads.emplace(std::make_pair(record.interface_number, message.msg_id),
+                                  std::vector<uint8_t>(message.payload, message.payload + message.payload_length));
+        }
+    }
+}
+
+std::vector<HID_DEVICE_ENTRY> ReplayTransport::enumerate(const uint16_t vendorId) {
+    std::vector<HID_DEVICE_ENTRY> entries;
+    for (const auto &entry: capture.devices()) {
+        if (vendorId == 0 || entry.vendor_id == vendorId) {
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+std::shared_ptr<HidDeviceHandle> ReplayTransport::open(const std::string &path) {
+    for (const auto &entry: capture.devices()) {
+        if (entry.path == path) {
+            auto handle = std::make_shared<ReplayDeviceHandle>(*this, entry.interface_number);
+            handle->start();
+            return handle;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t ReplayTransport::replayTimeOf(const uint64_t recordedNs) {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    if (!started || recordedNs <= originRecordedNs) {
+        return startHostNs;
+    }
+    return startHostNs + static_cast<uint64_t>(static_cast<double>(recordedNs - originRecordedNs) /
+                                               replayConfig.speed);
+}
+
+uint64_t ReplayTransport::recordedTimeNow() {
+    std::lock_guard<std::mutex> lock(clockMutex);
+    if (!started) {
+        // 第一次打开接口时开始计时
+        started = true;
+        startHostNs = Utils::steadyNowNs();
+        originRecordedNs = capture.firstNs() + replayConfig.start_offset_ns;
+        return originRecordedNs;
+    }
+    if (replayConfig.speed <= 0) {
+        return originRecordedNs;
+    }
+    return originRecordedNs + static_cast<uint64_t>(static_cast<double>(Utils::steadyNowNs() - startHostNs) *
+                                                    replayConfig.speed);
+}
+
+bool ReplayTransport::replyTo(const int interfaceNumber, const uint8_t *command, const size_t length,
+                              CommandHelper::McuReport &out, size_t &outLength) const {
+    if (length == 0 || command[0] != MCU_REPORT_LAYOUT::HEAD_BYTE) {
+        return false;
+    }
+    if (!isStructuredCommand(command, length)) {
+        const auto probe = probeReplies.find(interfaceNumber);
+        if (probe == probeReplies.end()) {
+            return false;
+        }
+        outLength = std::min(probe->second.size(), out.size());
+        std::memcpy(out.data(), probe->second.data(), outLength);
+        return true;
+    }
+    const auto msgId = static_cast<uint16_t>(readLittleEndian(command, MCU_REPORT_LAYOUT::MSG_ID));
+    const auto found = replyPayloads.find(std::make_pair(interfaceNumber, msgId));
+    if (found == replyPayloads.end()) {
+        return false;
+    }
+    outLength = CommandHelper::encode(out, msgId, readLittleEndian(command, MCU_REPORT_LAYOUT::SEQUENCE),
+                                      found->second.data(), found->second.size());
+    return true;
+}
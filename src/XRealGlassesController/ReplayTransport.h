@@ -0,0 +1,94 @@
+//
+// Created by Norman Wang on 2025/5/16.
+//
+
+#ifndef REPLAYTRANSPORT_H
+#define REPLAYTRANSPORT_H
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "CaptureReader.h"
+#include "CommandHelper.h"
+#include "HidTransport.h"
+
+
+/**
+ * 回放录制文件的传输层
+ * 枚举结果来自录制文件,打开接口后按录制时的时间间隔把该接口读到的上报重新送出,
+ * 经过与真实设备完全相同的读取/解码/融合流程. 没有眼镜也能复现追踪和协议问题.
+ *
+ * 命令应答不按时间回放,而是在收到命令时立即应答: 按接口和msgId找到录制中的应答负载,用新命令的序号重新编码;
+ * "v"探测直接使用录制中该接口探测得到的应答. 录制中没有应答过的接口/命令不应答(与眼镜无响应相同).
+ *
+ * 环境变量:
+ *   XREAL_REPLAY=文件路径     - 使用回放(优先于XREAL_SIMULATE和XREAL_RECORD)
+ *   XREAL_REPLAY_SPEED       - 回放速度倍数(默认1为实时,0为尽快回放,由读取速度决定)
+ *   XREAL_REPLAY_START_MS    - 从录制开始后多少毫秒处开始回放(默认0)
+ */
+class ReplayTransport : public HidTransport {
+public:
+    struct Config {
+        double speed = 1.0;
+        uint64_t start_offset_ns = 0;
+    };
+
+    /**
+     * 使用默认配置(可被环境变量覆盖)
+     */
+    explicit ReplayTransport(const std::string &path);
+
+    ReplayTransport(const std::string &path, const Config &config);
+
+    [[nodiscard]] bool isOpen() const {
+        return capture.isOpen();
+    }
+
+    std::vector<HID_DEVICE_ENTRY> enumerate(uint16_t vendorId) override;
+
+    std::shared_ptr<HidDeviceHandle> open(const std::string &path) override;
+
+    [[nodiscard]] const Config &config() const {
+        return replayConfig;
+    }
+
+    [[nodiscard]] const CaptureReader &reader() const {
+        return capture;
+    }
+
+    /**
+     * 录制时间对应的回放时间(主机steady_clock),第一次打开接口时开始计时
+     */
+    uint64_t replayTimeOf(uint64_t recordedNs);
+
+    /**
+     * 当前回放到的录制时间
+     */
+    uint64_t recordedTimeNow();
+
+    /**
+     * 为一条命令生成应答
+     * @return - 是否有应答
+     */
+    bool replyTo(int interfaceNumber, const uint8_t *command, size_t length, CommandHelper::McuReport &out,
+                 size_t &outLength) const;
+
+private:
+    void indexReplies();
+
+    CaptureReader capture;
+    Config replayConfig;
+
+    std::mutex clockMutex;
+    bool started = false;
+    uint64_t startHostNs = 0;
+    uint64_t originRecordedNs = 0;
+
+    // (接口编号, msgId) -> 录制中的应答负载
+    std::map<std::pair<int, uint16_t>, std::vector<uint8_t>> replyPayloads;
+    // 接口编号 -> "v"探测的应答(原始报文)
+    std::map<int, std::vector<uint8_t>> probeReplies;
+};
+
+
+#endif //REPLAYTRANSPORT_H
@@ -0,0 +1,138 @@
+//
+// Created by Norman Wang on 2025/5/6.
+//
+
+#include "ReportRingBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+// 计算不小于n的2的幂
+static size_t roundUpToPowerOfTwo(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+ReportRingBuffer::ReportRingBuffer(const size_t capacity) {
+    const size_t actualCapacity = roundUpToPowerOfTwo(std::max<size_t>(capacity, 2));
+    slots = std::make_unique<Slot[]>(actualCapacity);
+    mask = actualCapacity - 1;
+}
+
+uint64_t ReportRingBuffer::push(const uint8_t *data, size_t length, const uint64_t receivedAtNs) {
+    const uint64_t sequence = nextSequence++;
+    Slot &slot = slots[sequence & mask];
+
+    // 先在栈上组好,槽位处于写入中的时间只是一次分段拷贝
+    HID_REPORT report;
+    length = std::min(length, HID_REPORT::MAX_SIZE);
+    report.sequence = sequence;
+    report.received_at_ns = receivedAtNs;
+    report.length = static_cast<uint16_t>(length);
+    std::memcpy(report.data, data, length);
+
+    // 先标记为写入中,读者看到这个标记或者前后序号不一致都会放弃这次读取
+    slot.sequence.store(WRITING, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.report.store(report);
+
+    slot.sequence.store(sequence, std::memory_order_release);
+    head.store(sequence, std::memory_order_release);
+    return sequence;
+}
+
+ReportRingBuffer::ReadStatus ReportRingBuffer::read(const uint64_t sequence, HID_REPORT &out) const {
+    if (sequence == 0) {
+        return ReadStatus::NOT_YET;
+    }
+    const Slot &slot = slots[sequence & mask];
+
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before == WRITING) {
+        // 正在写入的是 head+1, 如果它正好落在我们要读的槽位上,说明我们要的数据已被覆盖
+        return sequence > head.load(std::memory_order_acquire) ? ReadStatus::NOT_YET : ReadStatus::OVERWRITTEN;
+    }
+    if (before < sequence) {
+        return ReadStatus::NOT_YET;
+    }
+    if (before > sequence) {
+        return ReadStatus::OVERWRITTEN;
+    }
+
+    slot.report.load(out);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // 拷贝期间槽位被改写则数据不可信
+    const uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+    return after == before ? ReadStatus::OK : ReadStatus::OVERWRITTEN;
+}
+
+bool ReportRingBuffer::latest(HID_REPORT &out) const {
+    // 生产者极快时最新槽位可能在读取过程中被覆盖,重新取一次head即可
+    for (int attempt = 0; attempt < 4; attempt++) {
+        const uint64_t sequence = head.load(std::memory_order_acquire);
+        if (sequence == 0) {
+            return false;
+        }
+        if (read(sequence, out) == ReadStatus::OK) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReportRingBuffer::next(Cursor &cursor, HID_REPORT &out) const {
+    for (int attempt = 0; attempt < 4; attempt++) {
+        const uint64_t newest = head.load(std::memory_order_acquire);
+        if (cursor.next > newest) {
+            return false;
+        }
+
+        // 游标已经落后于最旧的可用数据,跳过被覆盖的部分
+        const uint64_t oldest = newest > mask ? newest - mask : 1;
+        if (cursor.next < oldest) {
+            cursor.dropped += oldest - cursor.next;
+            cursor.next = oldest;
+        }
+
+        switch (read(cursor.next, out)) {
+            case ReadStatus::OK:
+                cursor.next++;
+                return true;
+            case ReadStatus::NOT_YET:
+                return false;
+            case ReadStatus::OVERWRITTEN:
+                break;
+        }
+    }
+    return false;
+}
+
+ReportRingBuffer::Cursor ReportRingBuffer::cursorAtEnd() const {
+    Cursor cursor;
+    cursor.next = head.load(std::memory_order_acquire) + 1;
+    return cursor;
+}
+
+size_t ReportRingBuffer::snapshot(std::vector<HID_REPORT> &out, const size_t maxCount) const {
+    out.clear();
+    const uint64_t newest = head.load(std::memory_order_acquire);
+    if (newest == 0 || maxCount == 0) {
+        return 0;
+    }
+
+    const uint64_t count = std::min<uint64_t>({newest, maxCount, mask + 1});
+    out.reserve(count);
+
+    HID_REPORT report;
+    for (uint64_t sequence = newest - count + 1; sequence <= newest; sequence++) {
+        // 被覆盖的条目直接跳过,快照里只保留一致的数据
+        if (read(sequence, report) == ReadStatus::OK) {
+            out.push_back(report);
+        }
+    }
+    return out.size();
+}
@@ -0,0 +1,123 @@
+//
+// Created by Norman Wang on 2025/5/6.
+//
+
+#ifndef REPORTRINGBUFFER_H
+#define REPORTRINGBUFFER_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AtomicWords.h"
+#include "HID_REPORT.h"
+
+
+/**
+ * HID上报的无锁环形缓冲区(单生产者/多消费者)
+ * 生产者是接口的读取线程,每个槽位用序号做seqlock(数据与SeqLock一样存放在AtomicWords中),
+ * 消费者不加锁读取,读到一半被覆盖时会自动重试或者报告丢失.
+ * 容量在构造时一次性分配,之后写入不会再有任何堆分配.
+ */
+class ReportRingBuffer {
+public:
+    // 读取结果
+    enum class ReadStatus {
+        OK,           // 读到了完整一致的数据
+        NOT_YET,      // 该序号的数据还没有写入
+        OVERWRITTEN   // 该序号的数据已被新数据覆盖
+    };
+
+    /**
+     * 基于游标的顺序读取位置,每个消费者各自持有一个
+     */
+    struct Cursor {
+        //下一条要读的序号
+        uint64_t next = 1;
+        //因读取太慢而被覆盖掉(跳过)的条数
+        uint64_t dropped = 0;
+    };
+
+    /**
+     * @param capacity - 槽位数量,会向上取整为2的幂
+     */
+    explicit ReportRingBuffer(size_t capacity = 128);
+
+    ReportRingBuffer(const ReportRingBuffer&) = delete;
+    ReportRingBuffer& operator=(const ReportRingBuffer&) = delete;
+
+    /**
+     * 写入一条上报(只能由单一生产者线程调用)
+     * @param data - 原始数据
+     * @param length - 数据长度,超过64字节的部分被截断
+     * @param receivedAtNs - 接收时间(steady_clock纳秒)
+     * @return - 分配给这条上报的序号
+     */
+    uint64_t push(const uint8_t *data, size_t length, uint64_t receivedAtNs);
+
+    /**
+     * 按序号读取一条上报
+     * @param sequence - 要读取的序号
+     * @param out - 输出
+     * @return - 读取结果
+     */
+    ReadStatus read(uint64_t sequence, HID_REPORT &out) const;
+
+    /**
+     * 读取最新的一条上报
+     * @param out - 输出
+     * @return - 是否读到
+     */
+    bool latest(HID_REPORT &out) const;
+
+    /**
+     * 按游标读取下一条上报,游标落后太多时跳到最旧的可用数据并累计丢失数
+     * @param cursor - 消费者自己的游标
+     * @param out - 输出
+     * @return - 是否读到(没有新数据时返回false)
+     */
+    bool next(Cursor &cursor, HID_REPORT &out) const;
+
+    /**
+     * 创建一个从"当前最新数据之后"开始读取的游标
+     */
+    Cursor cursorAtEnd() const;
+
+    /**
+     * 获取最近若干条上报的一致快照(按序号从旧到新)
+     * @param out - 输出列表(会先清空)
+     * @param maxCount - 最多取多少条
+     * @return - 实际取到的条数
+     */
+    size_t snapshot(std::vector<HID_REPORT> &out, size_t maxCount) const;
+
+    /**
+     * 最近一次写入的序号,0表示还没有任何数据
+     */
+    uint64_t lastSequence() const {
+        return head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    // 写入过程中的槽位标记
+    static constexpr uint64_t WRITING = UINT64_MAX;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};
+        AtomicWords<HID_REPORT> report;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    // 生产者私有的下一个序号
+    uint64_t nextSequence = 1;
+    // 最近一次发布的序号
+    std::atomic<uint64_t> head{0};
+};
+
+
+#endif //REPORTRINGBUFFER_H
@@ -0,0 +1,92 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#include "RotatingLogFile.h"
+
+#include <chrono>
+#include <ctime>
+
+#include "Utils.h"
+
+static const char *levelName(const LogLevel level) {
+    switch (level) {
+        case LogLevel::INFO:
+            return "INFO";
+        case LogLevel::SUCCESS:
+            return "SUCCESS";
+        case LogLevel::WARNING:
+            return "WARNING";
+        case LogLevel::ERROR:
+            return "ERROR";
+    }
+    return "";
+}
+
+RotatingLogFile::RotatingLogFile(const std::string &path, const size_t maxBytes, const int keepFiles)
+    : filePath(path), maxBytes(maxBytes), keepFiles(keepFiles) {
+    const int64_t wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    wallOffsetNs = wallNs - static_cast<int64_t>(Utils::steadyNowNs());
+    open();
+}
+
+RotatingLogFile::~RotatingLogFile() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+void RotatingLogFile::write(const LogLevel level, const uint64_t timeNs, const std::string &message) {
+    if (!file) {
+        return;
+    }
+    const int64_t wallNs = static_cast<int64_t>(timeNs) + wallOffsetNs;
+    const std::time_t seconds = static_cast<std::time_t>(wallNs / 1000000000);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+    char prefix[64];
+    const size_t prefixLength = std::strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+    const int written = std::fprintf(file, "%.*s.%03d [%s] %s\n", static_cast<int>(prefixLength), prefix,
+                                     static_cast<int>(wallNs / 1000000 % 1000), levelName(level), message.c_str());
+    if (written > 0) {
+        bytes += static_cast<size_t>(written);
+    }
+    if (bytes >= maxBytes) {
+        rotate();
+    }
+}
+
+void RotatingLogFile::flush() {
+    if (file) {
+        std::fflush(file);
+    }
+}
+
+void RotatingLogFile::open() {
+    file = std::fopen(filePath.c_str(), "a");
+    if (!file) {
+        std::fprintf(stderr, "[ERROR] 无法打开日志文件: %s\n", filePath.c_str());
+        return;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    bytes = size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+void RotatingLogFile::rotate() {
+    std::fclose(file);
+    file = nullptr;
+    // path.(n-1) -> path.n ... path -> path.1, 最旧的一个被覆盖
+    for (int index = keepFiles - 1; index >= 1; index--) {
+        const std::string from = filePath + "." + std::to_string(index);
+        const std::string to = filePath + "." + std::to_string(index + 1);
+        std::rename(from.c_str(), to.c_str());
+    }
+    if (keepFiles > 0) {
+        std::rename(filePath.c_str(), (filePath + ".1").c_str());
+    } else {
+        std::remove(filePath.c_str());
+    }
+    open();
+}
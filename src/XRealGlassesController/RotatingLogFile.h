@@ -0,0 +1,60 @@
+//
+// Created by Norman Wang on 2025/5/20.
+//
+
+#ifndef ROTATINGLOGFILE_H
+#define ROTATINGLOGFILE_H
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "LOG_LEVEL.h"
+
+
+/**
+ * 滚动日志文件
+ * 文件超过大小上限时依次改名为path.1, path.2 ...(只保留keepFiles个),再重新打开path.
+ * 每行带本地时间和级别,只在日志后台线程中使用,不加锁.
+ */
+class RotatingLogFile {
+public:
+    RotatingLogFile(const std::string &path, size_t maxBytes, int keepFiles);
+
+    ~RotatingLogFile();
+
+    RotatingLogFile(const RotatingLogFile&) = delete;
+    RotatingLogFile& operator=(const RotatingLogFile&) = delete;
+
+    bool isOpen() const {
+        return file != nullptr;
+    }
+
+    /**
+     * 写一行日志
+     * @param level - 日志级别
+     * @param timeNs - 写日志时的时间(steady_clock, 纳秒)
+     * @param message - 日志消息
+     */
+    void write(LogLevel level, uint64_t timeNs, const std::string &message);
+
+    /**
+     * 把缓冲的内容写到文件(每批日志之后调用一次)
+     */
+    void flush();
+
+private:
+    std::string filePath;
+    size_t maxBytes;
+    int keepFiles;
+    FILE *file = nullptr;
+    size_t bytes = 0;
+    //system_clock与steady_clock之差,用于把日志时间换算为本地时间
+    int64_t wallOffsetNs = 0;
+
+    void open();
+
+    void rotate();
+};
+
+
+#endif //ROTATINGLOGFILE_H
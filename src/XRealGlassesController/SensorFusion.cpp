@@ -0,0 +1,169 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#include "SensorFusion.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "Float4.h"
+#include "Logger.h"
+
+// 两条样本之间允许积分的最长时间,超过(丢包/设备重启)时只积分这么长
+static constexpr float MAX_STEP_SECONDS = 0.05f;
+
+SensorFusion::Config SensorFusion::defaultConfig() {
+    Config config;
+    if (const char *algorithm = std::getenv("XREAL_FUSION")) {
+        if (std::strcmp(algorithm, "mahony") == 0) {
+            config.algorithm = Algorithm::MAHONY;
+        } else if (std::strcmp(algorithm, "madgwick") == 0) {
+            config.algorithm = Algorithm::MADGWICK;
+        } else {
+            Logger::warning("未知的融合算法: %s", algorithm);
+        }
+    }
+    if (const char *path = std::getenv("XREAL_FUSION_PATH")) {
+        if (std::strcmp(path, "scalar") == 0) {
+            config.path = Path::SCALAR;
+        } else if (std::strcmp(path, "simd") == 0) {
+            config.path = Path::SIMD;
+        } else {
+            Logger::warning("未知的融合实现: %s", path);
+        }
+    }
+    return config;
+}
+
+SensorFusion::SensorFusion(const Config &config) : config(config) {
+}
+
+const ORIENTATION &SensorFusion::update(const IMU_SAMPLE *samples, const size_t count, const uint64_t firstSequence) {
+    if (count == 0) {
+        return current;
+    }
+    if (config.path == Path::SIMD) {
+        run<Float4Simd>(samples, count);
+    } else {
+        run<Float4Scalar>(samples, count);
+    }
+    if (firstSequence != 0) {
+        current.sample_sequence = firstSequence + count - 1;
+    }
+    return current;
+}
+
+void SensorFusion::setAlgorithm(const Algorithm algorithm) {
+    if (algorithm == config.algorithm) {
+        return;
+    }
+    config.algorithm = algorithm;
+    std::memset(integralError, 0, sizeof(integralError));
+}
+
+void SensorFusion::reset() {
+    current = ORIENTATION{};
+    initialized = false;
+    std::memset(integralError, 0, sizeof(integralError));
+}
+
+const char *SensorFusion::name(const Algorithm algorithm) {
+    return algorithm == Algorithm::MAHONY ? "mahony" : "madgwick";
+}
+
+const char *SensorFusion::name(const Path path) {
+    return path == Path::SIMD ? FLOAT4_SIMD_NAME : "scalar";
+}
+
+/**
+ * 按加速度计(重力方向)得到初始朝向,偏航角为0
+ */
+static void orientationFromGravity(const float (&accel)[3], float (&quaternion)[4]) {
+    const float roll = std::atan2(accel[1], accel[2]);
+    const float pitch = std::atan2(-accel[0], std::sqrt(accel[1] * accel[1] + accel[2] * accel[2]));
+    const float cr = std::cos(roll * 0.5f), sr = std::sin(roll * 0.5f);
+    const float cp = std::cos(pitch * 0.5f), sp = std::sin(pitch * 0.5f);
+    quaternion[0] = cr * cp;
+    quaternion[1] = sr * cp;
+    quaternion[2] = cr * sp;
+    quaternion[3] = -sr * sp;
+}
+
+template<typename V>
+void SensorFusion::run(const IMU_SAMPLE *samples, const size_t count) {
+    V q = V::load(current.quaternion);
+    V integral = V::load(integralError);
+
+    for (size_t i = 0; i < count; i++) {
+        const IMU_SAMPLE &sample = samples[i];
+        const uint64_t previousNs = current.device_timestamp_ns;
+        current.device_timestamp_ns = sample.device_timestamp_ns;
+        current.received_at_ns = sample.received_at_ns;
+        current.host_timestamp_ns = sample.received_at_ns;
+        current.angular_velocity[0] = sample.gyro[0];
+        current.angular_velocity[1] = sample.gyro[1];
+        current.angular_velocity[2] = sample.gyro[2];
+
+        if (!initialized) {
+            if (sample.accel[0] == 0 && sample.accel[1] == 0 && sample.accel[2] == 0) {
+                continue;
+            }
+            orientationFromGravity(sample.accel, current.quaternion);
+            q = V::load(current.quaternion);
+            initialized = true;
+            continue;
+        }
+        if (sample.device_timestamp_ns <= previousNs) {
+            continue;
+        }
+        const float dt = std::fmin(static_cast<float>(sample.device_timestamp_ns - previousNs) * 1e-9f,
+                                   MAX_STEP_SECONDS);
+
+        V gyro = V::set(0, sample.gyro[0], sample.gyro[1], sample.gyro[2]);
+        const V accel = V::set(0, sample.accel[0], sample.accel[1], sample.accel[2]);
+        const bool accelValid = dot(accel, accel) > 0;
+
+        if (config.algorithm == Algorithm::MADGWICK) {
+            // 陀螺仪积分的变化率
+            V qDot = quaternionMultiply(q, gyro) * 0.5f;
+            if (accelValid) {
+                const V a = normalize(accel);
+                const float q0 = q.template lane<0>(), q1 = q.template lane<1>();
+                const float q2 = q.template lane<2>(), q3 = q.template lane<3>();
+                // 目标函数: 当前朝向推算的重力方向 - 测得的重力方向
+                const float f1 = 2.0f * (q1 * q3 - q0 * q2) - a.template lane<1>();
+                const float f2 = 2.0f * (q0 * q1 + q2 * q3) - a.template lane<2>();
+                const float f3 = 1.0f - 2.0f * (q1 * q1 + q2 * q2) - a.template lane<3>();
+                // 梯度 = 雅可比矩阵的转置 × 目标函数,雅可比的三行都是q的重排
+                const V j1 = q.template shuffle<2, 3, 0, 1>() * V::set(-2, 2, -2, 2);
+                const V j2 = q.template shuffle<1, 0, 3, 2>() * 2.0f;
+                const V j3 = q * V::set(0, -4, -4, 0);
+                const V gradient = normalize(j1 * f1 + j2 * f2 + j3 * f3);
+                qDot = qDot - gradient * config.beta;
+            }
+            q = normalize(q + qDot * dt);
+        } else {
+            if (accelValid) {
+                const V a = normalize(accel);
+                const float q0 = q.template lane<0>(), q1 = q.template lane<1>();
+                const float q2 = q.template lane<2>(), q3 = q.template lane<3>();
+                // 当前朝向推算的重力方向,和测得的重力方向的叉积就是误差
+                const V gravity = V::set(0, 2.0f * (q1 * q3 - q0 * q2), 2.0f * (q0 * q1 + q2 * q3),
+                                         q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3);
+                const V error = cross3(a, gravity);
+                if (config.ki > 0) {
+                    integral = integral + error * (config.ki * dt);
+                    gyro = gyro + integral;
+                }
+                gyro = gyro + error * config.kp;
+            }
+            q = normalize(q + quaternionMultiply(q, gyro) * (0.5f * dt));
+        }
+    }
+
+    q.store(current.quaternion);
+    integral.store(integralError);
+}
+
@@ -0,0 +1,112 @@
+//
+// Created by Norman Wang on 2025/5/12.
+//
+
+#ifndef SENSORFUSION_H
+#define SENSORFUSION_H
+#include <cstddef>
+#include <cstdint>
+
+#include "IMU_SAMPLE.h"
+#include "ORIENTATION.h"
+
+
+/**
+ * 姿态融合引擎
+ * 把陀螺仪和加速度计融合成头部朝向,可在运行时选择算法:
+ *   MADGWICK - 梯度下降修正,参数beta
+ *   MAHONY   - 互补滤波(PI控制),参数kp/ki
+ * 四元数运算写成Float4模板,同时实例化了标量和SIMD(SSE/NEON)两种实现,默认使用SIMD.
+ * 磁力计没有参与融合(出厂未校准,偏航漂移由陀螺仪零偏校准来处理).
+ *
+ * 可以用环境变量覆盖默认配置(用于对比测量):
+ *   XREAL_FUSION       - madgwick/mahony
+ *   XREAL_FUSION_PATH  - scalar/simd
+ *
+ * 不是线程安全的,同一个实例只能在一个线程中使用.
+ */
+class SensorFusion {
+public:
+    enum class Algorithm {
+        MADGWICK,
+        MAHONY
+    };
+
+    // 四元数运算的实现
+    enum class Path {
+        SCALAR,
+        SIMD
+    };
+
+    struct Config {
+        Algorithm algorithm = Algorithm::MADGWICK;
+        Path path = Path::SIMD;
+        //Madgwick的修正增益
+        float beta = 0.05f;
+        //Mahony的比例/积分增益
+        float kp = 1.0f;
+        float ki = 0.0f;
+    };
+
+    /**
+     * 默认配置(可被环境变量覆盖)
+     */
+    static Config defaultConfig();
+
+    explicit SensorFusion(const Config &config = defaultConfig());
+
+    /**
+     * 融合一批样本(按设备时间戳顺序)
+     * @param samples - 样本数组
+     * @param count - 样本数
+     * @param firstSequence - 第一条样本在ImuSampleBuffer中的序号(用于输出,可为0)
+     * @return - 融合最后一条样本后的朝向
+     */
+    const ORIENTATION &update(const IMU_SAMPLE *samples, size_t count, uint64_t firstSequence = 0);
+
+    /**
+     * 当前朝向
+     */
+    [[nodiscard]] const ORIENTATION &orientation() const {
+        return current;
+    }
+
+    /**
+     * 切换算法,保留当前朝向
+     */
+    void setAlgorithm(Algorithm algorithm);
+
+    void setPath(Path path) {
+        config.path = path;
+    }
+
+    [[nodiscard]] Algorithm algorithm() const {
+        return config.algorithm;
+    }
+
+    [[nodiscard]] Path path() const {
+        return config.path;
+    }
+
+    /**
+     * 清除朝向,下一条样本按加速度计重新初始化
+     */
+    void reset();
+
+    static const char *name(Algorithm algorithm);
+
+    static const char *name(Path path);
+
+private:
+    template<typename V>
+    void run(const IMU_SAMPLE *samples, size_t count);
+
+    Config config;
+    ORIENTATION current;
+    bool initialized = false;
+    // Mahony的积分项(w分量始终为0)
+    float integralError[4] = {0, 0, 0, 0};
+};
+
+
+#endif //SENSORFUSION_H
@@ -0,0 +1,84 @@
+//
+// Created by Norman Wang on 2025/5/15.
+//
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "AtomicWords.h"
+
+
+/**
+ * 只保留最新值的无锁发布槽(顺序锁)
+ * 一个线程写入,任意多个线程读取一致的拷贝: 写入前后各把序号加1(写入过程中序号为奇数),
+ * 读取时在拷贝前后检查序号,序号为奇数或前后不同说明读到一半被覆盖了,重新读.
+ * 写入方从不等待读取方,读取方之间也互不影响,适合融合线程发布最新姿态、渲染/网页桥接等随时读取.
+ *
+ * 数据存放在AtomicWords中(按8字节分段的relaxed原子读写),避免并发拷贝在C++内存模型下成为数据竞争.
+ * T必须可以按字节拷贝.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock只能存放可以按字节拷贝的类型");
+
+public:
+    SeqLock() {
+        store(T());
+    }
+
+    /**
+     * 写入新值(只能在一个线程中调用)
+     */
+    void store(const T &value) {
+        const uint64_t sequence = version.load(std::memory_order_relaxed);
+        version.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        data.store(value);
+        version.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * 读取一致的拷贝(任意线程)
+     * @return - 写入的次数,0表示还没有写入过(out为默认值)
+     */
+    uint64_t load(T &out) const {
+        uint64_t before;
+        while (true) {
+            before = version.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            data.load(out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        // 构造函数中的写入不算
+        return before / 2 - 1;
+    }
+
+    T load() const {
+        T value;
+        load(value);
+        return value;
+    }
+
+    /**
+     * 写入的次数(不读取数据)
+     */
+    [[nodiscard]] uint64_t writes() const {
+        return version.load(std::memory_order_acquire) / 2 - 1;
+    }
+
+private:
+    // 序号和数据各占一个缓存行,读取方轮询序号时不会与其他变量伪共享
+    alignas(64) std::atomic<uint64_t> version{0};
+    alignas(64) AtomicWords<T> data;
+};
+
+
+#endif //SEQLOCK_H
@@ -0,0 +1,430 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#include "SimulatedTransport.h"
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "CommandHelper.h"
+#include "DevicesHelper.h"
+#include "HidReactor.h"
+#include "INPUT_EVENT.h"
+#include "Utils.h"
+
+// 接口队列最多缓存的上报条数,超出时丢弃最旧的(与hidraw内核队列的行为类似)
+static constexpr size_t MAX_QUEUED_REPORTS = 256;
+static constexpr const char *PATH_PREFIX = "sim://";
+
+// 读取环境变量覆盖配置
+static double envOr(const char *name, const double fallback) {
+    const char *value = std::getenv(name);
+    return value ? std::atof(value) : fallback;
+}
+
+static void writeLE16(uint8_t *out, const uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+}
+
+static void writeLE32(uint8_t *out, const uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static void writeLE24(uint8_t *out, const int32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+}
+
+/**
+ * 模拟眼镜的一个接口
+ * 上报放在队列里,并用管道的可读状态通知等待者,因此可以和真实设备一样交给poll/epoll
+ */
+class SimulatedDeviceHandle : public HidDeviceHandle, public std::enable_shared_from_this<SimulatedDeviceHandle> {
+public:
+    SimulatedDeviceHandle(SimulatedTransport &transport, const int interfaceNumber)
+        : transport(transport), interfaceNumber(interfaceNumber) {
+        if (pipe(notifyPipe) == 0) {
+            for (const int fd: notifyPipe) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+        }
+    }
+
+    ~SimulatedDeviceHandle() override {
+        if (const uint64_t timerId = imuTimerId.load()) {
+            HidReactor::instance().cancelTimer(timerId);
+        }
+        if (const uint64_t timerId = buttonTimerId.load()) {
+            HidReactor::instance().cancelTimer(timerId);
+        }
+        for (const int fd: notifyPipe) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    /**
+     * IMU接口打开后开始按配置频率上报
+     */
+    void startImuStream() {
+        if (interfaceNumber != SimulatedTransport::IMU_INTERFACE || transport.config().imu_rate_hz <= 0) {
+            return;
+        }
+        imuPeriodNs = static_cast<uint64_t>(1e9 / transport.config().imu_rate_hz);
+        streamStartNs = Utils::steadyNowNs();
+        nextImuNs = streamStartNs + imuPeriodNs;
+        scheduleImu();
+    }
+
+    /**
+     * 命令接口打开后按配置的间隔模拟按键: 亮度+, 亮度-, 按住亮度+切换3D/2D,依次循环
+     */
+    void startButtonEvents() {
+        if (interfaceNumber != SimulatedTransport::CONTROL_INTERFACE || transport.config().button_period_ms <= 0) {
+            return;
+        }
+        buttonPeriodNs = static_cast<uint64_t>(transport.config().button_period_ms * 1e6);
+        buttonStartNs = Utils::steadyNowNs();
+        nextButtonNs = buttonStartNs + buttonPeriodNs;
+        scheduleButton();
+    }
+
+    int write(const uint8_t *data, const size_t length) override {
+        if (transport.nextWriteFails()) {
+            setError("模拟写入错误");
+            return -1;
+        }
+        if (interfaceNumber == SimulatedTransport::CONTROL_INTERFACE && length > 0 && data[0] == 0xFD) {
+            handleCommand(data, length);
+        }
+        return static_cast<int>(length);
+    }
+
+    int sendFeatureReport(const uint8_t *data, const size_t length) override {
+        return write(data, length);
+    }
+
+    int read(uint8_t *buffer, const size_t length, const int timeoutMs) override {
+        if (timeoutMs != 0) {
+            pollfd event{notifyPipe[0], POLLIN, 0};
+            if (poll(&event, 1, timeoutMs) <= 0) {
+                return 0;
+            }
+        }
+        std::array<uint8_t, 64> report{};
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (queue.empty()) {
+                return 0;
+            }
+            report = queue.front();
+            queue.pop_front();
+            uint8_t token;
+            (void) ::read(notifyPipe[0], &token, 1);
+        }
+        const size_t count = std::min(length, report.size());
+        std::memcpy(buffer, report.data(), count);
+        return static_cast<int>(count);
+    }
+
+    int pollFd() const override {
+        return notifyPipe[0];
+    }
+
+    std::string lastError() override {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return errorText;
+    }
+
+private:
+    void setError(const std::string &error) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        errorText = error;
+    }
+
+    void deliver(const std::array<uint8_t, 64> &report) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queue.size() >= MAX_QUEUED_REPORTS) {
+            // 队列满了丢弃最旧的一条,管道中的计数保持不变
+            queue.pop_front();
+            queue.push_back(report);
+            return;
+        }
+        queue.push_back(report);
+        const uint8_t token = 1;
+        (void) ::write(notifyPipe[1], &token, 1);
+    }
+
+    void handleCommand(const uint8_t *data, const size_t length) {
+        uint16_t msgId;
+        uint32_t sequence = 0;
+        uint8_t payload[42] = {0};
+        size_t payloadLength = 1;
+
+        if (length >= 17) {
+            sequence = data[7] | (data[8] << 8) | (data[9] << 16) | (static_cast<uint32_t>(data[10]) << 24);
+            msgId = static_cast<uint16_t>(data[15] | (data[16] << 8));
+            if (msgId == 0x0008 && length > 22) {
+                // 设置显示模式: 记下新模式,应答状态0表示成功
+                displayMode = data[22];
+            } else if (msgId == 0x0007) {
+                // 读取显示模式
+                payload[0] = displayMode;
+            }
+        } else {
+            // "v"探测: 以固件版本文本作答
+            msgId = 0x0026;
+            const char version[] = "SIM-1.0.0";
+            std::memcpy(payload, version, sizeof(version) - 1);
+            payloadLength = sizeof(version) - 1;
+        }
+
+        const int64_t delayUs = transport.nextReplyDelayUs();
+        if (delayUs < 0) {
+            return;
+        }
+        CommandHelper::McuReport reply;
+        CommandHelper::encode(reply, msgId, sequence, payload, payloadLength);
+        std::weak_ptr<SimulatedDeviceHandle> weakSelf = shared_from_this();
+        HidReactor::instance().scheduleAt(Utils::steadyNowNs() + static_cast<uint64_t>(delayUs) * 1000,
+                                          [weakSelf, reply]() {
+                                              if (const auto self = weakSelf.lock()) {
+                                                  self->deliver(reply);
+                                              }
+                                          });
+    }
+
+    void scheduleImu() {
+        std::weak_ptr<SimulatedDeviceHandle> weakSelf = shared_from_this();
+        imuTimerId = HidReactor::instance().scheduleAt(nextImuNs, [weakSelf]() {
+            if (const auto self = weakSelf.lock()) {
+                self->pumpImu();
+            }
+        });
+    }
+
+    void scheduleButton() {
+        std::weak_ptr<SimulatedDeviceHandle> weakSelf = shared_from_this();
+        buttonTimerId = HidReactor::instance().scheduleAt(nextButtonNs, [weakSelf]() {
+            if (const auto self = weakSelf.lock()) {
+                self->pressButton();
+                self->nextButtonNs += self->buttonPeriodNs;
+                self->scheduleButton();
+            }
+        });
+    }
+
+    void pressButton() {
+        uint8_t payload[MCU_EVENT_LAYOUT::VALUE.end()] = {0};
+        GlassesButton button;
+        GlassesAction action;
+        uint8_t value;
+        switch (buttonPresses++ % 3) {
+            case 0:
+                button = GlassesButton::BRIGHTNESS_UP;
+                action = GlassesAction::BRIGHTNESS_UP;
+                brightness = static_cast<uint8_t>(std::min(brightness + 1, 7));
+                value = brightness;
+                break;
+            case 1:
+                button = GlassesButton::BRIGHTNESS_DOWN;
+                action = GlassesAction::BRIGHTNESS_DOWN;
+                brightness = static_cast<uint8_t>(std::max(brightness - 1, 0));
+                value = brightness;
+                break;
+            default: {
+                const bool to3D = displayMode != MCU_EVENT_LAYOUT::DISPLAY_MODE_3D;
+                button = GlassesButton::BRIGHTNESS_UP;
+                action = to3D ? GlassesAction::MODE_3D : GlassesAction::MODE_2D;
+                displayMode = to3D ? MCU_EVENT_LAYOUT::DISPLAY_MODE_3D : MCU_EVENT_LAYOUT::DISPLAY_MODE_2D;
+                value = displayMode;
+                break;
+            }
+        }
+        payload[MCU_EVENT_LAYOUT::BUTTON.offset] = static_cast<uint8_t>(button);
+        payload[MCU_EVENT_LAYOUT::ACTION.offset] = static_cast<uint8_t>(action);
+        payload[MCU_EVENT_LAYOUT::VALUE.offset] = value;
+
+        // 设备时间按毫秒计
+        const auto deviceTime = static_cast<uint32_t>((Utils::steadyNowNs() - buttonStartNs) / 1000000);
+        CommandHelper::McuReport report;
+        CommandHelper::encode(report, static_cast<uint16_t>(McuMsgId::BUTTON_PRESSED), ++eventSequence, payload,
+                              sizeof(payload), deviceTime);
+        deliver(report);
+    }
+
+    // 补齐所有已到期的IMU样本,定时器精度不够时一次上报多条
+    void pumpImu() {
+        const uint64_t now = Utils::steadyNowNs();
+        while (nextImuNs <= now) {
+            if (!transport.nextImuDropped()) {
+                deliver(buildImuReport(nextImuNs));
+            }
+            nextImuNs += imuPeriodNs;
+        }
+        scheduleImu();
+    }
+
+    /**
+     * 合成一条IMU上报: 绕竖直轴(z轴,与重力同轴)缓慢来回转头,陀螺仪各轴叠加固定零偏,加速度计只有重力
+     * 设备时间戳默认直接使用主机的steady_clock,便于测量上报到消费的延迟;可以配置偏移和漂移来模拟独立的设备时钟
+     */
+    std::array<uint8_t, 64> buildImuReport(const uint64_t sampledAtNs) const {
+        constexpr uint16_t MULTIPLIER = 1;
+        constexpr uint32_t DIVISOR = 8192;
+        const SimulatedTransport::Config &config = transport.config();
+        const double t = static_cast<double>(sampledAtNs - streamStartNs) / 1e9;
+        const uint64_t timestampNs = sampledAtNs + static_cast<int64_t>(config.clock_offset_ms * 1e6) +
+                                     static_cast<int64_t>(t * config.clock_skew_ppm * 1e3);
+        const double yawRate = config.yaw_amplitude_dps * std::sin(2.0 * M_PI * 0.25 * t); // 度/秒
+        const auto bias = static_cast<int32_t>(config.gyro_bias_dps * DIVISOR);
+
+        std::array<uint8_t, 64> report{};
+        report[0] = 0x01;
+        report[1] = 0x02;
+        writeLE16(&report[2], static_cast<uint16_t>(static_cast<int16_t>((35.0 - 25.0) * 132.48)));
+        for (int i = 0; i < 8; i++) {
+            report[4 + i] = (timestampNs >> (8 * i)) & 0xFF;
+        }
+        writeLE16(&report[12], MULTIPLIER);
+        writeLE32(&report[14], DIVISOR);
+        writeLE24(&report[18], bias);
+        writeLE24(&report[21], bias);
+        writeLE24(&report[24], static_cast<int32_t>(yawRate * DIVISOR) + bias);
+        writeLE16(&report[27], MULTIPLIER);
+        writeLE32(&report[29], DIVISOR);
+        writeLE24(&report[33], 0);
+        writeLE24(&report[36], 0);
+        writeLE24(&report[39], static_cast<int32_t>(1.0 * DIVISOR));
+        writeLE16(&report[42], MULTIPLIER);
+        writeLE32(&report[44], 1024);
+        return report;
+    }
+
+    SimulatedTransport &transport;
+    const int interfaceNumber;
+    int notifyPipe[2] = {-1, -1};
+
+    mutable std::mutex queueMutex;
+    std::deque<std::array<uint8_t, 64>> queue;
+    std::string errorText;
+
+    // 命令线程和模拟按键的定时器都会修改
+    std::atomic<uint8_t> displayMode{MCU_EVENT_LAYOUT::DISPLAY_MODE_2D};
+    uint8_t brightness = 4;
+
+    std::atomic<uint64_t> buttonTimerId{0};
+    uint64_t buttonPeriodNs = 0;
+    uint64_t buttonStartNs = 0;
+    uint64_t nextButtonNs = 0;
+    uint64_t buttonPresses = 0;
+    uint32_t eventSequence = 0;
+
+    std::atomic<uint64_t> imuTimerId{0};
+    uint64_t imuPeriodNs = 0;
+    uint64_t streamStartNs = 0;
+    uint64_t nextImuNs = 0;
+};
+
+SimulatedTransport::SimulatedTransport() : random(std::random_device{}()) {
+    simulatorConfig.device_count = static_cast<int>(envOr("XREAL_SIM_DEVICES", simulatorConfig.device_count));
+    simulatorConfig.imu_rate_hz = envOr("XREAL_SIM_IMU_HZ", simulatorConfig.imu_rate_hz);
+    simulatorConfig.yaw_amplitude_dps = envOr("XREAL_SIM_YAW_DPS", simulatorConfig.yaw_amplitude_dps);
+    simulatorConfig.gyro_bias_dps = envOr("XREAL_SIM_GYRO_BIAS", simulatorConfig.gyro_bias_dps);
+    simulatorConfig.clock_offset_ms = envOr("XREAL_SIM_CLOCK_OFFSET_MS", simulatorConfig.clock_offset_ms);
+    simulatorConfig.clock_skew_ppm = envOr("XREAL_SIM_CLOCK_PPM", simulatorConfig.clock_skew_ppm);
+    simulatorConfig.imu_drop_rate = envOr("XREAL_SIM_IMU_DROP", simulatorConfig.imu_drop_rate);
+    simulatorConfig.button_period_ms = envOr("XREAL_SIM_BUTTON_MS", simulatorConfig.button_period_ms);
+    simulatorConfig.reply_latency_us = static_cast<uint32_t>(
+        envOr("XREAL_SIM_LATENCY_US", simulatorConfig.reply_latency_us));
+    simulatorConfig.latency_jitter_us = static_cast<uint32_t>(
+        envOr("XREAL_SIM_JITTER_US", simulatorConfig.latency_jitter_us));
+    simulatorConfig.drop_rate = envOr("XREAL_SIM_DROP", simulatorConfig.drop_rate);
+    simulatorConfig.error_rate = envOr("XREAL_SIM_ERROR", simulatorConfig.error_rate);
+}
+
+SimulatedTransport::SimulatedTransport(const Config &config) : simulatorConfig(config),
+                                                               random(std::random_device{}()) {
+}
+
+std::vector<HID_DEVICE_ENTRY> SimulatedTransport::enumerate(const uint16_t vendorId) {
+    std::vector<HID_DEVICE_ENTRY> entries;
+    if (vendorId != 0 && vendorId != DevicesHelper::XREAL_VID) {
+        return entries;
+    }
+    for (int device = 0; device < simulatorConfig.device_count; device++) {
+        char serial[32];
+        snprintf(serial, sizeof(serial), "SIMXREAL%04d", device);
+        for (int interfaceNumber = 3; interfaceNumber <= 6; interfaceNumber++) {
+            HID_DEVICE_ENTRY entry;
+            entry.path = std::string(PATH_PREFIX) + serial + "/" + std::to_string(interfaceNumber);
+            entry.vendor_id = DevicesHelper::XREAL_VID;
+            entry.product_id = PRODUCT_ID;
+            entry.serial_number = serial;
+            entry.manufacturer = "XREAL (simulated)";
+            entry.product = "XREAL Air (simulated)";
+            entry.interface_number = interfaceNumber;
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+std::shared_ptr<HidDeviceHandle> SimulatedTransport::open(const std::string &path) {
+    if (path.rfind(PATH_PREFIX, 0) != 0) {
+        return nullptr;
+    }
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos || slash + 1 >= path.size()) {
+        return nullptr;
+    }
+    const int interfaceNumber = std::atoi(path.c_str() + slash + 1);
+    auto handle = std::make_shared<SimulatedDeviceHandle>(*this, interfaceNumber);
+    handle->startImuStream();
+    handle->startButtonEvents();
+    return handle;
+}
+
+int64_t SimulatedTransport::nextReplyDelayUs() {
+    std::lock_guard<std::mutex> lock(randomMutex);
+    if (simulatorConfig.drop_rate > 0 && std::uniform_real_distribution<double>(0, 1)(random) <
+        simulatorConfig.drop_rate) {
+        return -1;
+    }
+    int64_t delay = simulatorConfig.reply_latency_us;
+    if (simulatorConfig.latency_jitter_us > 0) {
+        const auto jitter = static_cast<int64_t>(simulatorConfig.latency_jitter_us);
+        delay += std::uniform_int_distribution<int64_t>(-jitter, jitter)(random);
+    }
+    return std::max<int64_t>(delay, 0);
+}
+
+bool SimulatedTransport::nextWriteFails() {
+    if (simulatorConfig.error_rate <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(randomMutex);
+    return std::uniform_real_distribution<double>(0, 1)(random) < simulatorConfig.error_rate;
+}
+
+bool SimulatedTransport::nextImuDropped() {
+    if (simulatorConfig.imu_drop_rate <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(randomMutex);
+    return std::uniform_real_distribution<double>(0, 1)(random) < simulatorConfig.imu_drop_rate;
+}
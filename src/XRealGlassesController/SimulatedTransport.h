@@ -0,0 +1,94 @@
+//
+// Created by Norman Wang on 2025/5/9.
+//
+
+#ifndef SIMULATEDTRANSPORT_H
+#define SIMULATEDTRANSPORT_H
+#include <mutex>
+#include <random>
+
+#include "HidTransport.h"
+
+
+/**
+ * 进程内模拟的XREAL眼镜
+ * 模拟一副眼镜上的4个HID接口:
+ *   接口3 - IMU上报(按配置的频率持续上报合成的陀螺仪/加速度计/磁力计数据)
+ *   接口4 - 命令接口(对"v"和0xFD命令给出带正确CRC的0xFD应答,可以按配置模拟按键事件)
+ *   接口5/6 - 不上报也不应答
+ * 可以注入应答延迟/抖动、丢包和写入错误,用于在没有眼镜的机器上测量和回归测试整个控制流程.
+ *
+ * 配置也可以通过环境变量覆盖:
+ *   XREAL_SIM_DEVICES     - 模拟几副眼镜(默认1)
+ *   XREAL_SIM_IMU_HZ      - IMU上报频率(默认1000)
+ *   XREAL_SIM_YAW_DPS     - 来回转头的最大角速度(默认20度/秒,0为静止)
+ *   XREAL_SIM_GYRO_BIAS   - 陀螺仪各轴的零偏(默认0度/秒)
+ *   XREAL_SIM_CLOCK_OFFSET_MS - 设备时钟相对主机时钟的偏移(默认0毫秒)
+ *   XREAL_SIM_CLOCK_PPM   - 设备时钟相对主机时钟的漂移(默认0,百万分之一)
+ *   XREAL_SIM_IMU_DROP    - IMU上报丢失概率(0~1,设备时间戳照常前进)
+ *   XREAL_SIM_BUTTON_MS   - 每隔多少毫秒模拟一次按键(默认0不模拟),依次为亮度+/亮度-/按住亮度+切换3D/2D
+ *   XREAL_SIM_LATENCY_US  - 命令应答延迟(默认1500微秒)
+ *   XREAL_SIM_JITTER_US   - 应答延迟抖动(默认500微秒)
+ *   XREAL_SIM_DROP        - 应答丢失概率(0~1)
+ *   XREAL_SIM_ERROR       - 写入失败概率(0~1)
+ */
+class SimulatedTransport : public HidTransport {
+public:
+    struct Config {
+        int device_count = 1;
+        double imu_rate_hz = 1000.0;
+        double yaw_amplitude_dps = 20.0;
+        double gyro_bias_dps = 0.0;
+        double clock_offset_ms = 0.0;
+        double clock_skew_ppm = 0.0;
+        double imu_drop_rate = 0.0;
+        double button_period_ms = 0.0;
+        uint32_t reply_latency_us = 1500;
+        uint32_t latency_jitter_us = 500;
+        double drop_rate = 0.0;
+        double error_rate = 0.0;
+    };
+
+    // 模拟眼镜的VID/PID和各接口编号
+    static constexpr uint16_t PRODUCT_ID = 0x0424;
+    static constexpr int IMU_INTERFACE = 3;
+    static constexpr int CONTROL_INTERFACE = 4;
+
+    /**
+     * 使用默认配置(可被环境变量覆盖)
+     */
+    SimulatedTransport();
+
+    explicit SimulatedTransport(const Config &config);
+
+    std::vector<HID_DEVICE_ENTRY> enumerate(uint16_t vendorId) override;
+
+    std::shared_ptr<HidDeviceHandle> open(const std::string &path) override;
+
+    const Config &config() const {
+        return simulatorConfig;
+    }
+
+    /**
+     * 按配置生成一次应答延迟(微秒),返回-1表示这次应答应被丢弃
+     */
+    int64_t nextReplyDelayUs();
+
+    /**
+     * 按配置判断这次写入是否应该失败
+     */
+    bool nextWriteFails();
+
+    /**
+     * 按配置判断这条IMU上报是否应该丢失
+     */
+    bool nextImuDropped();
+
+private:
+    Config simulatorConfig;
+    std::mutex randomMutex;
+    std::mt19937 random;
+};
+
+
+#endif //SIMULATEDTRANSPORT_H
@@ -0,0 +1,164 @@
+//
+// Created by Norman Wang on 2025/5/18.
+//
+
+#include "StreamHealth.h"
+
+#include <cstdio>
+
+#include "Utils.h"
+
+static constexpr uint64_t NS_PER_SECOND = 1000000000ull;
+// 序号跳过超过这个数时认为是眼镜重新开始编号,不算丢失
+static constexpr uint32_t MAX_SEQUENCE_GAP = 1000;
+
+/**
+ * 眼镜主动上报的报文,序号由眼镜逐条递增;命令应答的序号是命令里带的,不参与统计
+ */
+static bool isUnsolicited(const McuMessageKind kind) {
+    switch (kind) {
+        case McuMessageKind::BUTTON_EVENT:
+        case McuMessageKind::DISPLAY_TOGGLED:
+        case McuMessageKind::HEARTBEAT:
+        case McuMessageKind::TEXT_LOG:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void StreamHealth::onReport(const uint64_t receivedAtNs) {
+    bump(reports);
+    const uint64_t previous = lastReportNs.load(std::memory_order_relaxed);
+    if (previous == 0) {
+        firstReportNs.store(receivedAtNs, std::memory_order_relaxed);
+    } else if (receivedAtNs >= previous) {
+        arrival.record(receivedAtNs - previous);
+    }
+    lastReportNs.store(receivedAtNs, std::memory_order_relaxed);
+
+    const uint64_t second = receivedAtNs / NS_PER_SECOND;
+    RateSlot &slot = rateSlots[second % RATE_SLOTS];
+    if (slot.second.load(std::memory_order_relaxed) != second) {
+        slot.count.store(0, std::memory_order_relaxed);
+        slot.second.store(second, std::memory_order_release);
+    }
+    bump(slot.count);
+}
+
+void StreamHealth::onImu(const uint64_t deviceTimestampNs) {
+    bump(imuReports);
+    const uint64_t previous = lastDeviceTimestampNs;
+    lastDeviceTimestampNs = deviceTimestampNs;
+    if (previous == 0) {
+        return;
+    }
+    if (deviceTimestampNs <= previous) {
+        bump(timestampRegressions);
+        imuPeriodNs = 0;
+        return;
+    }
+
+    // 与ImuSampleBuffer相同的规则: 间隔超过1.5个周期时按周期推算丢失条数,其余间隔用于平滑周期
+    const uint64_t interval = deviceTimestampNs - previous;
+    deviceInterval.record(interval);
+    if (imuPeriodNs == 0) {
+        imuPeriodNs = interval;
+    } else if (interval * 2 > imuPeriodNs * 3) {
+        bump(imuMissing, (interval + imuPeriodNs / 2) / imuPeriodNs - 1);
+        bump(imuGaps);
+    } else {
+        imuPeriodNs = imuPeriodNs - imuPeriodNs / 16 + interval / 16;
+    }
+}
+
+void StreamHealth::onMcu(const MCU_MESSAGE_VIEW &message) {
+    bump(mcuReports);
+    if (!isUnsolicited(message.kind)) {
+        return;
+    }
+    if (hasUnsolicitedSequence) {
+        const uint32_t step = message.sequence - lastUnsolicitedSequence;
+        if (step > 1 && step <= MAX_SEQUENCE_GAP) {
+            bump(sequenceMissing, step - 1);
+        }
+    }
+    hasUnsolicitedSequence = true;
+    lastUnsolicitedSequence = message.sequence;
+}
+
+StreamHealth::Snapshot StreamHealth::snapshot() const {
+    Snapshot result;
+    result.interface_number = interfaceNumber.load(std::memory_order_relaxed);
+    result.reports = reports.load(std::memory_order_relaxed);
+    result.imu_reports = imuReports.load(std::memory_order_relaxed);
+    result.mcu_reports = mcuReports.load(std::memory_order_relaxed);
+    result.crc_failures = crcFailures.load(std::memory_order_relaxed);
+    result.malformed = malformed.load(std::memory_order_relaxed);
+    result.read_errors = readErrors.load(std::memory_order_relaxed);
+    result.imu_missing = imuMissing.load(std::memory_order_relaxed);
+    result.imu_gaps = imuGaps.load(std::memory_order_relaxed);
+    result.timestamp_regressions = timestampRegressions.load(std::memory_order_relaxed);
+    result.sequence_missing = sequenceMissing.load(std::memory_order_relaxed);
+    result.arrival = arrival.snapshot();
+    result.device_interval = deviceInterval.snapshot();
+    result.handling = handling.snapshot();
+
+    const uint64_t nowNs = Utils::steadyNowNs();
+    const uint64_t lastNs = lastReportNs.load(std::memory_order_relaxed);
+    if (lastNs == 0) {
+        return result;
+    }
+    result.idle_ns = nowNs > lastNs ? nowNs - lastNs : 0;
+
+    // 只统计完整的秒: 不含当前这一秒,也不含收到第一条上报的那一秒
+    const uint64_t nowSecond = nowNs / NS_PER_SECOND;
+    const uint64_t firstSecond = firstReportNs.load(std::memory_order_relaxed) / NS_PER_SECOND;
+    uint64_t total = 0;
+    uint64_t seconds = 0;
+    for (uint64_t second = nowSecond - 1; second > firstSecond && seconds < RATE_WINDOW_SECONDS; second--) {
+        const RateSlot &slot = rateSlots[second % RATE_SLOTS];
+        const uint64_t count = slot.second.load(std::memory_order_acquire) == second
+                                   ? slot.count.load(std::memory_order_relaxed)
+                                   : 0;
+        if (seconds == 0) {
+            result.rate_1s_hz = static_cast<double>(count);
+        }
+        total += count;
+        seconds++;
+    }
+    if (seconds > 0) {
+        result.rate_window_hz = static_cast<double>(total) / static_cast<double>(seconds);
+    }
+    return result;
+}
+
+/**
+ * 直方图的 p50/p99/最大值(微秒)
+ */
+static std::string describe(const LatencyHistogram::Snapshot &histogram) {
+    char text[96];
+    snprintf(text, sizeof(text), "%.1f/%.1f/%.1fus", static_cast<double>(histogram.percentile(0.5)) / 1e3,
+             static_cast<double>(histogram.percentile(0.99)) / 1e3, static_cast<double>(histogram.max_ns) / 1e3);
+    return text;
+}
+
+std::string StreamHealth::Snapshot::summary() const {
+    char text[256];
+    snprintf(text, sizeof(text),
+             "接口 %d: 上报 %llu (IMU %llu, 0xFD %llu), 频率 %.0fHz(1s) %.0fHz(%llus), IMU丢失 %llu(%llu次), "
+             "序号跳过 %llu, CRC错误 %llu, 格式错误 %llu, 读取失败 %llu",
+             interface_number, static_cast<unsigned long long>(reports),
+             static_cast<unsigned long long>(imu_reports), static_cast<unsigned long long>(mcu_reports),
+             rate_1s_hz, rate_window_hz, static_cast<unsigned long long>(RATE_WINDOW_SECONDS),
+             static_cast<unsigned long long>(imu_missing), static_cast<unsigned long long>(imu_gaps),
+             static_cast<unsigned long long>(sequence_missing), static_cast<unsigned long long>(crc_failures),
+             static_cast<unsigned long long>(malformed), static_cast<unsigned long long>(read_errors));
+    std::string result = text;
+    result += "; 到达间隔(p50/p99/max) " + describe(arrival);
+    if (device_interval.count > 0) {
+        result += ", 设备间隔 " + describe(device_interval);
+    }
+    result += ", 处理耗时 " + describe(handling);
+    return result;
+}
@@ -0,0 +1,159 @@
+//
+// Created by Norman Wang on 2025/5/18.
+//
+
+#ifndef STREAMHEALTH_H
+#define STREAMHEALTH_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "LatencyHistogram.h"
+#include "MCU_MESSAGE_VIEW.h"
+
+
+/**
+ * 单个接口上报流的健康统计
+ * 由读取线程在收到每条上报时更新(单一写入者,只有几次原子读写,不分配不加锁),任何线程都可以随时取快照.
+ *
+ *   丢失   - IMU按设备时间戳推算(间隔超过1.5个周期);眼镜主动上报的0xFD报文(心跳/按键等)按序号跳过的条数
+ *   抖动   - 主机收到相邻上报的间隔和IMU设备时间戳的间隔各一个直方图.
+ *            设备间隔平稳而到达间隔有尖峰,说明延迟来自USB/内核/读取线程的唤醒,而不是眼镜本身
+ *   处理   - 读取线程处理一条上报(解码/写入缓冲区/完成请求)的耗时直方图
+ *   频率   - 按主机时间每秒一个计数槽,给出最近1秒和最近10秒的平均频率
+ *   错误   - CRC错误/其他格式错误/读取失败的次数
+ *
+ * 消费者一侧的延迟(样本写入后多久被读走)由消费者自己统计,见HeadTracker::latency().
+ */
+class StreamHealth {
+public:
+    // 频率的滑动窗口(秒)
+    static constexpr uint64_t RATE_WINDOW_SECONDS = 10;
+
+    struct Snapshot {
+        int interface_number = -1;
+        uint64_t reports = 0;
+        uint64_t imu_reports = 0;
+        uint64_t mcu_reports = 0;
+        uint64_t crc_failures = 0;
+        //CRC以外的格式错误(截断/长度错误/无法解码的IMU上报)
+        uint64_t malformed = 0;
+        uint64_t read_errors = 0;
+        //按设备时间戳推算丢失的IMU样本数,以及发生丢失的次数
+        uint64_t imu_missing = 0;
+        uint64_t imu_gaps = 0;
+        //设备时间戳倒退的次数(设备重启/时钟复位)
+        uint64_t timestamp_regressions = 0;
+        //眼镜主动上报的0xFD报文按序号推算丢失的条数
+        uint64_t sequence_missing = 0;
+        //最近1秒/最近10秒(不足10秒时为已有的整秒数)的平均上报频率
+        double rate_1s_hz = 0;
+        double rate_window_hz = 0;
+        //最近一条上报距取快照时多久,还没有上报时为0
+        uint64_t idle_ns = 0;
+        //主机收到相邻两条上报的间隔
+        LatencyHistogram::Snapshot arrival;
+        //相邻两条IMU样本的设备时间戳间隔
+        LatencyHistogram::Snapshot device_interval;
+        //读取线程处理一条上报的耗时
+        LatencyHistogram::Snapshot handling;
+
+        /**
+         * 一行摘要,用于日志
+         */
+        [[nodiscard]] std::string summary() const;
+    };
+
+    StreamHealth() = default;
+
+    StreamHealth(const StreamHealth&) = delete;
+    StreamHealth& operator=(const StreamHealth&) = delete;
+
+    void setInterfaceNumber(const int number) {
+        interfaceNumber.store(number, std::memory_order_relaxed);
+    }
+
+    /**
+     * 收到一条上报(在解码之前调用)
+     */
+    void onReport(uint64_t receivedAtNs);
+
+    /**
+     * 一条IMU上报解码成功
+     */
+    void onImu(uint64_t deviceTimestampNs);
+
+    /**
+     * 一条0xFD报文校验通过
+     */
+    void onMcu(const MCU_MESSAGE_VIEW &message);
+
+    void onCrcFailure() {
+        bump(crcFailures);
+    }
+
+    void onMalformed() {
+        bump(malformed);
+    }
+
+    void onReadError() {
+        bump(readErrors);
+    }
+
+    /**
+     * 一条上报处理完毕
+     * @param handlingNs - 从收到到处理完的耗时
+     */
+    void onHandled(const uint64_t handlingNs) {
+        handling.record(handlingNs);
+    }
+
+    [[nodiscard]] Snapshot snapshot() const;
+
+private:
+    static void bump(std::atomic<uint64_t> &value, const uint64_t amount = 1) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // 每秒一个计数槽,second为该槽当前对应的主机时间(秒)
+    struct RateSlot {
+        std::atomic<uint64_t> second{UINT64_MAX};
+        std::atomic<uint64_t> count{0};
+    };
+
+    // 比窗口多留几个槽,读取时不会和正在重置的槽重叠
+    static constexpr size_t RATE_SLOTS = 16;
+    static_assert(RATE_SLOTS > RATE_WINDOW_SECONDS + 1, "频率计数槽不够");
+
+    std::atomic<int> interfaceNumber{-1};
+
+    std::atomic<uint64_t> reports{0};
+    std::atomic<uint64_t> imuReports{0};
+    std::atomic<uint64_t> mcuReports{0};
+    std::atomic<uint64_t> crcFailures{0};
+    std::atomic<uint64_t> malformed{0};
+    std::atomic<uint64_t> readErrors{0};
+    std::atomic<uint64_t> imuMissing{0};
+    std::atomic<uint64_t> imuGaps{0};
+    std::atomic<uint64_t> timestampRegressions{0};
+    std::atomic<uint64_t> sequenceMissing{0};
+
+    std::atomic<uint64_t> firstReportNs{0};
+    std::atomic<uint64_t> lastReportNs{0};
+    std::array<RateSlot, RATE_SLOTS> rateSlots{};
+
+    LatencyHistogram arrival;
+    LatencyHistogram deviceInterval;
+    LatencyHistogram handling;
+
+    // 写入线程私有的状态
+    uint64_t lastDeviceTimestampNs = 0;
+    // 平滑后的IMU上报周期,0表示还没有测出
+    uint64_t imuPeriodNs = 0;
+    bool hasUnsolicitedSequence = false;
+    uint32_t lastUnsolicitedSequence = 0;
+};
+
+
+#endif //STREAMHEALTH_H
@@ -5,10 +5,12 @@
 #include "Utils.h"
 
 #include <array>
-#include <iostream>
+#include <chrono>
 #include <random>
 
+#include "Crc32.h"
 #include "LOG_LEVEL.h"
+#include "Logger.h"
 
 
 //================ CRC32相关 ================//
@@ -27,18 +29,13 @@ const std::array<uint32_t, 256> Utils::CRC32_TABLE = []() {
 
 /**
  * 计算CRC32校验和
+ * 由Crc32按CPU选择最快的实现,结果与逐字节查表完全一致
  * @param data - 要计算校验和的数据
  * @param length - 数据长度
  * @return - 计算得到的CRC32值
  */
 uint32_t Utils::calculateCRC32(const uint8_t* data, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
-
-    for (size_t i = 0; i < length; i++) {
-        crc = (crc >> 8) ^ CRC32_TABLE[(crc ^ data[i]) & 0xFF];
-    }
-
-    return ~crc; // 按位取反并转为无符号32位整数
+    return Crc32::compute(data, length);
 }
 //========================================//
 
@@ -57,31 +54,12 @@ uint32_t Utils::generateRandomU32() {
 
 /**
  * 记录日志
+ * 由Logger在后台线程中输出,调用线程只复制消息;热路径上应直接使用Logger的格式化接口,不必先拼接字符串
  * @param message - 日志消息
  * @param level - 日志级别
  */
 void Utils::log(const std::string& message, LogLevel level) {
-    // 根据日志级别选择输出流
-    std::ostream& out = (level == LogLevel::ERROR) ? std::cerr : std::cout;
-
-    // 日志级别前缀
-    std::string prefix;
-    switch (level) {
-        case LogLevel::INFO:
-            prefix = "[INFO] ";
-        break;
-        case LogLevel::SUCCESS:
-            prefix = "[SUCCESS] ";
-        break;
-        case LogLevel::ERROR:
-            prefix = "[ERROR] ";
-        break;
-        default:
-            break;
-    }
-
-    // 输出日志
-    out << prefix << message << std::endl;
+    Logger::log(level, "%s", message);
 }
 
 std::string Utils::bytesToHex(const std::vector<uint8_t> &vector) {
@@ -96,3 +74,11 @@ std::string Utils::bytesToHex(const std::vector<uint8_t> &vector) {
     return hexStr; // Return the formatted hex string
 }
 
+/**
+ * 获取单调时钟(steady_clock)的当前时间
+ * @return - 纳秒
+ */
+uint64_t Utils::steadyNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
\ No newline at end of file
@@ -5,7 +5,10 @@
 #ifndef UTILS_H
 #define UTILS_H
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include "LOG_LEVEL.h"
 
@@ -36,6 +39,12 @@ public:
     static void log(const std::string& message, LogLevel level = LogLevel::INFO);
 
     static std::string bytesToHex(const std::vector<uint8_t> & vector);
+
+    /**
+     * 获取单调时钟(steady_clock)的当前时间
+     * @return - 纳秒
+     */
+    static uint64_t steadyNowNs();
 };
 
 
@@ -0,0 +1,145 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "CaptureReader.h"
+#include "CaptureWriter.h"
+#include "TestSupport.h"
+
+// 相邻记录相隔超过1秒,每条记录(包括开头的DEVICE记录)各占一个块
+static constexpr uint64_t RECORD_SPACING_NS = 2000000000ULL;
+
+static std::string temporaryPath(const char *name) {
+    return "/tmp/xreal_" + std::string(name) + "_" + std::to_string(getpid()) + ".xrcap";
+}
+
+static std::vector<uint8_t> payloadFor(const int index) {
+    std::vector<uint8_t> data(8 + index);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(index * 31 + i);
+    }
+    return data;
+}
+
+static void writeCapture(const std::string &path, const int records) {
+    CaptureWriter writer(path);
+    CHECK(writer.isOpen());
+    HID_DEVICE_ENTRY entry;
+    entry.vendor_id = 0x3318;
+    entry.product_id = 0x0436;
+    entry.interface_number = 3;
+    entry.path = "DevSrvsID:4294969327";
+    entry.product = "XREAL One";
+    writer.appendDevice(entry, 1);
+    for (int i = 0; i < records; i++) {
+        const std::vector<uint8_t> data = payloadFor(i);
+        writer.append(CaptureRecordKind::INPUT, 3, data.data(), data.size(), (i + 1) * RECORD_SPACING_NS);
+    }
+}
+
+TEST_CASE(roundTripKeepsEveryRecord) {
+    const std::string path = temporaryPath("roundtrip");
+    writeCapture(path, 5);
+
+    CaptureReader reader;
+    CHECK(reader.open(path));
+    CHECK_EQ(reader.recordCount(), uint64_t(6));
+    CHECK_EQ(reader.chunks().size(), size_t(6));
+    CHECK_EQ(reader.devices().size(), size_t(1));
+    if (!reader.devices().empty()) {
+        CHECK_EQ(reader.devices()[0].product_id, uint16_t(0x0436));
+        CHECK_EQ(reader.devices()[0].path, std::string("DevSrvsID:4294969327"));
+        CHECK_EQ(reader.devices()[0].product, std::string("XREAL One"));
+    }
+
+    CaptureReader::Cursor cursor = reader.begin();
+    CaptureReader::Record record;
+    CHECK(reader.next(cursor, record));
+    CHECK(record.kind == CaptureRecordKind::DEVICE);
+    for (int i = 0; i < 5; i++) {
+        CHECK(reader.next(cursor, record));
+        const std::vector<uint8_t> expected = payloadFor(i);
+        CHECK(record.kind == CaptureRecordKind::INPUT);
+        CHECK_EQ(record.interface_number, 3);
+        CHECK_EQ(record.host_ns, (i + 1) * RECORD_SPACING_NS);
+        CHECK(std::vector<uint8_t>(record.data, record.data + record.length) == expected);
+    }
+    CHECK(!reader.next(cursor, record));
+
+    cursor = reader.seek(3 * RECORD_SPACING_NS);
+    CHECK(reader.next(cursor, record));
+    CHECK_EQ(record.host_ns, 3 * RECORD_SPACING_NS);
+    reader.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE(truncatedTailDropsOnlyTheLastChunk) {
+    const std::string path = temporaryPath("truncated");
+    writeCapture(path, 4);
+    {
+        CaptureReader reader;
+        CHECK(reader.open(path));
+        CHECK_EQ(reader.chunks().size(), size_t(5));
+    }
+    // 模拟录制时崩溃: 最后一个块只写了一部分
+    FILE *file = std::fopen(path.c_str(), "rb");
+    CHECK(file != nullptr);
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fclose(file);
+    CHECK_EQ(truncate(path.c_str(), size - 3), 0);
+
+    CaptureReader reader;
+    CHECK(reader.open(path));
+    CHECK_EQ(reader.chunks().size(), size_t(4));
+    CHECK_EQ(reader.recordCount(), uint64_t(4));
+    CHECK_EQ(reader.lastNs(), 3 * RECORD_SPACING_NS);
+
+    // 只剩半个块头时同样丢弃
+    CHECK_EQ(truncate(path.c_str(), static_cast<off_t>(reader.chunks().back().payload_offset +
+                                                       reader.chunks().back().payload_size + 10)), 0);
+    CHECK(reader.open(path));
+    CHECK_EQ(reader.chunks().size(), size_t(4));
+    reader.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE(concurrentAppendsAreAllWritten) {
+    // 总共约600KB,不到待写块的上限,写文件线程再慢也不会丢弃
+    const std::string path = temporaryPath("concurrent");
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 2000;
+    {
+        CaptureWriter writer(path);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&writer, t]() {
+                uint8_t report[64] = {0};
+                for (int i = 0; i < PER_THREAD; i++) {
+                    report[0] = static_cast<uint8_t>(t);
+                    writer.append(CaptureRecordKind::INPUT, t, report, sizeof(report),
+                                  static_cast<uint64_t>(i) * 1000);
+                }
+            });
+        }
+        for (std::thread &thread: threads) {
+            thread.join();
+        }
+        writer.flush();
+        const CaptureWriter::Stats stats = writer.stats();
+        CHECK_EQ(stats.records, uint64_t(THREADS * PER_THREAD));
+        CHECK_EQ(stats.lost_records, uint64_t(0));
+    }
+    CaptureReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.chunks().size() > 1);
+    CHECK_EQ(reader.recordCount(), uint64_t(THREADS * PER_THREAD));
+    reader.close();
+    std::remove(path.c_str());
+}
@@ -0,0 +1,145 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+
+#include "ClockSync.h"
+#include "TestSupport.h"
+
+// 原始数据1000Hz
+static constexpr uint64_t SAMPLE_PERIOD_NS = 1000000;
+static constexpr uint64_t DEVICE_START_NS = 5000000000ULL;
+static constexpr int64_t TRUE_OFFSET_NS = 123456789;
+static constexpr double TRUE_SKEW_PPM = 50.0;
+// 传输延迟 = 最小延迟 + 0~500us的抖动
+static constexpr uint64_t MIN_LATENCY_NS = 50000;
+static constexpr uint32_t JITTER_US = 500;
+// 整个窗口都被阻塞时额外的延迟
+static constexpr uint64_t BLOCKED_NS = 5000000;
+
+/**
+ * 合成的设备/主机时钟: 主机时间 = 设备时间 + 偏移 + 漂移 + 传输延迟
+ * 抖动用固定种子的线性同余生成器,结果与平台无关
+ */
+class SyntheticClock {
+public:
+    uint64_t deviceNs = DEVICE_START_NS;
+
+    // 不含传输延迟的真实主机时间
+    static uint64_t trueHost(const uint64_t device) {
+        const double drift = TRUE_SKEW_PPM * 1e-6 * static_cast<double>(device - DEVICE_START_NS);
+        return device + TRUE_OFFSET_NS + static_cast<int64_t>(std::llround(drift));
+    }
+
+    uint64_t nextLatencyNs() {
+        seed = seed * 1664525u + 1013904223u;
+        return MIN_LATENCY_NS + static_cast<uint64_t>((seed >> 8) % JITTER_US) * 1000;
+    }
+
+private:
+    uint32_t seed = 12345;
+};
+
+/**
+ * 喂入若干个窗口的样本
+ * @param blocked - 哪些窗口(按结束的先后编号)整体被阻塞
+ * @return - 结束的窗口数
+ */
+static size_t feedWindows(ClockSync &sync, SyntheticClock &clock, const size_t count,
+                          const std::set<size_t> &blocked = {}) {
+    size_t finished = 0;
+    while (finished < count) {
+        clock.deviceNs += SAMPLE_PERIOD_NS;
+        uint64_t latency = clock.nextLatencyNs();
+        if (blocked.count(finished)) {
+            latency += BLOCKED_NS;
+        }
+        if (sync.observe(clock.deviceNs, SyntheticClock::trueHost(clock.deviceNs) + latency)) {
+            finished++;
+        }
+    }
+    return finished;
+}
+
+TEST_CASE(notSyncedBeforeMinWindows) {
+    ClockSync sync;
+    SyntheticClock clock;
+    feedWindows(sync, clock, 3);
+    const ClockSync::Estimate estimate = sync.estimate();
+    CHECK(!estimate.synced);
+    CHECK_EQ(estimate.windows, size_t(3));
+    uint64_t host = 0;
+    CHECK(!sync.toHost(clock.deviceNs, host));
+}
+
+TEST_CASE(recoversOffsetAndSkew) {
+    ClockSync sync;
+    SyntheticClock clock;
+    feedWindows(sync, clock, 80);
+    const ClockSync::Estimate estimate = sync.estimate();
+    CHECK(estimate.synced);
+    CHECK_EQ(estimate.windows, size_t(64));
+    CHECK_EQ(estimate.rejected_windows, size_t(0));
+
+    // 每个窗口取最小值,只剩下最小延迟和很小的抖动
+    const auto expected = static_cast<int64_t>(SyntheticClock::trueHost(estimate.reference_device_ns) -
+                                               estimate.reference_device_ns + MIN_LATENCY_NS);
+    CHECK(std::llabs(estimate.offset_ns - expected) < 30000);
+    CHECK(std::fabs(estimate.skew_ppm - TRUE_SKEW_PPM) < 3.0);
+    CHECK(estimate.residual_rms_ns < 20000);
+
+    // 外推1秒后的换算仍然准确
+    const uint64_t future = clock.deviceNs + 1000000000ULL;
+    uint64_t host = 0;
+    CHECK(sync.toHost(future, host));
+    CHECK(std::llabs(static_cast<int64_t>(host - SyntheticClock::trueHost(future) - MIN_LATENCY_NS)) < 40000);
+}
+
+TEST_CASE(blockedWindowsAreRejected) {
+    ClockSync sync;
+    SyntheticClock clock;
+    // 最后64个窗口是16~79,其中3个整体被阻塞
+    feedWindows(sync, clock, 80, {30, 50, 70});
+    const ClockSync::Estimate estimate = sync.estimate();
+    CHECK(estimate.synced);
+    CHECK_EQ(estimate.rejected_windows, size_t(3));
+    const auto expected = static_cast<int64_t>(SyntheticClock::trueHost(estimate.reference_device_ns) -
+                                               estimate.reference_device_ns + MIN_LATENCY_NS);
+    CHECK(std::llabs(estimate.offset_ns - expected) < 30000);
+    CHECK(std::fabs(estimate.skew_ppm - TRUE_SKEW_PPM) < 3.0);
+
+    // 阻塞的窗口移出回归范围后不再计入
+    feedWindows(sync, clock, 64);
+    CHECK_EQ(sync.estimate().rejected_windows, size_t(0));
+}
+
+TEST_CASE(deviceRestartResynchronizes) {
+    ClockSync sync;
+    SyntheticClock clock;
+    feedWindows(sync, clock, 10);
+    CHECK(sync.estimate().synced);
+
+    // 设备重启,时间戳从头开始
+    clock.deviceNs = DEVICE_START_NS;
+    sync.observe(clock.deviceNs, SyntheticClock::trueHost(clock.deviceNs) + clock.nextLatencyNs());
+    ClockSync::Estimate estimate = sync.estimate();
+    CHECK(!estimate.synced);
+    CHECK_EQ(estimate.resets, uint64_t(1));
+    CHECK_EQ(estimate.windows, size_t(0));
+
+    feedWindows(sync, clock, 8);
+    estimate = sync.estimate();
+    CHECK(estimate.synced);
+    CHECK_EQ(estimate.resets, uint64_t(1));
+    CHECK(std::fabs(estimate.skew_ppm - TRUE_SKEW_PPM) < 20.0);
+
+    // 长时间中断(超过reset_gap_ns)同样重新同步
+    clock.deviceNs += 2000000000ULL;
+    sync.observe(clock.deviceNs, SyntheticClock::trueHost(clock.deviceNs) + clock.nextLatencyNs());
+    CHECK(!sync.estimate().synced);
+    CHECK_EQ(sync.estimate().resets, uint64_t(2));
+}
@@ -0,0 +1,75 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Crc32.h"
+#include "TestSupport.h"
+#include "Utils.h"
+
+// 逐字节查表的参照实现
+static uint32_t referenceCrc(const uint8_t *data, const size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ Utils::CRC32_TABLE[(crc ^ data[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+static const Crc32::Implementation IMPLEMENTATIONS[] = {
+    Crc32::Implementation::TABLE, Crc32::Implementation::SLICE8, Crc32::Implementation::PCLMUL,
+    Crc32::Implementation::ARMV8
+};
+
+TEST_CASE(knownCheckValue) {
+    const char *text = "123456789";
+    const auto *data = reinterpret_cast<const uint8_t *>(text);
+    for (const Crc32::Implementation implementation: IMPLEMENTATIONS) {
+        CHECK_EQ(Crc32::compute(implementation, data, 9), uint32_t(0xCBF43926));
+    }
+    CHECK_EQ(Crc32::compute(data, 0), uint32_t(0));
+    CHECK_EQ(Utils::calculateCRC32(data, 9), uint32_t(0xCBF43926));
+}
+
+TEST_CASE(allImplementationsMatchReference) {
+    std::mt19937 random(1);
+    std::vector<uint8_t> buffer(1200);
+    for (uint8_t &byte: buffer) {
+        byte = static_cast<uint8_t>(random());
+    }
+    // 覆盖各实现的对齐/尾部/折叠分界
+    for (size_t length = 0; length < 1100; length++) {
+        for (const size_t offset: {0, 1, 3, 7}) {
+            const uint32_t expected = referenceCrc(buffer.data() + offset, length);
+            for (const Crc32::Implementation implementation: IMPLEMENTATIONS) {
+                if (Crc32::compute(implementation, buffer.data() + offset, length) != expected) {
+                    TestSupport::fail(__FILE__, __LINE__, std::string(Crc32::name(implementation)) + " 长度 " +
+                                                          std::to_string(length) + " 偏移 " +
+                                                          std::to_string(offset));
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(streamingMatchesOneShot) {
+    std::vector<uint8_t> buffer(4096);
+    for (size_t i = 0; i < buffer.size(); i++) {
+        buffer[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    const uint32_t expected = Crc32::compute(buffer.data(), buffer.size());
+    for (const size_t split: {size_t(0), size_t(1), size_t(63), size_t(64), size_t(1000), buffer.size()}) {
+        Crc32 crc;
+        crc.update(buffer.data(), split).update(buffer.data() + split, buffer.size() - split);
+        CHECK_EQ(crc.finalize(), expected);
+    }
+    Crc32 crc;
+    crc.update(buffer.data(), 10);
+    crc.reset();
+    crc.update(buffer.data(), buffer.size());
+    CHECK_EQ(crc.finalize(), expected);
+}
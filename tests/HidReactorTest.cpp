@@ -0,0 +1,210 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+#include "HidReactor.h"
+#include "TestSupport.h"
+
+/**
+ * 没有可等待句柄的接口(和macOS上的hidapi一样只能带超时阻塞读取)
+ */
+class QueueDeviceHandle : public HidDeviceHandle {
+public:
+    void deliver(const uint8_t value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(value);
+        }
+        ready.notify_all();
+    }
+
+    void fail() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = true;
+        }
+        ready.notify_all();
+    }
+
+    int write(const uint8_t *, const size_t length) override {
+        return static_cast<int>(length);
+    }
+
+    int sendFeatureReport(const uint8_t *, const size_t length) override {
+        return static_cast<int>(length);
+    }
+
+    int read(uint8_t *buffer, const size_t length, const int timeoutMs) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        reads++;
+        ready.wait_for(lock, std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 0),
+                       [this] { return failed || !queue.empty(); });
+        if (failed) {
+            return -1;
+        }
+        if (queue.empty() || length == 0) {
+            return 0;
+        }
+        buffer[0] = queue.front();
+        queue.pop_front();
+        return 1;
+    }
+
+    std::string lastError() override {
+        return "测试设备已断开";
+    }
+
+    int readCalls() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return reads;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<uint8_t> queue;
+    bool failed = false;
+    int reads = 0;
+};
+
+// 当前进程的线程数(只在Linux上可以统计,其他平台返回0)
+static size_t threadCount() {
+    size_t count = 0;
+#ifdef __linux__
+    DIR *tasks = opendir("/proc/self/task");
+    if (!tasks) {
+        return 0;
+    }
+    while (const dirent *entry = readdir(tasks)) {
+        if (entry->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(tasks);
+#endif
+    return count;
+}
+
+static bool waitUntil(const std::function<bool()> &condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST_CASE(deviceWithoutFdIsReadWithoutPolling) {
+    auto device = std::make_shared<QueueDeviceHandle>();
+    std::atomic<int> received{0};
+    std::atomic<int> lastValue{0};
+    const uint64_t id = HidReactor::instance().registerDevice(
+        device, [&](const uint8_t *data, const size_t length, uint64_t) {
+            if (length == 1) {
+                lastValue = data[0];
+                received++;
+            }
+        });
+    CHECK(id != 0);
+
+    // 空闲时只会按读取超时醒来,不会每毫秒轮询一次
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CHECK(device->readCalls() <= 5);
+
+    for (uint8_t value = 1; value <= 50; value++) {
+        device->deliver(value);
+    }
+    CHECK(waitUntil([&] { return received == 50; }));
+    CHECK_EQ(lastValue.load(), 50);
+
+    HidReactor::instance().unregisterDevice(id);
+    device->deliver(99);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(received.load(), 50);
+    CHECK_EQ(HidReactor::instance().registeredCount(), size_t(0));
+}
+
+TEST_CASE(readErrorStopsDispatchAfterQueuedReports) {
+    auto device = std::make_shared<QueueDeviceHandle>();
+    std::atomic<int> received{0};
+    const uint64_t id = HidReactor::instance().registerDevice(
+        device, [&](const uint8_t *, size_t, uint64_t) {
+            received++;
+        });
+    device->deliver(1);
+    device->deliver(2);
+    CHECK(waitUntil([&] { return received == 2; }));
+    device->fail();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(received.load(), 2);
+    HidReactor::instance().unregisterDevice(id);
+}
+
+TEST_CASE(handlerCanUnregisterItself) {
+    auto device = std::make_shared<QueueDeviceHandle>();
+    std::atomic<int> received{0};
+    std::atomic<uint64_t> id{0};
+    id = HidReactor::instance().registerDevice(device, [&](const uint8_t *, size_t, uint64_t) {
+        received++;
+        HidReactor::instance().unregisterDevice(id);
+    });
+    device->deliver(1);
+    device->deliver(2);
+    CHECK(waitUntil([&] { return HidReactor::instance().registeredCount() == 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(received.load(), 1);
+}
+
+TEST_CASE(devicesWithoutFdShareOneWaiter) {
+    std::vector<std::shared_ptr<QueueDeviceHandle>> devices;
+    std::vector<uint64_t> ids;
+    std::atomic<int> received[4] = {{0}, {0}, {0}, {0}};
+    for (size_t i = 0; i < 4; i++) {
+        devices.push_back(std::make_shared<QueueDeviceHandle>());
+        ids.push_back(HidReactor::instance().registerDevice(
+            devices[i], [&received, i](const uint8_t *, size_t, uint64_t) {
+                received[i]++;
+            }));
+        // 第一个接口启动了等待线程,之后再注册接口不会增加线程
+        if (i == 0) {
+            devices[0]->deliver(1);
+            CHECK(waitUntil([&] { return received[0] == 1; }));
+        }
+    }
+    const size_t threads = threadCount();
+    for (size_t i = 1; i < 4; i++) {
+        devices[i]->deliver(1);
+    }
+    CHECK(waitUntil([&] { return received[1] == 1 && received[2] == 1 && received[3] == 1; }));
+    CHECK_EQ(threadCount(), threads);
+
+    // 一个接口注销后,其他接口仍然照常收到上报
+    HidReactor::instance().unregisterDevice(ids[1]);
+    for (size_t i = 0; i < 4; i++) {
+        devices[i]->deliver(2);
+    }
+    CHECK(waitUntil([&] { return received[0] == 2 && received[2] == 2 && received[3] == 2; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(received[1].load(), 1);
+
+    for (size_t i = 0; i < 4; i++) {
+        if (i != 1) {
+            HidReactor::instance().unregisterDevice(ids[i]);
+        }
+    }
+    CHECK_EQ(HidReactor::instance().registeredCount(), size_t(0));
+}
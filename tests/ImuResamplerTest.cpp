@@ -0,0 +1,126 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "ImuResampler.h"
+#include "TestSupport.h"
+
+// 原始数据1000Hz
+static constexpr uint64_t INPUT_PERIOD_NS = 1000000;
+
+static void pushSamples(ImuSampleBuffer &buffer, uint64_t &deviceNs, const int count) {
+    for (int i = 0; i < count; i++) {
+        IMU_SAMPLE sample;
+        deviceNs += INPUT_PERIOD_NS;
+        sample.device_timestamp_ns = deviceNs;
+        sample.accel[2] = 1.0f;
+        buffer.push(sample);
+    }
+}
+
+static ImuResampler::StageStats stageAt(const ImuResampler &resampler, const double rateHz) {
+    for (const ImuResampler::StageStats &stats: resampler.stats()) {
+        if (stats.rate_hz == rateHz) {
+            return stats;
+        }
+    }
+    return {};
+}
+
+TEST_CASE(subscribersAreCountedPerHandle) {
+    auto source = std::make_shared<ImuSampleBuffer>();
+    ImuResampler resampler(source);
+    auto first = resampler.subscribe(100);
+    auto second = resampler.subscribe(100);
+    CHECK(first.get() == second.get());
+    CHECK_EQ(stageAt(resampler, 100).subscribers, 2L);
+
+    // 拷贝属于同一个订阅
+    const auto copy = first;
+    CHECK_EQ(stageAt(resampler, 100).subscribers, 2L);
+    first.reset();
+    CHECK_EQ(stageAt(resampler, 100).subscribers, 2L);
+    second.reset();
+    CHECK_EQ(stageAt(resampler, 100).subscribers, 1L);
+}
+
+TEST_CASE(upstreamStageRunsOnlyForActiveDownstream) {
+    auto source = std::make_shared<ImuSampleBuffer>();
+    ImuResampler resampler(source);
+    uint64_t deviceNs = 0;
+    auto fast = resampler.subscribe(200);
+    auto slow = resampler.subscribe(25);
+    CHECK_EQ(stageAt(resampler, 25).source_rate_hz, 200.0);
+
+    // 上游阶段没有自己的订阅者,但下游在计算,仍要计算
+    fast.reset();
+    pushSamples(*source, deviceNs, 400);
+    resampler.process();
+    const uint64_t upstreamInputs = stageAt(resampler, 200).inputs;
+    CHECK(upstreamInputs > 0);
+    CHECK(stageAt(resampler, 25).outputs > 0);
+
+    // 下游也没有订阅者后,两个阶段都暂停
+    slow.reset();
+    pushSamples(*source, deviceNs, 400);
+    CHECK_EQ(resampler.process(), size_t(0));
+    CHECK_EQ(stageAt(resampler, 200).inputs, upstreamInputs);
+
+    // 重新订阅后继续
+    slow = resampler.subscribe(25);
+    pushSamples(*source, deviceNs, 400);
+    CHECK(resampler.process() > 0);
+}
+
+TEST_CASE(workerThreadFollowsSubscriptions) {
+    auto source = std::make_shared<ImuSampleBuffer>();
+    ImuResampler resampler(source);
+    resampler.start();
+    uint64_t deviceNs = 0;
+
+    auto output = resampler.subscribe(100);
+    ImuSampleBuffer::Cursor cursor = output->cursorAtEnd();
+    pushSamples(*source, deviceNs, 200);
+    IMU_SAMPLE samples[64];
+    size_t received = 0;
+    for (int attempt = 0; attempt < 500 && received == 0; attempt++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        received = output->read(cursor, samples, 64);
+    }
+    CHECK(received > 0);
+
+    // 释放后线程退出,新数据不再处理;再次订阅后恢复
+    output.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t inputs = stageAt(resampler, 100).inputs;
+    pushSamples(*source, deviceNs, 200);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(stageAt(resampler, 100).inputs, inputs);
+
+    output = resampler.subscribe(100);
+    cursor = output->cursorAtEnd();
+    pushSamples(*source, deviceNs, 200);
+    received = 0;
+    for (int attempt = 0; attempt < 500 && received == 0; attempt++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        received = output->read(cursor, samples, 64);
+    }
+    CHECK(received > 0);
+    resampler.stop();
+}
+
+TEST_CASE(outputOutlivesResampler) {
+    auto source = std::make_shared<ImuSampleBuffer>();
+    std::shared_ptr<ImuSampleBuffer> output;
+    {
+        ImuResampler resampler(source);
+        output = resampler.subscribe(50);
+    }
+    // 订阅句柄释放时不能再访问已销毁的阶段
+    CHECK(output->lastSequence() == 0);
+    output.reset();
+}
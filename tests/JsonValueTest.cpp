@@ -0,0 +1,82 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <string>
+
+#include "JsonValue.h"
+#include "TestSupport.h"
+
+static std::string encoded(const std::string &text) {
+    std::string out;
+    JsonValue::appendString(out, text);
+    return out;
+}
+
+TEST_CASE(parsesNestedDocument) {
+    JsonValue value;
+    std::string error;
+    CHECK(JsonValue::parse(R"({"id": 7, "method": "device.switchMode", "params": {"mode3D": true},
+                               "list": [1, -2.5e3, null, "a\"b\\cé"]})", value, error));
+    CHECK(value.isObject());
+    CHECK_EQ(value["id"].asNumber(), 7.0);
+    CHECK_EQ(value["method"].asString(), std::string("device.switchMode"));
+    CHECK(value["params"]["mode3D"].asBool());
+    CHECK(value["missing"].isNull());
+    CHECK_EQ(value["list"].items().size(), size_t(4));
+    CHECK_EQ(value["list"].items()[1].asNumber(), -2500.0);
+    CHECK(value["list"].items()[2].isNull());
+    CHECK_EQ(value["list"].items()[3].asString(), std::string("a\"b\\c\xC3\xA9"));
+}
+
+TEST_CASE(rejectsMalformedDocuments) {
+    const char *documents[] = {"", "{", "[1, 2", "{\"a\" 1}", "[1,]", "\"unterminated", "tru", "{} extra"};
+    for (const char *document: documents) {
+        JsonValue value;
+        std::string error;
+        CHECK(!JsonValue::parse(document, value, error));
+        CHECK(!error.empty());
+    }
+}
+
+TEST_CASE(dumpRoundTrips) {
+    JsonValue original = JsonValue::object();
+    original.set("text", "换行\n制表\t引号\"");
+    original.set("number", 0.125);
+    original.set("flag", false);
+    JsonValue list = JsonValue::array();
+    list.push(1).push("二").push(JsonValue());
+    original.set("list", list);
+
+    JsonValue parsed;
+    std::string error;
+    CHECK(JsonValue::parse(original.dump(), parsed, error));
+    CHECK_EQ(parsed.dump(), original.dump());
+    CHECK_EQ(parsed["text"].asString(), std::string("换行\n制表\t引号\""));
+    CHECK_EQ(parsed["list"].items()[1].asString(), std::string("二"));
+}
+
+TEST_CASE(escapesControlAndLineSeparators) {
+    CHECK_EQ(encoded(std::string("a\x01z", 3)), std::string("\"a\\u0001z\""));
+    CHECK_EQ(encoded("\xE2\x80\xA8\xE2\x80\xA9"), std::string("\"\\u2028\\u2029\""));
+    // 其余多字节字符原样保留
+    CHECK_EQ(encoded("姿态\xF0\x9F\x98\x80"), std::string("\"姿态\xF0\x9F\x98\x80\""));
+}
+
+TEST_CASE(replacesInvalidUtf8) {
+    const std::string replacement = "\xEF\xBF\xBD";
+    // 截断的多字节字符(例如日志在字节处截断)
+    CHECK_EQ(encoded("ab\xE5\xA7"), "\"ab" + replacement + replacement + "\"");
+    // 孤立的后续字节、过长编码、代理区、超出U+10FFFF
+    CHECK_EQ(encoded("\x80"), "\"" + replacement + "\"");
+    CHECK_EQ(encoded("\xC0\xAF"), "\"" + replacement + replacement + "\"");
+    CHECK_EQ(encoded("\xED\xA0\x80"), "\"" + replacement + replacement + replacement + "\"");
+    CHECK_EQ(encoded("\xF4\x90\x80\x80"), "\"" + replacement + replacement + replacement + replacement + "\"");
+    // 无效字节之后的有效字符不受影响
+    CHECK_EQ(encoded("\xFF" "好"), "\"" + replacement + "好\"");
+
+    JsonValue parsed;
+    std::string error;
+    CHECK(JsonValue::parse(encoded("x\xE5"), parsed, error));
+    CHECK_EQ(parsed.asString(), "x" + replacement);
+}
@@ -0,0 +1,100 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Logger.h"
+#include "TestSupport.h"
+
+/**
+ * 收集Logger输出的消息
+ */
+class CapturedLog {
+public:
+    CapturedLog() {
+        Logger::setConsole(false);
+        sinkId = Logger::addSink(LogLevel::INFO, [this](LogLevel, uint64_t, const std::string &message) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(message);
+        });
+    }
+
+    ~CapturedLog() {
+        Logger::removeSink(sinkId);
+        Logger::setConsole(true);
+    }
+
+    std::vector<std::string> take() {
+        Logger::flush();
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::move(messages);
+    }
+
+private:
+    uint64_t sinkId = 0;
+    std::mutex mutex;
+    std::vector<std::string> messages;
+};
+
+static bool isCompleteUtf8(const std::string &text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        const auto c = static_cast<unsigned char>(text[i]);
+        const size_t length = c < 0x80 ? 1 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0;
+        if (length == 0 || i + length > text.size()) {
+            return false;
+        }
+        for (size_t k = 1; k < length; k++) {
+            if ((static_cast<unsigned char>(text[i + k]) & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += length;
+    }
+    return true;
+}
+
+TEST_CASE(formatsArguments) {
+    CapturedLog log;
+    const std::string path = "/tmp/校准.bin";
+    Logger::info("接口 %d: %u 条, %.1fms, %s, %s", 3, uint64_t(12), 2.25, path, "完成");
+    const std::vector<std::string> messages = log.take();
+    CHECK_EQ(messages.size(), size_t(1));
+    if (!messages.empty()) {
+        CHECK_EQ(messages[0], std::string("接口 3: 12 条, 2.2ms, /tmp/校准.bin, 完成"));
+    }
+}
+
+TEST_CASE(longStringsAreCutOnCharacterBoundaries) {
+    CapturedLog log;
+    // 每个汉字3字节,任何偏移的上限都可能落在字符中间
+    for (size_t prefix = 0; prefix < 3; prefix++) {
+        std::string text(prefix, 'a');
+        while (text.size() < Logger::MAX_STRING_BYTES + 16) {
+            text += "姿";
+        }
+        Logger::info("%s", text);
+        Logger::info("%s", text.c_str());
+    }
+    const std::vector<std::string> messages = log.take();
+    CHECK_EQ(messages.size(), size_t(6));
+    for (const std::string &message: messages) {
+        CHECK(message.size() <= Logger::MAX_STRING_BYTES);
+        CHECK(message.size() > Logger::MAX_STRING_BYTES - 3);
+        CHECK(isCompleteUtf8(message));
+    }
+}
+
+TEST_CASE(shortStringsAreNotCut) {
+    CapturedLog log;
+    const std::string exact(Logger::MAX_STRING_BYTES, 'x');
+    Logger::info("%s", exact);
+    const std::vector<std::string> messages = log.take();
+    CHECK_EQ(messages.size(), size_t(1));
+    if (!messages.empty()) {
+        CHECK_EQ(messages[0].size(), Logger::MAX_STRING_BYTES);
+    }
+}
@@ -0,0 +1,123 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <cstring>
+#include <vector>
+
+#include "CommandHelper.h"
+#include "McuDecoder.h"
+#include "TestSupport.h"
+#include "Utils.h"
+
+/**
+ * 改造前buildCustomDisplayCommand逐字节拼装报文的写法,作为报文格式的参照
+ */
+static std::vector<uint8_t> legacyDisplayCommand(const uint32_t sequence, const uint16_t msgId, const uint8_t mode,
+                                                 const uint8_t subMode, const uint8_t param1, const uint8_t param2,
+                                                 const uint8_t refresh, const uint16_t length) {
+    std::vector<uint8_t> buffer(64, 0);
+    buffer[0] = 0xFD;
+    buffer[7] = sequence & 0xFF;
+    buffer[8] = (sequence >> 8) & 0xFF;
+    buffer[9] = (sequence >> 16) & 0xFF;
+    buffer[10] = (sequence >> 24) & 0xFF;
+    buffer[15] = msgId & 0xFF;
+    buffer[16] = (msgId >> 8) & 0xFF;
+    buffer[5] = length & 0xFF;
+    buffer[6] = (length >> 8) & 0xFF;
+    buffer[22] = mode;
+    if (length > 0x12) {
+        buffer[23] = subMode;
+        if (length > 0x13) {
+            buffer[24] = param1;
+            if (length > 0x14) {
+                buffer[25] = param2;
+                if (length > 0x15) {
+                    buffer[26] = refresh;
+                }
+            }
+        }
+    }
+    const uint32_t crc = Utils::calculateCRC32(&buffer[5], length);
+    buffer[1] = crc & 0xFF;
+    buffer[2] = (crc >> 8) & 0xFF;
+    buffer[3] = (crc >> 16) & 0xFF;
+    buffer[4] = (crc >> 24) & 0xFF;
+    return buffer;
+}
+
+TEST_CASE(encodeMatchesLegacyLayout) {
+    CommandHelper::McuReport report;
+    for (uint16_t length = 0x12; length <= 0x30; length++) {
+        const uint8_t payload[MCU_REPORT_LAYOUT::MAX_PAYLOAD] = {3, 1, 3, 0xB4, 0};
+        CHECK_EQ(CommandHelper::encode(report, 0x0008, 0xDEADBEEF, payload, length - 17), size_t(64));
+        const std::vector<uint8_t> expected = legacyDisplayCommand(0xDEADBEEF, 0x0008, 3, 1, 3, 0xB4, 0, length);
+        CHECK(std::memcmp(report.data(), expected.data(), 64) == 0);
+    }
+
+    CommandHelper::encodeCommand<McuMsgId::SET_DISPLAY_MODE>(report, 0xDEADBEEF, 3, 1, 3, 0xB4, 0);
+    const std::vector<uint8_t> expected = legacyDisplayCommand(0xDEADBEEF, 0x0008, 3, 1, 3, 0xB4, 0, 0x18);
+    CHECK(std::memcmp(report.data(), expected.data(), 64) == 0);
+}
+
+TEST_CASE(encodeTruncatesPayloadAndText) {
+    CommandHelper::McuReport report;
+    uint8_t payload[60];
+    std::memset(payload, 0xAA, sizeof(payload));
+    CommandHelper::encode(report, 0x0026, 1, payload, sizeof(payload));
+    CHECK_EQ(report[5] | (report[6] << 8), int(17 + MCU_REPORT_LAYOUT::MAX_PAYLOAD));
+    CHECK_EQ(report[63], uint8_t(0xAA));
+
+    CHECK_EQ(CommandHelper::encodeText(report, "v"), size_t(2));
+    CHECK_EQ(report[0], uint8_t(0xFD));
+    CHECK_EQ(report[1], uint8_t('v'));
+    CHECK_EQ(report[2], uint8_t(0));
+    CHECK_EQ(CommandHelper::encodeText(report, std::string(100, 'x')), size_t(64));
+}
+
+TEST_CASE(decodeRoundTrip) {
+    CommandHelper::McuReport report;
+    const uint8_t payload[3] = {7, 8, 9};
+    CommandHelper::encode(report, static_cast<uint16_t>(McuMsgId::BUTTON_PRESSED), 42, payload, sizeof(payload),
+                          123456);
+    MCU_MESSAGE_VIEW message;
+    CHECK(McuDecoder::decode(report.data(), report.size(), message) == McuDecoder::Status::OK);
+    CHECK_EQ(message.sequence, uint32_t(42));
+    CHECK_EQ(message.device_time, uint32_t(123456));
+    CHECK_EQ(message.msg_id, static_cast<uint16_t>(McuMsgId::BUTTON_PRESSED));
+    CHECK_EQ(message.payload_length, size_t(3));
+    CHECK_EQ(message.payload[2], uint8_t(9));
+    CHECK(message.kind == McuMessageKind::BUTTON_EVENT);
+}
+
+TEST_CASE(decodeRejectsMalformedReports) {
+    CommandHelper::McuReport report;
+    CommandHelper::encodeCommand<McuMsgId::GET_FIRMWARE_VERSION>(report, 1);
+    MCU_MESSAGE_VIEW message;
+
+    const uint8_t imu[4] = {0x01, 0x02, 0, 0};
+    CHECK(McuDecoder::decode(imu, sizeof(imu), message) == McuDecoder::Status::NOT_MCU);
+    CHECK(McuDecoder::decode(report.data(), 10, message) == McuDecoder::Status::TRUNCATED);
+
+    CommandHelper::McuReport badLength = report;
+    badLength[5] = 0x40;
+    CHECK(McuDecoder::decode(badLength.data(), badLength.size(), message) == McuDecoder::Status::BAD_LENGTH);
+    badLength[5] = 0x10;
+    CHECK(McuDecoder::decode(badLength.data(), badLength.size(), message) == McuDecoder::Status::BAD_LENGTH);
+
+    CommandHelper::McuReport badCrc = report;
+    badCrc[15] ^= 0x01;
+    CHECK(McuDecoder::decode(badCrc.data(), badCrc.size(), message) == McuDecoder::Status::BAD_CRC);
+
+    McuDecoder decoder;
+    decoder.decodeAndCount(report.data(), report.size(), message);
+    decoder.decodeAndCount(badCrc.data(), badCrc.size(), message);
+    decoder.decodeAndCount(imu, sizeof(imu), message);
+    const McuDecoder::Stats stats = decoder.stats();
+    CHECK_EQ(stats.decoded, uint64_t(1));
+    CHECK_EQ(stats.bad_crc, uint64_t(1));
+    CHECK_EQ(stats.not_mcu, uint64_t(1));
+    CHECK_EQ(stats.rejected(), uint64_t(1));
+    CHECK_EQ(stats.by_kind[static_cast<size_t>(McuMessageKind::VERSION_REPLY)], uint64_t(1));
+}
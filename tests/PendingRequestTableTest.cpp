@@ -0,0 +1,142 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "PendingRequestTable.h"
+#include "TestSupport.h"
+#include "Utils.h"
+
+/**
+ * 一条已校验的应答报文,report[1]标记是哪条应答
+ */
+struct Reply {
+    uint8_t report[64] = {0xFD};
+    MCU_MESSAGE_VIEW view;
+
+    Reply(const uint32_t sequence, const uint16_t msgId, const uint8_t tag) {
+        report[1] = tag;
+        view.report = report;
+        view.report_length = sizeof(report);
+        view.sequence = sequence;
+        view.msg_id = msgId;
+    }
+};
+
+static bool isReady(const std::future<COMMAND_RESULT> &future) {
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+static constexpr std::chrono::milliseconds LONG_TIMEOUT{5000};
+
+TEST_CASE(exactMatchWinsOverEarlierSameMsgId) {
+    const auto table = std::make_shared<PendingRequestTable>();
+    auto earlier = table->add(10, 0x0008, LONG_TIMEOUT);
+    auto exact = table->add(11, 0x0008, LONG_TIMEOUT);
+
+    const Reply reply(11, 0x0008, 1);
+    CHECK(table->complete(reply.view, Utils::steadyNowNs()));
+    CHECK(isReady(exact));
+    CHECK(!isReady(earlier));
+    const COMMAND_RESULT result = exact.get();
+    CHECK(result.success);
+    CHECK_EQ(result.reply.data[1], uint8_t(1));
+    CHECK_EQ(table->pendingCount(), size_t(1));
+    table->cancelAll("结束");
+}
+
+TEST_CASE(unechoedSequenceMatchesEarliestSameMsgId) {
+    const auto table = std::make_shared<PendingRequestTable>();
+    auto first = table->add(20, 0x0015, LONG_TIMEOUT);
+    auto second = table->add(21, 0x0015, LONG_TIMEOUT);
+    auto other = table->add(22, 0x0008, LONG_TIMEOUT);
+
+    // 设备没有回显序号
+    const Reply reply(0, 0x0015, 2);
+    CHECK(table->complete(reply.view, Utils::steadyNowNs() + 1000000));
+    CHECK(isReady(first));
+    CHECK(!isReady(second));
+    CHECK(!isReady(other));
+    CHECK_EQ(first.get().reply.data[1], uint8_t(2));
+    CHECK(table->lastRoundTripNs(0x0015) >= 1000000);
+    table->cancelAll("结束");
+}
+
+TEST_CASE(anyMsgIdIsTheLastResort) {
+    const auto table = std::make_shared<PendingRequestTable>();
+    auto probe = table->add(0, PendingRequestTable::ANY_MSG_ID, LONG_TIMEOUT);
+    auto exact = table->add(30, 0x0008, LONG_TIMEOUT);
+
+    // 有精确匹配时,ANY_MSG_ID的请求不抢应答
+    const Reply ack(30, 0x0008, 3);
+    CHECK(table->complete(ack.view, Utils::steadyNowNs()));
+    CHECK(isReady(exact));
+    CHECK(!isReady(probe));
+
+    // 没有其他候选时才落到ANY_MSG_ID
+    const Reply version(0, 0x0001, 4);
+    CHECK(table->complete(version.view, Utils::steadyNowNs()));
+    CHECK(isReady(probe));
+    CHECK_EQ(probe.get().reply.data[1], uint8_t(4));
+    CHECK_EQ(table->pendingCount(), size_t(0));
+}
+
+TEST_CASE(unsolicitedReportDoesNotStealExactRequest) {
+    const auto table = std::make_shared<PendingRequestTable>();
+    auto request = table->add(40, 0x0008, LONG_TIMEOUT);
+
+    // 眼镜主动上报的0x6Cxx(按键/心跳等)不属于任何请求
+    const Reply heartbeat(0, 0x6C02, 5);
+    CHECK(!table->complete(heartbeat.view, Utils::steadyNowNs()));
+    const Reply button(41, 0x6C05, 6);
+    CHECK(!table->complete(button.view, Utils::steadyNowNs()));
+    CHECK(!isReady(request));
+    CHECK_EQ(table->pendingCount(), size_t(1));
+
+    const Reply ack(40, 0x0008, 7);
+    CHECK(table->complete(ack.view, Utils::steadyNowNs()));
+    CHECK_EQ(request.get().reply.data[1], uint8_t(7));
+}
+
+TEST_CASE(timeoutCompletesWithTimedOut) {
+    const auto table = std::make_shared<PendingRequestTable>();
+    bool callbackTimedOut = false;
+    auto future = table->add(50, 0x0008, std::chrono::milliseconds(20), [&](const COMMAND_RESULT &result) {
+        callbackTimedOut = result.timed_out;
+    });
+    CHECK(future.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+    const COMMAND_RESULT result = future.get();
+    CHECK(!result.success);
+    CHECK(result.timed_out);
+    CHECK(callbackTimedOut);
+    CHECK_EQ(table->pendingCount(), size_t(0));
+
+    // 超时之后迟到的应答不再匹配
+    const Reply late(50, 0x0008, 8);
+    CHECK(!table->complete(late.view, Utils::steadyNowNs()));
+}
+
+TEST_CASE(cancelAllAndFailCompleteImmediately) {
+    const auto table = std::make_shared<PendingRequestTable>();
+    auto failed = table->add(60, 0x0008, LONG_TIMEOUT);
+    auto first = table->add(61, 0x0015, LONG_TIMEOUT);
+    auto second = table->add(0, PendingRequestTable::ANY_MSG_ID, LONG_TIMEOUT);
+
+    table->fail(60, 0x0008, "写入失败");
+    CHECK(isReady(failed));
+    const COMMAND_RESULT failure = failed.get();
+    CHECK(!failure.success);
+    CHECK(!failure.timed_out);
+    CHECK_EQ(failure.error, std::string("写入失败"));
+
+    table->cancelAll("接口已关闭");
+    CHECK(isReady(first));
+    CHECK(isReady(second));
+    CHECK_EQ(first.get().error, std::string("接口已关闭"));
+    CHECK_EQ(second.get().error, std::string("接口已关闭"));
+    CHECK_EQ(table->pendingCount(), size_t(0));
+}
@@ -0,0 +1,180 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "ReportRingBuffer.h"
+#include "SeqLock.h"
+#include "TestSupport.h"
+
+// 所有字节都等于序号低8位的上报,读到的内容与序号不符即为撕裂
+static void pushPattern(ReportRingBuffer &buffer, const uint64_t sequence) {
+    uint8_t data[HID_REPORT::MAX_SIZE];
+    std::memset(data, static_cast<int>(sequence & 0xFF), sizeof(data));
+    buffer.push(data, sizeof(data), sequence * 1000);
+}
+
+static bool matchesPattern(const HID_REPORT &report) {
+    if (report.length != HID_REPORT::MAX_SIZE || report.received_at_ns != report.sequence * 1000) {
+        return false;
+    }
+    for (const uint8_t byte: report.data) {
+        if (byte != static_cast<uint8_t>(report.sequence & 0xFF)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(capacityRoundsUpToPowerOfTwo) {
+    CHECK_EQ(ReportRingBuffer(100).capacity(), size_t(128));
+    CHECK_EQ(ReportRingBuffer(1).capacity(), size_t(2));
+    CHECK_EQ(ReportRingBuffer(64).capacity(), size_t(64));
+}
+
+TEST_CASE(pushTruncatesAndReadsBack) {
+    ReportRingBuffer buffer(4);
+    HID_REPORT out;
+    CHECK(!buffer.latest(out));
+    CHECK(buffer.read(1, out) == ReportRingBuffer::ReadStatus::NOT_YET);
+
+    uint8_t data[80];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    CHECK_EQ(buffer.push(data, sizeof(data), 42), uint64_t(1));
+    CHECK(buffer.read(1, out) == ReportRingBuffer::ReadStatus::OK);
+    CHECK_EQ(out.sequence, uint64_t(1));
+    CHECK_EQ(out.received_at_ns, uint64_t(42));
+    CHECK_EQ(out.length, uint16_t(HID_REPORT::MAX_SIZE));
+    CHECK_EQ(out.data[63], uint8_t(63));
+    CHECK(buffer.read(2, out) == ReportRingBuffer::ReadStatus::NOT_YET);
+}
+
+TEST_CASE(overwrittenSlotsAreReported) {
+    ReportRingBuffer buffer(4);
+    for (uint64_t sequence = 1; sequence <= 6; sequence++) {
+        pushPattern(buffer, sequence);
+    }
+    HID_REPORT out;
+    CHECK(buffer.read(2, out) == ReportRingBuffer::ReadStatus::OVERWRITTEN);
+    CHECK(buffer.read(3, out) == ReportRingBuffer::ReadStatus::OK);
+    CHECK(buffer.latest(out));
+    CHECK_EQ(out.sequence, uint64_t(6));
+
+    std::vector<HID_REPORT> reports;
+    CHECK_EQ(buffer.snapshot(reports, 10), size_t(4));
+    CHECK_EQ(reports.front().sequence, uint64_t(3));
+    CHECK_EQ(reports.back().sequence, uint64_t(6));
+}
+
+TEST_CASE(cursorSkipsOverwrittenAndCountsDropped) {
+    ReportRingBuffer buffer(4);
+    ReportRingBuffer::Cursor cursor = buffer.cursorAtEnd();
+    for (uint64_t sequence = 1; sequence <= 10; sequence++) {
+        pushPattern(buffer, sequence);
+    }
+    HID_REPORT out;
+    CHECK(buffer.next(cursor, out));
+    CHECK_EQ(out.sequence, uint64_t(7));
+    CHECK_EQ(cursor.dropped, uint64_t(6));
+    size_t remaining = 0;
+    while (buffer.next(cursor, out)) {
+        remaining++;
+    }
+    CHECK_EQ(remaining, size_t(3));
+    CHECK_EQ(buffer.cursorAtEnd().next, uint64_t(11));
+}
+
+TEST_CASE(concurrentReadersNeverSeeTornReports) {
+    ReportRingBuffer buffer(8);
+    constexpr uint64_t TOTAL = 200000;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> outOfOrder{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; i++) {
+        readers.emplace_back([&] {
+            ReportRingBuffer::Cursor cursor;
+            HID_REPORT out;
+            uint64_t previous = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                while (buffer.next(cursor, out)) {
+                    if (!matchesPattern(out)) {
+                        torn++;
+                    }
+                    if (out.sequence <= previous) {
+                        outOfOrder++;
+                    }
+                    previous = out.sequence;
+                }
+                if (buffer.latest(out) && !matchesPattern(out)) {
+                    torn++;
+                }
+            }
+        });
+    }
+    for (uint64_t sequence = 1; sequence <= TOTAL; sequence++) {
+        pushPattern(buffer, sequence);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto &reader: readers) {
+        reader.join();
+    }
+    CHECK_EQ(torn.load(), uint64_t(0));
+    CHECK_EQ(outOfOrder.load(), uint64_t(0));
+    CHECK_EQ(buffer.lastSequence(), TOTAL);
+}
+
+// 跨越多个8字节分段的数据,每一段都写入同一个值
+struct SEQLOCK_PAYLOAD {
+    uint64_t values[9];
+};
+
+TEST_CASE(seqLockCountsWrites) {
+    SeqLock<SEQLOCK_PAYLOAD> lock;
+    SEQLOCK_PAYLOAD out{};
+    CHECK_EQ(lock.load(out), uint64_t(0));
+    CHECK_EQ(out.values[8], uint64_t(0));
+
+    SEQLOCK_PAYLOAD value{};
+    value.values[8] = 7;
+    lock.store(value);
+    lock.store(value);
+    CHECK_EQ(lock.writes(), uint64_t(2));
+    CHECK_EQ(lock.load().values[8], uint64_t(7));
+}
+
+TEST_CASE(seqLockNeverReturnsTornValue) {
+    SeqLock<SEQLOCK_PAYLOAD> lock;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::thread reader([&] {
+        SEQLOCK_PAYLOAD out;
+        while (!done.load(std::memory_order_acquire)) {
+            lock.load(out);
+            for (const uint64_t value: out.values) {
+                if (value != out.values[0]) {
+                    torn++;
+                    break;
+                }
+            }
+        }
+    });
+    SEQLOCK_PAYLOAD value;
+    for (uint64_t i = 1; i <= 200000; i++) {
+        for (uint64_t &slot: value.values) {
+            slot = i;
+        }
+        lock.store(value);
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+    CHECK_EQ(torn.load(), uint64_t(0));
+    CHECK_EQ(lock.writes(), uint64_t(200000));
+}
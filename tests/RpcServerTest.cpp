@@ -0,0 +1,130 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RpcServer.h"
+#include "TestSupport.h"
+
+/**
+ * 收集RpcServer发出的响应
+ */
+class Responses {
+public:
+    RpcServer::Responder responder() {
+        return [this](const std::string &json) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(json);
+            changed.notify_all();
+        };
+    }
+
+    bool waitFor(const size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, std::chrono::seconds(2), [&] { return received.size() >= count; });
+    }
+
+    std::vector<std::string> take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::string> received;
+};
+
+TEST_CASE(syncMethodResponds) {
+    Responses responses;
+    RpcServer server(responses.responder());
+    server.registerMethod("echo", [](const JsonValue &params, JsonValue &result, RpcServer::Error &) {
+        result = params["x"];
+        return true;
+    });
+    server.start();
+    server.receive(R"({"r":[{"i":1,"m":"echo","p":{"x":5}},{"i":2,"m":"missing","p":{}}]})");
+    CHECK(responses.waitFor(2));
+    const std::vector<std::string> received = responses.take();
+    CHECK_EQ(received[0], std::string(R"({"i":1,"ok":true,"v":5})"));
+    CHECK(received[1].find("unknown_method") != std::string::npos);
+    server.stop();
+    CHECK_EQ(server.stats().completed, uint64_t(1));
+    CHECK_EQ(server.stats().failed, uint64_t(1));
+}
+
+TEST_CASE(asyncMethodDoesNotHoldTheWorker) {
+    Responses responses;
+    RpcServer server(responses.responder());
+    RpcServer::Reply pendingReply;
+    std::mutex replyMutex;
+    server.registerAsyncMethod("slow", [&](const JsonValue &, RpcServer::Reply reply) {
+        std::lock_guard<std::mutex> lock(replyMutex);
+        pendingReply = std::move(reply);
+    });
+    server.registerMethod("fast", [](const JsonValue &, JsonValue &result, RpcServer::Error &) {
+        result = JsonValue(true);
+        return true;
+    });
+    server.start();
+
+    // 异步方法还没有回复时,后面的请求照常执行
+    server.receive(R"({"r":[{"i":1,"m":"slow","p":{}},{"i":2,"m":"fast","p":{}}]})");
+    CHECK(responses.waitFor(1));
+    const std::string first = responses.take()[0];
+    CHECK_EQ(first, std::string(R"({"i":2,"ok":true,"v":true})"));
+
+    // 在另一个线程中回复,重复的回复被忽略
+    std::thread device([&]() {
+        std::lock_guard<std::mutex> lock(replyMutex);
+        pendingReply(true, JsonValue("done"), RpcServer::Error());
+        pendingReply(false, JsonValue(), RpcServer::Error());
+    });
+    device.join();
+    CHECK(responses.waitFor(2));
+    server.stop();
+    const std::vector<std::string> received = responses.take();
+    CHECK_EQ(received.size(), size_t(2));
+    CHECK_EQ(received[1], std::string(R"({"i":1,"ok":true,"v":"done"})"));
+    CHECK_EQ(server.stats().completed, uint64_t(2));
+}
+
+TEST_CASE(stopWaitsForInFlightReplies) {
+    Responses responses;
+    RpcServer server(responses.responder());
+    std::thread device;
+    std::atomic<bool> replied{false};
+    server.registerAsyncMethod("slow", [&](const JsonValue &, RpcServer::Reply reply) {
+        device = std::thread([&replied, reply]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            RpcServer::Error error;
+            error.message = "超时";
+            replied = true;
+            reply(false, JsonValue(), error);
+        });
+    });
+    server.start();
+    server.receive(R"({"r":[{"i":7,"m":"slow","p":{}}]})");
+    for (int attempt = 0; attempt < 200 && !device.joinable(); attempt++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // stop返回时回复已经发出,responder的所有者可以安全销毁
+    server.stop();
+    CHECK(replied);
+    const std::vector<std::string> received = responses.take();
+    CHECK_EQ(received.size(), size_t(1));
+    CHECK(received[0].find("\"failed\"") != std::string::npos);
+    device.join();
+
+    // 停止之后的请求以busy拒绝
+    server.receive(R"({"r":[{"i":8,"m":"slow","p":{}}]})");
+    const std::string rejected = responses.take().back();
+    CHECK(rejected.find("busy") != std::string::npos);
+}
@@ -0,0 +1,77 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "StreamHealth.h"
+#include "TestSupport.h"
+
+TEST_CASE(histogramPercentilesWithinBucketError) {
+    std::mt19937_64 random(3);
+    std::lognormal_distribution<double> distribution(std::log(1e6), 0.5);
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    for (int i = 0; i < 100000; i++) {
+        const auto value = static_cast<uint64_t>(distribution(random));
+        values.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(values.begin(), values.end());
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    CHECK_EQ(snapshot.count, uint64_t(values.size()));
+    CHECK_EQ(snapshot.max_ns, values.back());
+    // 每个2的幂分为8个子桶,相对误差不超过1/8
+    for (const double quantile: {0.5, 0.9, 0.99, 0.999}) {
+        const double exact = static_cast<double>(values[static_cast<size_t>(std::ceil(quantile * values.size())) - 1]);
+        const double estimate = static_cast<double>(snapshot.percentile(quantile));
+        CHECK(std::fabs(estimate - exact) / exact <= 0.125);
+    }
+}
+
+TEST_CASE(imuGapsAndRegressionsAreCounted) {
+    StreamHealth health;
+    uint64_t timestampNs = 1000000;
+    for (int i = 0; i < 100; i++) {
+        health.onImu(timestampNs);
+        timestampNs += 1000000;
+    }
+    // 丢了3条
+    timestampNs += 3 * 1000000;
+    for (int i = 0; i < 10; i++) {
+        health.onImu(timestampNs);
+        timestampNs += 1000000;
+    }
+    health.onImu(5000000);
+
+    const StreamHealth::Snapshot snapshot = health.snapshot();
+    CHECK_EQ(snapshot.imu_reports, uint64_t(111));
+    CHECK_EQ(snapshot.imu_missing, uint64_t(3));
+    CHECK_EQ(snapshot.imu_gaps, uint64_t(1));
+    CHECK_EQ(snapshot.timestamp_regressions, uint64_t(1));
+}
+
+TEST_CASE(unsolicitedSequenceGapsAreCounted) {
+    StreamHealth health;
+    MCU_MESSAGE_VIEW message;
+    message.kind = McuMessageKind::HEARTBEAT;
+    for (uint32_t sequence = 1; sequence <= 100; sequence++) {
+        if (sequence % 10 == 0) {
+            continue;
+        }
+        message.sequence = sequence;
+        health.onMcu(message);
+    }
+    // 命令应答不参与序号统计
+    message.kind = McuMessageKind::VERSION_REPLY;
+    message.sequence = 5000;
+    health.onMcu(message);
+
+    const StreamHealth::Snapshot snapshot = health.snapshot();
+    CHECK_EQ(snapshot.sequence_missing, uint64_t(9));
+    CHECK_EQ(snapshot.mcu_reports, uint64_t(91));
+}
@@ -0,0 +1,22 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <cstdio>
+
+#include "TestSupport.h"
+
+int main() {
+    int failedCases = 0;
+    for (const auto &testCase: TestSupport::cases()) {
+        const int before = TestSupport::failures();
+        testCase.function();
+        const bool passed = TestSupport::failures() == before;
+        if (!passed) {
+            failedCases++;
+        }
+        std::printf("[%s] %s\n", passed ? "通过" : "失败", testCase.name);
+    }
+    std::printf("%zu个用例, %d个失败\n", TestSupport::cases().size(), failedCases);
+    return failedCases == 0 ? 0 : 1;
+}
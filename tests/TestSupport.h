@@ -0,0 +1,69 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#ifndef TESTSUPPORT_H
+#define TESTSUPPORT_H
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+/**
+ * 单元测试用的最小框架(不引入第三方依赖)
+ * 每个测试文件编译成一个独立的程序,TEST_CASE注册的用例由TestMain.cpp依次执行,
+ * 任何CHECK失败时打印位置,程序以非0退出,由ctest统计结果.
+ */
+class TestSupport {
+public:
+    using TestFunction = void (*)();
+
+    struct TestCase {
+        const char *name;
+        TestFunction function;
+    };
+
+    static std::vector<TestCase> &cases() {
+        static std::vector<TestCase> registered;
+        return registered;
+    }
+
+    static int &failures() {
+        static int count = 0;
+        return count;
+    }
+
+    static bool add(const char *name, const TestFunction function) {
+        cases().push_back({name, function});
+        return true;
+    }
+
+    static void fail(const char *file, const int line, const std::string &message) {
+        failures()++;
+        std::fprintf(stderr, "%s:%d: 失败: %s\n", file, line, message.c_str());
+    }
+};
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static const bool name##Registered = TestSupport::add(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            TestSupport::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        const auto &checkActual = (actual); \
+        const auto &checkExpected = (expected); \
+        if (!(checkActual == checkExpected)) { \
+            TestSupport::fail(__FILE__, __LINE__, std::string(#actual " == " #expected)); \
+        } \
+    } while (0)
+
+
+#endif //TESTSUPPORT_H
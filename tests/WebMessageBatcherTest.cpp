@@ -0,0 +1,61 @@
+//
+// Created by Norman Wang on 2025/5/22.
+//
+
+#include <string>
+
+#include "TestSupport.h"
+#include "WebMessageBatcher.h"
+
+TEST_CASE(batchFormatAndEscaping) {
+    WebMessageBatcher batcher;
+    CHECK(batcher.postText("log", "a\"b\\c\nd\te\x01 f\xE2\x80\xA8g"));
+    CHECK(!batcher.postLatest("pose", "{\"w\":1}"));
+    batcher.postLatest("pose", "{\"w\":0.5}");
+
+    std::string out;
+    CHECK(batcher.takeBatch(out));
+    CHECK_EQ(out, std::string("{\"m\":[[\"log\",\"a\\\"b\\\\c\\nd\\te\\u0001 f\\u2028g\"]],"
+                              "\"l\":{\"pose\":{\"w\":0.5}},\"d\":{},\"q\":0}"));
+    CHECK(batcher.empty());
+    CHECK(!batcher.takeBatch(out));
+
+    const WebMessageBatcher::Stats stats = batcher.stats();
+    CHECK_EQ(stats.posted, uint64_t(3));
+    CHECK_EQ(stats.coalesced, uint64_t(1));
+    CHECK_EQ(stats.delivered, uint64_t(2));
+}
+
+TEST_CASE(batchLimitsLeaveRestForNextFrame) {
+    WebMessageBatcher::Config config;
+    config.max_messages_per_batch = 2;
+    WebMessageBatcher batcher(config);
+    for (int i = 0; i < 5; i++) {
+        batcher.post("n", std::to_string(i));
+    }
+    std::string out;
+    CHECK(batcher.takeBatch(out));
+    CHECK_EQ(out, std::string("{\"m\":[[\"n\",0],[\"n\",1]],\"l\":{},\"d\":{},\"q\":3}"));
+    int batches = 1;
+    while (batcher.takeBatch(out)) {
+        batches++;
+    }
+    CHECK_EQ(batches, 3);
+}
+
+TEST_CASE(fullQueueDropsOldestDroppable) {
+    WebMessageBatcher::Config config;
+    config.max_queued = 4;
+    config.max_messages_per_batch = 100;
+    WebMessageBatcher batcher(config);
+    batcher.post("rpc", "0", false);
+    for (int i = 1; i <= 10; i++) {
+        batcher.post("log", std::to_string(i));
+    }
+    std::string out;
+    CHECK(batcher.takeBatch(out));
+    // 不可丢弃的消息不计入上限,可丢弃的只保留最新的4条
+    CHECK_EQ(out, std::string("{\"m\":[[\"rpc\",0],[\"log\",7],[\"log\",8],[\"log\",9],[\"log\",10]],"
+                              "\"l\":{},\"d\":{\"log\":6},\"q\":0}"));
+    CHECK_EQ(batcher.stats().dropped, uint64_t(6));
+}
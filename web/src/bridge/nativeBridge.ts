@@ -0,0 +1,100 @@
+// C++(WebViewBridge)发来的消息的接收端
+// C++每帧最多执行一次 window.xrealBridge.receive(batch),一批中包含这一帧的所有消息,格式见WebMessageBatcher.h
+
+interface NativeBatch {
+    // 按投递顺序的消息: [通道, 数据]
+    m: [string, unknown][];
+    // 只保留最新值的通道
+    l: Record<string, unknown>;
+    // 自上一批以来因队列满而丢弃的条数
+    d: Record<string, number>;
+    // C++中留到下一批的条数
+    q: number;
+}
+
+// 处理一个通道在一批中的所有消息,一批只调用一次,便于合并DOM操作
+type NativeHandler = (items: unknown[], dropped: number) => void;
+
+interface NativeBridgeStats {
+    batches: number;
+    messages: number;
+    dropped: number;
+    // 处理一批的耗时(毫秒)
+    lastCostMs: number;
+    maxCostMs: number;
+    totalCostMs: number;
+}
+
+const handlers = new Map<string, Set<NativeHandler>>();
+const bridgeStats: NativeBridgeStats = {
+    batches: 0,
+    messages: 0,
+    dropped: 0,
+    lastCostMs: 0,
+    maxCostMs: 0,
+    totalCostMs: 0,
+};
+
+function receive(batch: NativeBatch) {
+    const start = performance.now();
+    const byChannel = new Map<string, unknown[]>();
+    for (const [channel, data] of batch.m) {
+        let items = byChannel.get(channel);
+        if (!items) {
+            items = [];
+            byChannel.set(channel, items);
+        }
+        items.push(data);
+    }
+    for (const channel of Object.keys(batch.l)) {
+        byChannel.set(channel, [batch.l[channel]]);
+    }
+    for (const channel of Object.keys(batch.d)) {
+        if (!byChannel.has(channel)) {
+            byChannel.set(channel, []);
+        }
+        bridgeStats.dropped += batch.d[channel];
+    }
+
+    byChannel.forEach((items, channel) => {
+        bridgeStats.messages += items.length;
+        const channelHandlers = handlers.get(channel);
+        if (!channelHandlers) {
+            return;
+        }
+        const dropped = batch.d[channel] ?? 0;
+        channelHandlers.forEach(handler => {
+            try {
+                handler(items, dropped);
+            } catch (error) {
+                console.error(`[xrealBridge] ${channel} 处理失败:`, error);
+            }
+        });
+    });
+
+    const cost = performance.now() - start;
+    bridgeStats.batches++;
+    bridgeStats.lastCostMs = cost;
+    bridgeStats.maxCostMs = Math.max(bridgeStats.maxCostMs, cost);
+    bridgeStats.totalCostMs += cost;
+}
+
+// 订阅一个通道,返回取消订阅的函数
+function onNative(channel: string, handler: NativeHandler): () => void {
+    let channelHandlers = handlers.get(channel);
+    if (!channelHandlers) {
+        channelHandlers = new Set();
+        handlers.set(channel, channelHandlers);
+    }
+    channelHandlers.add(handler);
+    return () => {
+        channelHandlers!.delete(handler);
+    };
+}
+
+function installNativeBridge() {
+    (window as any).xrealBridge = {receive, stats: bridgeStats};
+}
+
+export {installNativeBridge, onNative, bridgeStats};
+export type {NativeHandler, NativeBridgeStats};
@@ -0,0 +1,188 @@
+// C++每帧发来的头部姿态包的接收端(C++端及包的格式见PoseStreamer.h)
+// 包经由xrealBridge的pose通道按帧发来,只保留最新的一个;渲染时再用角速度外推到预计的出光时间.
+// 延迟用系统时钟计算: C++发出的时间与页面的 performance.timeOrigin + performance.now() 是同一个时钟.
+import * as THREE from 'three';
+import {onNative} from './nativeBridge.ts';
+
+const PACKET_VERSION = 1;
+// 渲染到出光的预计时间(毫秒,约一帧)
+const RENDER_TO_PHOTON_MS = 16;
+// 外推的最长时间,超出时不再外推
+const MAX_EXTRAPOLATION_MS = 50;
+// 超过这么久没有新包时认为姿态不可用
+const STALE_AFTER_MS = 500;
+// 延迟统计保留的最近样本数
+const LATENCY_WINDOW = 256;
+
+interface HeadPose {
+    sequence: number;
+    // 朝向(Three.js坐标系,以recenterHeadPose时的水平朝向为正前方),已外推到预计的出光时间
+    quaternion: THREE.Quaternion;
+    // 角速度(弧度/秒,头部坐标系,Three.js的轴向)
+    angularVelocity: THREE.Vector3;
+    // C++发出的时间和C++预测到的时间(系统时钟,毫秒)
+    publishTimeMs: number;
+    photonTimeMs: number;
+    // 最后一条参与融合的IMU样本到C++发出时的时间(毫秒)
+    sampleAgeMs: number;
+}
+
+interface LatencySummary {
+    count: number;
+    lastMs: number;
+    p50Ms: number;
+    p99Ms: number;
+    maxMs: number;
+}
+
+interface PoseChannelStats {
+    packets: number;
+    // 版本不对或格式错误的包
+    rejected: number;
+    // 被渲染用到的包(没有被用到的是同一帧内被更新的包覆盖了)
+    consumed: number;
+    // C++发出到页面收到
+    receive: LatencySummary;
+    // C++发出到渲染第一次用到
+    consume: LatencySummary;
+}
+
+class LatencyWindow {
+    private readonly samples = new Float64Array(LATENCY_WINDOW);
+    private count = 0;
+    private last = 0;
+    private max = 0;
+
+    record(ms: number) {
+        this.samples[this.count % LATENCY_WINDOW] = ms;
+        this.count++;
+        this.last = ms;
+        this.max = Math.max(this.max, ms);
+    }
+
+    summary(): LatencySummary {
+        const size = Math.min(this.count, LATENCY_WINDOW);
+        const sorted = Array.from(this.samples.subarray(0, size)).sort((a, b) => a - b);
+        const at = (q: number) => size > 0 ? sorted[Math.min(size - 1, Math.floor(q * size))] : 0;
+        return {count: this.count, lastMs: this.last, p50Ms: at(0.5), p99Ms: at(0.99), maxMs: this.max};
+    }
+}
+
+// 最新的包(原始值,IMU坐标系)
+const latestPacket = new Float64Array(12);
+let hasPacket = false;
+let lastConsumedSequence = 0;
+let subscribed = false;
+let packets = 0;
+let rejected = 0;
+let consumed = 0;
+const receiveLatency = new LatencyWindow();
+const consumeLatency = new LatencyWindow();
+
+// 去掉偏航的旋转,使recenter时的水平朝向为正前方
+const recenterOffset = new THREE.Quaternion();
+let needsRecenter = true;
+
+const headPose: HeadPose = {
+    sequence: 0,
+    quaternion: new THREE.Quaternion(),
+    angularVelocity: new THREE.Vector3(),
+    publishTimeMs: 0,
+    photonTimeMs: 0,
+    sampleAgeMs: 0,
+};
+const deltaRotation = new THREE.Quaternion();
+const rotationAxis = new THREE.Vector3();
+const yawOnly = new THREE.Euler(0, 0, 0, 'YXZ');
+
+function wallNowMs(): number {
+    return performance.timeOrigin + performance.now();
+}
+
+function receivePose(items: unknown[]) {
+    const now = wallNowMs();
+    for (const item of items) {
+        const packet = item as number[];
+        if (!Array.isArray(packet) || packet.length < latestPacket.length || packet[0] !== PACKET_VERSION) {
+            rejected++;
+            continue;
+        }
+        latestPacket.set(packet.length === latestPacket.length ? packet : packet.slice(0, latestPacket.length));
+        hasPacket = true;
+        packets++;
+        receiveLatency.record(now - packet[2]);
+    }
+}
+
+function ensureSubscribed() {
+    if (subscribed) {
+        return;
+    }
+    subscribed = true;
+    onNative('pose', receivePose);
+}
+
+// 以当前的水平朝向为正前方(只去掉偏航,保留与重力方向的关系)
+function recenterHeadPose() {
+    needsRecenter = true;
+}
+
+// 渲染每帧调用一次,返回外推到预计出光时间的头部姿态;没有姿态数据时为null
+// 返回的对象每帧复用,不要保存
+function consumeHeadPose(): HeadPose | null {
+    ensureSubscribed();
+    if (!hasPacket) {
+        return null;
+    }
+    const now = wallNowMs();
+    if (now - latestPacket[2] > STALE_AFTER_MS) {
+        return null;
+    }
+    const sequence = latestPacket[1];
+    if (sequence !== lastConsumedSequence) {
+        lastConsumedSequence = sequence;
+        consumed++;
+        consumeLatency.record(now - latestPacket[2]);
+    }
+
+    // IMU的世界坐标系z轴向上,IMU自身x向右、y向前;Three.js为y向上、-z向前
+    // 四元数和角速度都按绕x轴转-90°的基变换换算: (x, y, z) -> (x, z, -y)
+    const [, , publishTimeMs, photonTimeMs, w, x, y, z, wx, wy, wz, sampleAgeMs] = latestPacket;
+    headPose.sequence = sequence;
+    headPose.publishTimeMs = publishTimeMs;
+    headPose.photonTimeMs = photonTimeMs;
+    headPose.sampleAgeMs = sampleAgeMs;
+    headPose.quaternion.set(x, z, -y, w);
+    headPose.angularVelocity.set(wx, wz, -wy);
+
+    if (needsRecenter) {
+        needsRecenter = false;
+        yawOnly.setFromQuaternion(headPose.quaternion, 'YXZ');
+        recenterOffset.setFromAxisAngle(THREE.Object3D.DEFAULT_UP, -yawOnly.y);
+    }
+    headPose.quaternion.premultiply(recenterOffset);
+
+    // C++预测到的是发出后的固定时间,按实际渲染的时间用角速度再外推(头部坐标系,右乘)
+    const dtSeconds = Math.max(-MAX_EXTRAPOLATION_MS,
+        Math.min(MAX_EXTRAPOLATION_MS, now + RENDER_TO_PHOTON_MS - photonTimeMs)) / 1000;
+    const rate = headPose.angularVelocity.length();
+    if (rate > 1e-6 && dtSeconds !== 0) {
+        rotationAxis.copy(headPose.angularVelocity).divideScalar(rate);
+        deltaRotation.setFromAxisAngle(rotationAxis, rate * dtSeconds);
+        headPose.quaternion.multiply(deltaRotation);
+    }
+    return headPose;
+}
+
+function poseChannelStats(): PoseChannelStats {
+    return {
+        packets,
+        rejected,
+        consumed,
+        receive: receiveLatency.summary(),
+        consume: consumeLatency.summary(),
+    };
+}
+
+export {consumeHeadPose, recenterHeadPose, poseChannelStats};
+export type {HeadPose, PoseChannelStats, LatencySummary};
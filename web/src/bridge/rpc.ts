@@ -0,0 +1,257 @@
+// 页面调用C++的RPC(C++端见RpcServer.h)
+// 同一个微任务内的调用合成一条消息,经由脚本消息处理器xrealRpc发给C++;响应经由xrealBridge的rpc通道按帧合批返回.
+// 同时等待响应的调用有上限,超出的先在页面排队;C++队列满时返回busy,自动稍后重试.
+import {onNative} from './nativeBridge.ts';
+
+interface HistogramSummary {
+    count: number;
+    meanUs: number;
+    p50Us: number;
+    p99Us: number;
+    maxUs: number;
+}
+
+interface StreamStats {
+    interface: number;
+    reports: number;
+    imuReports: number;
+    mcuReports: number;
+    crcFailures: number;
+    malformed: number;
+    readErrors: number;
+    imuMissing: number;
+    imuGaps: number;
+    timestampRegressions: number;
+    sequenceMissing: number;
+    rate1sHz: number;
+    rateWindowHz: number;
+    idleMs: number;
+    arrival: HistogramSummary;
+    handling: HistogramSummary;
+}
+
+interface DeviceInfo {
+    connected: boolean;
+    serialNumber: string;
+    imu: boolean;
+    orientation: boolean;
+}
+
+interface DeviceStats {
+    streams: StreamStats[];
+    imuLatency: { transit: HistogramSummary; consume: HistogramSummary } | null;
+    bridge: {
+        posted: number;
+        delivered: number;
+        coalesced: number;
+        dropped: number;
+        batches: number;
+        bytes: number;
+        queued: number;
+        highWater: number;
+        scriptCost: HistogramSummary;
+    };
+    log: { written: number; dropped: number; threads: number };
+    rpc: {
+        requests: number;
+        completed: number;
+        failed: number;
+        rejected: number;
+        expired: number;
+        malformed: number;
+        pending: number;
+        highWater: number;
+        queueTime: HistogramSummary;
+        handlerTime: HistogramSummary;
+    };
+    pose: {
+        packets: number;
+        repeated: number;
+        unavailable: number;
+        sampleAge: HistogramSummary;
+        encode: HistogramSummary;
+    };
+}
+
+// 方法名 -> 参数和返回值,与C++的RpcSchema.h一一对应
+interface RpcSchema {
+    'device.info': { params: Record<string, never>; result: DeviceInfo };
+    'device.switchMode': { params: { mode3D: boolean }; result: { switched: boolean } };
+    'device.stats': { params: Record<string, never>; result: DeviceStats };
+}
+
+type RpcMethod = keyof RpcSchema;
+
+interface RpcCallOptions {
+    // 超时(毫秒),同时告诉C++排队超过这么久就不必执行
+    timeoutMs?: number;
+}
+
+// C++返回的错误,code见RpcServer.h
+class RpcError extends Error {
+    constructor(readonly method: string, readonly code: string, message: string) {
+        super(`${method}: ${message} (${code})`);
+    }
+}
+
+interface RpcRequest {
+    i: number;
+    m: string;
+    p: unknown;
+    t: number;
+}
+
+interface RpcResponse {
+    i: number;
+    ok: boolean;
+    v?: unknown;
+    c?: string;
+    e?: string;
+}
+
+interface InFlight {
+    request: RpcRequest;
+    resolve: (value: any) => void;
+    reject: (error: Error) => void;
+    timer: number;
+    retries: number;
+}
+
+const DEFAULT_TIMEOUT_MS = 5000;
+// 同时等待响应的调用上限
+const MAX_IN_FLIGHT = 32;
+// 一条消息最多的请求数(与C++的max_requests_per_message一致)
+const MAX_PER_MESSAGE = 64;
+// busy时的重试间隔和次数
+const BUSY_RETRY_MS = 50;
+const MAX_BUSY_RETRIES = 5;
+
+let nextId = 1;
+const inFlight = new Map<number, InFlight>();
+// 超出上限、等待发送的调用
+const waiting: InFlight[] = [];
+// 本微任务内要发送的请求
+const outgoing: RpcRequest[] = [];
+let flushQueued = false;
+let subscribed = false;
+
+function postToNative(message: string): boolean {
+    const w = window as any;
+    // Edge后端注入 window.xrealRpc,WebKit后端为 window.webkit.messageHandlers.xrealRpc
+    const handler = w.xrealRpc ?? w.webkit?.messageHandlers?.xrealRpc;
+    if (!handler) {
+        return false;
+    }
+    handler.postMessage(message);
+    return true;
+}
+
+function flush() {
+    flushQueued = false;
+    while (outgoing.length > 0) {
+        const requests = outgoing.splice(0, MAX_PER_MESSAGE);
+        if (!postToNative(JSON.stringify({r: requests}))) {
+            for (const request of requests) {
+                settle(request.i, {i: request.i, ok: false, c: 'unavailable', e: '不在应用中运行,没有C++端'});
+            }
+        }
+    }
+}
+
+function send(call: InFlight) {
+    inFlight.set(call.request.i, call);
+    outgoing.push(call.request);
+    if (!flushQueued) {
+        flushQueued = true;
+        queueMicrotask(flush);
+    }
+}
+
+function settle(id: number, response: RpcResponse) {
+    const call = inFlight.get(id);
+    if (!call) {
+        // 已经超时
+        return;
+    }
+    inFlight.delete(id);
+    if (!response.ok && response.c === 'busy' && call.retries < MAX_BUSY_RETRIES) {
+        // C++队列满,稍后重新发送(仍然计入同时等待的上限)
+        call.retries++;
+        inFlight.set(id, call);
+        window.setTimeout(() => {
+            if (inFlight.get(id) === call) {
+                inFlight.delete(id);
+                send(call);
+            }
+        }, BUSY_RETRY_MS * call.retries);
+        return;
+    }
+    window.clearTimeout(call.timer);
+    if (response.ok) {
+        call.resolve(response.v);
+    } else {
+        call.reject(new RpcError(call.request.m, response.c ?? 'failed', response.e ?? ''));
+    }
+    sendWaiting();
+}
+
+// 空出了位置,发送排队的调用
+function sendWaiting() {
+    while (waiting.length > 0 && inFlight.size < MAX_IN_FLIGHT) {
+        send(waiting.shift()!);
+    }
+}
+
+function ensureSubscribed() {
+    if (subscribed) {
+        return;
+    }
+    subscribed = true;
+    onNative('rpc', items => {
+        for (const item of items) {
+            const response = item as RpcResponse;
+            settle(response.i, response);
+        }
+    });
+}
+
+// 调用C++方法,返回Promise
+function call<M extends RpcMethod>(method: M, params: RpcSchema[M]['params'],
+                                   options: RpcCallOptions = {}): Promise<RpcSchema[M]['result']> {
+    ensureSubscribed();
+    const timeoutMs = options.timeoutMs ?? DEFAULT_TIMEOUT_MS;
+    return new Promise((resolve, reject) => {
+        const id = nextId++;
+        const pending: InFlight = {
+            request: {i: id, m: method, p: params, t: timeoutMs},
+            resolve,
+            reject,
+            timer: 0,
+            retries: 0,
+        };
+        pending.timer = window.setTimeout(() => {
+            inFlight.delete(id);
+            const index = waiting.indexOf(pending);
+            if (index >= 0) {
+                waiting.splice(index, 1);
+            }
+            reject(new RpcError(method, 'timeout', `${timeoutMs}ms内没有响应`));
+            sendWaiting();
+        }, timeoutMs);
+        if (inFlight.size < MAX_IN_FLIGHT) {
+            send(pending);
+        } else {
+            waiting.push(pending);
+        }
+    });
+}
+
+// 各方法的便捷调用
+const rpc = {
+    deviceInfo: (options?: RpcCallOptions) => call('device.info', {}, options),
+    switchMode: (mode3D: boolean, options?: RpcCallOptions) => call('device.switchMode', {mode3D}, options),
+    stats: (options?: RpcCallOptions) => call('device.stats', {}, options),
+};
+
+export {call, rpc, RpcError};
+export type {RpcSchema, RpcMethod, RpcCallOptions, DeviceInfo, DeviceStats, StreamStats, HistogramSummary};
@@ -1,5 +1,9 @@
 import { createApp } from 'vue'
 import './style.css'
 import App from './App.vue'
+import {installNativeBridge} from './bridge/nativeBridge.ts'
+
+// 在页面挂载之前安装,C++在页面加载完成后就可能发来消息
+installNativeBridge()
 
 createApp(App).mount('#app')
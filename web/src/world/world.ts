@@ -14,10 +14,14 @@ import {initPages} from "./object/page";
 import { initWidget as initTextOutputWidget, releaseWidget as releaseTextOutputWidget, appendText as appendToTextOutput } from './object/widget/textOutput';
 import { initAxisIndicator, releaseAxisIndicator, type AxisIndicator } from './object/widget/axisIndicator';
 import gsap from 'gsap';
+import {consumeHeadPose} from "../bridge/pose.ts";
 
 let scene: THREE.Scene;
 let renderer: THREE.WebGLRenderer;
 const eyeSep = 0.06;
+// 头部跟踪时两眼相机绕这个点随头转动
+const headCenter = new THREE.Vector3(0, 0, 5);
+const eyeOffset = new THREE.Vector3();
 
 // let textOutputTestInterval: number | undefined; // Will be redefined for new interval
 let mockTextIntervalId: number | undefined;
@@ -308,10 +312,20 @@ function renderWorldByStereo() {
     rightCamera.near = camera.near;
     leftCamera.far = camera.far;
     rightCamera.far = camera.far;
-    leftCamera.position.set(-eyeSep / 2, 0, 5);
-    rightCamera.position.set(eyeSep / 2, 0, 5);
-    leftCamera.lookAt(0, 0, 0);
-    rightCamera.lookAt(0, 0, 0);
+    const headPose = consumeHeadPose();
+    if (headPose) {
+        // 有眼镜的头部姿态时两眼视线平行,随头转动
+        eyeOffset.set(eyeSep / 2, 0, 0).applyQuaternion(headPose.quaternion);
+        leftCamera.position.copy(headCenter).sub(eyeOffset);
+        rightCamera.position.copy(headCenter).add(eyeOffset);
+        leftCamera.quaternion.copy(headPose.quaternion);
+        rightCamera.quaternion.copy(headPose.quaternion);
+    } else {
+        leftCamera.position.set(-eyeSep / 2, 0, 5);
+        rightCamera.position.set(eyeSep / 2, 0, 5);
+        leftCamera.lookAt(0, 0, 0);
+        rightCamera.lookAt(0, 0, 0);
+    }
 
     // Left Eye
     renderPass.camera = leftCamera;